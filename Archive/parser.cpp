@@ -80,7 +80,7 @@ void parser(
         current_msg.valid_msg = 0;
         
         if (start_msg && valid) {
-            byte_idx = 1;
+            byte_idx = 0; // Incremented to 1 on the next byte, matching parser.sv's registered index
             count_en = true;
             current_msg.msg_type = message;
             
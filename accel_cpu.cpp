@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <ap_int.h>
+#include "itch.h"
+#include "accel_runtime.h"
+
+// CPU backend for accel_runtime.h: the HLS kernel sources, compiled natively, run on a pool of
+// worker threads. A buffer's host mirror doubles as its device memory, so to_device() and
+// to_host() only keep their place in the event order, and write()/read() are plain copies.
+// Each worker takes the oldest command whose wait list has completed, so independent runs of
+// the same kernel execute in parallel like several compute units would.
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -c accel_cpu.cpp double_vector.cpp parser_wide.cpp
+//            Archive/parser.cpp Archive/deserializer.cpp
+
+extern "C" {
+void double_vector(const int* input, int* output, int size);
+void deserialize(uint8_t* mem_in, uint8_t* mem_out, unsigned int length);
+void parser(const ByteData* input_stream, int num_bytes, ParserOutput* output_stream, int* num_outputs);
+void parser_framed(const ap_uint<512>* input_stream, int num_bytes, ParserOutput* output_stream, int* num_outputs);
+void parser_filtered(const ap_uint<512>* input_stream, int num_bytes, ParserOutput* output_stream,
+                     int* num_outputs, const ap_uint<512>* filter, int* num_dropped);
+void parser_columns(const ap_uint<512>* input_stream, int num_bytes, ap_uint<512>* output_stream, int capacity,
+                    int* num_outputs);
+}
+
+namespace {
+
+#define CPU_MAX_ARGS 8
+
+struct CpuArg {
+    AccelBuffer* buffer;
+    int32_t value;
+};
+
+// Kernels linked into the backend. invoke() unpacks the captured arguments into the kernel's
+// own signature; a buffer argument becomes its host mirror.
+struct CpuKernelDef {
+    const char* name;
+    int num_args;
+    void (*invoke)(const CpuArg* args);
+};
+
+static void* mem(const CpuArg& arg) { return arg.buffer ? arg.buffer->host() : 0; }
+
+static void run_double_vector(const CpuArg* a) {
+    double_vector((const int*)mem(a[0]), (int*)mem(a[1]), a[2].value);
+}
+
+static void run_deserialize(const CpuArg* a) {
+    deserialize((uint8_t*)mem(a[0]), (uint8_t*)mem(a[1]), (unsigned int)a[2].value);
+}
+
+static void run_parser(const CpuArg* a) {
+    parser((const ByteData*)mem(a[0]), a[1].value, (ParserOutput*)mem(a[2]), (int*)mem(a[3]));
+}
+
+static void run_parser_framed(const CpuArg* a) {
+    parser_framed((const ap_uint<512>*)mem(a[0]), a[1].value, (ParserOutput*)mem(a[2]), (int*)mem(a[3]));
+}
+
+static void run_parser_filtered(const CpuArg* a) {
+    parser_filtered((const ap_uint<512>*)mem(a[0]), a[1].value, (ParserOutput*)mem(a[2]), (int*)mem(a[3]),
+                    (const ap_uint<512>*)mem(a[4]), (int*)mem(a[5]));
+}
+
+static void run_parser_columns(const CpuArg* a) {
+    parser_columns((const ap_uint<512>*)mem(a[0]), a[1].value, (ap_uint<512>*)mem(a[2]), a[3].value,
+                   (int*)mem(a[4]));
+}
+
+static const CpuKernelDef cpu_kernels[] = {
+    {"double_vector",   3, run_double_vector},
+    {"deserialize",     3, run_deserialize},
+    {"parser",          4, run_parser},
+    {"parser_framed",   4, run_parser_framed},
+    {"parser_filtered", 6, run_parser_filtered},
+    {"parser_columns",  5, run_parser_columns},
+};
+
+class CpuBuffer : public AccelBuffer {
+public:
+    CpuBuffer(void* host, size_t size, bool owns_host) : owns_host_(owns_host) {
+        host_ = host;
+        size_ = size;
+    }
+    ~CpuBuffer() {
+        if (owns_host_) free(host_);
+    }
+
+private:
+    bool owns_host_;
+};
+
+class CpuKernel : public AccelKernel {
+public:
+    explicit CpuKernel(const CpuKernelDef* def) : def_(def) { memset(args_, 0, sizeof(args_)); }
+
+    int set_arg(int index, AccelBuffer* buffer) {
+        if (index < 0 || index >= def_->num_args) return -1;
+        args_[index].buffer = buffer;
+        return 0;
+    }
+    int set_scalar(int index, int32_t value) {
+        if (index < 0 || index >= def_->num_args) return -1;
+        args_[index].value = value;
+        return 0;
+    }
+
+    const CpuKernelDef* def() const { return def_; }
+    const CpuArg* args() const { return args_; }
+
+private:
+    const CpuKernelDef* def_;
+    CpuArg args_[CPU_MAX_ARGS];
+};
+
+class CpuDevice;
+
+// Completion is guarded by the device's lock, so one condition variable serves workers and waiters
+class CpuEvent : public AccelEventState {
+public:
+    explicit CpuEvent(CpuDevice* device) : device_(device), done_(false), seconds_(0) {}
+    void wait();
+    double seconds() {
+        wait();
+        return seconds_;
+    }
+
+private:
+    friend class CpuDevice;
+    CpuDevice* device_;
+    bool done_;
+    double seconds_;
+};
+
+struct CpuCommand {
+    enum Kind { COPY, KERNEL, NOP } kind;
+    void* dst;
+    const void* src;
+    size_t size;
+    const CpuKernelDef* kernel;
+    CpuArg args[CPU_MAX_ARGS];   // captured at enqueue
+    AccelWaitList wait_list;
+    std::shared_ptr<CpuEvent> done;
+};
+
+class CpuDevice : public AccelDevice {
+public:
+    explicit CpuDevice(int num_threads) : stop_(false), outstanding_(0) {
+        for (int i = 0; i < num_threads; i++) workers_.push_back(std::thread(&CpuDevice::work, this));
+    }
+
+    ~CpuDevice() {
+        finish();
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            stop_ = true;
+        }
+        changed_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++) workers_[i].join();
+        for (std::map<std::string, CpuKernel*>::iterator it = kernels_.begin(); it != kernels_.end(); ++it) {
+            delete it->second;
+        }
+    }
+
+    const char* name() const { return "cpu"; }
+
+    int load(const char* xclbin_path) {
+        (void)xclbin_path;
+        return 0;
+    }
+
+    AccelKernel* kernel(const char* name) {
+        std::map<std::string, CpuKernel*>::iterator it = kernels_.find(name);
+        if (it != kernels_.end()) return it->second;
+        for (size_t i = 0; i < sizeof(cpu_kernels) / sizeof(cpu_kernels[0]); i++) {
+            if (strcmp(cpu_kernels[i].name, name) == 0) {
+                CpuKernel* kernel = new CpuKernel(&cpu_kernels[i]);
+                kernels_[name] = kernel;
+                return kernel;
+            }
+        }
+        return 0;
+    }
+
+    AccelBuffer* buffer(size_t size, int access, void* host_ptr) {
+        (void)access;
+        bool owns_host = host_ptr == 0;
+        if (owns_host) {
+            if (posix_memalign(&host_ptr, 4096, size ? size : 1) != 0) {
+                printf("Error: could not allocate %zu bytes\n", size);
+                return 0;
+            }
+            memset(host_ptr, 0, size);
+        }
+        return new CpuBuffer(host_ptr, size, owns_host);
+    }
+
+    AccelEvent to_device(AccelBuffer* buffer, const AccelWaitList& wait_list) {
+        (void)buffer;
+        CpuCommand cmd = command(CpuCommand::NOP, wait_list);
+        return submit(cmd);
+    }
+
+    AccelEvent to_host(AccelBuffer* buffer, const AccelWaitList& wait_list) {
+        return to_device(buffer, wait_list);
+    }
+
+    AccelEvent write(AccelBuffer* buffer, const void* src, size_t size, size_t offset,
+                     const AccelWaitList& wait_list) {
+        if (offset + size > buffer->size()) { printf("Error: write past the end of a buffer\n"); return AccelEvent(); }
+        CpuCommand cmd = command(CpuCommand::COPY, wait_list);
+        cmd.dst = (uint8_t*)buffer->host() + offset;
+        cmd.src = src;
+        cmd.size = size;
+        return submit(cmd);
+    }
+
+    AccelEvent read(AccelBuffer* buffer, void* dst, size_t size, size_t offset, const AccelWaitList& wait_list) {
+        if (offset + size > buffer->size()) { printf("Error: read past the end of a buffer\n"); return AccelEvent(); }
+        CpuCommand cmd = command(CpuCommand::COPY, wait_list);
+        cmd.dst = dst;
+        cmd.src = (const uint8_t*)buffer->host() + offset;
+        cmd.size = size;
+        return submit(cmd);
+    }
+
+    AccelEvent run(AccelKernel* kernel, const AccelWaitList& wait_list) {
+        CpuKernel* k = static_cast<CpuKernel*>(kernel);
+        CpuCommand cmd = command(CpuCommand::KERNEL, wait_list);
+        cmd.kernel = k->def();
+        memcpy(cmd.args, k->args(), sizeof(cmd.args));
+        return submit(cmd);
+    }
+
+    void finish() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (outstanding_ > 0) changed_.wait(lock);
+    }
+
+private:
+    friend class CpuEvent;
+
+    CpuCommand command(CpuCommand::Kind kind, const AccelWaitList& wait_list) {
+        CpuCommand cmd;
+        cmd.kind = kind;
+        cmd.dst = 0;
+        cmd.src = 0;
+        cmd.size = 0;
+        cmd.kernel = 0;
+        cmd.wait_list = wait_list;
+        cmd.done = std::make_shared<CpuEvent>(this);
+        return cmd;
+    }
+
+    AccelEvent submit(CpuCommand& cmd) {
+        AccelEvent done = cmd.done;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            pending_.push_back(cmd);
+            outstanding_++;
+        }
+        changed_.notify_all();
+        return done;
+    }
+
+    // Called with the lock held
+    bool ready(const CpuCommand& cmd) const {
+        for (size_t i = 0; i < cmd.wait_list.size(); i++) {
+            if (cmd.wait_list[i] && !static_cast<CpuEvent*>(cmd.wait_list[i].get())->done_) return false;
+        }
+        return true;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(lock_);
+        for (;;) {
+            std::deque<CpuCommand>::iterator it = pending_.begin();
+            while (it != pending_.end() && !ready(*it)) ++it;
+            if (it == pending_.end()) {
+                if (stop_) return;
+                changed_.wait(lock);
+                continue;
+            }
+            CpuCommand cmd = *it;
+            pending_.erase(it);
+            lock.unlock();
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (cmd.kind == CpuCommand::COPY) memcpy(cmd.dst, cmd.src, cmd.size);
+            else if (cmd.kind == CpuCommand::KERNEL) cmd.kernel->invoke(cmd.args);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            cmd.done->seconds_ = seconds;
+            cmd.done->done_ = true;
+            outstanding_--;
+            changed_.notify_all();
+        }
+    }
+
+    std::mutex lock_;
+    std::condition_variable changed_;
+    std::deque<CpuCommand> pending_;
+    std::vector<std::thread> workers_;
+    bool stop_;
+    int outstanding_;
+    std::map<std::string, CpuKernel*> kernels_;
+};
+
+void CpuEvent::wait() {
+    std::unique_lock<std::mutex> lock(device_->lock_);
+    while (!done_) device_->changed_.wait(lock);
+}
+
+}  // namespace
+
+std::unique_ptr<AccelDevice> accel_open_cpu(int num_threads) {
+    if (num_threads <= 0) {
+        const char* env = getenv("ACCEL_CPU_THREADS");
+        num_threads = env ? atoi(env) : (int)std::thread::hardware_concurrency();
+        if (num_threads <= 0) num_threads = 1;
+    }
+    return std::unique_ptr<AccelDevice>(new CpuDevice(num_threads));
+}
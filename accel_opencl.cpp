@@ -0,0 +1,236 @@
+#ifdef CL_MOCK
+#include "cl_mock.h"
+#else
+#define CL_TARGET_OPENCL_VERSION 120
+#include <CL/opencl.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "accel_runtime.h"
+
+// OpenCL/XRT backend for accel_runtime.h: one context, one out-of-order queue with profiling,
+// and one program per device. Build with -lOpenCL, or with -DCL_MOCK and cl_mock.c.
+
+namespace {
+
+class ClBuffer : public AccelBuffer {
+public:
+    ClBuffer(cl_mem mem, void* host, size_t size, bool owns_host) : mem_(mem), owns_host_(owns_host) {
+        host_ = host;
+        size_ = size;
+    }
+    ~ClBuffer() {
+        clReleaseMemObject(mem_);
+        if (owns_host_) free(host_);
+    }
+    cl_mem mem() const { return mem_; }
+
+private:
+    cl_mem mem_;
+    bool owns_host_;
+};
+
+class ClKernel : public AccelKernel {
+public:
+    explicit ClKernel(cl_kernel kernel) : kernel_(kernel) {}
+    ~ClKernel() { clReleaseKernel(kernel_); }
+    cl_kernel handle() const { return kernel_; }
+
+    int set_arg(int index, AccelBuffer* buffer) {
+        cl_mem mem = static_cast<ClBuffer*>(buffer)->mem();
+        return clSetKernelArg(kernel_, index, sizeof(cl_mem), &mem);
+    }
+    int set_scalar(int index, int32_t value) {
+        return clSetKernelArg(kernel_, index, sizeof(value), &value);
+    }
+
+private:
+    cl_kernel kernel_;
+};
+
+class ClEvent : public AccelEventState {
+public:
+    explicit ClEvent(cl_event event) : event_(event) {}
+    ~ClEvent() { clReleaseEvent(event_); }
+    cl_event handle() const { return event_; }
+
+    void wait() { clWaitForEvents(1, &event_); }
+    double seconds() {
+        cl_ulong start = 0, end = 0;
+        clGetEventProfilingInfo(event_, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL);
+        clGetEventProfilingInfo(event_, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL);
+        return (end - start) * 1e-9;
+    }
+
+private:
+    cl_event event_;
+};
+
+class ClDevice : public AccelDevice {
+public:
+    ClDevice() : context_(0), queue_(0), program_(0) {}
+
+    ~ClDevice() {
+        finish();
+        for (std::map<std::string, ClKernel*>::iterator it = kernels_.begin(); it != kernels_.end(); ++it) {
+            delete it->second;
+        }
+        if (program_) clReleaseProgram(program_);
+        if (queue_) clReleaseCommandQueue(queue_);
+        if (context_) clReleaseContext(context_);
+    }
+
+    int open() {
+        cl_int err;
+        cl_platform_id platform;
+        err = clGetPlatformIDs(1, &platform, NULL);
+        if (err != CL_SUCCESS) { printf("clGetPlatformIDs failed: %d\n", err); return err; }
+
+        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ACCELERATOR, 1, &device_, NULL);
+        if (err != CL_SUCCESS) { printf("clGetDeviceIDs failed: %d\n", err); return err; }
+
+        context_ = clCreateContext(NULL, 1, &device_, NULL, NULL, &err);
+        if (!context_ || err != CL_SUCCESS) { printf("clCreateContext failed: %d\n", err); return err; }
+
+        queue_ = clCreateCommandQueue(context_, device_,
+                                      CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE, &err);
+        if (!queue_ || err != CL_SUCCESS) { printf("clCreateCommandQueue failed: %d\n", err); return err; }
+        return CL_SUCCESS;
+    }
+
+    const char* name() const { return "opencl"; }
+
+    int load(const char* xclbin_path) {
+        FILE* fp = fopen(xclbin_path, "rb");
+        if (!fp) { printf("Error: could not open %s\n", xclbin_path); return CL_INVALID_VALUE; }
+        fseek(fp, 0, SEEK_END);
+        size_t binary_size = ftell(fp);
+        rewind(fp);
+        std::vector<unsigned char> binary(binary_size);
+        size_t got = fread(binary.data(), 1, binary_size, fp);
+        fclose(fp);
+        if (got != binary_size) { printf("Error: could not read %s\n", xclbin_path); return CL_INVALID_VALUE; }
+
+        cl_int err;
+        const unsigned char* data = binary.data();
+        program_ = clCreateProgramWithBinary(context_, 1, &device_, &binary_size, &data, NULL, &err);
+        if (err != CL_SUCCESS) { printf("clCreateProgramWithBinary failed: %d\n", err); return err; }
+        err = clBuildProgram(program_, 1, &device_, NULL, NULL, NULL);
+        if (err != CL_SUCCESS) { printf("clBuildProgram failed: %d\n", err); return err; }
+        return CL_SUCCESS;
+    }
+
+    AccelKernel* kernel(const char* name) {
+        std::map<std::string, ClKernel*>::iterator it = kernels_.find(name);
+        if (it != kernels_.end()) return it->second;
+        if (!program_) return 0;
+        cl_int err;
+        cl_kernel k = clCreateKernel(program_, name, &err);
+        if (err != CL_SUCCESS) return 0;
+        ClKernel* kernel = new ClKernel(k);
+        kernels_[name] = kernel;
+        return kernel;
+    }
+
+    AccelBuffer* buffer(size_t size, int access, void* host_ptr) {
+        bool owns_host = host_ptr == 0;
+        if (owns_host && posix_memalign(&host_ptr, 4096, size ? size : 1) != 0) {
+            printf("Error: could not allocate %zu bytes\n", size);
+            return 0;
+        }
+        if (owns_host) memset(host_ptr, 0, size);
+        cl_mem_flags flags = CL_MEM_USE_HOST_PTR;
+        flags |= access == ACCEL_READ_ONLY ? CL_MEM_READ_ONLY
+               : access == ACCEL_WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_WRITE;
+        cl_int err;
+        cl_mem mem = clCreateBuffer(context_, flags, size, host_ptr, &err);
+        if (err != CL_SUCCESS) {
+            printf("clCreateBuffer failed: %d\n", err);
+            if (owns_host) free(host_ptr);
+            return 0;
+        }
+        return new ClBuffer(mem, host_ptr, size, owns_host);
+    }
+
+    AccelEvent to_device(AccelBuffer* buffer, const AccelWaitList& wait_list) {
+        return migrate(buffer, 0, wait_list);
+    }
+
+    AccelEvent to_host(AccelBuffer* buffer, const AccelWaitList& wait_list) {
+        return migrate(buffer, CL_MIGRATE_MEM_OBJECT_HOST, wait_list);
+    }
+
+    AccelEvent write(AccelBuffer* buffer, const void* src, size_t size, size_t offset,
+                     const AccelWaitList& wait_list) {
+        std::vector<cl_event> waits = handles(wait_list);
+        cl_event e;
+        cl_int err = clEnqueueWriteBuffer(queue_, static_cast<ClBuffer*>(buffer)->mem(), CL_FALSE, offset, size,
+                                          src, (cl_uint)waits.size(), waits.empty() ? NULL : waits.data(), &e);
+        if (err != CL_SUCCESS) { printf("clEnqueueWriteBuffer failed: %d\n", err); return AccelEvent(); }
+        return submitted(e);
+    }
+
+    AccelEvent read(AccelBuffer* buffer, void* dst, size_t size, size_t offset, const AccelWaitList& wait_list) {
+        std::vector<cl_event> waits = handles(wait_list);
+        cl_event e;
+        cl_int err = clEnqueueReadBuffer(queue_, static_cast<ClBuffer*>(buffer)->mem(), CL_FALSE, offset, size,
+                                         dst, (cl_uint)waits.size(), waits.empty() ? NULL : waits.data(), &e);
+        if (err != CL_SUCCESS) { printf("clEnqueueReadBuffer failed: %d\n", err); return AccelEvent(); }
+        return submitted(e);
+    }
+
+    AccelEvent run(AccelKernel* kernel, const AccelWaitList& wait_list) {
+        std::vector<cl_event> waits = handles(wait_list);
+        cl_event e;
+        cl_int err = clEnqueueTask(queue_, static_cast<ClKernel*>(kernel)->handle(), (cl_uint)waits.size(),
+                                   waits.empty() ? NULL : waits.data(), &e);
+        if (err != CL_SUCCESS) { printf("clEnqueueTask failed: %d\n", err); return AccelEvent(); }
+        return submitted(e);
+    }
+
+    void finish() {
+        if (queue_) clFinish(queue_);
+    }
+
+private:
+    static std::vector<cl_event> handles(const AccelWaitList& wait_list) {
+        std::vector<cl_event> waits;
+        waits.reserve(wait_list.size());
+        for (size_t i = 0; i < wait_list.size(); i++) {
+            if (wait_list[i]) waits.push_back(static_cast<ClEvent*>(wait_list[i].get())->handle());
+        }
+        return waits;
+    }
+
+    AccelEvent migrate(AccelBuffer* buffer, cl_mem_migration_flags flags, const AccelWaitList& wait_list) {
+        std::vector<cl_event> waits = handles(wait_list);
+        cl_mem mem = static_cast<ClBuffer*>(buffer)->mem();
+        cl_event e;
+        cl_int err = clEnqueueMigrateMemObjects(queue_, 1, &mem, flags, (cl_uint)waits.size(),
+                                                waits.empty() ? NULL : waits.data(), &e);
+        if (err != CL_SUCCESS) { printf("clEnqueueMigrateMemObjects failed: %d\n", err); return AccelEvent(); }
+        return submitted(e);
+    }
+
+    AccelEvent submitted(cl_event e) {
+        clFlush(queue_);
+        return AccelEvent(new ClEvent(e));
+    }
+
+    cl_device_id device_;
+    cl_context context_;
+    cl_command_queue queue_;
+    cl_program program_;
+    std::map<std::string, ClKernel*> kernels_;
+};
+
+}  // namespace
+
+std::unique_ptr<AccelDevice> accel_open_opencl() {
+    std::unique_ptr<ClDevice> device(new ClDevice());
+    if (device->open() != CL_SUCCESS) return std::unique_ptr<AccelDevice>();
+    return std::unique_ptr<AccelDevice>(device.release());
+}
@@ -0,0 +1,12 @@
+#include <stdlib.h>
+#include <string.h>
+#include "accel_runtime.h"
+
+std::unique_ptr<AccelDevice> accel_open(AccelBackend backend) {
+    return backend == ACCEL_CPU ? accel_open_cpu() : accel_open_opencl();
+}
+
+AccelBackend accel_backend_from_env() {
+    const char* env = getenv("ACCEL_BACKEND");
+    return env && strcmp(env, "cpu") == 0 ? ACCEL_CPU : ACCEL_OPENCL;
+}
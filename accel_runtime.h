@@ -0,0 +1,114 @@
+#ifndef ACCEL_RUNTIME_H
+#define ACCEL_RUNTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+// One host interface to the kernels, whatever runs them.
+//
+// AccelDevice covers the flow every host program repeats: load the kernels, create buffers, set
+// arguments, enqueue transfers and kernel runs chained by events, and wait. Backends:
+//   opencl  the Alveo card through OpenCL/XRT (accel_opencl.cpp), or cl_mock.c with -DCL_MOCK
+//   cpu     the HLS kernel sources compiled natively and run on a pool of worker threads
+//           (accel_cpu.cpp), so a whole pipeline runs and profiles on a machine with no card
+//
+// Every buffer has a host mirror, host(), owned by the caller if passed in and by the buffer
+// otherwise. to_device() and to_host() move the whole mirror; write() and read() copy a range
+// from or to any host pointer. Commands run as soon as the events they wait on have completed,
+// in any order otherwise, like an out-of-order OpenCL queue. Kernel arguments are captured when
+// the run is enqueued, so a kernel can be re-armed for the next run straight away.
+//
+//   std::unique_ptr<AccelDevice> dev = accel_open(accel_backend_from_env());
+//   if (!dev || dev->load("parser.xclbin") != 0) ...
+//   AccelKernel* k = dev->kernel("parser_framed");          // 0 if not in the xclbin
+//   AccelBuffer* in = dev->buffer(capacity);
+//   k->set_arg(0, in);
+//   k->set_scalar(1, num_bytes);
+//   AccelEvent w = dev->write(in, chunk, num_bytes);
+//   AccelEvent r = dev->run(k, {w});
+//   dev->wait(dev->to_host(num_outputs, {r}));
+//
+// Enqueue calls return a null event on failure, after printing why.
+
+enum AccelBackend {
+    ACCEL_OPENCL,
+    ACCEL_CPU
+};
+
+// Buffer direction, as seen from the kernel; only the OpenCL backend uses it
+#define ACCEL_READ_ONLY   1
+#define ACCEL_WRITE_ONLY  2
+#define ACCEL_READ_WRITE  3
+
+class AccelBuffer {
+public:
+    virtual ~AccelBuffer() {}
+    void* host() const { return host_; }
+    size_t size() const { return size_; }
+
+protected:
+    AccelBuffer() : host_(0), size_(0) {}
+    void* host_;
+    size_t size_;
+};
+
+class AccelKernel {
+public:
+    virtual ~AccelKernel() {}
+    virtual int set_arg(int index, AccelBuffer* buffer) = 0;
+    virtual int set_scalar(int index, int32_t value) = 0;
+};
+
+class AccelEventState {
+public:
+    virtual ~AccelEventState() {}
+    virtual void wait() = 0;
+    // Time the command ran for, once it has completed
+    virtual double seconds() = 0;
+};
+
+typedef std::shared_ptr<AccelEventState> AccelEvent;
+typedef std::vector<AccelEvent> AccelWaitList;
+
+class AccelDevice {
+public:
+    virtual ~AccelDevice() {}
+    virtual const char* name() const = 0;
+
+    // Loads an xclbin. The cpu backend has its kernels linked in and ignores the path.
+    virtual int load(const char* xclbin_path) = 0;
+
+    // The device owns its kernels; returns 0 if the loaded program has no such kernel
+    virtual AccelKernel* kernel(const char* name) = 0;
+
+    // The caller owns buffers and deletes them after the commands using them have completed.
+    // host_ptr, if given, becomes the mirror and must be 4 KiB aligned for zero-copy DMA.
+    virtual AccelBuffer* buffer(size_t size, int access = ACCEL_READ_WRITE, void* host_ptr = 0) = 0;
+
+    virtual AccelEvent to_device(AccelBuffer* buffer, const AccelWaitList& wait_list = AccelWaitList()) = 0;
+    virtual AccelEvent to_host(AccelBuffer* buffer, const AccelWaitList& wait_list = AccelWaitList()) = 0;
+    virtual AccelEvent write(AccelBuffer* buffer, const void* src, size_t size, size_t offset = 0,
+                             const AccelWaitList& wait_list = AccelWaitList()) = 0;
+    virtual AccelEvent read(AccelBuffer* buffer, void* dst, size_t size, size_t offset = 0,
+                            const AccelWaitList& wait_list = AccelWaitList()) = 0;
+    virtual AccelEvent run(AccelKernel* kernel, const AccelWaitList& wait_list = AccelWaitList()) = 0;
+
+    void wait(const AccelEvent& event) { if (event) event->wait(); }
+    // Waits for every command enqueued so far
+    virtual void finish() = 0;
+};
+
+// Returns 0 if the backend cannot be opened (no card, no platform), after printing why
+std::unique_ptr<AccelDevice> accel_open_opencl();
+
+// num_threads 0 uses ACCEL_CPU_THREADS if set, else one per hardware thread
+std::unique_ptr<AccelDevice> accel_open_cpu(int num_threads = 0);
+
+std::unique_ptr<AccelDevice> accel_open(AccelBackend backend);
+
+// ACCEL_BACKEND=cpu selects the cpu backend; anything else, or unset, selects opencl
+AccelBackend accel_backend_from_env();
+
+#endif
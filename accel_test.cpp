@@ -0,0 +1,205 @@
+// Runs each kernel through accel_runtime.h and checks its results, on the card or on the CPU.
+// Kernels the loaded xclbin does not contain are skipped, so one binary covers
+// double_vector.xclbin, Archive/deserializer.xclbin and Archive/parser.xclbin; the cpu backend
+// has every kernel and runs them all. The last test enqueues several independent parser_framed
+// runs at once, which the cpu backend spreads over its worker threads.
+//
+// Build: g++ -O2 -pthread -I$XILINX_HLS/include -o accel_test accel_test.cpp accel_runtime.cpp
+//            accel_opencl.cpp accel_cpu.cpp double_vector.cpp parser_wide.cpp Archive/parser.cpp
+//            Archive/deserializer.cpp libitch.a -lOpenCL
+// Usage: ./accel_test <xclbin>                      (card)
+//        ACCEL_BACKEND=cpu ./accel_test <anything>  (no card)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "accel_runtime.h"
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+
+#define TEST_SIZE 1024
+
+// Concurrent parser_framed runs in the last test, and messages per run
+#define NUM_CHUNKS 8
+#define CHUNK_MESSAGES 20000
+
+static int test_double_vector(AccelDevice& dev, AccelKernel* kernel) {
+    AccelBuffer* input = dev.buffer(TEST_SIZE * sizeof(int), ACCEL_READ_ONLY);
+    AccelBuffer* output = dev.buffer(TEST_SIZE * sizeof(int), ACCEL_WRITE_ONLY);
+    int* in = (int*)input->host();
+    for (int i = 0; i < TEST_SIZE; i++) in[i] = i;
+
+    kernel->set_arg(0, input);
+    kernel->set_arg(1, output);
+    kernel->set_scalar(2, TEST_SIZE);
+    AccelEvent sent = dev.to_device(input);
+    AccelEvent ran = dev.run(kernel, {sent});
+    dev.wait(dev.to_host(output, {ran}));
+
+    int errors = 0;
+    const int* out = (const int*)output->host();
+    for (int i = 0; i < TEST_SIZE; i++) {
+        if (out[i] != 2 * in[i]) {
+            if (errors < 10) printf("double_vector: index %d expected %d, got %d\n", i, 2 * in[i], out[i]);
+            errors++;
+        }
+    }
+    printf("double_vector:   %d elements, %d errors, kernel %.1f us\n", TEST_SIZE, errors, ran->seconds() * 1e6);
+    delete input;
+    delete output;
+    return errors != 0;
+}
+
+static int test_deserialize(AccelDevice& dev, AccelKernel* kernel) {
+    std::vector<uint8_t> pattern(TEST_SIZE), result(TEST_SIZE);
+    for (int i = 0; i < TEST_SIZE; i++) pattern[i] = (uint8_t)(i % 256);
+    AccelBuffer* input = dev.buffer(TEST_SIZE, ACCEL_READ_ONLY);
+    AccelBuffer* output = dev.buffer(TEST_SIZE, ACCEL_WRITE_ONLY);
+
+    kernel->set_arg(0, input);
+    kernel->set_arg(1, output);
+    kernel->set_scalar(2, TEST_SIZE);
+    AccelEvent sent = dev.write(input, pattern.data(), TEST_SIZE);
+    AccelEvent ran = dev.run(kernel, {sent});
+    dev.wait(dev.read(output, result.data(), TEST_SIZE, 0, {ran}));
+
+    int errors = 0;
+    for (int i = 0; i < TEST_SIZE; i++) errors += result[i] != pattern[i];
+    printf("deserialize:     %d bytes, %d errors, kernel %.1f us\n", TEST_SIZE, errors, ran->seconds() * 1e6);
+    delete input;
+    delete output;
+    return errors != 0;
+}
+
+static int test_parser(AccelDevice& dev, AccelKernel* kernel) {
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < TEST_SIZE; i++) append_random_message(bytes);
+    std::vector<ByteData> serial = to_byte_data(bytes);
+    std::vector<ParserOutput> expected(TEST_SIZE);
+    size_t consumed = 0;
+    int num_expected = (int)itch_decode_packed(bytes.data(), bytes.size(), expected.data(), TEST_SIZE, &consumed);
+
+    AccelBuffer* input = dev.buffer(serial.size() * sizeof(ByteData), ACCEL_READ_ONLY, 0);
+    AccelBuffer* output = dev.buffer(TEST_SIZE * sizeof(ParserOutput), ACCEL_WRITE_ONLY);
+    AccelBuffer* num_outputs = dev.buffer(sizeof(int));
+    memcpy(input->host(), serial.data(), serial.size() * sizeof(ByteData));
+
+    kernel->set_arg(0, input);
+    kernel->set_scalar(1, (int32_t)serial.size());
+    kernel->set_arg(2, output);
+    kernel->set_arg(3, num_outputs);
+    AccelEvent sent = dev.to_device(input);
+    AccelEvent ran = dev.run(kernel, {sent});
+    AccelEvent counted = dev.to_host(num_outputs, {ran});
+    dev.wait(dev.to_host(output, {ran}));
+    dev.wait(counted);
+
+    int errors = compare_outputs("parser", (const ParserOutput*)output->host(), *(int*)num_outputs->host(),
+                                 expected.data(), num_expected);
+    printf("parser:          %d messages, %s, kernel %.1f us\n", num_expected, errors ? "mismatch" : "match",
+           ran->seconds() * 1e6);
+    delete input;
+    delete output;
+    delete num_outputs;
+    return errors;
+}
+
+// Independent chunks, each with its own buffers and runs, all enqueued before any is waited on
+static int test_parser_framed(AccelDevice& dev, AccelKernel* kernel) {
+    struct Chunk {
+        std::vector<uint8_t> framed;
+        std::vector<ParserOutput> expected;
+        int num_expected;
+        AccelBuffer *input, *output, *num_outputs;
+        AccelEvent ran, counted, read;
+    } chunks[NUM_CHUNKS];
+
+    size_t max_outputs = CHUNK_MESSAGES + 1;
+    for (int c = 0; c < NUM_CHUNKS; c++) {
+        Chunk& ch = chunks[c];
+        std::vector<uint8_t> bytes;
+        for (int i = 0; i < CHUNK_MESSAGES; i++) append_random_message(bytes);
+        ch.framed = to_framed(bytes, 100);
+        ch.expected.resize(max_outputs);
+        size_t consumed = 0;
+        ch.num_expected = (int)itch_decode_framed(ch.framed.data(), ch.framed.size(), ch.expected.data(),
+                                                  max_outputs, &consumed);
+        ch.input = dev.buffer(ch.framed.size() + 64, ACCEL_READ_ONLY);
+        ch.output = dev.buffer(max_outputs * sizeof(ParserOutput), ACCEL_WRITE_ONLY);
+        ch.num_outputs = dev.buffer(sizeof(int));
+    }
+
+    // One kernel object, re-armed per chunk: arguments are captured at enqueue
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int c = 0; c < NUM_CHUNKS; c++) {
+        Chunk& ch = chunks[c];
+        kernel->set_arg(0, ch.input);
+        kernel->set_scalar(1, (int32_t)ch.framed.size());
+        kernel->set_arg(2, ch.output);
+        kernel->set_arg(3, ch.num_outputs);
+        AccelEvent sent = dev.write(ch.input, ch.framed.data(), ch.framed.size());
+        ch.ran = dev.run(kernel, {sent});
+        ch.counted = dev.to_host(ch.num_outputs, {ch.ran});
+        ch.read = dev.to_host(ch.output, {ch.ran});
+    }
+    dev.finish();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int errors = 0;
+    double kernel_seconds = 0;
+    size_t bytes = 0;
+    for (int c = 0; c < NUM_CHUNKS; c++) {
+        Chunk& ch = chunks[c];
+        errors += compare_outputs("parser_framed", (const ParserOutput*)ch.output->host(),
+                                  *(int*)ch.num_outputs->host(), ch.expected.data(), ch.num_expected);
+        kernel_seconds += ch.ran->seconds();
+        bytes += ch.framed.size();
+        delete ch.input;
+        delete ch.output;
+        delete ch.num_outputs;
+    }
+    printf("parser_framed:   %d chunks of %d messages, %s, kernels %.1f ms summed, %.1f ms wall, %.1f MB/s\n",
+           NUM_CHUNKS, CHUNK_MESSAGES, errors ? "mismatch" : "match", kernel_seconds * 1e3, wall * 1e3,
+           bytes / wall / 1e6);
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("Usage: %s <xclbin>   (ACCEL_BACKEND=cpu runs the kernels on the CPU)\n", argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<AccelDevice> dev = accel_open(accel_backend_from_env());
+    if (!dev || dev->load(argv[1]) != 0) return 1;
+    printf("Backend: %s\n", dev->name());
+
+    struct {
+        const char* kernel;
+        int (*test)(AccelDevice&, AccelKernel*);
+    } tests[] = {
+        {"double_vector", test_double_vector},
+        {"deserialize", test_deserialize},
+        {"parser", test_parser},
+        {"parser_framed", test_parser_framed},
+    };
+
+    int errors = 0, ran = 0;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        AccelKernel* kernel = dev->kernel(tests[i].kernel);
+        if (!kernel) {
+            printf("%-16s not in %s, skipped\n", (std::string(tests[i].kernel) + ":").c_str(), argv[1]);
+            continue;
+        }
+        errors += tests[i].test(*dev, kernel);
+        ran++;
+    }
+
+    int ok = errors == 0 && ran > 0;
+    printf(ok ? "TEST PASSED\n" : "TEST FAILED\n");
+    return ok ? 0 : 1;
+}
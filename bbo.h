@@ -0,0 +1,74 @@
+#ifndef BBO_H
+#define BBO_H
+
+#include <stdint.h>
+
+// Top-of-book (best bid and offer) change records, and the book state the bbo_stage kernel keeps
+// in card memory. bbo_stage reads the parser's ParserOutput records, keeps a book per
+// stock_locate, and writes a BboUpdate only when a message moves the best price or the size at
+// the best price on either side. book_apply_bbo() (order_book.h) is the CPU equivalent.
+// bbo_stage.h has the kernel's on-chip state and its core loop.
+//
+// The kernel tracks the best BBO_DEPTH (64) price levels on each side of each stock. Its BboUpdate
+// records are exact only as long as no side of any stock has ever held more than 64 levels. A level that does not fit, either because
+// it is worse than a full window or because a better level pushed it out, is counted in
+// num_overflow. From then on the deeper part of that side may be understated, which shows in the
+// BBO only if every level above it empties. num_overflow also counts adds dropped because both
+// of the order's buckets were full.
+// Layout must match between host and kernel.
+
+#define BBO_DEPTH   64
+#define BBO_STOCKS  65536
+
+// Sides of BboUpdate.changed
+#define BBO_BID     0x01
+#define BBO_ASK     0x02
+
+// One change of a stock's top of book: both sides as they stand after the message, 32 bytes, two
+// to a 512-bit beat. An empty side has price and shares 0.
+typedef struct {
+    uint64_t timestamp;      // of the message that changed the BBO
+    uint32_t bid_price;
+    uint32_t bid_shares;     // saturates at 0xFFFFFFFF
+    uint32_t ask_price;
+    uint32_t ask_shares;
+    uint16_t stock_locate;
+    uint8_t  changed;        // BBO_BID and/or BBO_ASK
+    uint8_t  reserved;
+    uint32_t msg_index;      // position of that message in the input
+} BboUpdate;
+
+// Order table: d-left hashing over two tables of 1 << order_bits buckets each, which the host sizes
+// for at most half load. An order lives in one of its two buckets, one per table, and goes into
+// the emptier one (the left one on a tie), so a lookup is always one bucket read per table and
+// nothing is ever moved. A bucket is one 512-bit beat of BBO_BUCKET_SLOTS orders; order_ref_no 0
+// marks an empty slot.
+#define BBO_BUCKET_SLOTS 3
+
+typedef struct {
+    uint64_t order_ref_no[BBO_BUCKET_SLOTS];
+    uint32_t shares[BBO_BUCKET_SLOTS];
+    uint32_t price[BBO_BUCKET_SLOTS];
+    uint16_t stock_locate[BBO_BUCKET_SLOTS];
+    uint8_t  buy_sell[BBO_BUCKET_SLOTS];
+    uint8_t  reserved[7];
+} BboBucket;
+
+// One aggregated price level. Each stock and side owns BBO_DEPTH consecutive entries, best first,
+// at index (stock_locate * 2 + side) * BBO_DEPTH with side 0 for bids and 1 for asks; its depth
+// entry says how many are in use. The kernel keeps the windows it is using on chip, and card
+// memory holds only the ones it has evicted.
+typedef struct {
+    uint32_t price;
+    uint32_t num_orders;
+    uint64_t shares;
+} BboLevel;
+
+#define BBO_LEVEL_ENTRIES  (BBO_STOCKS * 2 * BBO_DEPTH)
+#define BBO_DEPTH_ENTRIES  (BBO_STOCKS * 2)
+
+static inline uint32_t bbo_shares(uint64_t shares) {
+    return shares > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)shares;
+}
+
+#endif
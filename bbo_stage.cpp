@@ -0,0 +1,63 @@
+#include <stdint.h>
+#include "itch.h"
+#include "bbo.h"
+#include "bbo_stage.h"
+
+// Top-of-book stage that sits after the parser: reads its ParserOutput records and writes a
+// BboUpdate only for the messages that move a stock's best bid or offer (see bbo.h).
+//
+// Per message, the stage touches one or two order table buckets and one side of one stock. The
+// window of that side is on chip as long as the side is in the window cache (bbo_stage_core in
+// bbo_stage.h), and the loop is then designed to take one step per message, two for U; no
+// synthesis report backs that II yet. The top of book before
+// and after the message are both in the window, so no last-published BBO has to be stored.
+// The on-chip state is a static, so it stays from one call to the next along with the order
+// tables and evicted windows in card memory; a call with reset set clears it, and the host zeroes
+// the card memory at the same time.
+
+extern "C" {
+void bbo_stage(
+    // Input: parser output records, as parser() and parser_framed write them
+    const ParserOutput* input_stream,
+    int num_inputs,
+
+    // Output: top-of-book changes
+    BboUpdate* output_stream,
+    int* num_outputs,
+
+    // Book state in card memory, carried from one call to the next
+    BboBucket* orders_left,     // 1 << order_bits buckets each
+    BboBucket* orders_right,
+    int order_bits,
+    BboLevel* levels,           // BBO_LEVEL_ENTRIES entries
+    uint16_t* depths,           // BBO_DEPTH_ENTRIES entries
+
+    // Levels that did not fit in a side's window, and adds with no free slot (see bbo.h)
+    int* num_overflow,
+
+    // Clear the on-chip state before the first message
+    int reset
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_overflow bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE m_axi port=orders_left bundle=gmem3 offset=slave
+    #pragma HLS INTERFACE m_axi port=orders_right bundle=gmem5 offset=slave
+    #pragma HLS INTERFACE m_axi port=levels bundle=gmem4 offset=slave
+    #pragma HLS INTERFACE m_axi port=depths bundle=gmem4 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_inputs
+    #pragma HLS INTERFACE s_axilite port=order_bits
+    #pragma HLS INTERFACE s_axilite port=reset
+    #pragma HLS INTERFACE s_axilite port=return
+
+    static BboChip chip;
+    #pragma HLS ARRAY_PARTITION variable=chip.level complete dim=2
+    #pragma HLS BIND_STORAGE variable=chip.level type=ram_2p impl=uram
+    #pragma HLS ARRAY_PARTITION variable=chip.forward complete dim=0
+    #pragma HLS ARRAY_PARTITION variable=chip.recent complete dim=0
+
+    bbo_stage_core(chip, input_stream, num_inputs, output_stream, num_outputs, orders_left, orders_right,
+                   order_bits, levels, depths, num_overflow, reset);
+}
+}
@@ -0,0 +1,531 @@
+#ifndef BBO_STAGE_H
+#define BBO_STAGE_H
+
+#include <stdint.h>
+#include "itch.h"
+#include "bbo.h"
+
+// Core of the top-of-book stage (bbo_stage.cpp), kept in a header so the testbench can run it
+// with its on-chip state and read the modelled cycle count, as parser_wide_tb does with
+// parse_wide_core.
+//
+// The STEPS loop is pipelined at II=1. Everything a message needs is on chip or one fixed read
+// away, and nothing is searched:
+//  - Window cache: the level windows of BBO_CACHE_SIDES sides, direct-mapped by side, so each side
+//    of the first BBO_CACHE_SIDES / 2 stock_locates has a line of its own. A message whose side is
+//    cached works on its window in place. On a miss the loop writes the line's window back to
+//    card memory and reads the side's window in, one level per step.
+//  - The best level of every side of every stock, so the other side of a record is never read
+//    from card memory.
+//  - Order table (bbo.h): one bucket read per table, at an address that depends only on the
+//    message, so reads are issued back to back. A U message takes two steps: one for the order it
+//    replaces, one for the new order.
+// Writes still in flight are forwarded: order buckets from a ring of the last BBO_FORWARD writes
+// per table, and windows and best levels from the last BBO_RECENT windows written. In C-sim the
+// writes only reach the tables and the window cache when they leave their ring, as late as the
+// hardware may see them land, so the testbench checks the forwarding.
+//
+// Returns a modelled cycle count for C-sim benchmarking: one cycle per step, plus BBO_MEM_LATENCY
+// per window miss for the first level to arrive. Input is read in bursts ahead of the loop, at
+// 64 bytes per cycle, so the count is never below the input beats. It is a model, not an achieved
+// rate. No synthesis or board run has checked the three things it rests on: that the window cache
+// fits in 16 MB of URAM; that the DEPENDENCE inter false pragmas are safe, because forwarding from
+// the last BBO_RECENT (2) windows covers a window's read-to-write distance; and that the C-sim
+// write delay (the !__SYNTHESIS__ branches) matches when the hardware's writes land.
+
+#define BBO_CACHE_BITS   14                    // 16384 sides: 16 MB of windows, in URAM
+#define BBO_CACHE_SIDES  (1 << BBO_CACHE_BITS)
+#define BBO_MEM_LATENCY  64                    // cycles from a card memory read to its data
+#define BBO_FORWARD      (2 * BBO_MEM_LATENCY) // bucket writes per table that may be in flight
+#define BBO_RECENT       2                     // steps from reading a window to writing it back
+
+// One side of one stock, in registers while a message is applied
+struct SideWindow {
+    BboLevel level[BBO_DEPTH];
+    int depth;
+    bool sell;
+};
+
+// Bucket writes that may not have landed yet, oldest at head
+struct BboForward {
+    uint32_t index[BBO_FORWARD];
+    BboBucket bucket[BBO_FORWARD];
+    bool valid[BBO_FORWARD];
+    int head;
+};
+
+// Windows written by the last BBO_RECENT steps, oldest at head
+struct BboRecent {
+    uint32_t side[BBO_RECENT];   // side + 1, 0 when empty
+    SideWindow window[BBO_RECENT];
+    int head;
+};
+
+// All on-chip state, kept from one call to the next
+struct BboChip {
+    BboLevel level[BBO_CACHE_SIDES][BBO_DEPTH];
+    uint16_t depth[BBO_CACHE_SIDES];
+    uint32_t tag[BBO_CACHE_SIDES];          // side + 1, 0 when the line is empty
+    uint32_t best_price[BBO_DEPTH_ENTRIES];
+    uint32_t best_shares[BBO_DEPTH_ENTRIES];
+    BboForward forward[2];                  // left and right order table
+    BboRecent recent;
+};
+
+static inline uint32_t bbo_bucket_left(uint64_t order_ref_no, int order_bits) {
+    #pragma HLS INLINE
+    return (uint32_t)((order_ref_no * 0x9E3779B97F4A7C15ULL) >> (64 - order_bits));
+}
+
+static inline uint32_t bbo_bucket_right(uint64_t order_ref_no, int order_bits) {
+    #pragma HLS INLINE
+    uint64_t h = (order_ref_no ^ (order_ref_no >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return (uint32_t)(h >> (64 - order_bits));
+}
+
+static inline uint32_t bbo_line(uint32_t side) {
+    #pragma HLS INLINE
+    return side & (BBO_CACHE_SIDES - 1);
+}
+
+// Bucket i of one order table, with any write to it still in the ring
+static BboBucket bbo_read_bucket(const BboBucket* table, const BboForward& ring, uint32_t i) {
+    #pragma HLS INLINE
+    BboBucket b = table[i];
+    FORWARD: for (int k = 0; k < BBO_FORWARD; k++) {
+        #pragma HLS UNROLL
+        int e = (ring.head + k) % BBO_FORWARD;   // oldest first, so the newest write wins
+        if (ring.valid[e] && ring.index[e] == i) b = ring.bucket[e];
+    }
+    return b;
+}
+
+static void bbo_write_bucket(BboBucket* table, BboForward& ring, uint32_t i, const BboBucket& b) {
+    #pragma HLS INLINE
+#ifdef __SYNTHESIS__
+    table[i] = b;
+#else
+    if (ring.valid[ring.head]) table[ring.index[ring.head]] = ring.bucket[ring.head];
+#endif
+    ring.index[ring.head] = i;
+    ring.bucket[ring.head] = b;
+    ring.valid[ring.head] = true;
+    ring.head = (ring.head + 1) % BBO_FORWARD;
+}
+
+static void bbo_flush_buckets(BboBucket* table, BboForward& ring) {
+    FLUSH: for (int k = 0; k < BBO_FORWARD; k++) {
+        int e = (ring.head + k) % BBO_FORWARD;
+#ifndef __SYNTHESIS__
+        if (ring.valid[e]) table[ring.index[e]] = ring.bucket[e];
+#endif
+        ring.valid[e] = false;
+    }
+}
+
+// The level at `price` is before position i if it is strictly better
+static bool better(const SideWindow& w, uint32_t a, uint32_t b) {
+    #pragma HLS INLINE
+    return w.sell ? a < b : a > b;
+}
+
+static int find_pos(const SideWindow& w, uint32_t price) {
+    int pos = w.depth;
+    FIND: for (int i = BBO_DEPTH - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (i < w.depth && !better(w, w.level[i].price, price)) pos = i;
+    }
+    return pos;
+}
+
+// Adds an order's shares to its level, creating the level if needed. Returns 1 if a level fell
+// out of the window or never got in.
+static int window_add(SideWindow& w, uint32_t price, uint32_t shares) {
+    int pos = find_pos(w, price);
+    if (pos < w.depth && w.level[pos].price == price) {
+        w.level[pos].num_orders++;
+        w.level[pos].shares += shares;
+        return 0;
+    }
+    if (pos == BBO_DEPTH) return 1;
+    int overflow = w.depth == BBO_DEPTH;
+    SHIFT_DOWN: for (int i = BBO_DEPTH - 1; i > 0; i--) {
+        #pragma HLS UNROLL
+        if (i > pos) w.level[i] = w.level[i - 1];
+    }
+    w.level[pos].price = price;
+    w.level[pos].num_orders = 1;
+    w.level[pos].shares = shares;
+    if (!overflow) w.depth++;
+    return overflow;
+}
+
+// Takes shares off an order's level, and the order itself if `removed`. Orders at a level outside
+// the window change nothing.
+static void window_reduce(SideWindow& w, uint32_t price, uint32_t shares, bool removed) {
+    int pos = find_pos(w, price);
+    if (pos == w.depth || w.level[pos].price != price) return;
+    w.level[pos].shares -= shares;
+    if (!removed || --w.level[pos].num_orders != 0) return;
+    SHIFT_UP: for (int i = 0; i < BBO_DEPTH - 1; i++) {
+        #pragma HLS UNROLL
+        if (i >= pos) w.level[i] = w.level[i + 1];
+    }
+    w.depth--;
+}
+
+static void best_of(const SideWindow& w, uint32_t* price, uint32_t* shares) {
+    #pragma HLS INLINE
+    *price = w.depth ? w.level[0].price : 0;
+    *shares = w.depth ? bbo_shares(w.level[0].shares) : 0;
+}
+
+static void bbo_commit_window(BboChip& chip, uint32_t side, const SideWindow& w) {
+    #pragma HLS INLINE
+    uint32_t line = bbo_line(side);
+    COMMIT: for (int i = 0; i < BBO_DEPTH; i++) {
+        #pragma HLS UNROLL
+        chip.level[line][i] = w.level[i];
+    }
+    chip.depth[line] = (uint16_t)w.depth;
+    best_of(w, &chip.best_price[side], &chip.best_shares[side]);
+}
+
+// A cached side's window, with its last write if that is still in flight
+static void bbo_read_window(const BboChip& chip, uint32_t side, SideWindow& w) {
+    #pragma HLS INLINE
+    uint32_t line = bbo_line(side);
+    READ: for (int i = 0; i < BBO_DEPTH; i++) {
+        #pragma HLS UNROLL
+        w.level[i] = chip.level[line][i];
+    }
+    w.depth = chip.depth[line];
+    w.sell = side & 1;
+    RECENT: for (int k = 0; k < BBO_RECENT; k++) {
+        #pragma HLS UNROLL
+        int e = (chip.recent.head + k) % BBO_RECENT;
+        if (chip.recent.side[e] == side + 1) w = chip.recent.window[e];
+    }
+}
+
+static void bbo_write_window(BboChip& chip, uint32_t side, const SideWindow& w) {
+    #pragma HLS INLINE
+    BboRecent& r = chip.recent;
+#ifdef __SYNTHESIS__
+    bbo_commit_window(chip, side, w);
+#else
+    if (r.side[r.head]) bbo_commit_window(chip, r.side[r.head] - 1, r.window[r.head]);
+#endif
+    r.side[r.head] = side + 1;
+    r.window[r.head] = w;
+    r.head = (r.head + 1) % BBO_RECENT;
+}
+
+static void bbo_flush_windows(BboChip& chip) {
+    FLUSH: for (int k = 0; k < BBO_RECENT; k++) {
+        BboRecent& r = chip.recent;
+        int e = (r.head + k) % BBO_RECENT;
+#ifndef __SYNTHESIS__
+        if (r.side[e]) bbo_commit_window(chip, r.side[e] - 1, r.window[e]);
+#endif
+        r.side[e] = 0;
+    }
+}
+
+// Best level of any side, cached or not
+static void bbo_read_best(const BboChip& chip, uint32_t side, uint32_t* price, uint32_t* shares) {
+    #pragma HLS INLINE
+    *price = chip.best_price[side];
+    *shares = chip.best_shares[side];
+    RECENT: for (int k = 0; k < BBO_RECENT; k++) {
+        #pragma HLS UNROLL
+        int e = (chip.recent.head + k) % BBO_RECENT;
+        if (chip.recent.side[e] == side + 1) best_of(chip.recent.window[e], price, shares);
+    }
+}
+
+// Where an order sits: table 0 (left) or 1 (right) and the slot, or table -1
+struct BboSlot {
+    int table;
+    int slot;
+};
+
+static BboSlot bbo_find(const BboBucket& left, const BboBucket& right, uint64_t order_ref_no) {
+    #pragma HLS INLINE
+    BboSlot s = {-1, 0};
+    FIND_SLOT: for (int i = BBO_BUCKET_SLOTS - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (right.order_ref_no[i] == order_ref_no) s.table = 1, s.slot = i;
+    }
+    FIND_LEFT: for (int i = BBO_BUCKET_SLOTS - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (left.order_ref_no[i] == order_ref_no) s.table = 0, s.slot = i;
+    }
+    return s;
+}
+
+// Free slot for a new order in the emptier of its buckets, the left one on a tie, or table -1
+static BboSlot bbo_free(const BboBucket& left, const BboBucket& right) {
+    #pragma HLS INLINE
+    int free_left = 0, free_right = 0, first_left = 0, first_right = 0;
+    FREE: for (int i = BBO_BUCKET_SLOTS - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (left.order_ref_no[i] == 0) free_left++, first_left = i;
+        if (right.order_ref_no[i] == 0) free_right++, first_right = i;
+    }
+    BboSlot s = {-1, 0};
+    if (free_left && free_left >= free_right) s.table = 0, s.slot = first_left;
+    else if (free_right) s.table = 1, s.slot = first_right;
+    return s;
+}
+
+// Window transfer in progress after a miss
+enum BboMove { MOVE_NONE, MOVE_EVICT, MOVE_FILL };
+
+static int bbo_stage_core(
+    BboChip& chip,
+    const ParserOutput* input_stream,
+    int num_inputs,
+    BboUpdate* output_stream,
+    int* num_outputs,
+    BboBucket* orders_left,
+    BboBucket* orders_right,
+    int order_bits,
+    BboLevel* levels,
+    uint16_t* depths,
+    int* num_overflow,
+    int reset,
+    int* num_misses = 0
+) {
+    if (reset) {
+        RESET_LINES: for (int i = 0; i < BBO_CACHE_SIDES; i++) {
+            #pragma HLS PIPELINE II=1
+            chip.tag[i] = 0;
+            chip.depth[i] = 0;
+        }
+        RESET_BEST: for (int i = 0; i < BBO_DEPTH_ENTRIES; i++) {
+            #pragma HLS PIPELINE II=1
+            chip.best_price[i] = 0;
+            chip.best_shares[i] = 0;
+        }
+        RESET_RINGS: for (int k = 0; k < BBO_FORWARD; k++) {
+            chip.forward[0].valid[k] = false;
+            chip.forward[1].valid[k] = false;
+        }
+        chip.forward[0].head = chip.forward[1].head = 0;
+        RESET_RECENT: for (int k = 0; k < BBO_RECENT; k++) chip.recent.side[k] = 0;
+        chip.recent.head = 0;
+    }
+
+    int count = 0;
+    int overflow = 0;
+    int misses = 0;
+    int cycles = 0;
+
+    // Miss handling: the evicted side and the side coming in, and the next level to move
+    BboMove move = MOVE_NONE;
+    uint32_t move_line = 0, evict_side = 0, fill_side = 0;
+    int move_pos = 0, move_depth = 0;
+
+    // Between the two steps of a U: the replaced order's side and that side's best before it
+    bool replacing = false;
+    BboBucket held;   // the replaced order, as it was
+    int held_slot = 0;
+    uint32_t held_price0 = 0, held_shares0 = 0;
+
+    int m = 0;
+    STEPS: while (m < num_inputs) {
+        #pragma HLS PIPELINE II=1
+        #pragma HLS DEPENDENCE variable=orders_left inter false
+        #pragma HLS DEPENDENCE variable=orders_right inter false
+        #pragma HLS DEPENDENCE variable=chip.level inter false
+        #pragma HLS DEPENDENCE variable=chip.depth inter false
+        #pragma HLS DEPENDENCE variable=chip.best_price inter false
+        #pragma HLS DEPENDENCE variable=chip.best_shares inter false
+        cycles++;
+
+        // One level of a window transfer per step
+        if (move == MOVE_EVICT) {
+            if (move_pos < move_depth) levels[evict_side * BBO_DEPTH + move_pos] = chip.level[move_line][move_pos];
+            if (++move_pos >= move_depth) {
+                depths[evict_side] = (uint16_t)move_depth;
+                move = MOVE_FILL;
+                move_pos = 0;
+                move_depth = depths[fill_side];
+            }
+            continue;
+        }
+        if (move == MOVE_FILL) {
+            if (move_pos < move_depth) chip.level[move_line][move_pos] = levels[fill_side * BBO_DEPTH + move_pos];
+            if (++move_pos >= move_depth) {
+                chip.tag[move_line] = fill_side + 1;
+                chip.depth[move_line] = (uint16_t)move_depth;
+                move = MOVE_NONE;
+            }
+            continue;
+        }
+
+        ParserOutput msg = input_stream[m];
+        bool add = msg.msg_type == ITCH_ADD_ORDER || msg.msg_type == ITCH_ADD_ORDER_MPID;
+        bool update = msg.msg_type == ITCH_ORDER_EXECUTED || msg.msg_type == ITCH_ORDER_CANCEL ||
+                      msg.msg_type == ITCH_ORDER_DELETE || msg.msg_type == ITCH_ORDER_REPLACE;
+        if (!msg.valid_msg || msg.order_ref_no == 0 || (!add && !update) ||
+            (add && msg.buy_sell != 'B' && msg.buy_sell != 'S')) {
+            m++;
+            continue;
+        }
+
+        // The second step of a U adds the new order; the first has removed the old one
+        bool second = replacing;
+        uint64_t ref = second ? msg.new_order_ref_no : msg.order_ref_no;
+        uint32_t bl = bbo_bucket_left(ref, order_bits);
+        uint32_t br = bbo_bucket_right(ref, order_bits);
+        BboBucket left = bbo_read_bucket(orders_left, chip.forward[0], bl);
+        BboBucket right = bbo_read_bucket(orders_right, chip.forward[1], br);
+        BboSlot found = bbo_find(left, right, ref);
+
+        // The order the message is about: new for an add, from the table for the rest
+        uint16_t stock_locate;
+        uint8_t buy_sell;
+        if (second) {
+            stock_locate = held.stock_locate[held_slot];
+            buy_sell = held.buy_sell[held_slot];
+        } else if (add) {
+            stock_locate = msg.stock_locate;
+            buy_sell = msg.buy_sell;
+        } else {
+            if (found.table < 0) {
+                m++;
+                continue;
+            }
+            const BboBucket& b = found.table ? right : left;
+            stock_locate = b.stock_locate[found.slot];
+            buy_sell = b.buy_sell[found.slot];
+        }
+
+        uint32_t side = (uint32_t)stock_locate * 2 + (buy_sell == 'S');
+        uint32_t line = bbo_line(side);
+        if (chip.tag[line] != side + 1) {
+            // Miss: drain, then write the line back and read the side in; this message is retried
+            bbo_flush_windows(chip);
+            misses++;
+            move_line = line;
+            fill_side = side;
+            move_pos = 0;
+            cycles += BBO_MEM_LATENCY;
+            if (chip.tag[line]) {
+                move = MOVE_EVICT;
+                evict_side = chip.tag[line] - 1;
+                move_depth = chip.depth[line];
+            } else {
+                move = MOVE_FILL;
+                move_depth = depths[fill_side];
+            }
+            continue;
+        }
+
+        SideWindow w;
+        bbo_read_window(chip, side, w);
+        uint32_t price0, shares0, price1, shares1;
+        best_of(w, &price0, &shares0);
+        bool done = true;
+
+        if (second) {
+            // U, new order: same stock and side as the one it replaces
+            price0 = held_price0;
+            shares0 = held_shares0;
+            replacing = false;
+            BboSlot free = bbo_free(left, right);
+            if (found.table >= 0) {
+                // Already live: nothing to add
+            } else if (free.table < 0) {
+                overflow++;
+            } else {
+                BboBucket& b = free.table ? right : left;
+                b.order_ref_no[free.slot] = ref;
+                b.shares[free.slot] = msg.shares;
+                b.price[free.slot] = msg.price;
+                b.stock_locate[free.slot] = stock_locate;
+                b.buy_sell[free.slot] = buy_sell;
+                if (free.table) bbo_write_bucket(orders_right, chip.forward[1], br, right);
+                else bbo_write_bucket(orders_left, chip.forward[0], bl, left);
+                overflow += window_add(w, msg.price, msg.shares);
+            }
+        } else if (add) {
+            BboSlot free = bbo_free(left, right);
+            if (found.table >= 0) {
+                // Duplicate add: ignored
+            } else if (free.table < 0) {
+                overflow++;
+            } else {
+                BboBucket& b = free.table ? right : left;
+                b.order_ref_no[free.slot] = ref;
+                b.shares[free.slot] = msg.shares;
+                b.price[free.slot] = msg.price;
+                b.stock_locate[free.slot] = stock_locate;
+                b.buy_sell[free.slot] = buy_sell;
+                if (free.table) bbo_write_bucket(orders_right, chip.forward[1], br, right);
+                else bbo_write_bucket(orders_left, chip.forward[0], bl, left);
+                overflow += window_add(w, msg.price, msg.shares);
+            }
+        } else {
+            BboBucket& b = found.table ? right : left;
+            uint32_t price = b.price[found.slot];
+            uint32_t shares = b.shares[found.slot];
+            bool removed = msg.msg_type == ITCH_ORDER_DELETE || msg.msg_type == ITCH_ORDER_REPLACE ||
+                           msg.shares >= shares;
+            if (msg.msg_type == ITCH_ORDER_REPLACE) {
+                held = b;
+                held_slot = found.slot;
+            }
+            window_reduce(w, price, removed ? shares : msg.shares, removed);
+            if (removed) b.order_ref_no[found.slot] = 0;
+            else b.shares[found.slot] = shares - msg.shares;
+            if (found.table) bbo_write_bucket(orders_right, chip.forward[1], br, right);
+            else bbo_write_bucket(orders_left, chip.forward[0], bl, left);
+            if (msg.msg_type == ITCH_ORDER_REPLACE && msg.new_order_ref_no != 0) {
+                // The new order goes in on the next step, against the best before the old one left
+                replacing = true;
+                done = false;
+                held_price0 = price0;
+                held_shares0 = shares0;
+            }
+        }
+
+        bbo_write_window(chip, side, w);
+        if (!done) continue;
+        m++;
+        best_of(w, &price1, &shares1);
+        if (price0 == price1 && shares0 == shares1) continue;
+
+        // The other side's best level, unchanged, completes the record
+        uint32_t other_price, other_shares;
+        bbo_read_best(chip, side ^ 1, &other_price, &other_shares);
+        bool sell = side & 1;
+        BboUpdate u;
+        u.timestamp = msg.timestamp;
+        u.bid_price = sell ? other_price : price1;
+        u.bid_shares = sell ? other_shares : shares1;
+        u.ask_price = sell ? price1 : other_price;
+        u.ask_shares = sell ? shares1 : other_shares;
+        u.stock_locate = stock_locate;
+        u.changed = sell ? BBO_ASK : BBO_BID;
+        u.reserved = 0;
+        u.msg_index = (uint32_t)(m - 1);
+        output_stream[count++] = u;
+    }
+
+    bbo_flush_buckets(orders_left, chip.forward[0]);
+    bbo_flush_buckets(orders_right, chip.forward[1]);
+    bbo_flush_windows(chip);
+
+    int input_beats = (int)(((int64_t)num_inputs * sizeof(ParserOutput) + 63) / 64);
+    if (cycles < input_beats) cycles = input_beats;
+
+    *num_outputs = count;
+    *num_overflow = overflow;
+    if (num_misses) *num_misses = misses;
+    return cycles;
+}
+
+#endif
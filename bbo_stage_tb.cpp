@@ -0,0 +1,169 @@
+// C-simulation testbench for the top-of-book stage (bbo_stage) against its CPU equivalent
+// (book_apply_bbo), and a measure of how much it cuts the message volume downstream.
+//
+// A book-coherent feed (itch_testgen.h, about 1M resting orders over 8000 stocks by default) is
+// decoded in batches, as parser_framed would write it, and every batch goes through the kernel and
+// through an OrderBook. The kernel's book state stays in its buffers from one call to the next.
+// One message in 64 is sent a second time, so duplicate adds and updates for orders already gone
+// are covered too. Both must emit exactly the same BboUpdate records.
+// Reported after the warm-up: messages in, BBO changes out, the share of each message type that
+// moves a BBO, and the bytes a consumer reads either way. The kernel's core (bbo_stage.h) is run
+// directly for its modelled cycle count, which gives cycles per message, window cache misses, and
+// the message rate at 300 MHz. These are modelled figures, not achieved ones (see bbo_stage.h for
+// what the model assumes).
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -o bbo_stage_tb bbo_stage_tb.cpp itch_decoder.cpp order_book.cpp
+// Usage: ./bbo_stage_tb [million messages, default 2] [resting orders, default 1000000] [stocks, default 8000]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "bbo.h"
+#include "bbo_stage.h"
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+#include "order_book.h"
+
+static_assert(sizeof(BboBucket) == 64, "a bucket is one 512-bit beat");
+
+// Messages generated and passed to the kernel per call
+#define BATCH_MESSAGES 65536
+
+#define MODEL_MHZ 300.0
+
+struct TypeCount {
+    const char* name;
+    uint8_t types[2];
+    size_t messages, changes;
+};
+
+// Decodes the next batch of the feed, with every 64th message repeated
+static size_t next_batch(BookFeed& feed, std::vector<uint8_t>& bytes, std::vector<ParserOutput>& outputs) {
+    bytes.clear();
+    for (int i = 0; i < BATCH_MESSAGES; i++) {
+        size_t start = bytes.size();
+        append_book_message(feed, bytes);
+        if (next_rand() % 64 == 0) bytes.insert(bytes.end(), bytes.begin() + start, bytes.end());
+    }
+    std::vector<uint8_t> framed = to_framed(bytes, 0);
+    outputs.resize(2 * BATCH_MESSAGES);
+    size_t consumed = 0;
+    return itch_decode_framed(framed.data(), framed.size(), outputs.data(), outputs.size(), &consumed);
+}
+
+static bool same_update(const BboUpdate& a, const BboUpdate& b) {
+    return a.timestamp == b.timestamp && a.bid_price == b.bid_price && a.bid_shares == b.bid_shares &&
+           a.ask_price == b.ask_price && a.ask_shares == b.ask_shares && a.stock_locate == b.stock_locate &&
+           a.changed == b.changed && a.msg_index == b.msg_index;
+}
+
+static void print_update(const char* who, const BboUpdate& u) {
+    printf("    %s: msg %u stock %u changed %u bid %u x %u ask %u x %u ts %llu\n", who, u.msg_index,
+           u.stock_locate, u.changed, u.bid_price, u.bid_shares, u.ask_price, u.ask_shares,
+           (unsigned long long)u.timestamp);
+}
+
+int main(int argc, char** argv) {
+    double millions = argc > 1 ? atof(argv[1]) : 2;
+    size_t resting = argc > 2 ? (size_t)atol(argv[2]) : 1000000;
+    int num_stocks = argc > 3 ? atoi(argv[3]) : 8000;
+    if (millions <= 0 || resting < 1 || num_stocks < 1 || num_stocks > 65535) {
+        printf("Usage: %s [million messages] [resting orders] [stocks, at most 65535]\n", argv[0]);
+        return 1;
+    }
+    size_t num_messages = (size_t)(millions * 1e6);
+
+    // Kernel state: order tables at no more than half load, the level windows, and the on-chip state
+    int order_bits = 4;
+    while (((size_t)2 * BBO_BUCKET_SLOTS << order_bits) < 2 * (resting + resting / 4)) order_bits++;
+    std::vector<BboBucket> left((size_t)1 << order_bits), right((size_t)1 << order_bits);
+    std::vector<BboLevel> levels(BBO_LEVEL_ENTRIES);
+    std::vector<uint16_t> depths(BBO_DEPTH_ENTRIES);
+    memset(left.data(), 0, left.size() * sizeof(BboBucket));
+    memset(right.data(), 0, right.size() * sizeof(BboBucket));
+    memset(levels.data(), 0, levels.size() * sizeof(BboLevel));
+    BboChip* chip = new BboChip;
+
+    OrderBook book(resting + resting / 4);
+    BookFeed feed;
+    book_feed_init(feed, num_stocks, resting);
+    std::vector<uint8_t> bytes;
+    std::vector<ParserOutput> msgs;
+    std::vector<BboUpdate> hw(2 * BATCH_MESSAGES), sw(2 * BATCH_MESSAGES);
+
+    TypeCount counts[] = {
+        {"add A/F",   {ITCH_ADD_ORDER, ITCH_ADD_ORDER_MPID}, 0, 0},
+        {"execute E", {ITCH_ORDER_EXECUTED, ITCH_ORDER_EXECUTED}, 0, 0},
+        {"cancel X",  {ITCH_ORDER_CANCEL, ITCH_ORDER_CANCEL}, 0, 0},
+        {"delete D",  {ITCH_ORDER_DELETE, ITCH_ORDER_DELETE}, 0, 0},
+        {"replace U", {ITCH_ORDER_REPLACE, ITCH_ORDER_REPLACE}, 0, 0},
+    };
+    TypeCount* by_type[256] = {0};
+    for (TypeCount& c : counts) by_type[c.types[0]] = by_type[c.types[1]] = &c;
+
+    int errors = 0, overflow = 0;
+    size_t done = 0, changes = 0, hw_total = 0, misses = 0;
+    uint64_t cycles = 0;
+    bool warm = false, first = true;
+    while (done < num_messages) {
+        size_t n = next_batch(feed, bytes, msgs);
+        int hw_count = 0, hw_overflow = 0, hw_misses = 0;
+        int hw_cycles = bbo_stage_core(*chip, msgs.data(), (int)n, hw.data(), &hw_count, left.data(), right.data(),
+                                       order_bits, levels.data(), depths.data(), &hw_overflow, first, &hw_misses);
+        first = false;
+        size_t sw_count = book_apply_bbo_batch(book, msgs.data(), n, sw.data());
+        overflow += hw_overflow;
+        hw_total += hw_count;
+
+        if ((size_t)hw_count != sw_count) {
+            if (errors < 10) printf("  batch: kernel wrote %d updates, CPU %zu\n", hw_count, sw_count);
+            errors++;
+        }
+        for (size_t i = 0; i < sw_count && i < (size_t)hw_count; i++) {
+            if (same_update(hw[i], sw[i])) continue;
+            if (errors < 10) {
+                printf("  update %zu differs\n", i);
+                print_update("kernel", hw[i]);
+                print_update("cpu   ", sw[i]);
+            }
+            errors++;
+            break;
+        }
+
+        // Measure once the book has filled up to its resting size
+        if (!warm) {
+            warm = feed.live.size() >= resting;
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) by_type[msgs[i].msg_type]->messages++;
+        for (size_t i = 0; i < sw_count; i++) by_type[msgs[sw[i].msg_index].msg_type]->changes++;
+        done += n;
+        changes += sw_count;
+        cycles += hw_cycles;
+        misses += hw_misses;
+    }
+
+    printf("bbo_stage vs book_apply_bbo: %zu messages after warm-up, %zu resting orders, %d stocks\n", done,
+           book.num_orders(), num_stocks);
+    printf("  %-10s %10s %10s %8s\n", "", "messages", "BBO moves", "share");
+    for (const TypeCount& c : counts) {
+        printf("  %-10s %10zu %10zu %7.1f%%\n", c.name, c.messages, c.changes,
+               c.messages ? 100.0 * c.changes / c.messages : 0.0);
+    }
+    printf("  %-10s %10zu %10zu %7.1f%%\n", "total", done, changes, done ? 100.0 * changes / done : 0.0);
+    printf("  volume: %.1fx fewer records, %.1f MB of ParserOutput -> %.1f MB of BboUpdate (%.1fx)\n",
+           changes ? (double)done / changes : 0.0, done * sizeof(ParserOutput) / 1048576.0,
+           changes * sizeof(BboUpdate) / 1048576.0,
+           changes ? (double)(done * sizeof(ParserOutput)) / (changes * sizeof(BboUpdate)) : 0.0);
+    printf("  kernel: %zu updates in all, %d levels or orders overflowed\n", hw_total, overflow);
+    printf("  cycle model (modelled, not achieved): %.3f cycles per message, %.2f window misses per 1000 messages, "
+           "%.1f M msgs/s at %.0f MHz\n",
+           done ? (double)cycles / done : 0.0, done ? 1000.0 * misses / done : 0.0,
+           cycles ? MODEL_MHZ * done / cycles : 0.0, MODEL_MHZ);
+    delete chip;
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
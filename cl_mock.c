@@ -0,0 +1,540 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cl_mock.h"
+#include "itch_decoder.h"
+
+/* See cl_mock.h. Build: gcc -O2 -pthread -DCL_MOCK -o <host> <host>.c cl_mock.c libitch.a -lstdc++ */
+
+#define MAX_KERNEL_ARGS  8
+#define MAX_MIGRATE      8
+
+struct _cl_platform_id { int unused; };
+struct _cl_device_id { int unused; };
+struct _cl_context { int unused; };
+struct _cl_program { int unused; };
+
+struct _cl_event {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int complete;
+    int refs;
+    cl_ulong start;   /* ns since the mock started */
+    cl_ulong end;
+};
+
+struct _cl_mem {
+    void* device;     /* the card's copy */
+    void* host_ptr;   /* CL_MEM_USE_HOST_PTR backing, or NULL */
+    void* staging;    /* aligned bounce buffer when host_ptr is not 4 KiB aligned, as XRT allocates */
+    size_t size;
+};
+
+enum KernelKind { KERNEL_PARSER_FRAMED, KERNEL_PARSER_FILTERED };
+
+typedef struct {
+    cl_mem mem;
+    int64_t value;
+} KernelArg;
+
+struct _cl_kernel {
+    enum KernelKind kind;
+    unsigned mem_args;    /* bit i set: argument i is a buffer */
+    int num_args;
+    KernelArg args[MAX_KERNEL_ARGS];
+};
+
+struct _cl_command_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    int pending;
+    int in_order;
+    cl_event last;        /* in-order queues chain every command on the previous one */
+};
+
+enum CommandKind { CMD_WRITE, CMD_READ, CMD_TO_DEVICE, CMD_TO_HOST, CMD_TASK };
+
+typedef struct Command {
+    enum CommandKind kind;
+    cl_mem mems[MAX_MIGRATE];
+    int num_mems;
+    size_t offset, size;
+    void* ptr;
+    struct _cl_kernel kernel;   /* arguments as they were at enqueue time */
+    cl_event* deps;
+    cl_uint num_deps;
+    cl_event done;
+    cl_command_queue queue;
+    struct Command* next;
+} Command;
+
+/* Host-to-card DMA, compute unit, card-to-host DMA */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Command* head;
+    Command* tail;
+    pthread_t thread;
+} Engine;
+
+enum { ENGINE_H2D, ENGINE_CU, ENGINE_D2H, NUM_ENGINES };
+
+static struct _cl_platform_id the_platform;
+static struct _cl_device_id the_device;
+static Engine engines[NUM_ENGINES];
+static pthread_once_t engines_once = PTHREAD_ONCE_INIT;
+static struct timespec epoch;
+
+static double pcie_gbps, kernel_gbps, dma_ns, kernel_ns, time_scale;
+
+static double env_or(const char* name, double fallback) {
+    const char* v = getenv(name);
+    return v && *v ? atof(v) : fallback;
+}
+
+static cl_ulong now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (cl_ulong)(ts.tv_sec - epoch.tv_sec) * 1000000000ULL + ts.tv_nsec - epoch.tv_nsec;
+}
+
+static void sleep_until_ns(cl_ulong t) {
+    struct timespec ts;
+    ts.tv_sec = epoch.tv_sec + (time_t)(t / 1000000000ULL);
+    ts.tv_nsec = epoch.tv_nsec + (long)(t % 1000000000ULL);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {}
+}
+
+/* --- Events --- */
+
+static cl_event event_new(int refs) {
+    cl_event e = (cl_event)calloc(1, sizeof(*e));
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->cond, NULL);
+    e->refs = refs;
+    return e;
+}
+
+static void event_retain(cl_event e) {
+    pthread_mutex_lock(&e->lock);
+    e->refs++;
+    pthread_mutex_unlock(&e->lock);
+}
+
+static void event_wait(cl_event e) {
+    pthread_mutex_lock(&e->lock);
+    while (!e->complete) pthread_cond_wait(&e->cond, &e->lock);
+    pthread_mutex_unlock(&e->lock);
+}
+
+static void event_complete(cl_event e, cl_ulong start, cl_ulong end) {
+    pthread_mutex_lock(&e->lock);
+    e->start = start;
+    e->end = end;
+    e->complete = 1;
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+}
+
+cl_int clReleaseEvent(cl_event e) {
+    if (!e) return CL_INVALID_VALUE;
+    pthread_mutex_lock(&e->lock);
+    int refs = --e->refs;
+    pthread_mutex_unlock(&e->lock);
+    if (refs == 0) {
+        pthread_mutex_destroy(&e->lock);
+        pthread_cond_destroy(&e->cond);
+        free(e);
+    }
+    return CL_SUCCESS;
+}
+
+cl_int clWaitForEvents(cl_uint num_events, const cl_event* event_list) {
+    for (cl_uint i = 0; i < num_events; i++) event_wait(event_list[i]);
+    return CL_SUCCESS;
+}
+
+cl_int clGetEventProfilingInfo(cl_event e, cl_profiling_info param_name, size_t param_value_size,
+                               void* param_value, size_t* param_value_size_ret) {
+    if (param_value_size < sizeof(cl_ulong)) return CL_INVALID_VALUE;
+    event_wait(e);
+    cl_ulong v = param_name == CL_PROFILING_COMMAND_START ? e->start : e->end;
+    memcpy(param_value, &v, sizeof(v));
+    if (param_value_size_ret) *param_value_size_ret = sizeof(v);
+    return CL_SUCCESS;
+}
+
+/* --- Kernels --- */
+
+static int64_t arg_int(const struct _cl_kernel* k, int i) { return k->args[i].value; }
+static void* arg_mem(const struct _cl_kernel* k, int i) { return k->args[i].mem ? k->args[i].mem->device : NULL; }
+static size_t arg_size(const struct _cl_kernel* k, int i) { return k->args[i].mem ? k->args[i].mem->size : 0; }
+
+/* Runs the kernel on the CPU and returns the input bytes it was given, for the time model */
+static size_t run_kernel(const struct _cl_kernel* k) {
+    const uint8_t* input = (const uint8_t*)arg_mem(k, 0);
+    size_t num_bytes = (size_t)arg_int(k, 1);
+    ParserOutput* outputs = (ParserOutput*)arg_mem(k, 2);
+    size_t max_outputs = arg_size(k, 2) / sizeof(ParserOutput);
+    size_t consumed = 0, n;
+
+    switch (k->kind) {
+    case KERNEL_PARSER_FILTERED: {
+        size_t dropped = 0;
+        n = itch_decode_framed_filtered(input, num_bytes, (const uint64_t*)arg_mem(k, 4), outputs, max_outputs,
+                                        &dropped, &consumed);
+        *(int*)arg_mem(k, 5) = (int)dropped;
+        break;
+    }
+    case KERNEL_PARSER_FRAMED:
+    default:
+        n = itch_decode_framed(input, num_bytes, outputs, max_outputs, &consumed);
+        break;
+    }
+    *(int*)arg_mem(k, 3) = (int)n;
+    return num_bytes;
+}
+
+/* --- Engines --- */
+
+static void* engine_main(void* arg) {
+    Engine* engine = (Engine*)arg;
+    for (;;) {
+        pthread_mutex_lock(&engine->lock);
+        while (!engine->head) pthread_cond_wait(&engine->cond, &engine->lock);
+        Command* cmd = engine->head;
+        engine->head = cmd->next;
+        if (!engine->head) engine->tail = NULL;
+        pthread_mutex_unlock(&engine->lock);
+
+        for (cl_uint i = 0; i < cmd->num_deps; i++) event_wait(cmd->deps[i]);
+
+        /* An unaligned host pointer costs a CPU copy into the bounce buffer before the DMA */
+        if (cmd->kind == CMD_TO_DEVICE) {
+            for (int i = 0; i < cmd->num_mems; i++) {
+                cl_mem m = cmd->mems[i];
+                if (m->staging) memcpy(m->staging, m->host_ptr, m->size);
+            }
+        }
+
+        cl_ulong start = now_ns();
+        double model_ns;
+        size_t bytes = 0;
+        switch (cmd->kind) {
+        case CMD_WRITE:
+            memcpy((uint8_t*)cmd->mems[0]->device + cmd->offset, cmd->ptr, cmd->size);
+            bytes = cmd->size;
+            break;
+        case CMD_READ:
+            memcpy(cmd->ptr, (uint8_t*)cmd->mems[0]->device + cmd->offset, cmd->size);
+            bytes = cmd->size;
+            break;
+        case CMD_TO_DEVICE:
+        case CMD_TO_HOST:
+            for (int i = 0; i < cmd->num_mems; i++) {
+                cl_mem m = cmd->mems[i];
+                if (!m->host_ptr) continue;
+                void* dma_ptr = m->staging ? m->staging : m->host_ptr;
+                if (cmd->kind == CMD_TO_DEVICE) memcpy(m->device, dma_ptr, m->size);
+                else memcpy(dma_ptr, m->device, m->size);
+                bytes += m->size;
+            }
+            break;
+        case CMD_TASK:
+            bytes = run_kernel(&cmd->kernel);
+            break;
+        }
+        if (cmd->kind == CMD_TASK) model_ns = kernel_ns + bytes / kernel_gbps;
+        else model_ns = dma_ns + bytes / pcie_gbps;
+        cl_ulong end = start + (cl_ulong)(model_ns * time_scale);
+        if (now_ns() < end) sleep_until_ns(end);
+        else end = now_ns();
+
+        /* ...and another out of it after the DMA back */
+        if (cmd->kind == CMD_TO_HOST) {
+            int staged = 0;
+            for (int i = 0; i < cmd->num_mems; i++) {
+                cl_mem m = cmd->mems[i];
+                if (m->staging) memcpy(m->host_ptr, m->staging, m->size);
+                staged |= m->staging != NULL;
+            }
+            if (staged) end = now_ns();
+        }
+
+        event_complete(cmd->done, start, end);
+        clReleaseEvent(cmd->done);
+        for (cl_uint i = 0; i < cmd->num_deps; i++) clReleaseEvent(cmd->deps[i]);
+        free(cmd->deps);
+
+        cl_command_queue q = cmd->queue;
+        pthread_mutex_lock(&q->lock);
+        if (--q->pending == 0) pthread_cond_broadcast(&q->idle);
+        pthread_mutex_unlock(&q->lock);
+        free(cmd);
+    }
+    return NULL;
+}
+
+static void start_engines(void) {
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    pcie_gbps = env_or("CL_MOCK_PCIE_GBPS", 12);
+    kernel_gbps = env_or("CL_MOCK_KERNEL_GBPS", 10);
+    dma_ns = env_or("CL_MOCK_DMA_US", 10) * 1e3;
+    kernel_ns = env_or("CL_MOCK_KERNEL_US", 20) * 1e3;
+    time_scale = env_or("CL_MOCK_TIME_SCALE", 1);
+    for (int i = 0; i < NUM_ENGINES; i++) {
+        pthread_mutex_init(&engines[i].lock, NULL);
+        pthread_cond_init(&engines[i].cond, NULL);
+        pthread_create(&engines[i].thread, NULL, engine_main, &engines[i]);
+        pthread_detach(engines[i].thread);
+    }
+}
+
+/* Queues a command on its engine. The command waits on `wait_list` and, for an in-order queue,
+ * on the previous command. */
+static cl_int submit(cl_command_queue q, Command* cmd, int engine, cl_uint num_events, const cl_event* wait_list,
+                     cl_event* event, cl_bool blocking) {
+    pthread_mutex_lock(&q->lock);
+    cl_uint extra = q->in_order && q->last ? 1 : 0;
+    cmd->deps = (cl_event*)malloc((num_events + extra + 1) * sizeof(cl_event));
+    cmd->num_deps = 0;
+    for (cl_uint i = 0; i < num_events; i++) {
+        event_retain(wait_list[i]);
+        cmd->deps[cmd->num_deps++] = wait_list[i];
+    }
+    if (extra) cmd->deps[cmd->num_deps++] = q->last;   /* takes over the queue's reference */
+
+    /* References: one for the engine, one for the queue's chain, one for the caller */
+    cmd->done = event_new(1 + (q->in_order ? 1 : 0) + (event ? 1 : 0) + (blocking ? 1 : 0));
+    q->last = q->in_order ? cmd->done : NULL;
+    q->pending++;
+    cmd->queue = q;
+    cmd->next = NULL;
+    pthread_mutex_unlock(&q->lock);
+
+    cl_event done = cmd->done;
+    if (event) *event = done;
+
+    Engine* e = &engines[engine];
+    pthread_mutex_lock(&e->lock);
+    if (e->tail) e->tail->next = cmd;
+    else e->head = cmd;
+    e->tail = cmd;
+    pthread_cond_signal(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+
+    if (blocking) {
+        event_wait(done);
+        clReleaseEvent(done);
+    }
+    return CL_SUCCESS;
+}
+
+/* --- Platform, context, queue, program --- */
+
+cl_int clGetPlatformIDs(cl_uint num_entries, cl_platform_id* platforms, cl_uint* num_platforms) {
+    if (platforms && num_entries > 0) platforms[0] = &the_platform;
+    if (num_platforms) *num_platforms = 1;
+    return CL_SUCCESS;
+}
+
+cl_int clGetDeviceIDs(cl_platform_id platform, cl_device_type type, cl_uint num_entries,
+                      cl_device_id* devices, cl_uint* num_devices) {
+    (void)platform;
+    if (!(type & CL_DEVICE_TYPE_ACCELERATOR)) return CL_DEVICE_NOT_FOUND;
+    if (devices && num_entries > 0) devices[0] = &the_device;
+    if (num_devices) *num_devices = 1;
+    return CL_SUCCESS;
+}
+
+cl_context clCreateContext(const cl_context_properties* properties, cl_uint num_devices,
+                           const cl_device_id* devices, void (*notify)(const char*, const void*, size_t, void*),
+                           void* user_data, cl_int* errcode_ret) {
+    (void)properties; (void)num_devices; (void)devices; (void)notify; (void)user_data;
+    pthread_once(&engines_once, start_engines);
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return (cl_context)calloc(1, sizeof(struct _cl_context));
+}
+
+cl_command_queue clCreateCommandQueue(cl_context context, cl_device_id device,
+                                      cl_command_queue_properties properties, cl_int* errcode_ret) {
+    (void)context; (void)device;
+    cl_command_queue q = (cl_command_queue)calloc(1, sizeof(*q));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->idle, NULL);
+    q->in_order = !(properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return q;
+}
+
+cl_program clCreateProgramWithBinary(cl_context context, cl_uint num_devices, const cl_device_id* devices,
+                                     const size_t* lengths, const unsigned char** binaries,
+                                     cl_int* binary_status, cl_int* errcode_ret) {
+    (void)context; (void)devices; (void)lengths; (void)binaries;
+    for (cl_uint i = 0; binary_status && i < num_devices; i++) binary_status[i] = CL_SUCCESS;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return (cl_program)calloc(1, sizeof(struct _cl_program));
+}
+
+cl_int clBuildProgram(cl_program program, cl_uint num_devices, const cl_device_id* devices,
+                      const char* options, void (*notify)(cl_program, void*), void* user_data) {
+    (void)program; (void)num_devices; (void)devices; (void)options; (void)notify; (void)user_data;
+    return CL_SUCCESS;
+}
+
+cl_kernel clCreateKernel(cl_program program, const char* kernel_name, cl_int* errcode_ret) {
+    (void)program;
+    struct _cl_kernel k;
+    memset(&k, 0, sizeof(k));
+    if (strcmp(kernel_name, "parser_framed") == 0) {
+        k.kind = KERNEL_PARSER_FRAMED;
+        k.mem_args = (1u << 0) | (1u << 2) | (1u << 3);
+        k.num_args = 4;
+    } else if (strcmp(kernel_name, "parser_filtered") == 0) {
+        k.kind = KERNEL_PARSER_FILTERED;
+        k.mem_args = (1u << 0) | (1u << 2) | (1u << 3) | (1u << 4) | (1u << 5);
+        k.num_args = 6;
+    } else {
+        if (errcode_ret) *errcode_ret = CL_INVALID_KERNEL_NAME;
+        return NULL;
+    }
+    cl_kernel kernel = (cl_kernel)malloc(sizeof(*kernel));
+    *kernel = k;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return kernel;
+}
+
+cl_int clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void* arg_value) {
+    if ((int)arg_index >= kernel->num_args) return CL_INVALID_ARG_INDEX;
+    KernelArg* a = &kernel->args[arg_index];
+    if (kernel->mem_args & (1u << arg_index)) {
+        if (arg_size != sizeof(cl_mem)) return CL_INVALID_MEM_OBJECT;
+        memcpy(&a->mem, arg_value, sizeof(cl_mem));
+    } else {
+        if (arg_size > sizeof(a->value)) return CL_INVALID_VALUE;
+        a->value = 0;
+        if (arg_size == sizeof(int32_t)) {
+            int32_t v;
+            memcpy(&v, arg_value, sizeof(v));
+            a->value = v;
+        } else {
+            memcpy(&a->value, arg_value, arg_size);
+        }
+    }
+    return CL_SUCCESS;
+}
+
+cl_mem clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void* host_ptr, cl_int* errcode_ret) {
+    (void)context;
+    cl_mem m = (cl_mem)calloc(1, sizeof(*m));
+    m->device = calloc(1, size ? size : 1);
+    if (!m->device) {
+        free(m);
+        if (errcode_ret) *errcode_ret = CL_OUT_OF_HOST_MEMORY;
+        return NULL;
+    }
+    m->size = size;
+    m->host_ptr = (flags & CL_MEM_USE_HOST_PTR) ? host_ptr : NULL;
+    if (m->host_ptr && ((uintptr_t)host_ptr & 4095) != 0) {
+        static int warned = 0;
+        if (!warned) {
+            fprintf(stderr, "cl_mock: WARNING: unaligned host pointer %p detected, this leads to extra memcpy\n",
+                    host_ptr);
+            warned = 1;
+        }
+        if (posix_memalign(&m->staging, 4096, size ? size : 1) != 0) m->staging = NULL;
+    }
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return m;
+}
+
+/* --- Commands --- */
+
+static Command* new_command(enum CommandKind kind) {
+    Command* cmd = (Command*)calloc(1, sizeof(Command));
+    cmd->kind = kind;
+    return cmd;
+}
+
+cl_int clEnqueueWriteBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+                            const void* ptr, cl_uint num_events, const cl_event* wait_list, cl_event* event) {
+    if (offset + size > buffer->size) return CL_INVALID_VALUE;
+    Command* cmd = new_command(CMD_WRITE);
+    cmd->mems[0] = buffer;
+    cmd->num_mems = 1;
+    cmd->offset = offset;
+    cmd->size = size;
+    cmd->ptr = (void*)ptr;
+    return submit(queue, cmd, ENGINE_H2D, num_events, wait_list, event, blocking);
+}
+
+cl_int clEnqueueReadBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+                           void* ptr, cl_uint num_events, const cl_event* wait_list, cl_event* event) {
+    if (offset + size > buffer->size) return CL_INVALID_VALUE;
+    Command* cmd = new_command(CMD_READ);
+    cmd->mems[0] = buffer;
+    cmd->num_mems = 1;
+    cmd->offset = offset;
+    cmd->size = size;
+    cmd->ptr = ptr;
+    return submit(queue, cmd, ENGINE_D2H, num_events, wait_list, event, blocking);
+}
+
+cl_int clEnqueueMigrateMemObjects(cl_command_queue queue, cl_uint num_mem_objects, const cl_mem* mem_objects,
+                                  cl_mem_migration_flags flags, cl_uint num_events, const cl_event* wait_list,
+                                  cl_event* event) {
+    if (num_mem_objects == 0 || num_mem_objects > MAX_MIGRATE) return CL_INVALID_VALUE;
+    int to_host = (flags & CL_MIGRATE_MEM_OBJECT_HOST) != 0;
+    Command* cmd = new_command(to_host ? CMD_TO_HOST : CMD_TO_DEVICE);
+    for (cl_uint i = 0; i < num_mem_objects; i++) cmd->mems[i] = mem_objects[i];
+    cmd->num_mems = (int)num_mem_objects;
+    return submit(queue, cmd, to_host ? ENGINE_D2H : ENGINE_H2D, num_events, wait_list, event, CL_FALSE);
+}
+
+cl_int clEnqueueTask(cl_command_queue queue, cl_kernel kernel, cl_uint num_events, const cl_event* wait_list,
+                     cl_event* event) {
+    Command* cmd = new_command(CMD_TASK);
+    cmd->kernel = *kernel;
+    return submit(queue, cmd, ENGINE_CU, num_events, wait_list, event, CL_FALSE);
+}
+
+cl_int clFlush(cl_command_queue queue) {
+    (void)queue;
+    return CL_SUCCESS;
+}
+
+cl_int clFinish(cl_command_queue q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->pending > 0) pthread_cond_wait(&q->idle, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+    return CL_SUCCESS;
+}
+
+/* --- Release --- */
+
+cl_int clReleaseMemObject(cl_mem m) {
+    free(m->staging);
+    free(m->device);
+    free(m);
+    return CL_SUCCESS;
+}
+
+cl_int clReleaseKernel(cl_kernel kernel) { free(kernel); return CL_SUCCESS; }
+cl_int clReleaseProgram(cl_program program) { free(program); return CL_SUCCESS; }
+cl_int clReleaseContext(cl_context context) { free(context); return CL_SUCCESS; }
+
+cl_int clReleaseCommandQueue(cl_command_queue q) {
+    clFinish(q);
+    if (q->last) clReleaseEvent(q->last);
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->idle);
+    free(q);
+    return CL_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#ifndef CL_MOCK_H
+#define CL_MOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Mock of the OpenCL subset used by the host programs, for running them without a card.
+ *
+ * Build a host with -DCL_MOCK and link cl_mock.c instead of -lOpenCL. The mock keeps its own
+ * "device" copy of every buffer and runs three engines on their own threads, as an Alveo card
+ * does: host-to-card DMA, the compute unit, and card-to-host DMA. Commands on an out-of-order
+ * queue start as soon as their engine is free and their wait list has completed, so event
+ * chains overlap exactly as they would on hardware, and a missing dependency shows up as wrong
+ * data rather than going unnoticed.
+ *
+ * Each command takes a modelled time: a fixed launch latency plus its bytes over a bandwidth.
+ * The engine does the real work (copies, or the kernel run on the CPU) and then sleeps out the
+ * rest of the modelled time. The model is set by environment variables:
+ *   CL_MOCK_PCIE_GBPS     DMA bandwidth in each direction (default 12)
+ *   CL_MOCK_KERNEL_GBPS   kernel input bytes consumed per second (default 10)
+ *   CL_MOCK_DMA_US        launch latency of each transfer (default 10)
+ *   CL_MOCK_KERNEL_US     launch latency of each kernel run (default 20)
+ *   CL_MOCK_TIME_SCALE    multiplies every modelled time, so the model can be kept well above the
+ *                         cost of the real work on a small machine (default 1)
+ *
+ * Like XRT, a CL_MEM_USE_HOST_PTR buffer whose host pointer is not 4 KiB aligned gets an aligned
+ * bounce buffer: every migration then pays a real CPU copy on top of the modelled DMA.
+ *
+ * Kernels are matched by name: parser_framed and parser_filtered run the CPU reference decoder
+ * (itch_decoder.h) with the kernel's semantics, so link libitch.a as well. */
+
+#define CL_SUCCESS                    0
+#define CL_DEVICE_NOT_FOUND          -1
+#define CL_OUT_OF_HOST_MEMORY        -6
+#define CL_INVALID_VALUE            -30
+#define CL_INVALID_MEM_OBJECT       -38
+#define CL_INVALID_KERNEL_NAME      -46
+#define CL_INVALID_ARG_INDEX        -49
+
+#define CL_FALSE 0
+#define CL_TRUE  1
+
+#define CL_DEVICE_TYPE_ACCELERATOR  (1 << 3)
+
+#define CL_MEM_READ_WRITE           (1 << 0)
+#define CL_MEM_WRITE_ONLY           (1 << 1)
+#define CL_MEM_READ_ONLY            (1 << 2)
+#define CL_MEM_USE_HOST_PTR         (1 << 3)
+
+#define CL_MIGRATE_MEM_OBJECT_HOST  (1 << 0)
+
+#define CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE  (1 << 0)
+#define CL_QUEUE_PROFILING_ENABLE               (1 << 1)
+
+#define CL_PROFILING_COMMAND_START  0x1282
+#define CL_PROFILING_COMMAND_END    0x1283
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t  cl_int;
+typedef uint32_t cl_uint;
+typedef uint64_t cl_ulong;
+typedef cl_uint  cl_bool;
+typedef cl_ulong cl_bitfield;
+typedef cl_bitfield cl_device_type;
+typedef cl_bitfield cl_mem_flags;
+typedef cl_bitfield cl_mem_migration_flags;
+typedef cl_bitfield cl_command_queue_properties;
+typedef cl_uint cl_profiling_info;
+typedef intptr_t cl_context_properties;
+
+typedef struct _cl_platform_id*   cl_platform_id;
+typedef struct _cl_device_id*     cl_device_id;
+typedef struct _cl_context*       cl_context;
+typedef struct _cl_command_queue* cl_command_queue;
+typedef struct _cl_mem*           cl_mem;
+typedef struct _cl_program*       cl_program;
+typedef struct _cl_kernel*        cl_kernel;
+typedef struct _cl_event*         cl_event;
+
+cl_int clGetPlatformIDs(cl_uint num_entries, cl_platform_id* platforms, cl_uint* num_platforms);
+cl_int clGetDeviceIDs(cl_platform_id platform, cl_device_type type, cl_uint num_entries,
+                      cl_device_id* devices, cl_uint* num_devices);
+cl_context clCreateContext(const cl_context_properties* properties, cl_uint num_devices,
+                           const cl_device_id* devices, void (*notify)(const char*, const void*, size_t, void*),
+                           void* user_data, cl_int* errcode_ret);
+cl_command_queue clCreateCommandQueue(cl_context context, cl_device_id device,
+                                      cl_command_queue_properties properties, cl_int* errcode_ret);
+cl_program clCreateProgramWithBinary(cl_context context, cl_uint num_devices, const cl_device_id* devices,
+                                     const size_t* lengths, const unsigned char** binaries,
+                                     cl_int* binary_status, cl_int* errcode_ret);
+cl_int clBuildProgram(cl_program program, cl_uint num_devices, const cl_device_id* devices,
+                      const char* options, void (*notify)(cl_program, void*), void* user_data);
+cl_kernel clCreateKernel(cl_program program, const char* kernel_name, cl_int* errcode_ret);
+cl_mem clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void* host_ptr, cl_int* errcode_ret);
+cl_int clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void* arg_value);
+
+cl_int clEnqueueWriteBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+                            const void* ptr, cl_uint num_events, const cl_event* wait_list, cl_event* event);
+cl_int clEnqueueReadBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+                           void* ptr, cl_uint num_events, const cl_event* wait_list, cl_event* event);
+cl_int clEnqueueMigrateMemObjects(cl_command_queue queue, cl_uint num_mem_objects, const cl_mem* mem_objects,
+                                  cl_mem_migration_flags flags, cl_uint num_events, const cl_event* wait_list,
+                                  cl_event* event);
+cl_int clEnqueueTask(cl_command_queue queue, cl_kernel kernel, cl_uint num_events, const cl_event* wait_list,
+                     cl_event* event);
+
+cl_int clFlush(cl_command_queue queue);
+cl_int clFinish(cl_command_queue queue);
+cl_int clWaitForEvents(cl_uint num_events, const cl_event* event_list);
+cl_int clGetEventProfilingInfo(cl_event event, cl_profiling_info param_name, size_t param_value_size,
+                               void* param_value, size_t* param_value_size_ret);
+
+cl_int clReleaseEvent(cl_event event);
+cl_int clReleaseMemObject(cl_mem memobj);
+cl_int clReleaseKernel(cl_kernel kernel);
+cl_int clReleaseProgram(cl_program program);
+cl_int clReleaseCommandQueue(cl_command_queue queue);
+cl_int clReleaseContext(cl_context context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "host_pool.h"
+
+void host_pool_init(HostPool* pool, int flags, void (*release_handle)(void* handle)) {
+    memset(pool, 0, sizeof(*pool));
+    pool->flags = flags;
+    pool->release_handle = release_handle;
+}
+
+static int size_class(size_t size) {
+    int c = 0;
+    while (c < HOST_POOL_CLASSES && ((size_t)HOST_POOL_ALIGN << c) < size) c++;
+    return c;
+}
+
+// Maps `capacity` bytes and faults every page in now, so the first batch to use the buffer
+// does not pay for it
+static int map_buffer(HostBuffer* buf, size_t capacity, int huge) {
+    buf->huge = HOST_POOL_PAGES_4K;
+    if (huge && capacity >= HOST_POOL_HUGE_PAGE) {
+#ifdef MAP_HUGETLB
+        void* p = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (p != MAP_FAILED) {
+            buf->map = buf->data = p;
+            buf->map_size = capacity;
+            buf->huge = HOST_POOL_PAGES_2M;
+            return 0;
+        }
+#endif
+        // No reserved huge pages: over-map to get 2 MiB alignment and ask for THP
+        size_t map_size = capacity + HOST_POOL_HUGE_PAGE;
+        void* m = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED) return -1;
+        uintptr_t aligned = ((uintptr_t)m + HOST_POOL_HUGE_PAGE - 1) & ~(uintptr_t)(HOST_POOL_HUGE_PAGE - 1);
+        buf->map = m;
+        buf->map_size = map_size;
+        buf->data = (void*)aligned;
+#ifdef MADV_HUGEPAGE
+        if (madvise(buf->data, capacity, MADV_HUGEPAGE) == 0) buf->huge = HOST_POOL_PAGES_THP;
+#endif
+        for (size_t off = 0; off < capacity; off += HOST_POOL_ALIGN) ((volatile uint8_t*)buf->data)[off] = 0;
+        return 0;
+    }
+
+    void* p = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (p == MAP_FAILED) return -1;
+    buf->map = buf->data = p;
+    buf->map_size = capacity;
+    return 0;
+}
+
+HostBuffer* host_pool_get(HostPool* pool, size_t size) {
+    int c = size_class(size ? size : 1);
+    if (c >= HOST_POOL_CLASSES) return NULL;
+
+    HostBuffer* buf = pool->free_lists[c];
+    if (buf) {
+        pool->free_lists[c] = buf->next;
+        buf->next = NULL;
+        pool->reuses++;
+        return buf;
+    }
+
+    buf = (HostBuffer*)calloc(1, sizeof(HostBuffer));
+    if (!buf) return NULL;
+    buf->capacity = (size_t)HOST_POOL_ALIGN << c;
+    if (map_buffer(buf, buf->capacity, pool->flags & HOST_POOL_HUGE) != 0) {
+        free(buf);
+        return NULL;
+    }
+    pool->allocations++;
+    pool->bytes_mapped += buf->capacity;
+    return buf;
+}
+
+void host_pool_put(HostPool* pool, HostBuffer* buf) {
+    if (!buf) return;
+    int c = size_class(buf->capacity);
+    buf->next = pool->free_lists[c];
+    pool->free_lists[c] = buf;
+}
+
+void host_pool_destroy(HostPool* pool) {
+    for (int c = 0; c < HOST_POOL_CLASSES; c++) {
+        HostBuffer* buf = pool->free_lists[c];
+        while (buf) {
+            HostBuffer* next = buf->next;
+            if (buf->handle && pool->release_handle) pool->release_handle(buf->handle);
+            munmap(buf->map, buf->map_size);
+            free(buf);
+            buf = next;
+        }
+        pool->free_lists[c] = NULL;
+    }
+}
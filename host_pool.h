@@ -0,0 +1,77 @@
+#ifndef HOST_POOL_H
+#define HOST_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Reusable host buffers for CL_MEM_USE_HOST_PTR.
+//
+// XRT can DMA straight from a host pointer only if it is 4 KiB aligned; anything else (malloc
+// hands out 16-byte alignment) gets a hidden bounce buffer and a CPU copy on every migration.
+// Allocating per batch also pays for the mmap, the page faults on first touch and the buffer
+// registration every time. The pool hands out page-aligned, pre-faulted buffers in power-of-two
+// size classes and takes them back for the next batch. A buffer keeps whatever the caller
+// registered it as in `handle` (typically its cl_mem), so a recycled buffer needs no new
+// clCreateBuffer; the pool calls `release_handle` on it when the buffer is finally freed.
+//
+// With HOST_POOL_HUGE, buffers of 2 MiB and up are backed by huge pages: hugetlbfs pages if
+// any are reserved (vm.nr_hugepages), otherwise 2 MiB-aligned memory advised for transparent
+// huge pages. Fewer pages mean fewer IOMMU/TLB entries for the DMA engine to walk.
+//
+// Not thread-safe: use one pool per thread, or lock around get/put.
+
+#define HOST_POOL_ALIGN      4096
+#define HOST_POOL_HUGE_PAGE  (2u << 20)
+
+// Size classes: 4 KiB << class, up to 4 KiB << (HOST_POOL_CLASSES - 1) = 512 GiB
+#define HOST_POOL_CLASSES    28
+
+// host_pool_init flags
+#define HOST_POOL_HUGE       1
+
+// HostBuffer.huge values
+#define HOST_POOL_PAGES_4K   0
+#define HOST_POOL_PAGES_THP  1   // advised for transparent huge pages
+#define HOST_POOL_PAGES_2M   2   // hugetlbfs pages
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HostBuffer {
+    void* data;               // HOST_POOL_ALIGN aligned, or 2 MiB aligned for huge pages
+    size_t capacity;          // size class, at least the size asked for
+    int huge;                 // HOST_POOL_PAGES_*
+    void* handle;             // caller's registration (e.g. cl_mem), kept across reuse
+    struct HostBuffer* next;  // free list
+    void* map;                // mapping to unmap, which may start before data
+    size_t map_size;
+} HostBuffer;
+
+typedef struct {
+    HostBuffer* free_lists[HOST_POOL_CLASSES];
+    int flags;
+    void (*release_handle)(void* handle);
+    size_t allocations;       // buffers mapped
+    size_t reuses;            // gets served from a free list
+    size_t bytes_mapped;
+} HostPool;
+
+// release_handle may be NULL if buffers are never registered
+void host_pool_init(HostPool* pool, int flags, void (*release_handle)(void* handle));
+
+// Returns a buffer of at least `size` bytes, recycled if one of its class is free, or NULL if
+// memory runs out. The contents of a recycled buffer are whatever its last user left.
+HostBuffer* host_pool_get(HostPool* pool, size_t size);
+
+// Returns a buffer to the pool; its handle stays registered
+void host_pool_put(HostPool* pool, HostBuffer* buffer);
+
+// Frees every buffer on the free lists. Buffers still out are the caller's to put back first.
+void host_pool_destroy(HostPool* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+#ifdef CL_MOCK
+#include "cl_mock.h"
+#else
+#include <CL/opencl.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "host_pool.h"
+
+/* Per-batch cost of host buffers passed as CL_MEM_USE_HOST_PTR, four ways:
+ *   malloc          malloc and clCreateBuffer per batch, as double_vector_test.c did; the
+ *                   pointer is only 16-byte aligned, so every migration goes through a bounce
+ *                   buffer
+ *   posix_memalign  aligned, so no bounce copy, but still allocated, faulted in and registered
+ *                   per batch
+ *   pool            host_pool.h buffers, mapped and registered once and recycled
+ *   pool huge       the same on 2 MiB pages
+ * Each batch is one input buffer migrated to the card and one output buffer migrated back.
+ * Setup is allocation, registration and filling the input; teardown is release and free (or
+ * handing the buffers back); transfer is from the first migration to clFinish. Each mode first
+ * checks a round trip through the card on its own buffers.
+ *
+ * Build: gcc -O2 -o host_pool_bench host_pool_bench.c host_pool.c -lOpenCL
+ *        gcc -O2 -pthread -DCL_MOCK -o host_pool_bench host_pool_bench.c host_pool.c cl_mock.c libitch.a -lstdc++
+ * Usage: ./host_pool_bench [MB per buffer, default 8] [batches, default 100]
+ * Against the mock, CL_MOCK_DMA_US=0 CL_MOCK_PCIE_GBPS=1000 leaves only the host-side costs. */
+
+enum { MODE_MALLOC, MODE_MEMALIGN, MODE_POOL, MODE_POOL_HUGE, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"malloc", "posix_memalign", "pool", "pool huge"};
+
+static cl_context context;
+static cl_command_queue queue;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void release_mem(void* handle) {
+    clReleaseMemObject((cl_mem)handle);
+}
+
+typedef struct {
+    void* ptr;
+    cl_mem mem;
+    HostBuffer* pooled;
+} Batch;
+
+static int acquire(int mode, HostPool* pool, size_t size, cl_mem_flags flags, Batch* b) {
+    cl_int err = CL_SUCCESS;
+    memset(b, 0, sizeof(*b));
+    switch (mode) {
+    case MODE_MALLOC:
+        b->ptr = malloc(size);
+        break;
+    case MODE_MEMALIGN:
+        if (posix_memalign(&b->ptr, HOST_POOL_ALIGN, size) != 0) b->ptr = NULL;
+        break;
+    default:
+        b->pooled = host_pool_get(pool, size);
+        if (!b->pooled) return -1;
+        b->ptr = b->pooled->data;
+        if (!b->pooled->handle) {
+            /* First use of this buffer: register its whole capacity once */
+            b->pooled->handle = clCreateBuffer(context, flags | CL_MEM_USE_HOST_PTR, b->pooled->capacity,
+                                               b->ptr, &err);
+            if (err != CL_SUCCESS) { printf("clCreateBuffer failed: %d\n", err); return -1; }
+        }
+        b->mem = (cl_mem)b->pooled->handle;
+        return 0;
+    }
+    if (!b->ptr) return -1;
+    b->mem = clCreateBuffer(context, flags | CL_MEM_USE_HOST_PTR, size, b->ptr, &err);
+    if (err != CL_SUCCESS) { printf("clCreateBuffer failed: %d\n", err); return -1; }
+    return 0;
+}
+
+static void release(HostPool* pool, Batch* b) {
+    if (b->pooled) {
+        host_pool_put(pool, b->pooled);
+        return;
+    }
+    clReleaseMemObject(b->mem);
+    free(b->ptr);
+}
+
+static int round_trip(int mode, HostPool* pool, size_t size) {
+    Batch b;
+    if (acquire(mode, pool, size, CL_MEM_READ_WRITE, &b) != 0) return -1;
+    uint32_t* words = (uint32_t*)b.ptr;
+    size_t n = size / sizeof(uint32_t);
+    for (size_t i = 0; i < n; i++) words[i] = (uint32_t)(i * 2654435761u);
+    clEnqueueMigrateMemObjects(queue, 1, &b.mem, 0, 0, NULL, NULL);
+    clFinish(queue);
+    memset(b.ptr, 0, size);
+    clEnqueueMigrateMemObjects(queue, 1, &b.mem, CL_MIGRATE_MEM_OBJECT_HOST, 0, NULL, NULL);
+    clFinish(queue);
+    int errors = 0;
+    for (size_t i = 0; i < n; i++) errors += words[i] != (uint32_t)(i * 2654435761u);
+    release(pool, &b);
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    size_t size = (argc > 1 ? strtoull(argv[1], NULL, 10) : 8) << 20;
+    int batches = argc > 2 ? atoi(argv[2]) : 100;
+    if (size == 0 || batches < 1) {
+        printf("Usage: %s [MB per buffer, default 8] [batches, default 100]\n", argv[0]);
+        return 1;
+    }
+
+    cl_int err;
+    cl_platform_id platform;
+    err = clGetPlatformIDs(1, &platform, NULL);
+    if (err != CL_SUCCESS) { printf("clGetPlatformIDs failed: %d\n", err); return 1; }
+
+    cl_device_id device;
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ACCELERATOR, 1, &device, NULL);
+    if (err != CL_SUCCESS) { printf("clGetDeviceIDs failed: %d\n", err); return 1; }
+
+    context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (!context || err != CL_SUCCESS) { printf("clCreateContext failed: %d\n", err); return 1; }
+
+    queue = clCreateCommandQueue(context, device, 0, &err);
+    if (!queue || err != CL_SUCCESS) { printf("clCreateCommandQueue failed: %d\n", err); return 1; }
+
+    printf("%d batches, %zu MB in and %zu MB out per batch\n", batches, size >> 20, size >> 20);
+    printf("%-16s %12s %12s %12s %12s %10s\n", "mode", "setup us", "transfer us", "teardown us", "total us",
+           "GB/s");
+
+    int errors = 0;
+    double baseline = 0;
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        HostPool pool;
+        host_pool_init(&pool, mode == MODE_POOL_HUGE ? HOST_POOL_HUGE : 0, release_mem);
+        int e = round_trip(mode, &pool, size);
+        if (e != 0) {
+            printf("%s: round trip through the card corrupted %d words\n", mode_names[mode], e);
+            errors++;
+        }
+
+        double setup = 0, transfer = 0, teardown = 0;
+        int pages = HOST_POOL_PAGES_4K;
+        for (int i = 0; i < batches; i++) {
+            Batch in, out;
+            double t0 = now_seconds();
+            if (acquire(mode, &pool, size, CL_MEM_READ_ONLY, &in) != 0 ||
+                acquire(mode, &pool, size, CL_MEM_WRITE_ONLY, &out) != 0) {
+                printf("%s: allocation failed\n", mode_names[mode]);
+                return 1;
+            }
+            if (in.pooled) pages = in.pooled->huge;
+            memset(in.ptr, i, size);
+            double t1 = now_seconds();
+            clEnqueueMigrateMemObjects(queue, 1, &in.mem, 0, 0, NULL, NULL);
+            clEnqueueMigrateMemObjects(queue, 1, &out.mem, CL_MIGRATE_MEM_OBJECT_HOST, 0, NULL, NULL);
+            clFinish(queue);
+            double t2 = now_seconds();
+            release(&pool, &in);
+            release(&pool, &out);
+            double t3 = now_seconds();
+            setup += t1 - t0;
+            transfer += t2 - t1;
+            teardown += t3 - t2;
+        }
+
+        double total = (setup + transfer + teardown) / batches;
+        if (mode == MODE_MALLOC) baseline = total;
+        printf("%-16s %12.1f %12.1f %12.1f %12.1f %10.2f", mode_names[mode], setup / batches * 1e6,
+               transfer / batches * 1e6, teardown / batches * 1e6, total * 1e6, 2.0 * size / total / 1e9);
+        if (mode != MODE_MALLOC) printf("   %.2fx", baseline / total);
+        if (mode >= MODE_POOL) {
+            static const char* page_names[] = {"4 KiB pages", "transparent huge pages", "hugetlbfs pages"};
+            printf("   (%zu mapped, %zu reused, %s)", pool.allocations, pool.reuses, page_names[pages]);
+        }
+        printf("\n");
+        host_pool_destroy(&pool);
+    }
+
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
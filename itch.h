@@ -0,0 +1,139 @@
+#ifndef ITCH_H
+#define ITCH_H
+
+#include <stdint.h>
+
+// ITCH 5.0 message types handled by the parser
+#define ITCH_ADD_ORDER       0x41  // 'A' Add Order - No MPID Attribution
+#define ITCH_ORDER_DELETE    0x44  // 'D' Order Delete
+#define ITCH_ORDER_EXECUTED  0x45  // 'E' Order Executed
+#define ITCH_ADD_ORDER_MPID  0x46  // 'F' Add Order with MPID Attribution
+#define ITCH_ORDER_REPLACE   0x55  // 'U' Order Replace
+#define ITCH_ORDER_CANCEL    0x58  // 'X' Order Cancel
+
+// Total message lengths in bytes, including the message type byte
+#define ITCH_ADD_ORDER_LEN       36
+#define ITCH_ORDER_DELETE_LEN    19
+#define ITCH_ORDER_EXECUTED_LEN  31
+#define ITCH_ADD_ORDER_MPID_LEN  40
+#define ITCH_ORDER_REPLACE_LEN   35
+#define ITCH_ORDER_CANCEL_LEN    23
+
+#define ITCH_MIN_MSG_LEN  ITCH_ORDER_DELETE_LEN
+#define ITCH_MAX_MSG_LEN  ITCH_ADD_ORDER_MPID_LEN
+
+// The rest of the ITCH 5.0 message types, decoded only into the type-specific records of itch_records.h
+#define ITCH_SYSTEM_EVENT           0x53  // 'S' System Event
+#define ITCH_STOCK_DIRECTORY        0x52  // 'R' Stock Directory
+#define ITCH_STOCK_TRADING_ACTION   0x48  // 'H' Stock Trading Action
+#define ITCH_REG_SHO                0x59  // 'Y' Reg SHO Short Sale Price Test Restricted Indicator
+#define ITCH_MARKET_PARTICIPANT     0x4C  // 'L' Market Participant Position
+#define ITCH_MWCB_DECLINE_LEVEL     0x56  // 'V' MWCB Decline Level
+#define ITCH_MWCB_STATUS            0x57  // 'W' MWCB Status
+#define ITCH_IPO_QUOTING_PERIOD     0x4B  // 'K' IPO Quoting Period Update
+#define ITCH_LULD_AUCTION_COLLAR    0x4A  // 'J' LULD Auction Collar
+#define ITCH_OPERATIONAL_HALT       0x68  // 'h' Operational Halt
+#define ITCH_ORDER_EXECUTED_PRICE   0x43  // 'C' Order Executed With Price
+#define ITCH_TRADE                  0x50  // 'P' Trade (Non-Cross)
+#define ITCH_CROSS_TRADE            0x51  // 'Q' Cross Trade
+#define ITCH_BROKEN_TRADE           0x42  // 'B' Broken Trade
+#define ITCH_NOII                   0x49  // 'I' Net Order Imbalance Indicator
+#define ITCH_RPII                   0x4E  // 'N' Retail Price Improvement Indicator
+#define ITCH_DLCR_PRICE_DISCOVERY   0x4F  // 'O' Direct Listing with Capital Raise Price Discovery
+
+#define ITCH_SYSTEM_EVENT_LEN          12
+#define ITCH_STOCK_DIRECTORY_LEN       39
+#define ITCH_STOCK_TRADING_ACTION_LEN  25
+#define ITCH_REG_SHO_LEN               20
+#define ITCH_MARKET_PARTICIPANT_LEN    26
+#define ITCH_MWCB_DECLINE_LEVEL_LEN    35
+#define ITCH_MWCB_STATUS_LEN           12
+#define ITCH_IPO_QUOTING_PERIOD_LEN    28
+#define ITCH_LULD_AUCTION_COLLAR_LEN   35
+#define ITCH_OPERATIONAL_HALT_LEN      21
+#define ITCH_ORDER_EXECUTED_PRICE_LEN  36
+#define ITCH_TRADE_LEN                 44
+#define ITCH_CROSS_TRADE_LEN           40
+#define ITCH_BROKEN_TRADE_LEN          19
+#define ITCH_NOII_LEN                  50
+#define ITCH_RPII_LEN                  20
+#define ITCH_DLCR_PRICE_DISCOVERY_LEN  48
+
+// Shortest and longest message anywhere in the ITCH 5.0 spec; the longest also bounds skipped
+// messages in framed input
+#define ITCH_SPEC_MIN_MSG_LEN  ITCH_SYSTEM_EVENT_LEN
+#define ITCH_SPEC_MAX_MSG_LEN  ITCH_NOII_LEN
+
+// Nasdaq BinaryFILE framing: each message is preceded by a 2-byte big-endian length
+#define ITCH_LENGTH_PREFIX  2
+
+// Byte transmission structure (layout must match the kernel's ByteData exactly)
+typedef struct {
+    uint8_t data;
+    uint8_t valid;
+    uint8_t start_msg;
+    uint8_t end_msg;
+} ByteData;
+
+// Parser output structure (layout must match the kernel's ParserOutput exactly)
+typedef struct {
+    uint8_t  valid_msg;
+    uint8_t  msg_type;
+    uint16_t stock_locate;
+    uint16_t tracking_no;
+    uint64_t timestamp;
+    uint64_t order_ref_no;
+    uint32_t shares;
+    uint8_t  buy_sell;
+    uint64_t stock;
+    uint32_t price;
+    uint64_t match_no;
+    uint64_t new_order_ref_no;
+    uint32_t attribution;
+#ifdef ITCH_INSTRUMENT
+    // Latency stamps from the parser's free-running cycle counter (see parse_wide_core):
+    // the cycle the message's first byte arrived and the cycle it was emitted (valid_msg).
+    // Only built with -DITCH_INSTRUMENT, which host and kernel must agree on.
+    uint64_t first_cycle;
+    uint64_t done_cycle;
+#endif
+} ParserOutput;
+
+// Returns the total length of a message of the given type, or 0 if the type is not supported
+static inline int itch_msg_length(uint8_t msg_type) {
+    switch (msg_type) {
+        case ITCH_ADD_ORDER:      return ITCH_ADD_ORDER_LEN;
+        case ITCH_ORDER_DELETE:   return ITCH_ORDER_DELETE_LEN;
+        case ITCH_ORDER_EXECUTED: return ITCH_ORDER_EXECUTED_LEN;
+        case ITCH_ADD_ORDER_MPID: return ITCH_ADD_ORDER_MPID_LEN;
+        case ITCH_ORDER_REPLACE:  return ITCH_ORDER_REPLACE_LEN;
+        case ITCH_ORDER_CANCEL:   return ITCH_ORDER_CANCEL_LEN;
+        default:                  return 0;
+    }
+}
+
+// Returns the total length of any ITCH 5.0 message type, or 0 if the type is not in the spec
+static inline int itch_spec_msg_length(uint8_t msg_type) {
+    switch (msg_type) {
+        case ITCH_SYSTEM_EVENT:         return ITCH_SYSTEM_EVENT_LEN;
+        case ITCH_STOCK_DIRECTORY:      return ITCH_STOCK_DIRECTORY_LEN;
+        case ITCH_STOCK_TRADING_ACTION: return ITCH_STOCK_TRADING_ACTION_LEN;
+        case ITCH_REG_SHO:              return ITCH_REG_SHO_LEN;
+        case ITCH_MARKET_PARTICIPANT:   return ITCH_MARKET_PARTICIPANT_LEN;
+        case ITCH_MWCB_DECLINE_LEVEL:   return ITCH_MWCB_DECLINE_LEVEL_LEN;
+        case ITCH_MWCB_STATUS:          return ITCH_MWCB_STATUS_LEN;
+        case ITCH_IPO_QUOTING_PERIOD:   return ITCH_IPO_QUOTING_PERIOD_LEN;
+        case ITCH_LULD_AUCTION_COLLAR:  return ITCH_LULD_AUCTION_COLLAR_LEN;
+        case ITCH_OPERATIONAL_HALT:     return ITCH_OPERATIONAL_HALT_LEN;
+        case ITCH_ORDER_EXECUTED_PRICE: return ITCH_ORDER_EXECUTED_PRICE_LEN;
+        case ITCH_TRADE:                return ITCH_TRADE_LEN;
+        case ITCH_CROSS_TRADE:          return ITCH_CROSS_TRADE_LEN;
+        case ITCH_BROKEN_TRADE:         return ITCH_BROKEN_TRADE_LEN;
+        case ITCH_NOII:                 return ITCH_NOII_LEN;
+        case ITCH_RPII:                 return ITCH_RPII_LEN;
+        case ITCH_DLCR_PRICE_DISCOVERY: return ITCH_DLCR_PRICE_DISCOVERY_LEN;
+        default:                        return itch_msg_length(msg_type);
+    }
+}
+
+#endif
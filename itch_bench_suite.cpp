@@ -0,0 +1,319 @@
+// Throughput of every decoding path over one BinaryFILE feed, with machine-readable results.
+//
+// Paths:
+//   cpu_decoder  itch_decode_framed() over the whole feed, in batches like a real consumer
+//   hls_csim     parse_wide_core as built into parser_framed, run natively (C-sim speed)
+//   hls_model    the same run, timed by the kernel's cycle model at the kernel clock instead of
+//                the wall clock: what one compute unit would sustain on the card
+//   kernel       parser_framed through accel_runtime.h: the card, a Vitis emulation
+//                (XCL_EMULATION_MODE=sw_emu/hw_emu) or ACCEL_BACKEND=cpu; only with xclbin=
+//
+// C-sim and the kernel are slow next to the CPU decoder, so they run on the first csim_mb MB
+// of the feed (whole chunks). Each is checked against the CPU decoder over the same bytes, via
+// an order-sensitive checksum of every record.
+//
+// Every path writes one JSON object per line to results= (appended, so a file accumulates a
+// history). With baseline=, each path's msgs/s is compared with the last result for the same
+// path and feed in that file, and the run fails if any dropped by more than tolerance= percent.
+//
+// Build: g++ -O3 -pthread -I$XILINX_HLS/include -o itch_bench_suite itch_bench_suite.cpp itch_replay.c
+//            parser_wide.cpp accel_runtime.cpp accel_opencl.cpp accel_cpu.cpp double_vector.cpp
+//            Archive/parser.cpp Archive/deserializer.cpp libitch.a -lOpenCL
+// Usage: ./itch_bench_suite <feed> [csim_mb=8] [chunk_kb=1024] [mhz=300] [xclbin=path] [label=text]
+//                           [results=file.jsonl] [baseline=file.jsonl] [tolerance=10]
+// Feeds come from itch_feedgen.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ap_int.h>
+#include "accel_runtime.h"
+#include "itch_decoder.h"
+#include "itch_replay.h"
+#include "parser_wide.h"
+
+// Records decoded per call by the CPU path
+#define BATCH_OUTPUTS 4096
+
+struct PathResult {
+    std::string path;
+    size_t bytes;
+    size_t messages;
+    double seconds;
+    uint64_t checksum;
+    int verified;   // 1 matched the CPU decoder, 0 mismatched, -1 is the reference itself
+};
+
+struct Options {
+    const char* feed;
+    size_t csim_bytes;
+    size_t chunk_size;
+    double mhz;
+    const char* xclbin;
+    const char* label;
+    const char* results;
+    const char* baseline;
+    double tolerance;
+};
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Order-sensitive hash of the fields every record carries, as in itch_stream_host.c
+static uint64_t checksum_records(uint64_t h, const ParserOutput* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ out[i].msg_type) * 0x100000001B3ULL;
+        h = (h ^ out[i].stock_locate) * 0x100000001B3ULL;
+        h = (h ^ out[i].timestamp) * 0x100000001B3ULL;
+        h = (h ^ out[i].order_ref_no) * 0x100000001B3ULL;
+    }
+    return h;
+}
+
+static size_t max_outputs_for(size_t chunk_size) {
+    return (chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+}
+
+// CPU decoder over the feed's chunks until `limit` bytes have been covered
+static PathResult run_cpu(const Options& opt, size_t limit) {
+    PathResult r = {"cpu_decoder", 0, 0, 0, 0xCBF29CE484222325ULL, -1};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return r;
+    std::vector<ParserOutput> outputs(BATCH_OUTPUTS);
+    const uint8_t* chunk;
+    size_t len;
+    double start = now_seconds();
+    while (r.bytes < limit && itch_replay_next(&replay, &chunk, &len)) {
+        size_t pos = 0;
+        while (pos < len) {
+            size_t consumed = 0;
+            size_t n = itch_decode_framed(chunk + pos, len - pos, outputs.data(), BATCH_OUTPUTS, &consumed);
+            r.checksum = checksum_records(r.checksum, outputs.data(), n);
+            r.messages += n;
+            if (consumed == 0) break;
+            pos += consumed;
+        }
+        r.bytes += len;
+    }
+    r.seconds = now_seconds() - start;
+    itch_replay_close(&replay);
+    return r;
+}
+
+// parse_wide_core in C-sim; fills both hls_csim (wall clock) and hls_model (cycle model)
+static void run_csim(const Options& opt, PathResult& csim, PathResult& model) {
+    csim = {"hls_csim", 0, 0, 0, 0xCBF29CE484222325ULL, 0};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return;
+    std::vector<ParserOutput> outputs(max_outputs_for(opt.chunk_size));
+    std::vector<ap_uint<512> > beats;
+    uint64_t cycles = 0;
+    const uint8_t* chunk;
+    size_t len;
+    while (csim.bytes < opt.csim_bytes && itch_replay_next(&replay, &chunk, &len)) {
+        // Packing the chunk into beats is the DMA's job, so it is not timed
+        beats.assign((len + 63) / 64 + 1, 0);
+        for (size_t i = 0; i < len; i++) beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = chunk[i];
+
+        int n = 0;
+        double start = now_seconds();
+        cycles += parse_wide_core<64, INPUT_FRAMED>(beats.data(), (int)len, outputs.data(), &n);
+        csim.seconds += now_seconds() - start;
+        csim.checksum = checksum_records(csim.checksum, outputs.data(), n);
+        csim.messages += n;
+        csim.bytes += len;
+    }
+    itch_replay_close(&replay);
+    model = csim;
+    model.path = "hls_model";
+    model.seconds = cycles / (opt.mhz * 1e6);
+}
+
+// parser_framed through accel_runtime.h, one chunk at a time: write, run, read back
+static int run_kernel(const Options& opt, PathResult& r) {
+    r = {"kernel", 0, 0, 0, 0xCBF29CE484222325ULL, 0};
+    std::unique_ptr<AccelDevice> dev = accel_open(accel_backend_from_env());
+    if (!dev || dev->load(opt.xclbin) != 0) return -1;
+    AccelKernel* kernel = dev->kernel("parser_framed");
+    if (!kernel) {
+        printf("kernel: %s has no parser_framed kernel\n", opt.xclbin);
+        return -1;
+    }
+    r.path = std::string("kernel_") + dev->name();
+
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return -1;
+    size_t max_outputs = max_outputs_for(opt.chunk_size);
+    AccelBuffer* input = dev->buffer(opt.chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN + 64, ACCEL_READ_ONLY);
+    AccelBuffer* output = dev->buffer(max_outputs * sizeof(ParserOutput), ACCEL_WRITE_ONLY);
+    AccelBuffer* num_outputs = dev->buffer(sizeof(int));
+    std::vector<ParserOutput> records(max_outputs);
+    kernel->set_arg(0, input);
+    kernel->set_arg(2, output);
+    kernel->set_arg(3, num_outputs);
+
+    const uint8_t* chunk;
+    size_t len;
+    double start = now_seconds();
+    while (r.bytes < opt.csim_bytes && itch_replay_next(&replay, &chunk, &len)) {
+        kernel->set_scalar(1, (int32_t)len);
+        AccelEvent sent = dev->write(input, chunk, len);
+        AccelEvent ran = dev->run(kernel, {sent});
+        dev->wait(dev->to_host(num_outputs, {ran}));
+        int n = *(int*)num_outputs->host();
+        dev->wait(dev->read(output, records.data(), (size_t)n * sizeof(ParserOutput)));
+        r.checksum = checksum_records(r.checksum, records.data(), n);
+        r.messages += n;
+        r.bytes += len;
+    }
+    r.seconds = now_seconds() - start;
+    delete input;
+    delete output;
+    delete num_outputs;
+    itch_replay_close(&replay);
+    return 0;
+}
+
+static std::string json_line(const Options& opt, const PathResult& r, time_t when) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf),
+             "{\"time\": %lld, \"label\": \"%s\", \"feed\": \"%s\", \"path\": \"%s\", \"bytes\": %zu, "
+             "\"messages\": %zu, \"seconds\": %.6f, \"msgs_per_s\": %.0f, \"bytes_per_s\": %.0f, "
+             "\"checksum\": \"%016llx\", \"verified\": %s}",
+             (long long)when, opt.label, opt.feed, r.path.c_str(), r.bytes, r.messages, r.seconds,
+             r.seconds > 0 ? r.messages / r.seconds : 0.0, r.seconds > 0 ? r.bytes / r.seconds : 0.0,
+             (unsigned long long)r.checksum, r.verified < 0 ? "null" : r.verified ? "true" : "false");
+    return buf;
+}
+
+// Pulls a string or number field out of one of our own JSON lines
+static int json_field(const char* line, const char* key, char* value, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* p = strstr(line, pattern);
+    if (!p) return -1;
+    p += strlen(pattern);
+    if (*p == '"') p++;
+    size_t n = 0;
+    while (p[n] && p[n] != '"' && p[n] != ',' && p[n] != '}' && n + 1 < size) n++;
+    memcpy(value, p, n);
+    value[n] = 0;
+    return 0;
+}
+
+// Last msgs/s recorded for `path` on `feed` in the baseline file, or 0 if there is none
+static double baseline_rate(const char* file, const char* feed, const std::string& path) {
+    FILE* f = fopen(file, "r");
+    if (!f) return 0;
+    char line[2048], value[512];
+    double rate = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (json_field(line, "path", value, sizeof(value)) != 0 || path != value) continue;
+        if (json_field(line, "feed", value, sizeof(value)) != 0 || strcmp(value, feed) != 0) continue;
+        if (json_field(line, "msgs_per_s", value, sizeof(value)) == 0) rate = atof(value);
+    }
+    fclose(f);
+    return rate;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <feed> [csim_mb=8] [chunk_kb=1024] [mhz=300] [xclbin=path] [label=text]\n"
+               "       [results=file.jsonl] [baseline=file.jsonl] [tolerance=10]\n", argv[0]);
+        return 1;
+    }
+    Options opt = {argv[1], 8u << 20, 1u << 20, 300.0, NULL, "", NULL, NULL, 10.0};
+    for (int i = 2; i < argc; i++) {
+        const char* a = argv[i];
+        if (strncmp(a, "csim_mb=", 8) == 0) opt.csim_bytes = strtoull(a + 8, NULL, 10) << 20;
+        else if (strncmp(a, "chunk_kb=", 9) == 0) opt.chunk_size = strtoull(a + 9, NULL, 10) << 10;
+        else if (strncmp(a, "mhz=", 4) == 0) opt.mhz = atof(a + 4);
+        else if (strncmp(a, "xclbin=", 7) == 0) opt.xclbin = a + 7;
+        else if (strncmp(a, "label=", 6) == 0) opt.label = a + 6;
+        else if (strncmp(a, "results=", 8) == 0) opt.results = a + 8;
+        else if (strncmp(a, "baseline=", 9) == 0) opt.baseline = a + 9;
+        else if (strncmp(a, "tolerance=", 10) == 0) opt.tolerance = atof(a + 10);
+        else {
+            printf("Error: unknown argument %s\n", a);
+            return 1;
+        }
+    }
+    if (opt.chunk_size == 0 || opt.mhz <= 0) {
+        printf("Error: chunk_kb and mhz must be positive\n");
+        return 1;
+    }
+
+    ItchReplay probe;
+    if (itch_replay_open(&probe, opt.feed, opt.chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", opt.feed, strerror(errno));
+        return 1;
+    }
+    size_t feed_size = probe.size;
+    itch_replay_close(&probe);
+
+    std::vector<PathResult> results;
+    results.push_back(run_cpu(opt, SIZE_MAX));
+
+    int errors = 0;
+    if (opt.csim_bytes > 0) {
+        PathResult reference = run_cpu(opt, opt.csim_bytes);
+        PathResult csim, model;
+        run_csim(opt, csim, model);
+        csim.verified = model.verified = csim.checksum == reference.checksum && csim.messages == reference.messages;
+        results.push_back(csim);
+        results.push_back(model);
+
+        if (opt.xclbin) {
+            PathResult kernel;
+            if (run_kernel(opt, kernel) == 0) {
+                kernel.verified = kernel.checksum == reference.checksum && kernel.messages == reference.messages;
+                results.push_back(kernel);
+            } else {
+                errors++;
+            }
+        }
+    }
+
+    printf("Feed %s: %.1f MB%s%s\n", opt.feed, feed_size / 1048576.0, *opt.label ? ", " : "", opt.label);
+    printf("%-18s %10s %12s %10s %14s %10s %10s\n", "path", "MB", "messages", "seconds", "msgs/s", "MB/s",
+           "verified");
+    for (const PathResult& r : results) {
+        printf("%-18s %10.1f %12zu %10.3f %14.0f %10.1f %10s\n", r.path.c_str(), r.bytes / 1048576.0, r.messages,
+               r.seconds, r.seconds > 0 ? r.messages / r.seconds : 0.0,
+               r.seconds > 0 ? r.bytes / r.seconds / 1048576.0 : 0.0,
+               r.verified < 0 ? "reference" : r.verified ? "yes" : "NO");
+        if (r.verified == 0 || r.messages == 0) errors++;
+    }
+
+    if (opt.baseline) {
+        for (const PathResult& r : results) {
+            double old_rate = baseline_rate(opt.baseline, opt.feed, r.path);
+            if (old_rate <= 0 || r.seconds <= 0) continue;
+            double change = 100.0 * (r.messages / r.seconds - old_rate) / old_rate;
+            int regressed = change < -opt.tolerance;
+            printf("%-18s %+.1f%% against baseline%s\n", r.path.c_str(), change, regressed ? "  REGRESSION" : "");
+            errors += regressed;
+        }
+    }
+
+    if (opt.results) {
+        FILE* f = fopen(opt.results, "a");
+        if (!f) {
+            printf("Error: could not open %s (%s)\n", opt.results, strerror(errno));
+            return 1;
+        }
+        time_t when = time(NULL);
+        for (const PathResult& r : results) fprintf(f, "%s\n", json_line(opt, r, when).c_str());
+        fclose(f);
+    }
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
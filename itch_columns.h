@@ -0,0 +1,182 @@
+#ifndef ITCH_COLUMNS_H
+#define ITCH_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "itch.h"
+
+// Columnar (structure-of-arrays) parser output.
+//
+// Each order book message type has its own column set, and every field a type carries is a
+// contiguous array in that set: add_order.price[i] is the price of the i-th Add Order. A scan
+// over one field then reads only that field, with no ParserOutput stride and no msg_type test,
+// and compiles to plain vector loops. Records of different types lose their relative order; the
+// timestamp column gives it back where a query needs it.
+//
+// All columns live in one buffer, set by set in ITCH_SET_* order and column by column in
+// ITCH_COL_* order within a set. Each column holds its set's capacity in records, rounded up to
+// ITCH_COLUMN_ALIGN so that every column starts on a 64-byte boundary (one gmem beat) and the
+// kernel only ever writes whole beats. Fields are little-endian, in host byte order on x86.
+
+// Column sets, one per order book message type
+#define ITCH_SET_ADD          0    // A
+#define ITCH_SET_ADD_MPID     1    // F
+#define ITCH_SET_EXECUTED     2    // E
+#define ITCH_SET_CANCEL       3    // X
+#define ITCH_SET_DELETE       4    // D
+#define ITCH_SET_REPLACE      5    // U
+#define ITCH_COLUMN_SETS      6
+
+// Columns, with their element sizes in bytes
+#define ITCH_COL_TIMESTAMP         0    // 8
+#define ITCH_COL_ORDER_REF_NO      1    // 8
+#define ITCH_COL_STOCK_LOCATE      2    // 2
+#define ITCH_COL_TRACKING_NO       3    // 2
+#define ITCH_COL_SHARES            4    // 4
+#define ITCH_COL_PRICE             5    // 4
+#define ITCH_COL_BUY_SELL          6    // 1
+#define ITCH_COL_STOCK             7    // 8
+#define ITCH_COL_MATCH_NO          8    // 8
+#define ITCH_COL_NEW_ORDER_REF_NO  9    // 8
+#define ITCH_COL_ATTRIBUTION       10   // 4
+#define ITCH_COLUMNS               11
+
+// Records per column are rounded up to this, so each column is whole 64-byte words
+#define ITCH_COLUMN_ALIGN 64
+
+// The columns every set carries
+#define ITCH_HEADER_COLUMNS ((1u << ITCH_COL_TIMESTAMP) | (1u << ITCH_COL_ORDER_REF_NO) | \
+                             (1u << ITCH_COL_STOCK_LOCATE) | (1u << ITCH_COL_TRACKING_NO))
+
+// One set's view into the column buffer. Columns the type does not carry are null.
+typedef struct {
+    uint64_t* timestamp;
+    uint64_t* order_ref_no;
+    uint16_t* stock_locate;
+    uint16_t* tracking_no;
+    uint32_t* shares;
+    uint32_t* price;
+    uint8_t*  buy_sell;
+    uint64_t* stock;
+    uint64_t* match_no;
+    uint64_t* new_order_ref_no;
+    uint32_t* attribution;
+    size_t count;             // records held
+    size_t capacity;          // records the columns have room for
+} ItchColumnSet;
+
+typedef struct {
+    ItchColumnSet set[ITCH_COLUMN_SETS];
+} ItchColumns;
+
+static inline int itch_column_bytes(int col) {
+    switch (col) {
+        case ITCH_COL_STOCK_LOCATE:
+        case ITCH_COL_TRACKING_NO:  return 2;
+        case ITCH_COL_SHARES:
+        case ITCH_COL_PRICE:
+        case ITCH_COL_ATTRIBUTION:  return 4;
+        case ITCH_COL_BUY_SELL:     return 1;
+        default:                    return 8;
+    }
+}
+
+// Column set of a message type, or -1 if the type has none
+static inline int itch_column_set(uint8_t msg_type) {
+    switch (msg_type) {
+        case ITCH_ADD_ORDER:      return ITCH_SET_ADD;
+        case ITCH_ADD_ORDER_MPID: return ITCH_SET_ADD_MPID;
+        case ITCH_ORDER_EXECUTED: return ITCH_SET_EXECUTED;
+        case ITCH_ORDER_CANCEL:   return ITCH_SET_CANCEL;
+        case ITCH_ORDER_DELETE:   return ITCH_SET_DELETE;
+        case ITCH_ORDER_REPLACE:  return ITCH_SET_REPLACE;
+        default:                  return -1;
+    }
+}
+
+// Bitmask of the ITCH_COL_* columns a set carries
+static inline uint32_t itch_set_columns(int set) {
+    const uint32_t add = ITCH_HEADER_COLUMNS | (1u << ITCH_COL_SHARES) | (1u << ITCH_COL_PRICE) |
+                         (1u << ITCH_COL_BUY_SELL) | (1u << ITCH_COL_STOCK);
+    switch (set) {
+        case ITCH_SET_ADD:      return add;
+        case ITCH_SET_ADD_MPID: return add | (1u << ITCH_COL_ATTRIBUTION);
+        case ITCH_SET_EXECUTED: return ITCH_HEADER_COLUMNS | (1u << ITCH_COL_SHARES) | (1u << ITCH_COL_MATCH_NO);
+        case ITCH_SET_CANCEL:   return ITCH_HEADER_COLUMNS | (1u << ITCH_COL_SHARES);
+        case ITCH_SET_DELETE:   return ITCH_HEADER_COLUMNS;
+        case ITCH_SET_REPLACE:  return ITCH_HEADER_COLUMNS | (1u << ITCH_COL_SHARES) | (1u << ITCH_COL_PRICE) |
+                                       (1u << ITCH_COL_NEW_ORDER_REF_NO);
+        default:                return 0;
+    }
+}
+
+static inline size_t itch_columns_round(size_t records) {
+    return (records + ITCH_COLUMN_ALIGN - 1) / ITCH_COLUMN_ALIGN * ITCH_COLUMN_ALIGN;
+}
+
+// Byte offset of a column in the buffer, given every set's capacity in records. Passing
+// ITCH_COLUMN_SETS as `set` gives the size of the whole buffer.
+static inline size_t itch_column_offset(const size_t* capacity, int set, int col) {
+    size_t offset = 0;
+    for (int s = 0; s <= set && s < ITCH_COLUMN_SETS; s++) {
+        uint32_t cols = itch_set_columns(s);
+        for (int c = 0; c < ITCH_COLUMNS; c++) {
+            if (s == set && c == col) return offset;
+            if (cols & (1u << c)) offset += itch_columns_round(capacity[s]) * itch_column_bytes(c);
+        }
+    }
+    return offset;
+}
+
+static inline size_t itch_columns_size(const size_t* capacity) {
+    return itch_column_offset(capacity, ITCH_COLUMN_SETS, 0);
+}
+
+// Points `columns` at a buffer of itch_columns_size(capacity) bytes, 64-byte aligned, and empties
+// every set
+static inline void itch_columns_bind(ItchColumns* columns, void* buf, const size_t* capacity) {
+    uint8_t* base = (uint8_t*)buf;
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        ItchColumnSet* set = &columns->set[s];
+        uint32_t cols = itch_set_columns(s);
+        void* col[ITCH_COLUMNS];
+        for (int c = 0; c < ITCH_COLUMNS; c++) {
+            col[c] = cols & (1u << c) ? base + itch_column_offset(capacity, s, c) : 0;
+        }
+        set->timestamp = (uint64_t*)col[ITCH_COL_TIMESTAMP];
+        set->order_ref_no = (uint64_t*)col[ITCH_COL_ORDER_REF_NO];
+        set->stock_locate = (uint16_t*)col[ITCH_COL_STOCK_LOCATE];
+        set->tracking_no = (uint16_t*)col[ITCH_COL_TRACKING_NO];
+        set->shares = (uint32_t*)col[ITCH_COL_SHARES];
+        set->price = (uint32_t*)col[ITCH_COL_PRICE];
+        set->buy_sell = (uint8_t*)col[ITCH_COL_BUY_SELL];
+        set->stock = (uint64_t*)col[ITCH_COL_STOCK];
+        set->match_no = (uint64_t*)col[ITCH_COL_MATCH_NO];
+        set->new_order_ref_no = (uint64_t*)col[ITCH_COL_NEW_ORDER_REF_NO];
+        set->attribution = (uint32_t*)col[ITCH_COL_ATTRIBUTION];
+        set->count = 0;
+        set->capacity = capacity[s];
+    }
+}
+
+// Appends a decoded record to its set. Returns 1, or 0 if the type has no set or the set is full.
+static inline int itch_columns_append(ItchColumns* columns, const ParserOutput* out) {
+    int s = itch_column_set(out->msg_type);
+    if (s < 0 || columns->set[s].count >= columns->set[s].capacity) return 0;
+    ItchColumnSet* set = &columns->set[s];
+    size_t i = set->count++;
+    set->timestamp[i] = out->timestamp;
+    set->order_ref_no[i] = out->order_ref_no;
+    set->stock_locate[i] = out->stock_locate;
+    set->tracking_no[i] = out->tracking_no;
+    if (set->shares) set->shares[i] = out->shares;
+    if (set->price) set->price[i] = out->price;
+    if (set->buy_sell) set->buy_sell[i] = out->buy_sell;
+    if (set->stock) set->stock[i] = out->stock;
+    if (set->match_no) set->match_no[i] = out->match_no;
+    if (set->new_order_ref_no) set->new_order_ref_no[i] = out->new_order_ref_no;
+    if (set->attribution) set->attribution[i] = out->attribution;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,234 @@
+// AoS vs SoA: typical aggregation queries over the same decoded feed, once as an array of
+// ParserOutput records and once as column sets (itch_columns.h).
+//
+// The feed is decoded both ways (itch_decode_framed and itch_decode_framed_columns, both timed),
+// then every query runs over each layout and must give the same answer:
+//   notional     sum of shares * price over every add (A, F)
+//   exec volume  executed shares per stock_locate (E), a group-by into 65536 buckets
+//   time span    first and last timestamp over every order message
+//   buy adds     adds on the buy side at or above a price
+// Reported per query: best time over the passes, the bytes each layout has to read, and the
+// resulting GB/s. The AoS scan reads whole 72-byte records and tests msg_type; the SoA scan reads
+// only the columns the query names, with no type test.
+//
+// Build: g++ -O3 -c itch_decoder.cpp && ar rcs libitch.a itch_decoder.o
+//        g++ -O3 -march=native -o itch_columns_bench itch_columns_bench.cpp itch_replay.c libitch.a
+// Usage: ./itch_columns_bench [feed, default a generated 64 MB feed] [passes=5]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_feedgen.h"
+#include "itch_replay.h"
+
+#define GENERATED_BYTES (64u << 20)
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME  0x100000001B3ULL
+
+static const uint8_t kAddSets[] = {ITCH_SET_ADD, ITCH_SET_ADD_MPID};
+
+// Query answers; a query fills the fields it computes
+struct Answer {
+    uint64_t a, b;
+    bool operator==(const Answer& o) const { return a == o.a && b == o.b; }
+};
+
+static uint64_t hash_buckets(const std::vector<uint64_t>& buckets) {
+    uint64_t h = FNV_OFFSET;
+    for (uint64_t v : buckets) h = (h ^ v) * FNV_PRIME;
+    return h;
+}
+
+// AoS queries
+
+static Answer aos_notional(const ParserOutput* r, size_t n, uint32_t) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (r[i].msg_type == ITCH_ADD_ORDER || r[i].msg_type == ITCH_ADD_ORDER_MPID) {
+            sum += (uint64_t)r[i].shares * r[i].price;
+        }
+    }
+    return {sum, 0};
+}
+
+static Answer aos_exec_volume(const ParserOutput* r, size_t n, uint32_t) {
+    std::vector<uint64_t> volume(STOCK_FILTER_BITS, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (r[i].msg_type == ITCH_ORDER_EXECUTED) volume[r[i].stock_locate] += r[i].shares;
+    }
+    return {hash_buckets(volume), 0};
+}
+
+static Answer aos_time_span(const ParserOutput* r, size_t n, uint32_t) {
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (size_t i = 0; i < n; i++) {
+        lo = r[i].timestamp < lo ? r[i].timestamp : lo;
+        hi = r[i].timestamp > hi ? r[i].timestamp : hi;
+    }
+    return {lo, hi};
+}
+
+static Answer aos_buy_adds(const ParserOutput* r, size_t n, uint32_t min_price) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += (r[i].msg_type == ITCH_ADD_ORDER || r[i].msg_type == ITCH_ADD_ORDER_MPID) &&
+                 r[i].buy_sell == 'B' && r[i].price >= min_price;
+    }
+    return {count, 0};
+}
+
+// SoA queries: the same answers from the columns alone
+
+static Answer soa_notional(const ItchColumns& c, uint32_t) {
+    uint64_t sum = 0;
+    for (uint8_t s : kAddSets) {
+        const uint32_t* shares = c.set[s].shares;
+        const uint32_t* price = c.set[s].price;
+        size_t n = c.set[s].count;
+        for (size_t i = 0; i < n; i++) sum += (uint64_t)shares[i] * price[i];
+    }
+    return {sum, 0};
+}
+
+static Answer soa_exec_volume(const ItchColumns& c, uint32_t) {
+    std::vector<uint64_t> volume(STOCK_FILTER_BITS, 0);
+    const ItchColumnSet& e = c.set[ITCH_SET_EXECUTED];
+    for (size_t i = 0; i < e.count; i++) volume[e.stock_locate[i]] += e.shares[i];
+    return {hash_buckets(volume), 0};
+}
+
+static Answer soa_time_span(const ItchColumns& c, uint32_t) {
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        const uint64_t* ts = c.set[s].timestamp;
+        size_t n = c.set[s].count;
+        for (size_t i = 0; i < n; i++) {
+            lo = ts[i] < lo ? ts[i] : lo;
+            hi = ts[i] > hi ? ts[i] : hi;
+        }
+    }
+    return {lo, hi};
+}
+
+static Answer soa_buy_adds(const ItchColumns& c, uint32_t min_price) {
+    uint64_t count = 0;
+    for (uint8_t s : kAddSets) {
+        const uint8_t* side = c.set[s].buy_sell;
+        const uint32_t* price = c.set[s].price;
+        size_t n = c.set[s].count;
+        for (size_t i = 0; i < n; i++) count += (side[i] == 'B') & (price[i] >= min_price);
+    }
+    return {count, 0};
+}
+
+struct Query {
+    const char* name;
+    Answer (*aos)(const ParserOutput*, size_t, uint32_t);
+    Answer (*soa)(const ItchColumns&, uint32_t);
+    uint32_t columns;       // ITCH_COL_* the SoA scan reads
+    int sets_mask;          // column sets it reads them from
+};
+
+static const Query kQueries[] = {
+    {"notional", aos_notional, soa_notional, (1u << ITCH_COL_SHARES) | (1u << ITCH_COL_PRICE),
+     (1 << ITCH_SET_ADD) | (1 << ITCH_SET_ADD_MPID)},
+    {"exec volume", aos_exec_volume, soa_exec_volume, (1u << ITCH_COL_STOCK_LOCATE) | (1u << ITCH_COL_SHARES),
+     1 << ITCH_SET_EXECUTED},
+    {"time span", aos_time_span, soa_time_span, 1u << ITCH_COL_TIMESTAMP, (1 << ITCH_COLUMN_SETS) - 1},
+    {"buy adds", aos_buy_adds, soa_buy_adds, (1u << ITCH_COL_BUY_SELL) | (1u << ITCH_COL_PRICE),
+     (1 << ITCH_SET_ADD) | (1 << ITCH_SET_ADD_MPID)},
+};
+
+template <typename F>
+static double best_seconds(int passes, F&& f) {
+    double best = 1e30;
+    for (int p = 0; p < passes; p++) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (s < best) best = s;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const char* feed = argc > 1 ? argv[1] : NULL;
+    int passes = argc > 2 ? atoi(argv[2]) : 5;
+    if (passes < 1) {
+        printf("Usage: %s [feed] [passes, default 5]\n", argv[0]);
+        return 1;
+    }
+
+    // The feed, whole, in memory
+    std::vector<uint8_t> framed;
+    if (feed) {
+        ItchReplay replay;
+        if (itch_replay_open(&replay, feed, 64u << 20) != 0) {
+            printf("Error: could not open %s (%s)\n", feed, strerror(errno));
+            return 1;
+        }
+        const uint8_t* chunk;
+        size_t len;
+        while (itch_replay_next(&replay, &chunk, &len)) framed.insert(framed.end(), chunk, chunk + len);
+        itch_replay_close(&replay);
+    } else {
+        FeedGen gen;
+        feedgen_init(gen, feedgen_default_config());
+        feedgen_preamble(gen, framed);
+        while (framed.size() < GENERATED_BYTES) feedgen_append(gen, framed);
+    }
+
+    // Decode both ways; the AoS decode sizes the column sets
+    std::vector<ParserOutput> aos(framed.size() / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1);
+    size_t consumed = 0, n = 0;
+    double aos_decode = best_seconds(passes, [&] {
+        n = itch_decode_framed(framed.data(), framed.size(), aos.data(), aos.size(), &consumed);
+    });
+    aos.resize(n);
+
+    size_t capacity[ITCH_COLUMN_SETS] = {0};
+    for (const ParserOutput& r : aos) capacity[itch_column_set(r.msg_type)]++;
+    std::vector<uint64_t> column_buf(itch_columns_size(capacity) / 8 + 1);
+    ItchColumns cols;
+    size_t n_cols = 0;
+    double soa_decode = best_seconds(passes, [&] {
+        itch_columns_bind(&cols, column_buf.data(), capacity);
+        n_cols = itch_decode_framed_columns(framed.data(), framed.size(), &cols, &consumed);
+    });
+
+    printf("%s: %.1f MB, %zu order messages\n", feed ? feed : "generated feed", framed.size() / 1048576.0, n);
+    printf("%-12s %10s %10s %10s %10s %10s %10s %9s\n", "", "AoS ms", "SoA ms", "AoS MB", "SoA MB", "AoS GB/s",
+           "SoA GB/s", "speedup");
+    printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.2f %10.2f %8.2fx\n", "decode", aos_decode * 1e3,
+           soa_decode * 1e3, n * sizeof(ParserOutput) / 1048576.0, itch_columns_size(capacity) / 1048576.0,
+           framed.size() / aos_decode / 1e9, framed.size() / soa_decode / 1e9, aos_decode / soa_decode);
+
+    int errors = n_cols != n;
+    uint32_t min_price = n ? aos[n / 2].price : 0;
+    for (const Query& q : kQueries) {
+        Answer a = {0, 0}, b = {0, 0};
+        double t_aos = best_seconds(passes, [&] { a = q.aos(aos.data(), n, min_price); });
+        double t_soa = best_seconds(passes, [&] { b = q.soa(cols, min_price); });
+        size_t aos_bytes = n * sizeof(ParserOutput), soa_bytes = 0;
+        for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+            if (!(q.sets_mask & (1 << s))) continue;
+            for (int c = 0; c < ITCH_COLUMNS; c++) {
+                if (q.columns & itch_set_columns(s) & (1u << c)) soa_bytes += cols.set[s].count * itch_column_bytes(c);
+            }
+        }
+        bool ok = a == b;
+        errors += !ok;
+        printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.2f %10.2f %8.2fx %s\n", q.name, t_aos * 1e3, t_soa * 1e3,
+               aos_bytes / 1048576.0, soa_bytes / 1048576.0, aos_bytes / t_aos / 1e9, soa_bytes / t_soa / 1e9,
+               t_aos / t_soa, ok ? "" : "MISMATCH");
+    }
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+#ifndef ITCH_COMPACT_H
+#define ITCH_COMPACT_H
+
+#include <stdint.h>
+#include <string.h>
+#include "itch.h"
+
+// Compact, type-tagged parser output records.
+//
+// Instead of a fixed ParserOutput per message, the kernel packs records back to back:
+// 32 bytes for D/X/E messages and 48 bytes for A/F/U messages. Every record starts with
+// the message type (the tag) and its own length, so a reader can walk the buffer without
+// knowing the type set. Fields are stored little-endian, in host byte order on x86.
+// The 48-bit timestamp is split into 16 high and 32 low bits to keep the short record at 32 bytes.
+
+#define COMPACT_SHORT_LEN  32
+#define COMPACT_LONG_LEN   48
+
+// Records are written to gmem1 in 16-byte words
+#define COMPACT_WORD_BYTES 16
+
+// Order Delete (D), Order Cancel (X), Order Executed (E)
+typedef struct {
+    uint8_t  msg_type;        // record tag
+    uint8_t  length;          // COMPACT_SHORT_LEN
+    uint16_t stock_locate;
+    uint16_t tracking_no;
+    uint16_t timestamp_hi;    // timestamp[47:32]
+    uint32_t timestamp_lo;    // timestamp[31:0]
+    uint32_t shares;          // X, E
+    uint64_t order_ref_no;
+    uint64_t match_no;        // E only
+} CompactShortRecord;
+
+// Add Order (A), Add Order with MPID Attribution (F), Order Replace (U)
+typedef struct {
+    uint8_t  msg_type;        // record tag
+    uint8_t  length;          // COMPACT_LONG_LEN
+    uint16_t stock_locate;
+    uint16_t tracking_no;
+    uint16_t timestamp_hi;    // timestamp[47:32]
+    uint32_t timestamp_lo;    // timestamp[31:0]
+    uint32_t shares;
+    uint64_t order_ref_no;
+    union {
+        uint64_t stock;             // A, F
+        uint64_t new_order_ref_no;  // U
+    };
+    uint32_t price;
+    uint32_t attribution;     // F only
+    uint8_t  buy_sell;        // A, F
+    uint8_t  reserved[7];
+} CompactLongRecord;
+
+// Returns the compact record length for a message type, or 0 if the type has no record
+static inline int compact_record_length(uint8_t msg_type) {
+    switch (msg_type) {
+        case ITCH_ORDER_DELETE:
+        case ITCH_ORDER_CANCEL:
+        case ITCH_ORDER_EXECUTED:  return COMPACT_SHORT_LEN;
+        case ITCH_ADD_ORDER:
+        case ITCH_ADD_ORDER_MPID:
+        case ITCH_ORDER_REPLACE:   return COMPACT_LONG_LEN;
+        default:                   return 0;
+    }
+}
+
+// Host-side decoder: expands the record at `record` into a ParserOutput and returns its length,
+// or 0 if the tag is unknown
+static inline int compact_decode_record(const uint8_t* record, ParserOutput* out) {
+    memset(out, 0, sizeof(*out));
+    out->msg_type = record[0];
+    int len = compact_record_length(out->msg_type);
+    if (len == 0 || record[1] != len) return 0;
+
+    if (len == COMPACT_SHORT_LEN) {
+        CompactShortRecord r;
+        memcpy(&r, record, sizeof(r));
+        out->stock_locate = r.stock_locate;
+        out->tracking_no = r.tracking_no;
+        out->timestamp = ((uint64_t)r.timestamp_hi << 32) | r.timestamp_lo;
+        out->order_ref_no = r.order_ref_no;
+        out->shares = r.shares;
+        out->match_no = r.match_no;
+    } else {
+        CompactLongRecord r;
+        memcpy(&r, record, sizeof(r));
+        out->stock_locate = r.stock_locate;
+        out->tracking_no = r.tracking_no;
+        out->timestamp = ((uint64_t)r.timestamp_hi << 32) | r.timestamp_lo;
+        out->order_ref_no = r.order_ref_no;
+        out->shares = r.shares;
+        out->price = r.price;
+        if (out->msg_type == ITCH_ORDER_REPLACE) {
+            out->new_order_ref_no = r.new_order_ref_no;
+        } else {
+            out->stock = r.stock;
+            out->buy_sell = r.buy_sell;
+            out->attribution = r.attribution;
+        }
+    }
+    out->valid_msg = 1;
+    return len;
+}
+
+// Host-side decoder: walks `num_records` packed records and expands them into `out`.
+// Returns the number of records decoded, which is less than `num_records` only if a corrupt tag is found.
+static inline int compact_decode(const uint8_t* records, int num_records, ParserOutput* out) {
+    size_t pos = 0;
+    for (int i = 0; i < num_records; i++) {
+        int len = compact_decode_record(records + pos, &out[i]);
+        if (len == 0) return i;
+        pos += len;
+    }
+    return num_records;
+}
+
+#endif
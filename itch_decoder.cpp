@@ -0,0 +1,323 @@
+#include <string.h>
+#include "itch_decoder.h"
+#include "itch_layout.h"
+
+// All multi-byte ITCH fields are big-endian. Fields are read with a single unaligned load
+// followed by a byte swap, instead of being shifted in one byte at a time.
+#if defined(__GNUC__) || defined(__clang__)
+#define BSWAP16(x) __builtin_bswap16(x)
+#define BSWAP32(x) __builtin_bswap32(x)
+#define BSWAP64(x) __builtin_bswap64(x)
+#else
+static inline uint16_t BSWAP16(uint16_t x) { return (uint16_t)((x >> 8) | (x << 8)); }
+static inline uint32_t BSWAP32(uint32_t x) {
+    return ((uint32_t)BSWAP16((uint16_t)x) << 16) | BSWAP16((uint16_t)(x >> 16));
+}
+static inline uint64_t BSWAP64(uint64_t x) {
+    return ((uint64_t)BSWAP32((uint32_t)x) << 32) | BSWAP32((uint32_t)(x >> 32));
+}
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define FROM_BE16(x) (x)
+#define FROM_BE32(x) (x)
+#define FROM_BE64(x) (x)
+#else
+#define FROM_BE16(x) BSWAP16(x)
+#define FROM_BE32(x) BSWAP32(x)
+#define FROM_BE64(x) BSWAP64(x)
+#endif
+
+static inline uint16_t load_be16(const uint8_t* p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return FROM_BE16(v);
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return FROM_BE32(v);
+}
+
+static inline uint64_t load_be64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return FROM_BE64(v);
+}
+
+// 6-byte timestamp: one 2-byte and one 4-byte load
+static inline uint64_t load_be48(const uint8_t* p) {
+    return ((uint64_t)load_be16(p) << 32) | load_be32(p + 2);
+}
+
+// Field extractors generated from the ITCH_LAYOUT table in itch_layout.h. Each message type
+// gets its own straight-line decode function, and a 256-entry table of function pointers
+// indexed by the type byte picks one with a single indirect call.
+
+template <int N> static inline uint64_t load_be(const uint8_t* p);
+template <> inline uint64_t load_be<1>(const uint8_t* p) { return p[0]; }
+template <> inline uint64_t load_be<2>(const uint8_t* p) { return load_be16(p); }
+template <> inline uint64_t load_be<4>(const uint8_t* p) { return load_be32(p); }
+template <> inline uint64_t load_be<6>(const uint8_t* p) { return load_be48(p); }
+template <> inline uint64_t load_be<8>(const uint8_t* p) { return load_be64(p); }
+
+// Stores an integer in host byte order at the width of its ItchRecord member
+template <int N>
+static inline void store_host(uint8_t* p, uint64_t value) {
+    if (N == 1) {
+        *p = (uint8_t)value;
+    } else if (N == 2) {
+        uint16_t v = (uint16_t)value;
+        memcpy(p, &v, sizeof(v));
+    } else if (N == 4) {
+        uint32_t v = (uint32_t)value;
+        memcpy(p, &v, sizeof(v));
+    } else {
+        memcpy(p, &value, sizeof(value));
+    }
+}
+
+struct OutputCtx {
+    const uint8_t* msg;
+    ParserOutput* out;
+};
+
+struct StoreOutputField {
+    template <int ROW>
+    static void field(OutputCtx& ctx) {
+        constexpr LayoutRow row = ITCH_LAYOUT[ROW];
+        set_output_field<row.field>(*ctx.out, load_be<row.width>(ctx.msg + row.offset));
+    }
+};
+
+struct RecordCtx {
+    const uint8_t* msg;
+    uint8_t* rec;
+};
+
+struct StoreRecordField {
+    template <int ROW>
+    static void field(RecordCtx& ctx) {
+        constexpr LayoutRow row = ITCH_LAYOUT[ROW];
+        if (row.kind == KIND_ALPHA) {
+            memcpy(ctx.rec + row.rec_offset, ctx.msg + row.offset, row.width);
+        } else {
+            store_host<row.width>(ctx.rec + row.rec_offset, load_be<row.width>(ctx.msg + row.offset));
+        }
+    }
+};
+
+typedef void (*OutputDecoder)(const uint8_t* msg, ParserOutput* out);
+typedef void (*RecordDecoder)(const uint8_t* msg, ItchRecord* out);
+
+template <int MSG_TYPE>
+static void decode_output_type(const uint8_t* msg, ParserOutput* out) {
+    out->valid_msg = 1;
+    out->shares = 0;
+    out->buy_sell = 0;
+    out->stock = 0;
+    out->price = 0;
+    out->match_no = 0;
+    out->new_order_ref_no = 0;
+    out->attribution = 0;
+#ifdef ITCH_INSTRUMENT
+    out->first_cycle = 0;
+    out->done_cycle = 0;
+#endif
+    OutputCtx ctx = {msg, out};
+    LayoutFields<ITCH_LAYOUT_HEADER, StoreOutputField>::visit(ctx);
+    LayoutFields<MSG_TYPE, StoreOutputField>::visit(ctx);
+}
+
+template <int MSG_TYPE>
+static void decode_record_type(const uint8_t* msg, ItchRecord* out) {
+    memset(out, 0, sizeof(*out));
+    RecordCtx ctx = {msg, (uint8_t*)out};
+    LayoutFields<ITCH_LAYOUT_HEADER, StoreRecordField>::visit(ctx);
+    LayoutFields<MSG_TYPE, StoreRecordField>::visit(ctx);
+}
+
+// Per-type lengths and decoders, indexed by the type byte. A length of 0 marks a type that is
+// not decoded into that format; its decoder is never called.
+template <int... T>
+struct DecoderTables {
+    static constexpr uint8_t output_length[256] = {
+        (uint8_t)(layout_in_parser_output(T) ? layout_length(T) : 0)...
+    };
+    static constexpr uint8_t record_length[256] = {(uint8_t)layout_length(T)...};
+    static constexpr OutputDecoder output[256] = {&decode_output_type<T>...};
+    static constexpr RecordDecoder record[256] = {&decode_record_type<T>...};
+};
+
+template <int... T> constexpr uint8_t DecoderTables<T...>::output_length[256];
+template <int... T> constexpr uint8_t DecoderTables<T...>::record_length[256];
+template <int... T> constexpr OutputDecoder DecoderTables<T...>::output[256];
+template <int... T> constexpr RecordDecoder DecoderTables<T...>::record[256];
+
+template <int N, int... T>
+struct MakeDecoderTables : MakeDecoderTables<N - 1, N - 1, T...> {};
+
+template <int... T>
+struct MakeDecoderTables<0, T...> {
+    typedef DecoderTables<T...> type;
+};
+
+typedef MakeDecoderTables<256>::type Decoders;
+
+int itch_decode_message(const uint8_t* msg, size_t len, ParserOutput* out) {
+    uint8_t msg_type = msg[0];
+    if (len == 0 || Decoders::output_length[msg_type] != len) return 0;
+    Decoders::output[msg_type](msg, out);
+    return 1;
+}
+
+int itch_decode_record(const uint8_t* msg, size_t len, ItchRecord* out) {
+    uint8_t msg_type = msg[0];
+    if (len == 0 || Decoders::record_length[msg_type] != len) return 0;
+    Decoders::record[msg_type](msg, out);
+    return 1;
+}
+
+
+size_t itch_decode_framed(const uint8_t* buf, size_t size, ParserOutput* outputs,
+                          size_t max_outputs, size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    while (count < max_outputs && pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = load_be16(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        count += itch_decode_message(buf + pos + ITCH_LENGTH_PREFIX, len, &outputs[count]);
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    *consumed = pos;
+    return count;
+}
+
+size_t itch_decode_framed_filtered(const uint8_t* buf, size_t size, const uint64_t* filter,
+                                   ParserOutput* outputs, size_t max_outputs, size_t* dropped,
+                                   size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    while (count < max_outputs && pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = load_be16(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        const uint8_t* msg = buf + pos + ITCH_LENGTH_PREFIX;
+        if (len < 3 || stock_filter_test(filter, load_be16(msg + 1))) {
+            count += itch_decode_message(msg, len, &outputs[count]);
+        } else {
+            *dropped += (size_t)itch_msg_length(msg[0]) == len;
+        }
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    *consumed = pos;
+    return count;
+}
+
+size_t itch_decode_framed_columns(const uint8_t* buf, size_t size, ItchColumns* columns, size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    while (pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = load_be16(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        ParserOutput out;
+        if (itch_decode_message(buf + pos + ITCH_LENGTH_PREFIX, len, &out)) {
+            if (!itch_columns_append(columns, &out)) break;
+            count++;
+        }
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    *consumed = pos;
+    return count;
+}
+
+size_t itch_decode_framed_records(const uint8_t* buf, size_t size, ItchRecord* outputs,
+                                  size_t max_outputs, size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    while (count < max_outputs && pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = load_be16(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        count += itch_decode_record(buf + pos + ITCH_LENGTH_PREFIX, len, &outputs[count]);
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    *consumed = pos;
+    return count;
+}
+
+size_t itch_decode_packed(const uint8_t* buf, size_t size, ParserOutput* outputs,
+                          size_t max_outputs, size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    while (count < max_outputs && pos < size) {
+        size_t len = (size_t)itch_msg_length(buf[pos]);
+        if (len == 0 || pos + len > size) break;
+        count += itch_decode_message(buf + pos, len, &outputs[count]);
+        pos += len;
+    }
+    *consumed = pos;
+    return count;
+}
+
+// Returns the total size of the packet at `buf`, or 0 if it is incomplete or a message block is empty or longer
+// than any ITCH 5.0 message
+static size_t mold_packet_size(const uint8_t* buf, size_t size, unsigned count) {
+    size_t pos = MOLD_HEADER_LEN;
+    for (unsigned i = 0; i < count; i++) {
+        if (pos + ITCH_LENGTH_PREFIX > size) return 0;
+        size_t len = load_be16(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) return 0;
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    return pos;
+}
+
+size_t itch_decode_moldudp64(const uint8_t* buf, size_t size, MoldState* state,
+                             ParserOutput* outputs, size_t max_outputs,
+                             MoldGap* gaps, size_t max_gaps, size_t* num_gaps, size_t* consumed) {
+    size_t pos = 0;
+    size_t count = 0;
+    size_t gap_count = 0;
+    while (pos + MOLD_HEADER_LEN <= size) {
+        const uint8_t* pkt = buf + pos;
+        uint64_t seq = load_be64(pkt + MOLD_SESSION_LEN);
+        unsigned msg_count = load_be16(pkt + MOLD_SESSION_LEN + 8);
+        bool end_of_session = msg_count == MOLD_END_OF_SESSION;
+        if (end_of_session) msg_count = 0;
+
+        size_t pkt_size = mold_packet_size(pkt, size - pos, msg_count);
+        if (pkt_size == 0 || count + msg_count > max_outputs) break;
+
+        bool new_session = !state->have_session ||
+                           memcmp(state->session, pkt, MOLD_SESSION_LEN) != 0;
+        if (new_session) {
+            memcpy(state->session, pkt, MOLD_SESSION_LEN);
+            state->have_session = 1;
+            state->end_of_session = 0;
+            state->next_seq = seq;
+        } else if (seq > state->next_seq) {
+            if (gap_count == max_gaps) break;
+            gaps[gap_count].expected_seq = state->next_seq;
+            gaps[gap_count].received_seq = seq;
+            gaps[gap_count].output_index = (uint32_t)count;
+            gaps[gap_count].reserved = 0;
+            gap_count++;
+            state->next_seq = seq;
+        }
+        if (end_of_session) state->end_of_session = 1;
+
+        size_t msg_pos = MOLD_HEADER_LEN;
+        for (unsigned i = 0; i < msg_count; i++, seq++) {
+            size_t len = load_be16(pkt + msg_pos);
+            if (seq >= state->next_seq) {
+                count += itch_decode_message(pkt + msg_pos + ITCH_LENGTH_PREFIX, len, &outputs[count]);
+                state->next_seq = seq + 1;
+            }
+            msg_pos += ITCH_LENGTH_PREFIX + len;
+        }
+        pos += pkt_size;
+    }
+    *num_gaps = gap_count;
+    *consumed = pos;
+    return count;
+}
@@ -0,0 +1,74 @@
+#ifndef ITCH_DECODER_H
+#define ITCH_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "itch.h"
+#include "itch_columns.h"
+#include "itch_records.h"
+#include "moldudp64.h"
+#include "stock_filter.h"
+
+// Portable CPU reference decoder. Produces exactly the ParserOutput records of the HLS
+// parser kernels, with no Vitis headers, so it can serve both as a fallback when the card
+// is unavailable and as a golden model for the kernels.
+//
+// Build as a static library:
+//   g++ -O3 -c itch_decoder.cpp && ar rcs libitch.a itch_decoder.o
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decodes one message (type byte first, `len` bytes). Returns 1 if the type is supported and
+// `len` matches its length, 0 otherwise (out is left untouched).
+int itch_decode_message(const uint8_t* msg, size_t len, ParserOutput* out);
+
+// Decodes a Nasdaq BinaryFILE buffer (2-byte big-endian length + message body, back to back)
+// into at most `max_outputs` records, skipping unsupported messages like parser_framed does.
+// Stops at the first incomplete message, at a zero length, or at a length over
+// ITCH_SPEC_MAX_MSG_LEN, which the kernels cannot buffer. Returns the number of records written
+// and sets *consumed to the number of input bytes fully processed.
+size_t itch_decode_framed(const uint8_t* buf, size_t size, ParserOutput* outputs,
+                          size_t max_outputs, size_t* consumed);
+
+// Like itch_decode_framed, but drops messages whose stock_locate is not set in `filter` (a
+// stock_filter.h bitmap) before they are written, like parser_filtered does. Messages that would
+// have been decoded but were filtered out are added to *dropped.
+size_t itch_decode_framed_filtered(const uint8_t* buf, size_t size, const uint64_t* filter,
+                                   ParserOutput* outputs, size_t max_outputs, size_t* dropped,
+                                   size_t* consumed);
+
+// Like itch_decode_framed, but appends each record to its column set in `columns` (see
+// itch_columns.h), after the records the sets already hold, like parser_columns does. Stops
+// before a message whose set is full. Returns the number of records written.
+size_t itch_decode_framed_columns(const uint8_t* buf, size_t size, ItchColumns* columns, size_t* consumed);
+
+// Decodes messages packed back to back with no framing (boundaries implied by each type, as
+// in parser_wide). Stops at an unsupported type or an incomplete message.
+size_t itch_decode_packed(const uint8_t* buf, size_t size, ParserOutput* outputs,
+                          size_t max_outputs, size_t* consumed);
+
+// Decodes one message of any ITCH 5.0 type into its type-specific record, exactly as parser_itch
+// does. Returns 1 if the type is in the spec and `len` matches its length, 0 otherwise.
+int itch_decode_record(const uint8_t* msg, size_t len, ItchRecord* out);
+
+// Like itch_decode_framed, but every ITCH 5.0 message becomes an ItchRecord; only types outside
+// the spec or with the wrong length are skipped.
+size_t itch_decode_framed_records(const uint8_t* buf, size_t size, ItchRecord* outputs,
+                                  size_t max_outputs, size_t* consumed);
+
+// Decodes MoldUDP64 packets back to back (see moldudp64.h), checking sequence numbers like
+// parser_moldudp64 does: a jump forward appends a MoldGap, messages already seen are dropped, and
+// *state is carried over to the next call. Only whole packets are decoded; stops before a packet
+// that is incomplete, malformed, or would overflow `outputs` or `gaps`. Returns the number of
+// records written, sets *num_gaps and sets *consumed to the end of the last packet decoded.
+size_t itch_decode_moldudp64(const uint8_t* buf, size_t size, MoldState* state,
+                             ParserOutput* outputs, size_t max_outputs,
+                             MoldGap* gaps, size_t max_gaps, size_t* num_gaps, size_t* consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
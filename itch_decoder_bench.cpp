@@ -0,0 +1,105 @@
+// Throughput benchmark for the CPU reference decoder.
+// Builds a synthetic BinaryFILE feed of the requested size by repeating a pool of random
+// messages, decodes it on 1..N threads and reports messages per second per core.
+//
+// Build: g++ -O3 -c itch_decoder.cpp && ar rcs libitch.a itch_decoder.o
+//        g++ -O3 -pthread -o itch_decoder_bench itch_decoder_bench.cpp libitch.a
+// Usage: ./itch_decoder_bench [feed size in MB, default 2048] [max threads, default all cores] [records]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+
+// Records decoded per call; small enough to stay in L2 like a real consumer's batch
+#define BATCH_OUTPUTS 4096
+
+struct ThreadResult {
+    size_t messages;
+    uint64_t checksum;   // keeps the decode from being optimised away
+};
+
+// Decodes one batch in either output format
+static size_t decode_batch(const uint8_t* buf, size_t size, ParserOutput* outputs, size_t* consumed,
+                           uint64_t* checksum) {
+    size_t n = itch_decode_framed(buf, size, outputs, BATCH_OUTPUTS, consumed);
+    for (size_t i = 0; i < n; i++) *checksum += outputs[i].order_ref_no ^ outputs[i].timestamp;
+    return n;
+}
+
+static size_t decode_batch(const uint8_t* buf, size_t size, ItchRecord* outputs, size_t* consumed,
+                           uint64_t* checksum) {
+    size_t n = itch_decode_framed_records(buf, size, outputs, BATCH_OUTPUTS, consumed);
+    for (size_t i = 0; i < n; i++) *checksum += outputs[i].order_delete.order_ref_no ^ outputs[i].timestamp;
+    return n;
+}
+
+// Decodes copies first, first + stride, ... of the pool within the feed
+template <typename OutT>
+static void decode_copies(const uint8_t* feed, size_t pool_size, size_t num_copies,
+                          size_t first, size_t stride, ThreadResult* result) {
+    std::vector<OutT> outputs(BATCH_OUTPUTS);
+    size_t messages = 0;
+    uint64_t checksum = 0;
+    for (size_t c = first; c < num_copies; c += stride) {
+        const uint8_t* buf = feed + c * pool_size;
+        size_t pos = 0;
+        while (pos < pool_size) {
+            size_t consumed = 0;
+            messages += decode_batch(buf + pos, pool_size - pos, outputs.data(), &consumed, &checksum);
+            pos += consumed;
+        }
+    }
+    result->messages = messages;
+    result->checksum = checksum;
+}
+
+int main(int argc, char** argv) {
+    size_t feed_mb = argc > 1 ? strtoull(argv[1], NULL, 10) : 2048;
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (max_threads < 1) max_threads = 1;
+    bool records = argc > 3 && strcmp(argv[3], "records") == 0;
+
+    // A pool well past the size of the last-level cache, so every copy streams from DRAM
+    std::vector<uint8_t> bytes;
+    while (bytes.size() < (32u << 20)) append_random_message(bytes);
+    std::vector<uint8_t> pool = to_framed(bytes, 0);
+
+    size_t num_copies = (feed_mb << 20) / pool.size();
+    if (num_copies == 0) num_copies = 1;
+    size_t feed_size = num_copies * pool.size();
+    uint8_t* feed = (uint8_t*)malloc(feed_size);
+    if (!feed) { printf("Error: could not allocate %zu byte feed\n", feed_size); return 1; }
+    for (size_t c = 0; c < num_copies; c++) memcpy(feed + c * pool.size(), pool.data(), pool.size());
+
+    printf("Feed: %.2f GB (%zu copies of a %.1f MB pool), decoding into %s\n\n", feed_size / 1e9, num_copies,
+           pool.size() / 1e6, records ? "ItchRecord" : "ParserOutput");
+    printf("%8s %12s %14s %18s %10s\n", "threads", "seconds", "GB/s", "msgs/s", "msgs/s/core");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<ThreadResult> results(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back(records ? decode_copies<ItchRecord> : decode_copies<ParserOutput>, feed, pool.size(), num_copies, (size_t)t, (size_t)threads, &results[t]);
+        }
+        for (auto& w : workers) w.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t messages = 0;
+        uint64_t checksum = 0;
+        for (auto& r : results) { messages += r.messages; checksum += r.checksum; }
+        printf("%8d %12.3f %14.2f %18.0f %10.3g   (checksum %016llx)\n", threads, seconds,
+               feed_size / seconds / 1e9, messages / seconds, messages / seconds / threads,
+               (unsigned long long)checksum);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+
+    free(feed);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Writes a synthetic Nasdaq BinaryFILE feed (see itch_feedgen.h) of the requested size.
+// Messages are generated and written in batches, so the size is bounded only by the disk.
+// Prints the mix actually written and how concentrated the symbol flow is.
+//
+// Build: g++ -O2 -o itch_feedgen itch_feedgen.cpp
+// Usage: ./itch_feedgen <output file> <size in MB> [mix=A=40,F=2,E=5,X=3,D=40,U=10] [stocks=8000]
+//                       [zipf=1.0] [resting=1000000] [seed=N]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include <vector>
+#include "itch_feedgen.h"
+
+// Bytes generated per write
+#define BATCH_BYTES (4u << 20)
+
+static void usage(const char* prog) {
+    printf("Usage: %s <output file> <size in MB> [mix=A=40,F=2,E=5,X=3,D=40,U=10] [stocks=8000] [zipf=1.0]\n"
+           "       [resting=1000000] [seed=N]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    uint64_t target = strtoull(argv[2], NULL, 10) << 20;
+    FeedConfig config = feedgen_default_config();
+    for (int i = 3; i < argc; i++) {
+        const char* arg = argv[i];
+        int ok = 1;
+        if (strncmp(arg, "mix=", 4) == 0) ok = feedgen_parse_mix(arg + 4, config.mix) == 0;
+        else if (strncmp(arg, "stocks=", 7) == 0) config.num_stocks = atoi(arg + 7);
+        else if (strncmp(arg, "zipf=", 5) == 0) config.zipf_s = atof(arg + 5);
+        else if (strncmp(arg, "resting=", 8) == 0) config.target_live = strtoull(arg + 8, NULL, 10);
+        else if (strncmp(arg, "seed=", 5) == 0) config.seed = strtoull(arg + 5, NULL, 0);
+        else ok = 0;
+        if (!ok) {
+            printf("Error: bad argument %s\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (target == 0 || config.num_stocks < 1 || config.num_stocks > 65535 || config.target_live < 1) {
+        printf("Error: size, stocks (1..65535) and resting orders must be positive\n");
+        return 1;
+    }
+
+    FILE* out = fopen(argv[1], "wb");
+    if (!out) {
+        printf("Error: could not create %s (%s)\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    FeedGen gen;
+    feedgen_init(gen, config);
+    std::vector<uint64_t> by_stock(65536);
+    std::vector<uint8_t> batch;
+    batch.reserve(BATCH_BYTES + 64);
+    feedgen_preamble(gen, batch);
+    do {
+        while (batch.size() < BATCH_BYTES && gen.bytes < target) {
+            size_t start = batch.size();
+            feedgen_append(gen, batch);
+            by_stock[(batch[start + 3] << 8) | batch[start + 4]]++;
+        }
+        if (fwrite(batch.data(), 1, batch.size(), out) != batch.size()) {
+            printf("Error: write to %s failed (%s)\n", argv[1], strerror(errno));
+            fclose(out);
+            return 1;
+        }
+        batch.clear();
+    } while (gen.bytes < target);
+    if (fclose(out) != 0) {
+        printf("Error: could not close %s (%s)\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    uint64_t orders = 0;
+    static const uint8_t types[] = {ITCH_ADD_ORDER, ITCH_ADD_ORDER_MPID, ITCH_ORDER_EXECUTED,
+                                    ITCH_ORDER_CANCEL, ITCH_ORDER_DELETE, ITCH_ORDER_REPLACE};
+    for (uint8_t t : types) orders += gen.counts[t];
+    printf("%s: %.1f MB, %llu messages (%llu order messages, %zu orders resting at the end)\n", argv[1],
+           gen.bytes / 1048576.0, (unsigned long long)gen.messages, (unsigned long long)orders,
+           gen.book.live.size());
+    printf("Mix:");
+    for (uint8_t t : types) printf("  %c %.1f%%", t, orders ? 100.0 * gen.counts[t] / orders : 0.0);
+    printf("\n");
+
+    std::sort(by_stock.begin(), by_stock.end(), [](uint64_t a, uint64_t b) { return a > b; });
+    uint64_t top1 = by_stock[0], top10 = 0, top100 = 0;
+    for (int i = 0; i < 100; i++) {
+        if (i < 10) top10 += by_stock[i];
+        top100 += by_stock[i];
+    }
+    printf("Symbols: %d, zipf %.2f; the busiest carries %.1f%% of order messages, the top 10 %.1f%%, "
+           "the top 100 %.1f%%\n", config.num_stocks, config.zipf_s, orders ? 100.0 * top1 / orders : 0.0,
+           orders ? 100.0 * top10 / orders : 0.0, orders ? 100.0 * top100 / orders : 0.0);
+    return 0;
+}
@@ -0,0 +1,249 @@
+#ifndef ITCH_FEEDGEN_H
+#define ITCH_FEEDGEN_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "itch.h"
+#include "itch_testgen.h"
+
+// Realistic synthetic ITCH 5.0 feeds in BinaryFILE framing, of any size.
+//
+// Unlike append_random_message(), which fills fields at random, every order here has a lifecycle:
+// it is added (A/F), may be partially executed (E) or cancelled (X), replaced (U) under a new
+// reference number, and leaves the book on a delete or a full execution. Only resting orders are
+// referenced, so the whole stream applies cleanly to an order book. Orders pick their stock
+// from a Zipf distribution over the locate codes, so a few symbols carry most of the flow as
+// on the real feed. The most active symbols are scattered over the locate space, as alphabetical
+// locate assignment does. Prices cluster a few ticks from each stock's mid.
+//
+// The stream opens like a real session: a System Event 'O' (start of messages), one Stock
+// Directory 'R' per symbol, then System Event 'Q' (start of market hours). The order messages
+// follow; the feed is generated one message at a time, so its size is only bounded by the
+// caller.
+//
+// Message types are drawn from FeedMix. A removal drawn while the book is empty becomes an add.
+// Until the book first holds target_live orders, half the removals drawn become adds, like the
+// pre-open build-up. Beyond 2 * target_live orders, adds become deletes. An X on a 1-share order
+// becomes a D. FeedGen::counts has the mix actually written.
+
+// Relative weights of the order message types
+struct FeedMix {
+    int add, add_mpid, executed, cancel, del, replace;
+};
+
+struct FeedConfig {
+    FeedMix mix;
+    int num_stocks;        // locate codes 1..num_stocks
+    double zipf_s;         // exponent of the symbol popularity distribution; 0 is uniform
+    size_t target_live;    // resting orders the book builds up to
+    uint64_t seed;
+};
+
+// A/F/E/X/D/U weights in the proportions of a typical TotalView-ITCH day
+static inline FeedConfig feedgen_default_config() {
+    FeedConfig c;
+    c.mix = {40, 2, 5, 3, 40, 10};
+    c.num_stocks = 8000;
+    c.zipf_s = 1.0;
+    c.target_live = 1000000;
+    c.seed = 0x9E3779B97F4A7C15ULL;
+    return c;
+}
+
+struct FeedGen {
+    FeedConfig config;
+    BookFeed book;                  // resting orders and the clock, shared with append_book_message()
+    std::vector<double> symbol_cdf; // by popularity rank
+    std::vector<uint16_t> locate;   // popularity rank -> locate code
+    bool built_up;
+    uint64_t counts[256];           // messages written, by type
+    uint64_t messages;
+    uint64_t bytes;
+};
+
+static inline void feedgen_init(FeedGen& g, const FeedConfig& config) {
+    g.config = config;
+    rng_state = config.seed ? config.seed : 1;
+    book_feed_init(g.book, config.num_stocks, config.target_live);
+    g.built_up = false;
+    memset(g.counts, 0, sizeof(g.counts));
+    g.messages = 0;
+    g.bytes = 0;
+
+    g.symbol_cdf.resize(config.num_stocks);
+    double total = 0;
+    for (int k = 0; k < config.num_stocks; k++) {
+        total += 1.0 / pow(k + 1.0, config.zipf_s);
+        g.symbol_cdf[k] = total;
+    }
+    for (int k = 0; k < config.num_stocks; k++) g.symbol_cdf[k] /= total;
+
+    g.locate.resize(config.num_stocks);
+    for (int k = 0; k < config.num_stocks; k++) g.locate[k] = (uint16_t)(k + 1);
+    for (int k = config.num_stocks - 1; k > 0; k--) {
+        std::swap(g.locate[k], g.locate[next_rand() % (k + 1)]);
+    }
+}
+
+static inline uint16_t feedgen_pick_stock(FeedGen& g) {
+    double u = (double)(next_rand() >> 11) / (double)(1ULL << 53);
+    size_t k = std::lower_bound(g.symbol_cdf.begin(), g.symbol_cdf.end(), u) - g.symbol_cdf.begin();
+    if (k >= g.locate.size()) k = g.locate.size() - 1;
+    return g.locate[k];
+}
+
+// Frames the message started at `start` (its 2-byte length placeholder) and counts it
+static inline void feedgen_finish(FeedGen& g, std::vector<uint8_t>& framed, size_t start) {
+    size_t len = framed.size() - start - ITCH_LENGTH_PREFIX;
+    framed[start] = (uint8_t)(len >> 8);
+    framed[start + 1] = (uint8_t)len;
+    g.counts[framed[start + ITCH_LENGTH_PREFIX]]++;
+    g.messages++;
+    g.bytes += framed.size() - start;
+}
+
+static inline size_t feedgen_begin(FeedGen& g, std::vector<uint8_t>& framed, uint8_t msg_type,
+                                   uint16_t stock_locate) {
+    size_t start = framed.size();
+    framed.push_back(0);
+    framed.push_back(0);
+    put_header(framed, msg_type, stock_locate, g.book);
+    return start;
+}
+
+static inline void feedgen_system_event(FeedGen& g, std::vector<uint8_t>& framed, char event) {
+    size_t start = feedgen_begin(g, framed, ITCH_SYSTEM_EVENT, 0);
+    framed.push_back((uint8_t)event);
+    feedgen_finish(g, framed, start);
+}
+
+// Appends the session preamble: start of messages, the stock directory, start of market hours
+static inline void feedgen_preamble(FeedGen& g, std::vector<uint8_t>& framed) {
+    feedgen_system_event(g, framed, 'O');
+    for (int s = 1; s <= g.config.num_stocks; s++) {
+        size_t start = feedgen_begin(g, framed, ITCH_STOCK_DIRECTORY, (uint16_t)s);
+        put_stock(framed, (uint16_t)s);
+        framed.push_back('Q');                   // market category: NASDAQ Global Select
+        framed.push_back('N');                   // financial status: normal
+        put_be(framed, 100, 4);                  // round lot size
+        framed.push_back('N');                   // round lots only
+        framed.push_back('C');                   // issue classification: common stock
+        framed.push_back('Z');                   // issue sub-type
+        framed.push_back(' ');
+        framed.push_back('P');                   // authenticity: production
+        framed.push_back('N');                   // short sale threshold
+        framed.push_back('N');                   // IPO flag
+        framed.push_back('1');                   // LULD reference price tier
+        framed.push_back('N');                   // ETP flag
+        put_be(framed, 0, 4);                    // ETP leverage factor
+        framed.push_back('N');                   // inverse indicator
+        feedgen_finish(g, framed, start);
+    }
+    feedgen_system_event(g, framed, 'Q');
+}
+
+// Appends one framed order message
+static inline void feedgen_append(FeedGen& g, std::vector<uint8_t>& framed) {
+    const FeedMix& m = g.config.mix;
+    int total = m.add + m.add_mpid + m.executed + m.cancel + m.del + m.replace;
+    int r = (int)(next_rand() % (uint64_t)(total > 0 ? total : 1));
+    uint8_t msg_type = r < m.add ? ITCH_ADD_ORDER
+                     : (r -= m.add) < m.add_mpid ? ITCH_ADD_ORDER_MPID
+                     : (r -= m.add_mpid) < m.executed ? ITCH_ORDER_EXECUTED
+                     : (r -= m.executed) < m.cancel ? ITCH_ORDER_CANCEL
+                     : (r -= m.cancel) < m.del ? ITCH_ORDER_DELETE
+                     : ITCH_ORDER_REPLACE;
+
+    std::vector<LiveOrder>& live = g.book.live;
+    if (live.size() >= g.config.target_live) g.built_up = true;
+    bool is_add = msg_type == ITCH_ADD_ORDER || msg_type == ITCH_ADD_ORDER_MPID;
+    if (!is_add && (live.empty() || (!g.built_up && (next_rand() & 1)))) {
+        msg_type = ITCH_ADD_ORDER;
+        is_add = true;
+    } else if (is_add && live.size() >= 2 * g.config.target_live) {
+        msg_type = ITCH_ORDER_DELETE;
+        is_add = false;
+    }
+
+    if (is_add) {
+        LiveOrder o;
+        o.order_ref_no = g.book.next_ref_no++;
+        o.stock_locate = feedgen_pick_stock(g);
+        o.buy_sell = next_rand() & 1 ? 'B' : 'S';
+        o.shares = 100 * (uint32_t)(1 + next_rand() % 10);
+        o.price = book_feed_price(o.stock_locate, o.buy_sell);
+        size_t start = feedgen_begin(g, framed, msg_type, o.stock_locate);
+        put_be(framed, o.order_ref_no, 8);
+        framed.push_back(o.buy_sell);
+        put_be(framed, o.shares, 4);
+        put_stock(framed, o.stock_locate);
+        put_be(framed, o.price, 4);
+        if (msg_type == ITCH_ADD_ORDER_MPID) framed.insert(framed.end(), {'M', 'P', 'I', 'D'});
+        feedgen_finish(g, framed, start);
+        live.push_back(o);
+        return;
+    }
+
+    size_t i = next_rand() % live.size();
+    LiveOrder& o = live[i];
+    if (msg_type == ITCH_ORDER_CANCEL && o.shares <= 1) msg_type = ITCH_ORDER_DELETE;
+
+    size_t start = feedgen_begin(g, framed, msg_type, o.stock_locate);
+    put_be(framed, o.order_ref_no, 8);
+    bool gone = false;
+    if (msg_type == ITCH_ORDER_DELETE) {
+        gone = true;
+    } else if (msg_type == ITCH_ORDER_EXECUTED) {
+        uint32_t shares = next_rand() & 1 ? o.shares : 1 + (uint32_t)(next_rand() % o.shares);
+        put_be(framed, shares, 4);
+        put_be(framed, next_rand(), 8);                  // match_no
+        o.shares -= shares;
+        gone = o.shares == 0;
+    } else if (msg_type == ITCH_ORDER_CANCEL) {
+        uint32_t shares = 1 + (uint32_t)(next_rand() % (o.shares - 1));
+        put_be(framed, shares, 4);
+        o.shares -= shares;
+    } else {
+        o.order_ref_no = g.book.next_ref_no++;
+        o.shares = 100 * (uint32_t)(1 + next_rand() % 10);
+        o.price = book_feed_price(o.stock_locate, o.buy_sell);
+        put_be(framed, o.order_ref_no, 8);
+        put_be(framed, o.shares, 4);
+        put_be(framed, o.price, 4);
+    }
+    feedgen_finish(g, framed, start);
+    if (gone) {
+        o = live.back();
+        live.pop_back();
+    }
+}
+
+// Parses "A=40,F=2,E=5,X=3,D=40,U=10" (any subset, in any order) into `mix`. Returns 0 on
+// success, -1 on a malformed entry.
+static inline int feedgen_parse_mix(const char* text, FeedMix& mix) {
+    while (*text) {
+        char type = *text;
+        if (text[1] != '=') return -1;
+        char* end;
+        long weight = strtol(text + 2, &end, 10);
+        if (end == text + 2 || weight < 0) return -1;
+        switch (type) {
+            case ITCH_ADD_ORDER:      mix.add = (int)weight; break;
+            case ITCH_ADD_ORDER_MPID: mix.add_mpid = (int)weight; break;
+            case ITCH_ORDER_EXECUTED: mix.executed = (int)weight; break;
+            case ITCH_ORDER_CANCEL:   mix.cancel = (int)weight; break;
+            case ITCH_ORDER_DELETE:   mix.del = (int)weight; break;
+            case ITCH_ORDER_REPLACE:  mix.replace = (int)weight; break;
+            default:                  return -1;
+        }
+        if (*end && *end != ',') return -1;
+        text = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+#endif
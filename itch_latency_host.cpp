@@ -0,0 +1,220 @@
+// Per-message latency of a BinaryFILE replay through parser_framed, split in two halves:
+//
+//   parser  cycles from the beat holding a message's first byte to its emission (valid_msg),
+//           read straight from the first_cycle/done_cycle stamps the kernel writes into each
+//           record in an ITCH_INSTRUMENT build
+//   host    ns from that emission until the consumer on the host reaches the record: the rest
+//           of the kernel run, the read back and the records consumed ahead of it
+//
+// The two clocks are joined at the end of the kernel run. The host takes a time-stamp counter
+// reading as soon as the run's event completes, which is when the record with the largest
+// done_cycle was written, give or take the completion latency; a record with done_cycle d
+// became valid (last_done - d) cycles earlier. Each record is then stamped again when the
+// consumer reaches it. Both halves go into per-type HDR histograms (latency_hist.h), reported
+// as p50/p99/p99.9. The host latency is an upper bound, since the run's completion is seen late.
+//
+// Chunks run one at a time, so every record's host latency includes its own chunk's read back
+// but no queueing behind other chunks. The stamps must also be in order within each chunk, with
+// first_cycle <= done_cycle; anything else fails the run.
+//
+// Kernel and host must both be built with -DITCH_INSTRUMENT (the records grow by 16 bytes):
+//   v++ ... -DITCH_INSTRUMENT parser_wide.cpp
+// Build: g++ -O2 -pthread -DITCH_INSTRUMENT -I$XILINX_HLS/include -o itch_latency_host
+//            itch_latency_host.cpp itch_replay.c accel_runtime.cpp accel_opencl.cpp accel_cpu.cpp
+//            double_vector.cpp parser_wide.cpp Archive/parser.cpp Archive/deserializer.cpp
+//            itch_decoder.cpp order_book.cpp -lOpenCL
+// (build libitch.a's sources with the flag too, rather than linking an uninstrumented libitch.a)
+// Usage: ./itch_latency_host <xclbin> <itch BinaryFILE> [chunk size in KB, default 1024] [kernel MHz, default 300]
+// ACCEL_BACKEND=cpu runs parser_framed in C-sim, whose stamps come from the kernel's cycle model.
+
+#ifndef ITCH_INSTRUMENT
+#error "itch_latency_host needs -DITCH_INSTRUMENT, for the kernel and the host alike"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <vector>
+#include "accel_runtime.h"
+#include "itch.h"
+#include "itch_replay.h"
+#include "latency_hist.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t ticks() {
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+#else
+static inline uint64_t ticks() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static double ticks_per_ns() {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = ticks();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(200)) {}
+    uint64_t c1 = ticks();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return (c1 - c0) / ns;
+}
+
+// Histograms per message type, plus every type together
+static const struct {
+    const char* name;
+    uint8_t type;
+} kTypes[] = {
+    {"add A", ITCH_ADD_ORDER},
+    {"add F", ITCH_ADD_ORDER_MPID},
+    {"execute E", ITCH_ORDER_EXECUTED},
+    {"cancel X", ITCH_ORDER_CANCEL},
+    {"delete D", ITCH_ORDER_DELETE},
+    {"replace U", ITCH_ORDER_REPLACE},
+};
+#define NUM_TYPES ((int)(sizeof(kTypes) / sizeof(kTypes[0])))
+
+struct TypeLatency {
+    LatencyHist parser;   // cycles
+    LatencyHist host;     // ns
+};
+
+static void report_row(const char* name, const TypeLatency& t, double ns_per_cycle) {
+    if (t.parser.total == 0) return;
+    printf("  %-10s %10llu   %7llu %7llu %7llu %7.0f ns   %9.1f %9.1f %9.1f us\n", name,
+           (unsigned long long)t.parser.total,
+           (unsigned long long)latency_hist_percentile(&t.parser, 50),
+           (unsigned long long)latency_hist_percentile(&t.parser, 99),
+           (unsigned long long)latency_hist_percentile(&t.parser, 99.9),
+           latency_hist_percentile(&t.parser, 50) * ns_per_cycle,
+           latency_hist_percentile(&t.host, 50) / 1e3,
+           latency_hist_percentile(&t.host, 99) / 1e3,
+           latency_hist_percentile(&t.host, 99.9) / 1e3);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <xclbin> <itch BinaryFILE> [chunk size in KB, default 1024] [kernel MHz, default 300]\n",
+               argv[0]);
+        return 1;
+    }
+    size_t chunk_size = (argc > 3 ? strtoull(argv[3], NULL, 10) : 1024) << 10;
+    double mhz = argc > 4 ? atof(argv[4]) : 300.0;
+    if (chunk_size == 0 || mhz <= 0) {
+        printf("Error: chunk size and kernel clock must be positive\n");
+        return 1;
+    }
+    double ns_per_cycle = 1e3 / mhz;
+
+    ItchReplay replay;
+    if (itch_replay_open(&replay, argv[2], chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", argv[2], strerror(errno));
+        return 1;
+    }
+
+    std::unique_ptr<AccelDevice> dev = accel_open(accel_backend_from_env());
+    if (!dev || dev->load(argv[1]) != 0) return 1;
+    AccelKernel* kernel = dev->kernel("parser_framed");
+    if (!kernel) {
+        printf("Error: %s has no parser_framed kernel\n", argv[1]);
+        return 1;
+    }
+    printf("Backend: %s, %zu KB chunks, stamps at %.0f MHz\n", dev->name(), chunk_size >> 10, mhz);
+
+    // Same bounds as itch_replay_host.c
+    size_t max_outputs = (chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) /
+                         (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    size_t input_capacity = chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN + 64;
+    AccelBuffer* input = dev->buffer(input_capacity, ACCEL_READ_ONLY);
+    AccelBuffer* output = dev->buffer(max_outputs * sizeof(ParserOutput), ACCEL_WRITE_ONLY);
+    AccelBuffer* num_outputs = dev->buffer(sizeof(int));
+    kernel->set_arg(0, input);
+    kernel->set_arg(2, output);
+    kernel->set_arg(3, num_outputs);
+    std::vector<ParserOutput> records(max_outputs);
+
+    static TypeLatency by_slot[NUM_TYPES + 1];
+    int slot_of[256];
+    for (int i = 0; i < 256; i++) slot_of[i] = NUM_TYPES;
+    for (int t = 0; t <= NUM_TYPES; t++) {
+        latency_hist_reset(&by_slot[t].parser);
+        latency_hist_reset(&by_slot[t].host);
+        if (t < NUM_TYPES) slot_of[kTypes[t].type] = t;
+    }
+
+    double tpn = ticks_per_ns();
+    uint64_t checksum = 0xCBF29CE484222325ULL;
+    size_t total_messages = 0, num_chunks = 0, bad_stamps = 0;
+    const uint8_t* chunk;
+    size_t len;
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        kernel->set_scalar(1, (int32_t)len);
+        AccelEvent sent = dev->write(input, chunk, len);
+        AccelEvent ran = dev->run(kernel, {sent});
+        dev->wait(ran);
+        uint64_t t_end = ticks();
+        dev->wait(dev->to_host(num_outputs, {ran}));
+        int n = *(int*)num_outputs->host();
+        dev->wait(dev->read(output, records.data(), (size_t)n * sizeof(ParserOutput)));
+
+        // The consumer: stamp each record as it is reached, then fold it into the checksum
+        const ParserOutput* out = records.data();
+        uint64_t last_done = n > 0 ? out[n - 1].done_cycle : 0;
+        uint64_t prev_done = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t t = ticks();
+            const ParserOutput& r = out[i];
+            if (r.first_cycle > r.done_cycle || r.done_cycle < prev_done || r.done_cycle > last_done) {
+                if (bad_stamps < 10) {
+                    printf("chunk %zu record %d: bad stamps first %llu done %llu\n", num_chunks, i,
+                           (unsigned long long)r.first_cycle, (unsigned long long)r.done_cycle);
+                }
+                bad_stamps++;
+            }
+            prev_done = r.done_cycle;
+
+            double host_ns = (double)(t - t_end) / tpn + (double)(last_done - r.done_cycle) * ns_per_cycle;
+            TypeLatency& lat = by_slot[slot_of[r.msg_type]];
+            latency_hist_record(&lat.parser, r.done_cycle - r.first_cycle);
+            latency_hist_record(&lat.host, (uint64_t)host_ns);
+
+            checksum = (checksum ^ r.msg_type) * 0x100000001B3ULL;
+            checksum = (checksum ^ r.order_ref_no) * 0x100000001B3ULL;
+        }
+        total_messages += n;
+        num_chunks++;
+    }
+
+    TypeLatency all;
+    latency_hist_reset(&all.parser);
+    latency_hist_reset(&all.host);
+    for (int t = 0; t <= NUM_TYPES; t++) {
+        latency_hist_merge(&all.parser, &by_slot[t].parser);
+        latency_hist_merge(&all.host, &by_slot[t].host);
+    }
+
+    printf("%zu messages in %zu chunks, checksum %016llx\n", total_messages, num_chunks,
+           (unsigned long long)checksum);
+    printf("  %-10s %10s   %-31s   %-29s\n", "type", "messages", "parser cycles p50/p99/p99.9 (p50)",
+           "valid to consumed p50/p99/p99.9");
+    for (int t = 0; t < NUM_TYPES; t++) report_row(kTypes[t].name, by_slot[t], ns_per_cycle);
+    report_row("other", by_slot[NUM_TYPES], ns_per_cycle);
+    report_row("all", all, ns_per_cycle);
+
+    delete input;
+    delete output;
+    delete num_outputs;
+    itch_replay_close(&replay);
+
+    int ok = bad_stamps == 0 && total_messages > 0 && all.parser.max > 0;
+    if (all.parser.max == 0) printf("No record carries a cycle stamp: is the kernel built with -DITCH_INSTRUMENT?\n");
+    printf(ok ? "TEST PASSED\n" : "TEST FAILED\n");
+    return ok ? 0 : 1;
+}
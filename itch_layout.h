@@ -0,0 +1,371 @@
+#ifndef ITCH_LAYOUT_H
+#define ITCH_LAYOUT_H
+
+#include <stdint.h>
+#include "itch.h"
+#include "itch_records.h"
+
+// ITCH 5.0 message layouts as a single compile-time table.
+//
+// Every field of every message type is one row: where it sits in the message, how wide it is,
+// and where it goes in the ItchRecord of itch_records.h. The field extractors of the HLS kernels
+// (parser_wide.h) and of the CPU decoder (itch_decoder.cpp) are generated from this table by the
+// LayoutFields / LayoutTypes templates below. Each message type expands into a straight-line
+// sequence of constant-offset loads and stores with no branches. Adding a message type means
+// adding its rows here.
+//
+// Needs C++14 (constexpr functions with loops).
+
+// Destination of a field in ParserOutput. Fields that ParserOutput does not carry are
+// FIELD_OTHER and only reach the ItchRecord.
+enum LayoutField {
+    FIELD_MSG_TYPE,
+    FIELD_STOCK_LOCATE,
+    FIELD_TRACKING_NO,
+    FIELD_TIMESTAMP,
+    FIELD_ORDER_REF_NO,
+    FIELD_NEW_ORDER_REF_NO,
+    FIELD_SHARES,
+    FIELD_BUY_SELL,
+    FIELD_STOCK,
+    FIELD_PRICE,
+    FIELD_MATCH_NO,
+    FIELD_ATTRIBUTION,
+    FIELD_OTHER
+};
+
+// Integers are byte swapped into the record; alphanumeric fields are copied as they are
+enum LayoutKind {
+    KIND_INT,
+    KIND_ALPHA
+};
+
+struct LayoutRow {
+    uint8_t msg_type;    // ITCH_LAYOUT_HEADER for the header fields shared by every type
+    uint8_t length;      // total message length (0 for header rows)
+    uint8_t field;       // LayoutField
+    uint8_t offset;      // byte offset in the message
+    uint8_t width;       // bytes in the message
+    uint8_t kind;        // LayoutKind
+    uint8_t rec_offset;  // byte offset in ItchRecord
+};
+
+#define ITCH_LAYOUT_HEADER  0
+
+static constexpr LayoutRow ITCH_LAYOUT[] = {
+    // type                      length                          field                   off wid kind        rec
+    {ITCH_LAYOUT_HEADER,         0,                              FIELD_MSG_TYPE,          0, 1, KIND_INT,     0},
+    {ITCH_LAYOUT_HEADER,         0,                              FIELD_STOCK_LOCATE,      1, 2, KIND_INT,     2},
+    {ITCH_LAYOUT_HEADER,         0,                              FIELD_TRACKING_NO,       3, 2, KIND_INT,     4},
+    {ITCH_LAYOUT_HEADER,         0,                              FIELD_TIMESTAMP,         5, 6, KIND_INT,     8},
+
+    {ITCH_SYSTEM_EVENT,          ITCH_SYSTEM_EVENT_LEN,          FIELD_OTHER,            11, 1, KIND_ALPHA,  16},  // event_code
+
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            19, 1, KIND_ALPHA,  24},  // market_category
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            20, 1, KIND_ALPHA,  25},  // financial_status
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            21, 4, KIND_INT,    36},  // round_lot_size
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            25, 1, KIND_ALPHA,  26},  // round_lots_only
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            26, 1, KIND_ALPHA,  27},  // issue_classification
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            27, 2, KIND_ALPHA,  28},  // issue_subtype
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            29, 1, KIND_ALPHA,  30},  // authenticity
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            30, 1, KIND_ALPHA,  31},  // short_sale_threshold
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            31, 1, KIND_ALPHA,  32},  // ipo_flag
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            32, 1, KIND_ALPHA,  33},  // luld_ref_price_tier
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            33, 1, KIND_ALPHA,  34},  // etp_flag
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            34, 4, KIND_INT,    40},  // etp_leverage_factor
+    {ITCH_STOCK_DIRECTORY,       ITCH_STOCK_DIRECTORY_LEN,       FIELD_OTHER,            38, 1, KIND_ALPHA,  35},  // inverse_indicator
+
+    {ITCH_STOCK_TRADING_ACTION,  ITCH_STOCK_TRADING_ACTION_LEN,  FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_STOCK_TRADING_ACTION,  ITCH_STOCK_TRADING_ACTION_LEN,  FIELD_OTHER,            19, 1, KIND_ALPHA,  24},  // trading_state
+    {ITCH_STOCK_TRADING_ACTION,  ITCH_STOCK_TRADING_ACTION_LEN,  FIELD_OTHER,            20, 1, KIND_ALPHA,  25},  // reserved
+    {ITCH_STOCK_TRADING_ACTION,  ITCH_STOCK_TRADING_ACTION_LEN,  FIELD_OTHER,            21, 4, KIND_ALPHA,  26},  // reason
+
+    {ITCH_REG_SHO,               ITCH_REG_SHO_LEN,               FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_REG_SHO,               ITCH_REG_SHO_LEN,               FIELD_OTHER,            19, 1, KIND_ALPHA,  24},  // reg_sho_action
+
+    {ITCH_MARKET_PARTICIPANT,    ITCH_MARKET_PARTICIPANT_LEN,    FIELD_OTHER,            11, 4, KIND_ALPHA,  16},  // mpid
+    {ITCH_MARKET_PARTICIPANT,    ITCH_MARKET_PARTICIPANT_LEN,    FIELD_STOCK,            15, 8, KIND_ALPHA,  20},
+    {ITCH_MARKET_PARTICIPANT,    ITCH_MARKET_PARTICIPANT_LEN,    FIELD_OTHER,            23, 1, KIND_ALPHA,  28},  // primary_market_maker
+    {ITCH_MARKET_PARTICIPANT,    ITCH_MARKET_PARTICIPANT_LEN,    FIELD_OTHER,            24, 1, KIND_ALPHA,  29},  // market_maker_mode
+    {ITCH_MARKET_PARTICIPANT,    ITCH_MARKET_PARTICIPANT_LEN,    FIELD_OTHER,            25, 1, KIND_ALPHA,  30},  // participant_state
+
+    {ITCH_MWCB_DECLINE_LEVEL,    ITCH_MWCB_DECLINE_LEVEL_LEN,    FIELD_OTHER,            11, 8, KIND_INT,    16},  // level1
+    {ITCH_MWCB_DECLINE_LEVEL,    ITCH_MWCB_DECLINE_LEVEL_LEN,    FIELD_OTHER,            19, 8, KIND_INT,    24},  // level2
+    {ITCH_MWCB_DECLINE_LEVEL,    ITCH_MWCB_DECLINE_LEVEL_LEN,    FIELD_OTHER,            27, 8, KIND_INT,    32},  // level3
+
+    {ITCH_MWCB_STATUS,           ITCH_MWCB_STATUS_LEN,           FIELD_OTHER,            11, 1, KIND_ALPHA,  16},  // breached_level
+
+    {ITCH_IPO_QUOTING_PERIOD,    ITCH_IPO_QUOTING_PERIOD_LEN,    FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_IPO_QUOTING_PERIOD,    ITCH_IPO_QUOTING_PERIOD_LEN,    FIELD_OTHER,            19, 4, KIND_INT,    24},  // release_time
+    {ITCH_IPO_QUOTING_PERIOD,    ITCH_IPO_QUOTING_PERIOD_LEN,    FIELD_OTHER,            23, 1, KIND_ALPHA,  32},  // release_qualifier
+    {ITCH_IPO_QUOTING_PERIOD,    ITCH_IPO_QUOTING_PERIOD_LEN,    FIELD_PRICE,            24, 4, KIND_INT,    28},  // ipo_price
+
+    {ITCH_LULD_AUCTION_COLLAR,   ITCH_LULD_AUCTION_COLLAR_LEN,   FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_LULD_AUCTION_COLLAR,   ITCH_LULD_AUCTION_COLLAR_LEN,   FIELD_PRICE,            19, 4, KIND_INT,    24},  // ref_price
+    {ITCH_LULD_AUCTION_COLLAR,   ITCH_LULD_AUCTION_COLLAR_LEN,   FIELD_OTHER,            23, 4, KIND_INT,    28},  // upper_price
+    {ITCH_LULD_AUCTION_COLLAR,   ITCH_LULD_AUCTION_COLLAR_LEN,   FIELD_OTHER,            27, 4, KIND_INT,    32},  // lower_price
+    {ITCH_LULD_AUCTION_COLLAR,   ITCH_LULD_AUCTION_COLLAR_LEN,   FIELD_OTHER,            31, 4, KIND_INT,    36},  // extension
+
+    {ITCH_OPERATIONAL_HALT,      ITCH_OPERATIONAL_HALT_LEN,      FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_OPERATIONAL_HALT,      ITCH_OPERATIONAL_HALT_LEN,      FIELD_OTHER,            19, 1, KIND_ALPHA,  24},  // market_code
+    {ITCH_OPERATIONAL_HALT,      ITCH_OPERATIONAL_HALT_LEN,      FIELD_OTHER,            20, 1, KIND_ALPHA,  25},  // halt_action
+
+    {ITCH_ADD_ORDER,             ITCH_ADD_ORDER_LEN,             FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ADD_ORDER,             ITCH_ADD_ORDER_LEN,             FIELD_BUY_SELL,         19, 1, KIND_ALPHA,  40},
+    {ITCH_ADD_ORDER,             ITCH_ADD_ORDER_LEN,             FIELD_SHARES,           20, 4, KIND_INT,    32},
+    {ITCH_ADD_ORDER,             ITCH_ADD_ORDER_LEN,             FIELD_STOCK,            24, 8, KIND_ALPHA,  24},
+    {ITCH_ADD_ORDER,             ITCH_ADD_ORDER_LEN,             FIELD_PRICE,            32, 4, KIND_INT,    36},
+
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_BUY_SELL,         19, 1, KIND_ALPHA,  40},
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_SHARES,           20, 4, KIND_INT,    32},
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_STOCK,            24, 8, KIND_ALPHA,  24},
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_PRICE,            32, 4, KIND_INT,    36},
+    {ITCH_ADD_ORDER_MPID,        ITCH_ADD_ORDER_MPID_LEN,        FIELD_ATTRIBUTION,      36, 4, KIND_ALPHA,  44},
+
+    {ITCH_ORDER_EXECUTED,        ITCH_ORDER_EXECUTED_LEN,        FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ORDER_EXECUTED,        ITCH_ORDER_EXECUTED_LEN,        FIELD_SHARES,           19, 4, KIND_INT,    32},
+    {ITCH_ORDER_EXECUTED,        ITCH_ORDER_EXECUTED_LEN,        FIELD_MATCH_NO,         23, 8, KIND_INT,    24},
+
+    {ITCH_ORDER_EXECUTED_PRICE,  ITCH_ORDER_EXECUTED_PRICE_LEN,  FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ORDER_EXECUTED_PRICE,  ITCH_ORDER_EXECUTED_PRICE_LEN,  FIELD_SHARES,           19, 4, KIND_INT,    32},
+    {ITCH_ORDER_EXECUTED_PRICE,  ITCH_ORDER_EXECUTED_PRICE_LEN,  FIELD_MATCH_NO,         23, 8, KIND_INT,    24},
+    {ITCH_ORDER_EXECUTED_PRICE,  ITCH_ORDER_EXECUTED_PRICE_LEN,  FIELD_OTHER,            31, 1, KIND_ALPHA,  40},  // printable
+    {ITCH_ORDER_EXECUTED_PRICE,  ITCH_ORDER_EXECUTED_PRICE_LEN,  FIELD_PRICE,            32, 4, KIND_INT,    36},  // execution_price
+
+    {ITCH_ORDER_CANCEL,          ITCH_ORDER_CANCEL_LEN,          FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ORDER_CANCEL,          ITCH_ORDER_CANCEL_LEN,          FIELD_SHARES,           19, 4, KIND_INT,    24},
+
+    {ITCH_ORDER_DELETE,          ITCH_ORDER_DELETE_LEN,          FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+
+    {ITCH_ORDER_REPLACE,         ITCH_ORDER_REPLACE_LEN,         FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_ORDER_REPLACE,         ITCH_ORDER_REPLACE_LEN,         FIELD_NEW_ORDER_REF_NO, 19, 8, KIND_INT,    24},
+    {ITCH_ORDER_REPLACE,         ITCH_ORDER_REPLACE_LEN,         FIELD_SHARES,           27, 4, KIND_INT,    32},
+    {ITCH_ORDER_REPLACE,         ITCH_ORDER_REPLACE_LEN,         FIELD_PRICE,            31, 4, KIND_INT,    36},
+
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_ORDER_REF_NO,     11, 8, KIND_INT,    16},
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_BUY_SELL,         19, 1, KIND_ALPHA,  48},
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_SHARES,           20, 4, KIND_INT,    40},
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_STOCK,            24, 8, KIND_ALPHA,  32},
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_PRICE,            32, 4, KIND_INT,    44},
+    {ITCH_TRADE,                 ITCH_TRADE_LEN,                 FIELD_MATCH_NO,         36, 8, KIND_INT,    24},
+
+    {ITCH_CROSS_TRADE,           ITCH_CROSS_TRADE_LEN,           FIELD_SHARES,           11, 8, KIND_INT,    16},
+    {ITCH_CROSS_TRADE,           ITCH_CROSS_TRADE_LEN,           FIELD_STOCK,            19, 8, KIND_ALPHA,  32},
+    {ITCH_CROSS_TRADE,           ITCH_CROSS_TRADE_LEN,           FIELD_PRICE,            27, 4, KIND_INT,    40},  // cross_price
+    {ITCH_CROSS_TRADE,           ITCH_CROSS_TRADE_LEN,           FIELD_MATCH_NO,         31, 8, KIND_INT,    24},
+    {ITCH_CROSS_TRADE,           ITCH_CROSS_TRADE_LEN,           FIELD_OTHER,            39, 1, KIND_ALPHA,  44},  // cross_type
+
+    {ITCH_BROKEN_TRADE,          ITCH_BROKEN_TRADE_LEN,          FIELD_MATCH_NO,         11, 8, KIND_INT,    16},
+
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            11, 8, KIND_INT,    16},  // paired_shares
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            19, 8, KIND_INT,    24},  // imbalance_shares
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            27, 1, KIND_ALPHA,  52},  // imbalance_direction
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_STOCK,            28, 8, KIND_ALPHA,  32},
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            36, 4, KIND_INT,    40},  // far_price
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            40, 4, KIND_INT,    44},  // near_price
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_PRICE,            44, 4, KIND_INT,    48},  // ref_price
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            48, 1, KIND_ALPHA,  53},  // cross_type
+    {ITCH_NOII,                  ITCH_NOII_LEN,                  FIELD_OTHER,            49, 1, KIND_ALPHA,  54},  // price_variation
+
+    {ITCH_RPII,                  ITCH_RPII_LEN,                  FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_RPII,                  ITCH_RPII_LEN,                  FIELD_OTHER,            19, 1, KIND_ALPHA,  24},  // interest_flag
+
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_STOCK,            11, 8, KIND_ALPHA,  16},
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            19, 1, KIND_ALPHA,  52},  // open_eligibility
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            20, 4, KIND_INT,    32},  // min_allowable_price
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            24, 4, KIND_INT,    36},  // max_allowable_price
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_PRICE,            28, 4, KIND_INT,    40},  // near_execution_price
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            32, 8, KIND_INT,    24},  // near_execution_time
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            40, 4, KIND_INT,    44},  // lower_price_collar
+    {ITCH_DLCR_PRICE_DISCOVERY,  ITCH_DLCR_PRICE_DISCOVERY_LEN,  FIELD_OTHER,            44, 4, KIND_INT,    48},  // upper_price_collar
+};
+
+static constexpr int ITCH_LAYOUT_ROWS = sizeof(ITCH_LAYOUT) / sizeof(ITCH_LAYOUT[0]);
+
+// Bytes a field takes in ItchRecord: integers are stored at their C type's width
+constexpr int layout_store_width(const LayoutRow& row) {
+    return row.kind == KIND_INT && row.width == 6 ? 8 : row.width;
+}
+
+// Total length of a message type, or 0 if the table has no rows for it
+constexpr int layout_length(int msg_type) {
+    for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+        if (msg_type != ITCH_LAYOUT_HEADER && ITCH_LAYOUT[i].msg_type == msg_type) return ITCH_LAYOUT[i].length;
+    }
+    return 0;
+}
+
+constexpr int layout_num_fields(int msg_type) {
+    int n = 0;
+    for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+        if (ITCH_LAYOUT[i].msg_type == msg_type) n++;
+    }
+    return n;
+}
+
+// Table index of the n-th row of a message type
+constexpr int layout_row(int msg_type, int n) {
+    for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+        if (ITCH_LAYOUT[i].msg_type == msg_type && n-- == 0) return i;
+    }
+    return -1;
+}
+
+// Message types in table order, header excluded
+constexpr int layout_num_types() {
+    int n = 0;
+    for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+        if (ITCH_LAYOUT[i].msg_type != ITCH_LAYOUT_HEADER &&
+            (i == 0 || ITCH_LAYOUT[i - 1].msg_type != ITCH_LAYOUT[i].msg_type)) n++;
+    }
+    return n;
+}
+
+constexpr int layout_type(int n) {
+    for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+        if (ITCH_LAYOUT[i].msg_type != ITCH_LAYOUT_HEADER &&
+            (i == 0 || ITCH_LAYOUT[i - 1].msg_type != ITCH_LAYOUT[i].msg_type) && n-- == 0) {
+            return ITCH_LAYOUT[i].msg_type;
+        }
+    }
+    return -1;
+}
+
+// Message types decoded into ParserOutput (see itch_msg_length)
+constexpr bool layout_in_parser_output(int msg_type) {
+    return msg_type == ITCH_ADD_ORDER || msg_type == ITCH_ORDER_DELETE ||
+           msg_type == ITCH_ORDER_EXECUTED || msg_type == ITCH_ADD_ORDER_MPID ||
+           msg_type == ITCH_ORDER_REPLACE || msg_type == ITCH_ORDER_CANCEL;
+}
+
+// Checks, for every type, that the header and its fields cover each message byte exactly once,
+// that each type's rows are contiguous, and that the fields neither overlap nor overflow the record
+constexpr bool layout_valid() {
+    for (int t = 0; t < layout_num_types(); t++) {
+        int msg_type = layout_type(t);
+        int length = layout_length(msg_type);
+        uint64_t msg_bytes = 0;
+        uint64_t rec_bytes = 0;
+        if (length > 64 || layout_num_fields(msg_type) == 0 ||
+            layout_row(msg_type, layout_num_fields(msg_type) - 1) - layout_row(msg_type, 0) + 1 !=
+                layout_num_fields(msg_type)) {
+            return false;
+        }
+        for (int i = 0; i < ITCH_LAYOUT_ROWS; i++) {
+            const LayoutRow& row = ITCH_LAYOUT[i];
+            if (row.msg_type != ITCH_LAYOUT_HEADER && row.msg_type != msg_type) continue;
+            if (row.msg_type == msg_type && row.length != length) return false;
+            if (row.offset + row.width > length) return false;
+            if (row.rec_offset + layout_store_width(row) > ITCH_RECORD_LEN) return false;
+            for (int b = row.offset; b < row.offset + row.width; b++) {
+                if ((msg_bytes >> b) & 1) return false;
+                msg_bytes |= 1ULL << b;
+            }
+            for (int b = row.rec_offset; b < row.rec_offset + layout_store_width(row); b++) {
+                if ((rec_bytes >> b) & 1) return false;
+                rec_bytes |= 1ULL << b;
+            }
+        }
+        if (msg_bytes != (length == 64 ? ~0ULL : (1ULL << length) - 1)) return false;
+    }
+    return true;
+}
+
+// The table's lengths against the spec lengths in itch.h
+constexpr bool layout_lengths_match() {
+    const int expected[][2] = {
+        {ITCH_SYSTEM_EVENT, ITCH_SYSTEM_EVENT_LEN},
+        {ITCH_STOCK_DIRECTORY, ITCH_STOCK_DIRECTORY_LEN},
+        {ITCH_STOCK_TRADING_ACTION, ITCH_STOCK_TRADING_ACTION_LEN},
+        {ITCH_REG_SHO, ITCH_REG_SHO_LEN},
+        {ITCH_MARKET_PARTICIPANT, ITCH_MARKET_PARTICIPANT_LEN},
+        {ITCH_MWCB_DECLINE_LEVEL, ITCH_MWCB_DECLINE_LEVEL_LEN},
+        {ITCH_MWCB_STATUS, ITCH_MWCB_STATUS_LEN},
+        {ITCH_IPO_QUOTING_PERIOD, ITCH_IPO_QUOTING_PERIOD_LEN},
+        {ITCH_LULD_AUCTION_COLLAR, ITCH_LULD_AUCTION_COLLAR_LEN},
+        {ITCH_OPERATIONAL_HALT, ITCH_OPERATIONAL_HALT_LEN},
+        {ITCH_ADD_ORDER, ITCH_ADD_ORDER_LEN},
+        {ITCH_ADD_ORDER_MPID, ITCH_ADD_ORDER_MPID_LEN},
+        {ITCH_ORDER_EXECUTED, ITCH_ORDER_EXECUTED_LEN},
+        {ITCH_ORDER_EXECUTED_PRICE, ITCH_ORDER_EXECUTED_PRICE_LEN},
+        {ITCH_ORDER_CANCEL, ITCH_ORDER_CANCEL_LEN},
+        {ITCH_ORDER_DELETE, ITCH_ORDER_DELETE_LEN},
+        {ITCH_ORDER_REPLACE, ITCH_ORDER_REPLACE_LEN},
+        {ITCH_TRADE, ITCH_TRADE_LEN},
+        {ITCH_CROSS_TRADE, ITCH_CROSS_TRADE_LEN},
+        {ITCH_BROKEN_TRADE, ITCH_BROKEN_TRADE_LEN},
+        {ITCH_NOII, ITCH_NOII_LEN},
+        {ITCH_RPII, ITCH_RPII_LEN},
+        {ITCH_DLCR_PRICE_DISCOVERY, ITCH_DLCR_PRICE_DISCOVERY_LEN},
+    };
+    int n = (int)(sizeof(expected) / sizeof(expected[0]));
+    if (n != layout_num_types()) return false;
+    for (int i = 0; i < n; i++) {
+        if (layout_length(expected[i][0]) != expected[i][1]) return false;
+    }
+    return true;
+}
+
+static_assert(layout_valid(), "ITCH_LAYOUT rows overlap, leave gaps or overflow the record");
+static_assert(layout_lengths_match(), "ITCH_LAYOUT lengths differ from itch.h");
+
+// Stores a decoded integer into the ParserOutput member for FIELD. FIELD is a constant, so this
+// folds down to a single assignment.
+template <int FIELD>
+static void set_output_field(ParserOutput& out, uint64_t value) {
+    #pragma HLS INLINE
+    switch (FIELD) {
+        case FIELD_MSG_TYPE:         out.msg_type = (uint8_t)value; break;
+        case FIELD_STOCK_LOCATE:     out.stock_locate = (uint16_t)value; break;
+        case FIELD_TRACKING_NO:      out.tracking_no = (uint16_t)value; break;
+        case FIELD_TIMESTAMP:        out.timestamp = value; break;
+        case FIELD_ORDER_REF_NO:     out.order_ref_no = value; break;
+        case FIELD_NEW_ORDER_REF_NO: out.new_order_ref_no = value; break;
+        case FIELD_SHARES:           out.shares = (uint32_t)value; break;
+        case FIELD_BUY_SELL:         out.buy_sell = (uint8_t)value; break;
+        case FIELD_STOCK:            out.stock = value; break;
+        case FIELD_PRICE:            out.price = (uint32_t)value; break;
+        case FIELD_MATCH_NO:         out.match_no = value; break;
+        case FIELD_ATTRIBUTION:      out.attribution = (uint32_t)value; break;
+        default:                     break;
+    }
+}
+
+// Calls Visitor::field<ROW>(ctx) for every row of `MSG_TYPE`, unrolled at compile time.
+// MSG_TYPE = ITCH_LAYOUT_HEADER visits the header fields.
+template <int MSG_TYPE, typename Visitor, int N = 0, int COUNT = layout_num_fields(MSG_TYPE)>
+struct LayoutFields {
+    template <typename Ctx>
+    static void visit(Ctx& ctx) {
+        #pragma HLS INLINE
+        Visitor::template field<layout_row(MSG_TYPE, N)>(ctx);
+        LayoutFields<MSG_TYPE, Visitor, N + 1, COUNT>::visit(ctx);
+    }
+};
+
+template <int MSG_TYPE, typename Visitor, int COUNT>
+struct LayoutFields<MSG_TYPE, Visitor, COUNT, COUNT> {
+    template <typename Ctx>
+    static void visit(Ctx&) {}
+};
+
+// Calls Visitor::type<MSG_TYPE>(ctx) for every message type in the table
+template <typename Visitor, int N = 0, int COUNT = layout_num_types()>
+struct LayoutTypes {
+    template <typename Ctx>
+    static void visit(Ctx& ctx) {
+        #pragma HLS INLINE
+        Visitor::template type<layout_type(N)>(ctx);
+        LayoutTypes<Visitor, N + 1, COUNT>::visit(ctx);
+    }
+};
+
+template <typename Visitor, int COUNT>
+struct LayoutTypes<Visitor, COUNT, COUNT> {
+    template <typename Ctx>
+    static void visit(Ctx&) {}
+};
+
+#endif
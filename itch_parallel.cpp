@@ -0,0 +1,143 @@
+#include <string.h>
+#include <time.h>
+#include <thread>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_parallel.h"
+
+static inline size_t load_len(const uint8_t* p) {
+    return ((size_t)p[0] << 8) | p[1];
+}
+
+static double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+size_t itch_find_boundary(const uint8_t* buf, size_t size, size_t from) {
+    for (size_t start = from; start + ITCH_LENGTH_PREFIX < size; start++) {
+        size_t pos = start;
+        int framed = 0;
+        while (framed < ITCH_SYNC_MESSAGES && pos + ITCH_LENGTH_PREFIX < size) {
+            size_t len = load_len(buf + pos);
+            if (len == 0 || (size_t)itch_spec_msg_length(buf[pos + ITCH_LENGTH_PREFIX]) != len) break;
+            pos += ITCH_LENGTH_PREFIX + len;
+            framed++;
+        }
+        if (framed == ITCH_SYNC_MESSAGES || (framed > 0 && pos + ITCH_LENGTH_PREFIX >= size)) return start;
+    }
+    return size;
+}
+
+struct Range {
+    size_t base;            // [base, limit) is the thread's share of the buffer
+    size_t limit;
+    size_t start;           // first message of the range
+    size_t end;             // just past its last message
+    bool stopped;           // hit a zero length or a truncated message before limit
+    size_t count;           // records it decodes to
+    double cpu_seconds;
+};
+
+// Walks the messages starting in [r->start, r->limit), stopping where itch_decode_framed would,
+// and counts those itch_decode_message accepts
+static void scan_range(const uint8_t* buf, size_t size, Range* r) {
+    size_t pos = r->start;
+    size_t count = 0;
+    while (pos < r->limit && pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = load_len(buf + pos);
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        count += (size_t)itch_msg_length(buf[pos + ITCH_LENGTH_PREFIX]) == len;
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    r->end = pos;
+    r->stopped = pos < r->limit;
+    r->count = count;
+}
+
+static void find_and_scan(const uint8_t* buf, size_t size, Range* r) {
+    double t0 = thread_cpu_seconds();
+    r->start = r->base == 0 ? 0 : itch_find_boundary(buf, size, r->base);
+    scan_range(buf, size, r);
+    r->cpu_seconds = thread_cpu_seconds() - t0;
+}
+
+// Decodes the range's messages into their final place
+static void decode_range(const uint8_t* buf, Range* r, ParserOutput* out) {
+    double t0 = thread_cpu_seconds();
+    size_t pos = r->start;
+    size_t count = 0;
+    while (pos < r->end) {
+        size_t len = load_len(buf + pos);
+        count += itch_decode_message(buf + pos + ITCH_LENGTH_PREFIX, len, &out[count]);
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    r->cpu_seconds += thread_cpu_seconds() - t0;
+}
+
+size_t itch_decode_parallel(const uint8_t* buf, size_t size, int num_threads, ParserOutput* outputs,
+                            size_t* consumed, ItchParallelStats* stats) {
+    size_t max_ranges = size / ITCH_PARALLEL_MIN_RANGE;
+    int n = num_threads < 1 ? 1 : num_threads;
+    if ((size_t)n > max_ranges) n = max_ranges > 1 ? (int)max_ranges : 1;
+    if (stats) {
+        stats->ranges = n;
+        stats->resyncs = 0;
+        stats->busiest_seconds = 0;
+    }
+    if (n == 1) {
+        double t0 = thread_cpu_seconds();
+        size_t count = itch_decode_framed(buf, size, outputs, itch_parallel_max_outputs(size), consumed);
+        if (stats) stats->busiest_seconds = thread_cpu_seconds() - t0;
+        return count;
+    }
+
+    // Pass 1: every range finds its first message and counts its records
+    std::vector<Range> ranges(n);
+    for (int i = 0; i < n; i++) {
+        ranges[i].base = size / n * i;
+        ranges[i].limit = i == n - 1 ? size : size / n * (i + 1);
+    }
+    std::vector<std::thread> workers;
+    for (int i = 1; i < n; i++) workers.emplace_back(find_and_scan, buf, size, &ranges[i]);
+    find_and_scan(buf, size, &ranges[0]);
+    for (auto& w : workers) w.join();
+    workers.clear();
+
+    // Join the ranges in order; a range that does not start where its predecessor ended is
+    // scanned again from there
+    std::vector<size_t> offset(n, 0);
+    size_t expected = 0, total = 0;
+    int last = n - 1;
+    for (int i = 0; i < n; i++) {
+        Range& r = ranges[i];
+        if (r.start != expected) {
+            double t0 = thread_cpu_seconds();
+            r.start = expected;
+            scan_range(buf, size, &r);
+            ranges[0].cpu_seconds += thread_cpu_seconds() - t0;
+            if (stats) stats->resyncs++;
+        }
+        offset[i] = total;
+        expected = r.end;
+        total += r.count;
+        if (r.stopped) {
+            last = i;
+            break;
+        }
+    }
+
+    // Pass 2: every range decodes straight into its place in `outputs`
+    for (int i = 1; i <= last; i++) workers.emplace_back(decode_range, buf, &ranges[i], outputs + offset[i]);
+    decode_range(buf, &ranges[0], outputs);
+    for (auto& w : workers) w.join();
+
+    if (stats) {
+        for (int i = 0; i <= last; i++) {
+            if (ranges[i].cpu_seconds > stats->busiest_seconds) stats->busiest_seconds = ranges[i].cpu_seconds;
+        }
+    }
+    *consumed = expected;
+    return total;
+}
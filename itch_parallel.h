@@ -0,0 +1,61 @@
+#ifndef ITCH_PARALLEL_H
+#define ITCH_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "itch.h"
+
+// Multi-threaded decode of one BinaryFILE buffer, with the records in exact file order.
+//
+// The buffer is cut into equal byte ranges, one per thread. BinaryFILE has no sync marker, so
+// each thread but the first finds its first message with itch_find_boundary(): the first offset
+// from which ITCH_SYNC_MESSAGES length prefixes in a row each frame a message of an ITCH 5.0
+// type with exactly that type's length. A range owns every message that starts before its end,
+// including one that runs past it.
+//
+// The decode takes two parallel passes. First each thread walks its range's length prefixes
+// and counts the records they will decode to. The ranges are then joined in order: range i
+// must start exactly where range i - 1 ended. The first range starts at 0, so every range that
+// joins its predecessor is on the true message chain. A range that does not join (a false sync,
+// or a chain broken by a message type outside the spec) is walked again from its predecessor's
+// end, serially. The counts give each range its offset in `outputs`, and in the second pass
+// every thread decodes its range straight into place, so records are never copied. The result
+// is always the same as itch_decode_framed() on the whole buffer: the same records and the
+// same consumed count. That includes stopping at a zero or over-long length or a truncated message.
+
+// Consecutive messages that must frame correctly before an offset is taken as a boundary
+#define ITCH_SYNC_MESSAGES 8
+
+// Ranges are never cut smaller than this, so tiny buffers use fewer threads
+#define ITCH_PARALLEL_MIN_RANGE (64u << 10)
+
+typedef struct {
+    int ranges;                 // ranges the buffer was cut into
+    int resyncs;                // ranges decoded again because they did not join
+    double busiest_seconds;     // CPU time of the busiest thread
+} ItchParallelStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Records `outputs` must hold for a buffer of `size` bytes
+static inline size_t itch_parallel_max_outputs(size_t size) {
+    return size / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+}
+
+// Returns the first offset at or after `from` where a message plausibly starts, or `size` if
+// there is none. A chain that reaches the end of the buffer in fewer messages also counts.
+size_t itch_find_boundary(const uint8_t* buf, size_t size, size_t from);
+
+// Decodes `buf` like itch_decode_framed() on up to `num_threads` threads. `outputs` must hold
+// itch_parallel_max_outputs(size) records. Returns the number of records written and sets
+// *consumed; fills *stats if it is not null.
+size_t itch_decode_parallel(const uint8_t* buf, size_t size, int num_threads, ParserOutput* outputs,
+                            size_t* consumed, ItchParallelStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+// Scaling of itch_decode_parallel() (itch_parallel.h) from 1 to N threads over a BinaryFILE,
+// and a check that its output is exactly that of the serial decoder.
+//
+// The feed is replayed in chunks of chunk_mb MB, each decoded with 1, 2, 4 .. N threads. Every
+// run folds all of its records, in output order, into one hash that must equal the serial
+// decode's, along with the record count and the bytes consumed. Reported per thread count: wall
+// time, msgs/s and GB/s, and the CPU time of the busiest thread summed over chunks. On a machine
+// with fewer cores than threads the wall time cannot improve, but 1-thread CPU time over the
+// busiest thread's shows how far the split itself scales.
+//
+// The boundary check then decodes the first 4 MB of the feed at random sizes with random thread
+// counts, also with a zero length, a type outside the spec or a garbled length planted at a
+// random message. Each case must match itch_decode_framed() on the same bytes.
+//
+// Build: g++ -O3 -pthread -o itch_parallel_bench itch_parallel_bench.cpp itch_parallel.cpp itch_replay.c libitch.a
+// Usage: ./itch_parallel_bench <feed> [max threads, default 8] [chunk_mb=256] [cases=200]
+// Feeds come from itch_feedgen.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_parallel.h"
+#include "itch_replay.h"
+#include "itch_testgen.h"
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME  0x100000001B3ULL
+
+// Bytes of the feed the boundary check works on
+#define CHECK_BYTES (4u << 20)
+
+static uint64_t hash_records(uint64_t h, const ParserOutput* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ out[i].msg_type) * FNV_PRIME;
+        h = (h ^ out[i].stock_locate) * FNV_PRIME;
+        h = (h ^ out[i].timestamp) * FNV_PRIME;
+        h = (h ^ out[i].order_ref_no) * FNV_PRIME;
+        h = (h ^ out[i].shares) * FNV_PRIME;
+        h = (h ^ out[i].price) * FNV_PRIME;
+        h = (h ^ out[i].new_order_ref_no) * FNV_PRIME;
+    }
+    return h;
+}
+
+struct RunResult {
+    double wall;
+    double busiest;         // CPU seconds of the busiest thread, summed over chunks
+    size_t messages;
+    size_t bytes;
+    int resyncs;
+    uint64_t hash;
+};
+
+// threads == 0 runs itch_decode_framed() itself, for the reference
+static RunResult run(const char* feed, size_t chunk_size, int threads, std::vector<ParserOutput>& outputs) {
+    RunResult r = {0, 0, 0, 0, 0, FNV_OFFSET};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, feed, chunk_size) != 0) return r;
+    const uint8_t* chunk;
+    size_t len;
+    auto start = std::chrono::steady_clock::now();
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        size_t consumed = 0, n;
+        if (threads == 0) {
+            n = itch_decode_framed(chunk, len, outputs.data(), outputs.size(), &consumed);
+        } else {
+            ItchParallelStats stats;
+            n = itch_decode_parallel(chunk, len, threads, outputs.data(), &consumed, &stats);
+            r.busiest += stats.busiest_seconds;
+            r.resyncs += stats.resyncs;
+        }
+        r.hash = hash_records(r.hash, outputs.data(), n);
+        r.messages += n;
+        r.bytes += consumed;
+    }
+    r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    itch_replay_close(&replay);
+    return r;
+}
+
+// Decodes buf[0, size) both ways; returns 1 if they agree
+static int check_case(const uint8_t* buf, size_t size, int threads, std::vector<ParserOutput>& expect,
+                      std::vector<ParserOutput>& got, int* resyncs) {
+    size_t expect_consumed = 0, got_consumed = 0;
+    size_t n_expect = itch_decode_framed(buf, size, expect.data(), expect.size(), &expect_consumed);
+    ItchParallelStats stats;
+    size_t n_got = itch_decode_parallel(buf, size, threads, got.data(), &got_consumed, &stats);
+    *resyncs += stats.resyncs;
+    return n_got == n_expect && got_consumed == expect_consumed &&
+           hash_records(FNV_OFFSET, got.data(), n_got) == hash_records(FNV_OFFSET, expect.data(), n_expect);
+}
+
+// Offset of a random message's length prefix within buf[0, size)
+static size_t random_message(const uint8_t* buf, size_t size) {
+    size_t target = next_rand() % size, pos = 0;
+    while (pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t next = pos + ITCH_LENGTH_PREFIX + (((size_t)buf[pos] << 8) | buf[pos + 1]);
+        if (next > target || next + ITCH_LENGTH_PREFIX > size) break;
+        pos = next;
+    }
+    return pos;
+}
+
+static int boundary_check(const char* feed, int cases, int* resyncs) {
+    FILE* f = fopen(feed, "rb");
+    if (!f) return 0;
+    std::vector<uint8_t> original(CHECK_BYTES);
+    original.resize(fread(original.data(), 1, original.size(), f));
+    fclose(f);
+    if (original.size() < ITCH_PARALLEL_MIN_RANGE) return 0;
+
+    std::vector<ParserOutput> expect(itch_parallel_max_outputs(original.size()));
+    std::vector<ParserOutput> got(expect.size());
+    int failures = 0;
+    for (int c = 0; c < cases; c++) {
+        std::vector<uint8_t> buf = original;
+        size_t size = ITCH_PARALLEL_MIN_RANGE + next_rand() % (buf.size() - ITCH_PARALLEL_MIN_RANGE + 1);
+        int threads = 2 + (int)(next_rand() % 15);
+        size_t at = random_message(buf.data(), size);
+        const char* what = "clean";
+        switch (c % 4) {
+            case 1: buf[at] = 0; buf[at + 1] = 0; what = "zero length"; break;
+            case 2: buf[at + ITCH_LENGTH_PREFIX] = 'z'; what = "unknown type"; break;
+            case 3: buf[at + 1] ^= 0x01; what = "garbled length"; break;
+        }
+        if (!check_case(buf.data(), size, threads, expect, got, resyncs)) {
+            if (failures < 10) printf("  %s at %zu, %zu bytes, %d threads: differs from the serial decode\n",
+                                      what, at, size, threads);
+            failures++;
+        }
+    }
+    return failures == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <feed> [max threads, default 8] [chunk_mb=256] [cases=200]\n", argv[0]);
+        return 1;
+    }
+    const char* feed = argv[1];
+    int max_threads = 8;
+    size_t chunk_size = 256u << 20;
+    int cases = 200;
+    for (int i = 2; i < argc; i++) {
+        const char* a = argv[i];
+        if (strncmp(a, "chunk_mb=", 9) == 0) chunk_size = strtoull(a + 9, NULL, 10) << 20;
+        else if (strncmp(a, "cases=", 6) == 0) cases = atoi(a + 6);
+        else if (a[0] >= '0' && a[0] <= '9') max_threads = atoi(a);
+        else {
+            printf("Error: unknown argument %s\n", a);
+            return 1;
+        }
+    }
+    if (max_threads < 1 || chunk_size == 0) {
+        printf("Error: threads and the chunk size must be positive\n");
+        return 1;
+    }
+
+    ItchReplay probe;
+    if (itch_replay_open(&probe, feed, chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", feed, strerror(errno));
+        return 1;
+    }
+    size_t feed_size = probe.size;
+    itch_replay_close(&probe);
+
+    size_t max_chunk = chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN;
+    std::vector<ParserOutput> outputs(itch_parallel_max_outputs(max_chunk < feed_size ? max_chunk : feed_size));
+    RunResult ref = run(feed, chunk_size, 0, outputs);
+    printf("Feed %s: %.1f MB in %zu MB chunks, %zu messages; serial decode %.3f s, %.1f M msgs/s; "
+           "%u hardware threads\n", feed, feed_size / 1048576.0, chunk_size >> 20, ref.messages, ref.wall,
+           ref.messages / ref.wall / 1e6, std::thread::hardware_concurrency());
+
+    int errors = 0;
+    printf("%8s %10s %14s %8s %12s %10s %8s %8s\n", "threads", "wall s", "msgs/s", "GB/s", "busiest s",
+           "speedup", "resyncs", "check");
+    double base_busiest = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        RunResult r = run(feed, chunk_size, threads, outputs);
+        if (threads == 1) base_busiest = r.busiest;
+        int ok = r.hash == ref.hash && r.messages == ref.messages && r.bytes == ref.bytes;
+        errors += !ok;
+        printf("%8d %10.3f %14.0f %8.2f %12.3f %9.2fx %8d %8s\n", threads, r.wall, r.messages / r.wall,
+               r.bytes / r.wall / 1e9, r.busiest, r.busiest > 0 ? base_busiest / r.busiest : 0.0, r.resyncs,
+               ok ? "ok" : "FAIL");
+    }
+
+    int resyncs = 0;
+    int ok = boundary_check(feed, cases, &resyncs);
+    printf("Boundary check: %d cases on the first %u MB, %d ranges resynced: %s\n", cases, CHECK_BYTES >> 20,
+           resyncs, ok ? "ok" : "FAIL");
+    errors += !ok;
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
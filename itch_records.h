@@ -0,0 +1,228 @@
+#ifndef ITCH_RECORDS_H
+#define ITCH_RECORDS_H
+
+#include <stdint.h>
+#include "itch.h"
+
+// Type-specific records covering every ITCH 5.0 message type.
+//
+// Each message decodes into one 64-byte ItchRecord: a common header followed by a body whose
+// layout depends on the message type (the tag). A record is exactly one 512-bit beat on gmem1.
+// Integer and price fields are converted to little-endian, host byte order on x86.
+// Alphanumeric fields (stock symbols, MPIDs, reason codes) keep their bytes in message order,
+// space padded as on the wire, so they can be compared or printed as they are.
+// Padding and reserved bytes are always zero.
+
+#define ITCH_RECORD_LEN         64
+#define ITCH_RECORD_HEADER_LEN  16
+
+// 'S'
+typedef struct {
+    char     event_code;
+} ItchSystemEvent;
+
+// 'R'
+typedef struct {
+    char     stock[8];
+    char     market_category;
+    char     financial_status;
+    char     round_lots_only;
+    char     issue_classification;
+    char     issue_subtype[2];
+    char     authenticity;
+    char     short_sale_threshold;
+    char     ipo_flag;
+    char     luld_ref_price_tier;
+    char     etp_flag;
+    char     inverse_indicator;
+    uint32_t round_lot_size;
+    uint32_t etp_leverage_factor;
+} ItchStockDirectory;
+
+// 'H'
+typedef struct {
+    char     stock[8];
+    char     trading_state;
+    char     reserved;
+    char     reason[4];
+} ItchStockTradingAction;
+
+// 'Y'
+typedef struct {
+    char     stock[8];
+    char     reg_sho_action;
+} ItchRegSho;
+
+// 'L'
+typedef struct {
+    char     mpid[4];
+    char     stock[8];
+    char     primary_market_maker;
+    char     market_maker_mode;
+    char     participant_state;
+} ItchMarketParticipant;
+
+// 'V' (prices with 8 implied decimal places)
+typedef struct {
+    uint64_t level1;
+    uint64_t level2;
+    uint64_t level3;
+} ItchMwcbDeclineLevel;
+
+// 'W'
+typedef struct {
+    char     breached_level;
+} ItchMwcbStatus;
+
+// 'K'
+typedef struct {
+    char     stock[8];
+    uint32_t release_time;
+    uint32_t ipo_price;
+    char     release_qualifier;
+} ItchIpoQuotingPeriod;
+
+// 'J'
+typedef struct {
+    char     stock[8];
+    uint32_t ref_price;
+    uint32_t upper_price;
+    uint32_t lower_price;
+    uint32_t extension;
+} ItchLuldAuctionCollar;
+
+// 'h'
+typedef struct {
+    char     stock[8];
+    char     market_code;
+    char     halt_action;
+} ItchOperationalHalt;
+
+// 'A' and 'F' (attribution is all zero for 'A')
+typedef struct {
+    uint64_t order_ref_no;
+    char     stock[8];
+    uint32_t shares;
+    uint32_t price;
+    char     buy_sell;
+    char     reserved[3];
+    char     attribution[4];
+} ItchAddOrder;
+
+// 'E' and 'C' (execution_price and printable are zero for 'E')
+typedef struct {
+    uint64_t order_ref_no;
+    uint64_t match_no;
+    uint32_t shares;
+    uint32_t execution_price;
+    char     printable;
+} ItchOrderExecuted;
+
+// 'X'
+typedef struct {
+    uint64_t order_ref_no;
+    uint32_t shares;
+} ItchOrderCancel;
+
+// 'D'
+typedef struct {
+    uint64_t order_ref_no;
+} ItchOrderDelete;
+
+// 'U'
+typedef struct {
+    uint64_t order_ref_no;
+    uint64_t new_order_ref_no;
+    uint32_t shares;
+    uint32_t price;
+} ItchOrderReplace;
+
+// 'P'
+typedef struct {
+    uint64_t order_ref_no;
+    uint64_t match_no;
+    char     stock[8];
+    uint32_t shares;
+    uint32_t price;
+    char     buy_sell;
+} ItchTrade;
+
+// 'Q'
+typedef struct {
+    uint64_t shares;
+    uint64_t match_no;
+    char     stock[8];
+    uint32_t cross_price;
+    char     cross_type;
+} ItchCrossTrade;
+
+// 'B'
+typedef struct {
+    uint64_t match_no;
+} ItchBrokenTrade;
+
+// 'I'
+typedef struct {
+    uint64_t paired_shares;
+    uint64_t imbalance_shares;
+    char     stock[8];
+    uint32_t far_price;
+    uint32_t near_price;
+    uint32_t ref_price;
+    char     imbalance_direction;
+    char     cross_type;
+    char     price_variation;
+} ItchNoii;
+
+// 'N'
+typedef struct {
+    char     stock[8];
+    char     interest_flag;
+} ItchRpii;
+
+// 'O'
+typedef struct {
+    char     stock[8];
+    uint64_t near_execution_time;
+    uint32_t min_allowable_price;
+    uint32_t max_allowable_price;
+    uint32_t near_execution_price;
+    uint32_t lower_price_collar;
+    uint32_t upper_price_collar;
+    char     open_eligibility;
+} ItchDlcrPriceDiscovery;
+
+typedef struct {
+    uint8_t  msg_type;        // record tag
+    uint8_t  reserved0;
+    uint16_t stock_locate;
+    uint16_t tracking_no;
+    uint16_t reserved1;
+    uint64_t timestamp;
+    union {
+        ItchSystemEvent         system_event;
+        ItchStockDirectory      stock_directory;
+        ItchStockTradingAction  trading_action;
+        ItchRegSho              reg_sho;
+        ItchMarketParticipant   market_participant;
+        ItchMwcbDeclineLevel    mwcb_decline_level;
+        ItchMwcbStatus          mwcb_status;
+        ItchIpoQuotingPeriod    ipo_quoting_period;
+        ItchLuldAuctionCollar   luld_auction_collar;
+        ItchOperationalHalt     operational_halt;
+        ItchAddOrder            add_order;
+        ItchOrderExecuted       order_executed;
+        ItchOrderCancel         order_cancel;
+        ItchOrderDelete         order_delete;
+        ItchOrderReplace        order_replace;
+        ItchTrade               trade;
+        ItchCrossTrade          cross_trade;
+        ItchBrokenTrade         broken_trade;
+        ItchNoii                noii;
+        ItchRpii                rpii;
+        ItchDlcrPriceDiscovery  dlcr_price_discovery;
+        uint8_t                 body[ITCH_RECORD_LEN - ITCH_RECORD_HEADER_LEN];
+    };
+} ItchRecord;
+
+#endif
@@ -0,0 +1,74 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "itch.h"
+#include "itch_replay.h"
+
+int itch_replay_open(ItchReplay* replay, const char* path, size_t chunk_size) {
+    replay->fd = open(path, O_RDONLY);
+    if (replay->fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(replay->fd, &st) != 0) { close(replay->fd); return -1; }
+    replay->size = (size_t)st.st_size;
+    replay->pos = 0;
+    replay->released = 0;
+    replay->chunk_size = chunk_size;
+    replay->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    replay->data = NULL;
+
+    if (replay->size > 0) {
+        void* p = mmap(NULL, replay->size, PROT_READ, MAP_PRIVATE, replay->fd, 0);
+        if (p == MAP_FAILED) { close(replay->fd); return -1; }
+        replay->data = (const uint8_t*)p;
+        // Read ahead aggressively and drop pages soon after they are used
+        madvise(p, replay->size, MADV_SEQUENTIAL);
+    }
+    return 0;
+}
+
+int itch_replay_next(ItchReplay* replay, const uint8_t** chunk, size_t* len) {
+    const uint8_t* data = replay->data;
+    size_t start = replay->pos;
+    size_t end = start;
+
+    // Walk the length prefixes up to the target size; a single message is always taken whole
+    while (end + ITCH_LENGTH_PREFIX <= replay->size) {
+        size_t msg_len = ((size_t)data[end] << 8) | data[end + 1];
+        size_t next = end + ITCH_LENGTH_PREFIX + msg_len;
+        if (msg_len == 0 || next > replay->size) break;
+        if (next - start > replay->chunk_size && end > start) break;
+        end = next;
+    }
+    if (end == start) return 0;
+
+    // The caller is done with the previous chunk once it asks for the next one. Dropped pages
+    // of a read-only file mapping are simply faulted back in if touched again, so this only
+    // ever costs performance, never correctness.
+    size_t release_to = start - start % replay->page_size;
+    if (release_to > replay->released) {
+        madvise((void*)(data + replay->released), release_to - replay->released, MADV_DONTNEED);
+        replay->released = release_to;
+    }
+
+    *chunk = data + start;
+    *len = end - start;
+    replay->pos = end;
+
+    // Start paging in the chunk after this one while this one is being parsed
+    size_t ahead = end - end % replay->page_size;
+    if (ahead < replay->size) {
+        size_t ahead_len = replay->chunk_size < replay->size - ahead ? replay->chunk_size : replay->size - ahead;
+        madvise((void*)(data + ahead), ahead_len, MADV_WILLNEED);
+    }
+    return 1;
+}
+
+void itch_replay_close(ItchReplay* replay) {
+    if (replay->data) munmap((void*)replay->data, replay->size);
+    if (replay->fd >= 0) close(replay->fd);
+    replay->data = NULL;
+    replay->fd = -1;
+}
@@ -0,0 +1,42 @@
+#ifndef ITCH_REPLAY_H
+#define ITCH_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory-mapped Nasdaq BinaryFILE replay source.
+//
+// The file is mmapped read-only and handed out as chunks of roughly `chunk_size` bytes that
+// always end on a message boundary, so each chunk can go straight to parser_framed or
+// itch_decode_framed. Chunks point into the mapping (nothing is copied), and pages behind the
+// current chunk are released as the replay advances, so resident memory stays around two
+// chunks no matter how large the file is.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int fd;
+    const uint8_t* data;    // start of the mapping
+    size_t size;            // file size in bytes
+    size_t pos;             // start of the next chunk
+    size_t chunk_size;      // target chunk size
+    size_t released;        // bytes before this offset have been returned to the kernel
+    size_t page_size;
+} ItchReplay;
+
+// Maps `path`. Returns 0 on success, -1 on failure (errno is set).
+int itch_replay_open(ItchReplay* replay, const char* path, size_t chunk_size);
+
+// Returns the next chunk in *chunk / *len, or 0 when the file is exhausted. A truncated
+// final message is never returned. Pages of the previous chunk are released by this call.
+int itch_replay_next(ItchReplay* replay, const uint8_t** chunk, size_t* len);
+
+void itch_replay_close(ItchReplay* replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "itch_decoder.h"
+#include "itch_parallel.h"
+#include "itch_replay.h"
+
+/* Replays a BinaryFILE through the CPU decoder chunk by chunk and reports sustained throughput.
+ * With more than one thread, each chunk is decoded by itch_decode_parallel (itch_parallel.h);
+ * the records of a whole chunk are then held at once (about 3.5x the chunk size).
+ * Build: g++ -O3 -c itch_parallel.cpp
+ *        gcc -O2 -pthread -o itch_replay_cpu itch_replay_cpu.c itch_replay.c itch_parallel.o libitch.a -lstdc++ */
+
+#define BATCH_OUTPUTS 65536
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        printf("Usage: %s <itch BinaryFILE> [chunk size in MB, default 64] [threads, default 1]\n", argv[0]);
+        return 1;
+    }
+    size_t chunk_size = (argc > 2 ? strtoull(argv[2], NULL, 10) : 64) << 20;
+    int threads = argc > 3 ? atoi(argv[3]) : 1;
+    if (chunk_size == 0 || threads < 1) {
+        printf("Error: chunk size and threads must be positive\n");
+        return 1;
+    }
+
+    ItchReplay replay;
+    if (itch_replay_open(&replay, argv[1], chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    size_t max_outputs = threads > 1
+        ? itch_parallel_max_outputs(chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) : BATCH_OUTPUTS;
+    ParserOutput *outputs = (ParserOutput*)malloc(max_outputs * sizeof(ParserOutput));
+    if (!outputs) { perror("malloc outputs"); return 1; }
+
+    size_t total_bytes = 0, total_messages = 0, num_chunks = 0, resyncs = 0;
+    uint64_t checksum = 0;
+    const uint8_t *chunk;
+    size_t len;
+    double start = now_seconds();
+
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        size_t pos = 0;
+        if (threads > 1) {
+            size_t consumed = 0;
+            ItchParallelStats stats;
+            size_t n = itch_decode_parallel(chunk, len, threads, outputs, &consumed, &stats);
+            for (size_t i = 0; i < n; i++) checksum += outputs[i].order_ref_no;
+            total_messages += n;
+            resyncs += stats.resyncs;
+            pos = len;
+        }
+        while (pos < len) {
+            size_t consumed = 0;
+            size_t n = itch_decode_framed(chunk + pos, len - pos, outputs, BATCH_OUTPUTS, &consumed);
+            for (size_t i = 0; i < n; i++) checksum += outputs[i].order_ref_no;
+            total_messages += n;
+            pos += consumed;
+        }
+        total_bytes += len;
+        num_chunks++;
+    }
+
+    double seconds = now_seconds() - start;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%zu of %zu bytes in %zu chunks, %zu messages decoded (checksum %016llx)\n",
+           total_bytes, replay.size, num_chunks, total_messages, (unsigned long long)checksum);
+    printf("%.3f s, %.2f GB/s, %.1f M msgs/s, peak RSS %.1f MB\n", seconds,
+           total_bytes / seconds / 1e9, total_messages / seconds / 1e6, usage.ru_maxrss / 1024.0);
+    if (threads > 1) printf("%d threads, %zu ranges resynced\n", threads, resyncs);
+    if (total_bytes != replay.size) printf("Warning: file ends with a truncated message\n");
+
+    itch_replay_close(&replay);
+    free(outputs);
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include <CL/opencl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "itch.h"
+#include "itch_replay.h"
+#include "stock_filter.h"
+
+/* Replays a BinaryFILE through the parser_framed kernel chunk by chunk and reports sustained
+ * throughput. Each chunk is DMA'd to the card straight out of the file mapping, so the host
+ * never copies or fully loads the file.
+ *
+ * With a subscription file (stock_locate numbers, one per line), parser_filtered runs instead:
+ * the bitmap is written to the card once, and only messages for subscribed stocks are written to
+ * card memory and read back. */
+
+/* Reads stock_locate numbers, one per line, into a filter bitmap. Returns the number of stocks. */
+static int load_subscription(const char *path, uint64_t *filter) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    stock_filter_clear(filter);
+    int count = 0;
+    unsigned locate;
+    while (fscanf(fp, "%u", &locate) == 1) {
+        if (locate < STOCK_FILTER_BITS && !stock_filter_test(filter, (uint16_t)locate)) {
+            stock_filter_add(filter, (uint16_t)locate);
+            count++;
+        }
+    }
+    fclose(fp);
+    return count;
+}
+
+/* Helper: aligned allocation for XRT-friendly host pointers */
+static void *aligned_alloc_xrt(size_t align, size_t size) {
+    void *p = NULL;
+    int r = posix_memalign(&p, align, size);
+    if (r != 0) return NULL;
+    memset(p, 0, size);
+    return p;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        printf("Usage: %s <xclbin> <itch BinaryFILE> [chunk size in MB, default 64] [subscription file]\n", argv[0]);
+        return 1;
+    }
+    const char* xclbinPath = argv[1];
+    size_t chunk_size = (argc > 3 ? strtoull(argv[3], NULL, 10) : 64) << 20;
+    int filtered = argc > 4;
+
+    uint64_t *filter = (uint64_t*)aligned_alloc_xrt(4096, STOCK_FILTER_BYTES);
+    if (!filter) { perror("aligned_alloc filter"); return 1; }
+    if (filtered) {
+        int num_stocks = load_subscription(argv[4], filter);
+        if (num_stocks < 0) { printf("Error: could not open %s (%s)\n", argv[4], strerror(errno)); return 1; }
+        printf("Subscribed to %d stocks\n", num_stocks);
+    }
+
+    ItchReplay replay;
+    if (itch_replay_open(&replay, argv[2], chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", argv[2], strerror(errno));
+        return 1;
+    }
+
+    /* A chunk holds at most one record per shortest framed message, plus the one message
+     * that may overshoot the target size */
+    size_t max_outputs = (chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) /
+                         (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    size_t input_capacity = chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN + 64;
+    ParserOutput *output = (ParserOutput*)aligned_alloc_xrt(4096, max_outputs * sizeof(ParserOutput));
+    if (!output) { perror("aligned_alloc output"); return 1; }
+    int num_outputs_host = 0;
+    int num_dropped_host = 0;
+
+    /* --- OpenCL / Xilinx flow --- */
+    cl_int err;
+    cl_platform_id platform;
+    err = clGetPlatformIDs(1, &platform, NULL);
+    if (err != CL_SUCCESS) { printf("clGetPlatformIDs failed: %d\n", err); return 1; }
+
+    cl_device_id device;
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ACCELERATOR, 1, &device, NULL);
+    if (err != CL_SUCCESS) { printf("clGetDeviceIDs failed: %d\n", err); return 1; }
+
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (!context || err != CL_SUCCESS) { printf("clCreateContext failed: %d\n", err); return 1; }
+
+    cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+    if (!queue || err != CL_SUCCESS) { printf("clCreateCommandQueue failed: %d\n", err); return 1; }
+
+    FILE* fp = fopen(xclbinPath, "rb");
+    if (!fp) { printf("Error: could not open %s (%s)\n", xclbinPath, strerror(errno)); return 1; }
+    fseek(fp, 0, SEEK_END);
+    size_t binary_size = ftell(fp);
+    rewind(fp);
+    void *binary = aligned_alloc_xrt(4096, binary_size);
+    if (!binary) { perror("aligned_alloc binary"); fclose(fp); return 1; }
+    if (fread(binary, 1, binary_size, fp) != binary_size) { perror("fread"); fclose(fp); return 1; }
+    fclose(fp);
+
+    cl_program program = clCreateProgramWithBinary(context, 1, &device, &binary_size,
+                                                   (const unsigned char**)&binary, NULL, &err);
+    if (err != CL_SUCCESS) { printf("clCreateProgramWithBinary failed: %d\n", err); return 1; }
+    err = clBuildProgram(program, 1, &device, NULL, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clBuildProgram failed: %d\n", err); return 1; }
+
+    cl_kernel kernel = clCreateKernel(program, filtered ? "parser_filtered" : "parser_framed", &err);
+    if (err != CL_SUCCESS) { printf("clCreateKernel failed: %d\n", err); return 1; }
+
+    /* Device buffers are allocated once and reused for every chunk */
+    cl_mem buffer_input = clCreateBuffer(context, CL_MEM_READ_ONLY, input_capacity, NULL, &err);
+    if (err != CL_SUCCESS) { printf("buffer_input create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_output = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR,
+                                          max_outputs * sizeof(ParserOutput), output, &err);
+    if (err != CL_SUCCESS) { printf("buffer_output create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_num_outputs = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                                               sizeof(int), &num_outputs_host, &err);
+    if (err != CL_SUCCESS) { printf("buffer_num_outputs create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_filter = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
+                                          STOCK_FILTER_BYTES, filter, &err);
+    if (err != CL_SUCCESS) { printf("buffer_filter create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_num_dropped = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                                               sizeof(int), &num_dropped_host, &err);
+    if (err != CL_SUCCESS) { printf("buffer_num_dropped create failed: %d\n", err); return 1; }
+
+    err  = clSetKernelArg(kernel, 0, sizeof(cl_mem), &buffer_input);
+    err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &buffer_output);
+    err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &buffer_num_outputs);
+    if (filtered) {
+        err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &buffer_filter);
+        err |= clSetKernelArg(kernel, 5, sizeof(cl_mem), &buffer_num_dropped);
+    }
+    if (err != CL_SUCCESS) { printf("clSetKernelArg failed: %d\n", err); return 1; }
+
+    /* The subscription stays on the card for the whole replay */
+    if (filtered) {
+        err = clEnqueueMigrateMemObjects(queue, 1, &buffer_filter, 0, 0, NULL, NULL);
+        if (err != CL_SUCCESS) { printf("clEnqueueMigrate filter failed: %d\n", err); return 1; }
+    }
+
+    size_t total_bytes = 0, total_messages = 0, total_dropped = 0, bytes_read_back = 0, num_chunks = 0;
+    const uint8_t *chunk;
+    size_t len;
+    double start = now_seconds();
+
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        int num_bytes = (int)len;
+
+        /* DMA straight from the file mapping */
+        err = clEnqueueWriteBuffer(queue, buffer_input, CL_FALSE, 0, len, chunk, 0, NULL, NULL);
+        if (err != CL_SUCCESS) { printf("clEnqueueWriteBuffer failed: %d\n", err); return 1; }
+
+        err = clSetKernelArg(kernel, 1, sizeof(int), &num_bytes);
+        if (err != CL_SUCCESS) { printf("clSetKernelArg failed: %d\n", err); return 1; }
+
+        err = clEnqueueTask(queue, kernel, 0, NULL, NULL);
+        if (err != CL_SUCCESS) { printf("clEnqueueTask failed: %d\n", err); return 1; }
+
+        err = clEnqueueMigrateMemObjects(queue, 1, &buffer_num_outputs, CL_MIGRATE_MEM_OBJECT_HOST, 0, NULL, NULL);
+        if (filtered) {
+            err |= clEnqueueMigrateMemObjects(queue, 1, &buffer_num_dropped, CL_MIGRATE_MEM_OBJECT_HOST, 0, NULL, NULL);
+        }
+        if (err != CL_SUCCESS) { printf("clEnqueueMigrate back failed: %d\n", err); return 1; }
+        clFinish(queue);
+
+        if (num_outputs_host > 0) {
+            err = clEnqueueReadBuffer(queue, buffer_output, CL_TRUE, 0, num_outputs_host * sizeof(ParserOutput),
+                                      output, 0, NULL, NULL);
+            if (err != CL_SUCCESS) { printf("clEnqueueReadBuffer output failed: %d\n", err); return 1; }
+        }
+
+        total_messages += num_outputs_host;
+        bytes_read_back += num_outputs_host * sizeof(ParserOutput);
+        if (filtered) total_dropped += num_dropped_host;
+        total_bytes += len;
+        num_chunks++;
+    }
+
+    double seconds = now_seconds() - start;
+    printf("%zu of %zu bytes in %zu chunks, %zu messages parsed on the card\n",
+           total_bytes, replay.size, num_chunks, total_messages);
+    printf("%.3f s, %.2f GB/s, %.1f M msgs/s\n", seconds, total_bytes / seconds / 1e9,
+           total_messages / seconds / 1e6);
+    printf("%zu bytes of records read back", bytes_read_back);
+    if (filtered) printf(", %zu messages for unsubscribed stocks dropped on the card", total_dropped);
+    printf("\n");
+    if (total_bytes != replay.size) printf("Warning: file ends with a truncated message\n");
+
+    clReleaseMemObject(buffer_input);
+    clReleaseMemObject(buffer_output);
+    clReleaseMemObject(buffer_num_outputs);
+    clReleaseMemObject(buffer_filter);
+    clReleaseMemObject(buffer_num_dropped);
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    itch_replay_close(&replay);
+    free(output);
+    free(filter);
+    free(binary);
+
+    return 0;
+}
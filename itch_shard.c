@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include "itch.h"
+#include "itch_shard.h"
+
+// Longest copy the splitter makes for one message: prefix and longest body, rounded up
+#define ITCH_SHARD_COPY 64
+
+size_t itch_shard_count(const uint8_t* buf, size_t size, uint64_t* counts) {
+    size_t pos = 0;
+    while (pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = ((size_t)buf[pos] << 8) | buf[pos + 1];
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        if (len >= 3) counts[((uint16_t)buf[pos + 3] << 8) | buf[pos + 4]]++;
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    return pos;
+}
+
+size_t itch_shard_split(const uint8_t* buf, size_t size, const uint8_t* shard_of, int num_shards,
+                        ItchShardStream* streams) {
+    size_t pos = 0;
+    while (pos + ITCH_LENGTH_PREFIX <= size) {
+        size_t len = ((size_t)buf[pos] << 8) | buf[pos + 1];
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > size) break;
+        size_t n = ITCH_LENGTH_PREFIX + len;
+        uint16_t locate = len >= 3 ? ((uint16_t)buf[pos + 3] << 8) | buf[pos + 4] : 0;
+        int first = locate ? shard_of[locate] : 0;
+        int last = locate ? first : num_shards - 1;
+        int s;
+        for (s = first; s <= last; s++) {
+            if (streams[s].size + n > streams[s].capacity) break;
+        }
+        if (s <= last) break;
+        for (s = first; s <= last; s++) {
+            ItchShardStream* st = &streams[s];
+            // A whole 64-byte copy is a few fixed stores; the bytes past the message are
+            // overwritten by the next one
+            if (pos + ITCH_SHARD_COPY <= size && st->size + ITCH_SHARD_COPY <= st->capacity) {
+                memcpy(st->data + st->size, buf + pos, ITCH_SHARD_COPY);
+            } else {
+                memcpy(st->data + st->size, buf + pos, n);
+            }
+            st->size += n;
+        }
+        pos += n;
+    }
+    return pos;
+}
+
+void itch_shard_plan_hash(int num_shards, uint8_t* shard_of) {
+    for (int locate = 0; locate < STOCK_FILTER_BITS; locate++) shard_of[locate] = (uint8_t)(locate % num_shards);
+}
+
+static const uint64_t* sort_counts;
+
+static int by_count_desc(const void* a, const void* b) {
+    uint64_t ca = sort_counts[*(const uint16_t*)a], cb = sort_counts[*(const uint16_t*)b];
+    if (ca != cb) return ca > cb ? -1 : 1;
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+void itch_shard_plan_balanced(const uint64_t* counts, int num_shards, uint8_t* shard_of) {
+    itch_shard_plan_hash(num_shards, shard_of);
+
+    uint16_t* order = (uint16_t*)malloc(STOCK_FILTER_BITS * sizeof(uint16_t));
+    if (!order) return;   // the hash plan stays
+    int seen = 0;
+    for (int locate = 1; locate < STOCK_FILTER_BITS; locate++) {
+        if (counts[locate]) order[seen++] = (uint16_t)locate;
+    }
+    sort_counts = counts;
+    qsort(order, seen, sizeof(uint16_t), by_count_desc);
+
+    uint64_t load[ITCH_SHARD_MAX] = {0};
+    for (int i = 0; i < seen; i++) {
+        int best = 0;
+        for (int s = 1; s < num_shards; s++) {
+            if (load[s] < load[best]) best = s;
+        }
+        shard_of[order[i]] = (uint8_t)best;
+        load[best] += counts[order[i]];
+    }
+    free(order);
+}
+
+double itch_shard_imbalance(const uint64_t* counts, const uint8_t* shard_of, int num_shards) {
+    uint64_t load[ITCH_SHARD_MAX] = {0};
+    uint64_t total = 0;
+    for (int locate = 1; locate < STOCK_FILTER_BITS; locate++) {
+        load[shard_of[locate]] += counts[locate];
+        total += counts[locate];
+    }
+    uint64_t max = 0;
+    for (int s = 0; s < num_shards; s++) {
+        if (load[s] > max) max = load[s];
+    }
+    return total ? (double)max * num_shards / (double)total : 1.0;
+}
+
+void itch_shard_filters(const uint8_t* shard_of, int num_shards, uint64_t* filters) {
+    for (int s = 0; s < num_shards; s++) {
+        uint64_t* filter = filters + (size_t)s * STOCK_FILTER_WORDS;
+        stock_filter_clear(filter);
+        stock_filter_add(filter, 0);
+    }
+    for (int locate = 1; locate < STOCK_FILTER_BITS; locate++) {
+        stock_filter_add(filters + (size_t)shard_of[locate] * STOCK_FILTER_WORDS, (uint16_t)locate);
+    }
+}
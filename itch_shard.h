@@ -0,0 +1,66 @@
+#ifndef ITCH_SHARD_H
+#define ITCH_SHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "stock_filter.h"
+
+// Partitioning a feed over several parser instances by stock_locate.
+//
+// Order flow for different symbols is independent, so a feed can be split by symbol and each
+// part parsed by its own instance: a parser_framed compute unit or a CPU thread running
+// itch_decode_framed(). itch_shard_split is the splitter in front of them. It walks the frames
+// once and copies each message to its shard's own BinaryFILE stream, so an instance reads only
+// its shard's messages, and each symbol's messages come out of exactly one instance, in feed
+// order. Where the input cannot be split first (one buffer shared by every compute unit),
+// itch_shard_filters gives each parser_filtered instance a bitmap instead, at the cost of every
+// instance scanning the whole stream.
+//
+// A plan maps every locate code to a shard. Hashing (locate % N) balances only when symbols are
+// equally busy; on a real feed a few symbols carry most of the flow, so itch_shard_plan_balanced
+// packs symbols by their message counts instead (largest first onto the least loaded shard).
+// Counts come from a sample, such as the start of the feed or the previous session.
+// Locate 0 (market-wide messages) belongs to every shard.
+
+#define ITCH_SHARD_MAX 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One shard's part of a feed: its messages in feed order, length prefixes included
+typedef struct {
+    uint8_t* data;
+    size_t size;        // bytes in use
+    size_t capacity;
+} ItchShardStream;
+
+// Adds the number of messages per stock_locate in a BinaryFILE buffer to counts[STOCK_FILTER_BITS].
+// Returns the number of bytes scanned (whole messages only).
+size_t itch_shard_count(const uint8_t* buf, size_t size, uint64_t* counts);
+
+// shard_of[STOCK_FILTER_BITS] = locate % num_shards
+void itch_shard_plan_hash(int num_shards, uint8_t* shard_of);
+
+// Balanced plan from per-locate message counts; locates never seen fall back to hashing
+void itch_shard_plan_balanced(const uint64_t* counts, int num_shards, uint8_t* shard_of);
+
+// Busiest shard's message count over the mean, under `counts`: 1.0 is perfect balance, and
+// num_shards / imbalance bounds the speedup over one instance
+double itch_shard_imbalance(const uint64_t* counts, const uint8_t* shard_of, int num_shards);
+
+// Appends every whole message of a BinaryFILE buffer to streams[shard_of[stock_locate]], after
+// what the stream already holds; locate 0 goes to every stream. Stops where itch_decode_framed()
+// would, or before a message that does not fit. A stream with room for the whole buffer never
+// fills. Returns the number of bytes consumed.
+size_t itch_shard_split(const uint8_t* buf, size_t size, const uint8_t* shard_of, int num_shards,
+                        ItchShardStream* streams);
+
+// Fills one stock_filter.h bitmap per shard; shard s is at filters + s * STOCK_FILTER_WORDS
+void itch_shard_filters(const uint8_t* shard_of, int num_shards, uint64_t* filters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,428 @@
+// Scaling of sharded parsing (itch_shard.h) from 1 to N instances on a skewed feed.
+//
+// The feed is replayed in chunks. The splitter (itch_shard_split) cuts each chunk into one
+// BinaryFILE stream per shard on the main thread, and each instance parses only its own stream,
+// one chunk behind the splitter:
+//   threads  N threads per chunk, one per stream, running itch_decode_framed()
+//   model    parser_framed's core in C-sim, one instance per stream, timed by the kernel's cycle
+//            model at 300 MHz. Runs on the first model_mb MB only (C-sim is slow).
+//   kernel   one parser_framed run per stream and chunk through accel_runtime.h, each with its
+//            own input buffer; the card runs them on as many compute units as the xclbin has
+//            (v++ --connectivity.nk=parser_framed:N), the cpu backend on its worker threads
+// Both the hash plan and the balanced plan are measured. Plans are built from the message
+// counts of the first sample_mb MB of the feed.
+//
+// Every run is checked against a single-threaded decode of the whole feed. Each symbol's records
+// are folded into a per-symbol hash in the order they come out of their instance, and every
+// hash must match, so a lost, duplicated or reordered message shows up.
+//
+// Reported per run: wall time, the splitter's CPU time, and the busiest instance's own time: CPU
+// time for a thread, modelled cycles for a model instance, summed run times from event profiling
+// for a kernel instance. On a machine with fewer cores than instances the wall time cannot
+// improve, but 1-instance time over the busiest instance's time still shows how far the sharding
+// itself scales. The "bound" column is N / imbalance, the best any N instances could do with that
+// plan. The splitter is one serial stage, so "msgs/s" is the rate of the whole pipeline with the
+// splitter and every instance on a core of its own: messages over the slower of the two.
+//
+// Build: g++ -O3 -pthread -o itch_shard_bench itch_shard_bench.cpp itch_shard.c itch_replay.c libitch.a
+//        (for model and kernel, add -DSHARD_KERNEL -I$XILINX_HLS/include accel_runtime.cpp
+//         accel_opencl.cpp accel_cpu.cpp double_vector.cpp parser_wide.cpp Archive/parser.cpp
+//         Archive/deserializer.cpp -lOpenCL)
+// Usage: ./itch_shard_bench <feed> [max instances, default 8] [sample_mb=16] [chunk_kb=4096]
+//                           [model_mb=4] [xclbin=path]
+// Feeds come from itch_feedgen.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_replay.h"
+#include "itch_shard.h"
+#ifdef SHARD_KERNEL
+#include <ap_int.h>
+#include "accel_runtime.h"
+#include "parser_wide.h"
+#endif
+
+// Records decoded per call
+#define BATCH_OUTPUTS 4096
+
+enum { MODE_THREADS, MODE_MODEL, MODE_KERNEL };
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME  0x100000001B3ULL
+
+// Per-symbol hashes, updated as records come out of an instance
+struct SymbolHashes {
+    std::vector<uint64_t> hash;
+    size_t messages;
+    SymbolHashes() : hash(STOCK_FILTER_BITS, FNV_OFFSET), messages(0) {}
+
+    void add(const ParserOutput* out, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            uint64_t& h = hash[out[i].stock_locate];
+            h = (h ^ out[i].msg_type) * FNV_PRIME;
+            h = (h ^ out[i].timestamp) * FNV_PRIME;
+            h = (h ^ out[i].order_ref_no) * FNV_PRIME;
+        }
+        messages += n;
+    }
+};
+
+struct Options {
+    const char* feed;
+    size_t chunk_size;
+    size_t model_bytes;
+};
+
+static double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Decodes the feed's chunks, unsharded, until `limit` bytes have been covered
+static void decode_feed(const Options* opt, size_t limit, SymbolHashes* out, double* cpu_seconds) {
+    double start = thread_cpu_seconds();
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt->feed, opt->chunk_size) != 0) return;
+    std::vector<ParserOutput> outputs(BATCH_OUTPUTS);
+    const uint8_t* chunk;
+    size_t len, bytes = 0;
+    while (bytes < limit && itch_replay_next(&replay, &chunk, &len)) {
+        bytes += len;
+        size_t pos = 0;
+        while (pos < len) {
+            size_t consumed = 0;
+            size_t n = itch_decode_framed(chunk + pos, len - pos, outputs.data(), BATCH_OUTPUTS, &consumed);
+            out->add(outputs.data(), n);
+            if (consumed == 0) break;
+            pos += consumed;
+        }
+    }
+    itch_replay_close(&replay);
+    *cpu_seconds = thread_cpu_seconds() - start;
+}
+
+struct RunResult {
+    double wall;
+    double split;          // splitter CPU seconds
+    double busiest;        // seconds of the busiest instance
+    size_t messages;
+    int mismatches;        // symbols whose hash differs from the reference
+};
+
+// Per-shard streams for one chunk, each with room for the whole chunk
+struct ShardStreams {
+    std::vector<std::vector<uint8_t> > data;
+    std::vector<ItchShardStream> streams;
+
+    ShardStreams(int shards, size_t chunk_size) : data(shards), streams(shards) {
+        for (int s = 0; s < shards; s++) {
+            data[s].resize(chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN);
+            streams[s].data = data[s].data();
+            streams[s].capacity = data[s].size();
+        }
+    }
+
+    // Splits `chunk` and returns the splitter's CPU time
+    double split(const uint8_t* chunk, size_t len, const uint8_t* shard_of) {
+        double start = thread_cpu_seconds();
+        for (ItchShardStream& st : streams) st.size = 0;
+        itch_shard_split(chunk, len, shard_of, (int)streams.size(), streams.data());
+        return thread_cpu_seconds() - start;
+    }
+};
+
+// Decodes one shard's stream of one chunk
+static void decode_stream(const ItchShardStream* stream, SymbolHashes* out, double* cpu_seconds) {
+    double start = thread_cpu_seconds();
+    std::vector<ParserOutput> outputs(BATCH_OUTPUTS);
+    size_t pos = 0;
+    while (pos < stream->size) {
+        size_t consumed = 0;
+        size_t n = itch_decode_framed(stream->data + pos, stream->size - pos, outputs.data(), BATCH_OUTPUTS,
+                                      &consumed);
+        out->add(outputs.data(), n);
+        if (consumed == 0) break;
+        pos += consumed;
+    }
+    *cpu_seconds += thread_cpu_seconds() - start;
+}
+
+// Merges each instance's symbols into one view and compares it with the reference
+static int count_mismatches(const std::vector<SymbolHashes>& parts, const uint8_t* shard_of,
+                            const SymbolHashes& reference) {
+    int mismatches = 0;
+    for (int locate = 1; locate < STOCK_FILTER_BITS; locate++) {
+        mismatches += parts[shard_of[locate]].hash[locate] != reference.hash[locate];
+    }
+    return mismatches;
+}
+
+// The main thread splits chunk k + 1 while one thread per shard decodes chunk k
+static RunResult run_threads(const Options& opt, const uint8_t* shard_of, int shards,
+                             const SymbolHashes& reference) {
+    RunResult r = {0, 0, 0, 0, 0};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return r;
+    ShardStreams sets[2] = {ShardStreams(shards, opt.chunk_size), ShardStreams(shards, opt.chunk_size)};
+    std::vector<SymbolHashes> parts(shards);
+    std::vector<double> cpu(shards, 0.0);
+    std::vector<std::thread> workers;
+    const uint8_t* chunk;
+    size_t len;
+    int cur = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        r.split += sets[cur].split(chunk, len, shard_of);
+        for (auto& w : workers) w.join();
+        workers.clear();
+        for (int s = 0; s < shards; s++) {
+            workers.emplace_back(decode_stream, &sets[cur].streams[s], &parts[s], &cpu[s]);
+        }
+        cur ^= 1;
+    }
+    for (auto& w : workers) w.join();
+    itch_replay_close(&replay);
+
+    r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.messages = 0;
+    for (int s = 0; s < shards; s++) {
+        if (cpu[s] > r.busiest) r.busiest = cpu[s];
+        r.messages += parts[s].messages;
+    }
+    r.mismatches = count_mismatches(parts, shard_of, reference);
+    return r;
+}
+
+#ifdef SHARD_KERNEL
+#define MODEL_MHZ 300.0
+
+// One parse_wide_core instance per shard stream over the first model_bytes of the feed; the
+// instances would run side by side, so the busiest one's modelled time is the wall time
+static RunResult run_model(const Options& opt, const uint8_t* shard_of, int shards,
+                           const SymbolHashes& reference) {
+    RunResult r = {0, 0, 0, 0, 0};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return r;
+    size_t max_outputs = (opt.chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) /
+                         (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    std::vector<ParserOutput> outputs(max_outputs);
+    std::vector<SymbolHashes> parts(shards);
+    std::vector<uint64_t> cycles(shards, 0);
+    ShardStreams split(shards, opt.chunk_size);
+
+    std::vector<ap_uint<512> > beats;
+    const uint8_t* chunk;
+    size_t len, bytes = 0;
+    while (bytes < opt.model_bytes && itch_replay_next(&replay, &chunk, &len)) {
+        bytes += len;
+        r.split += split.split(chunk, len, shard_of);
+        for (int s = 0; s < shards; s++) {
+            const ItchShardStream& st = split.streams[s];
+            beats.assign((st.size + 63) / 64 + 1, 0);
+            for (size_t i = 0; i < st.size; i++) beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = st.data[i];
+            int n = 0;
+            cycles[s] += parse_wide_core<64, INPUT_FRAMED>(beats.data(), (int)st.size, outputs.data(), &n);
+            parts[s].add(outputs.data(), n);
+        }
+    }
+    itch_replay_close(&replay);
+    for (int s = 0; s < shards; s++) {
+        double seconds = cycles[s] / (MODEL_MHZ * 1e6);
+        if (seconds > r.busiest) r.busiest = seconds;
+        r.messages += parts[s].messages;
+    }
+    r.wall = r.busiest;
+    r.mismatches = count_mismatches(parts, shard_of, reference);
+    return r;
+}
+
+// One chunk at a time: split, then one write and one parser_framed run per shard stream
+static RunResult run_kernel(const Options& opt, AccelDevice& dev, AccelKernel* kernel, const uint8_t* shard_of,
+                            int shards, const SymbolHashes& reference) {
+    RunResult r = {0, 0, 0, 0, 0};
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, opt.chunk_size) != 0) return r;
+    size_t max_outputs = (opt.chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) /
+                         (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    struct Shard {
+        AccelBuffer *input, *output, *num_outputs;
+        AccelEvent ran, counted;
+    };
+    std::vector<Shard> sh(shards);
+    std::vector<SymbolHashes> parts(shards);
+    std::vector<ParserOutput> records(max_outputs);
+    std::vector<double> kernel_seconds(shards, 0.0);
+    ShardStreams split(shards, opt.chunk_size);
+    for (int s = 0; s < shards; s++) {
+        sh[s].input = dev.buffer(opt.chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN + 64, ACCEL_READ_ONLY);
+        sh[s].output = dev.buffer(max_outputs * sizeof(ParserOutput), ACCEL_WRITE_ONLY);
+        sh[s].num_outputs = dev.buffer(sizeof(int));
+    }
+
+    const uint8_t* chunk;
+    size_t len;
+    auto start = std::chrono::steady_clock::now();
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        r.split += split.split(chunk, len, shard_of);
+        for (int s = 0; s < shards; s++) {
+            const ItchShardStream& st = split.streams[s];
+            AccelEvent sent = dev.write(sh[s].input, st.data, st.size);
+            // Arguments are captured at enqueue, so one kernel object serves every shard
+            kernel->set_arg(0, sh[s].input);
+            kernel->set_scalar(1, (int32_t)st.size);
+            kernel->set_arg(2, sh[s].output);
+            kernel->set_arg(3, sh[s].num_outputs);
+            sh[s].ran = dev.run(kernel, {sent});
+            sh[s].counted = dev.to_host(sh[s].num_outputs, {sh[s].ran});
+        }
+        for (int s = 0; s < shards; s++) {
+            dev.wait(sh[s].counted);
+            int n = *(int*)sh[s].num_outputs->host();
+            dev.wait(dev.read(sh[s].output, records.data(), (size_t)n * sizeof(ParserOutput)));
+            parts[s].add(records.data(), n);
+            kernel_seconds[s] += sh[s].ran->seconds();
+        }
+    }
+    r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int s = 0; s < shards; s++) {
+        if (kernel_seconds[s] > r.busiest) r.busiest = kernel_seconds[s];
+        r.messages += parts[s].messages;
+        delete sh[s].input;
+        delete sh[s].output;
+        delete sh[s].num_outputs;
+    }
+    itch_replay_close(&replay);
+    r.mismatches = count_mismatches(parts, shard_of, reference);
+    return r;
+}
+#endif
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <feed> [max instances, default 8] [sample_mb=16] [chunk_kb=4096] [model_mb=4] [xclbin=path]\n",
+               argv[0]);
+        return 1;
+    }
+    Options opt = {argv[1], 4u << 20, 4u << 20};
+    int max_shards = 8;
+    size_t sample = 16u << 20;
+    const char* xclbin = NULL;
+    for (int i = 2; i < argc; i++) {
+        const char* a = argv[i];
+        if (strncmp(a, "sample_mb=", 10) == 0) sample = strtoull(a + 10, NULL, 10) << 20;
+        else if (strncmp(a, "chunk_kb=", 9) == 0) opt.chunk_size = strtoull(a + 9, NULL, 10) << 10;
+        else if (strncmp(a, "model_mb=", 9) == 0) opt.model_bytes = strtoull(a + 9, NULL, 10) << 20;
+        else if (strncmp(a, "xclbin=", 7) == 0) xclbin = a + 7;
+        else if (a[0] >= '0' && a[0] <= '9') max_shards = atoi(a);
+        else {
+            printf("Error: unknown argument %s\n", a);
+            return 1;
+        }
+    }
+    if (max_shards < 1 || max_shards > ITCH_SHARD_MAX || opt.chunk_size == 0) {
+        printf("Error: instances must be 1..%d and the chunk size positive\n", ITCH_SHARD_MAX);
+        return 1;
+    }
+#ifndef SHARD_KERNEL
+    if (xclbin) {
+        printf("Error: xclbin= needs a build with -DSHARD_KERNEL and the accelerator runtime\n");
+        return 1;
+    }
+#endif
+
+    // Plan from the start of the feed
+    ItchReplay replay;
+    if (itch_replay_open(&replay, opt.feed, sample ? sample : 1) != 0) {
+        printf("Error: could not open %s (%s)\n", opt.feed, strerror(errno));
+        return 1;
+    }
+    std::vector<uint64_t> counts(STOCK_FILTER_BITS, 0);
+    const uint8_t* chunk;
+    size_t len;
+    if (itch_replay_next(&replay, &chunk, &len)) itch_shard_count(chunk, len, counts.data());
+    size_t feed_size = replay.size;
+    itch_replay_close(&replay);
+
+    SymbolHashes reference;
+    double ref_cpu = 0;
+    auto start = std::chrono::steady_clock::now();
+    decode_feed(&opt, SIZE_MAX, &reference, &ref_cpu);
+    double ref_wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Feed %s: %.1f MB, %zu messages; unsharded decode %.3f s, %.1f M msgs/s; %u hardware threads\n",
+           opt.feed, feed_size / 1048576.0, reference.messages, ref_wall, reference.messages / ref_wall / 1e6,
+           std::thread::hardware_concurrency());
+
+    int errors = 0;
+    std::vector<uint8_t> shard_of(STOCK_FILTER_BITS);
+
+#ifdef SHARD_KERNEL
+    std::unique_ptr<AccelDevice> dev;
+    AccelKernel* kernel = 0;
+    if (xclbin) {
+        dev = accel_open(accel_backend_from_env());
+        if (!dev || dev->load(xclbin) != 0) return 1;
+        kernel = dev->kernel("parser_framed");
+        if (!kernel) {
+            printf("Error: %s has no parser_framed kernel\n", xclbin);
+            return 1;
+        }
+    }
+    SymbolHashes model_reference;
+    if (opt.model_bytes) decode_feed(&opt, opt.model_bytes, &model_reference, &ref_cpu);
+    const int modes[] = {MODE_THREADS, opt.model_bytes ? MODE_MODEL : -1, xclbin ? MODE_KERNEL : -1};
+#else
+    const int modes[] = {MODE_THREADS};
+#endif
+    static const char* mode_names[] = {"threads", "model", "kernel"};
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        int mode = modes[m];
+        if (mode < 0) continue;
+        for (int balanced = 0; balanced < 2; balanced++) {
+            printf("\n%s, %s plan\n", mode_names[mode], balanced ? "balanced" : "hash");
+            printf("%10s %10s %10s %10s %12s %12s %8s %14s %8s\n", "instances", "imbalance", "wall ms", "split ms",
+                   "busiest ms", "speedup", "bound", "msgs/s", "check");
+            double base_busiest = 0;
+            for (int shards = 1; shards <= max_shards; shards *= 2) {
+                if (balanced) itch_shard_plan_balanced(counts.data(), shards, shard_of.data());
+                else itch_shard_plan_hash(shards, shard_of.data());
+                double imbalance = itch_shard_imbalance(counts.data(), shard_of.data(), shards);
+
+                RunResult r;
+                const SymbolHashes* expected = &reference;
+#ifdef SHARD_KERNEL
+                if (mode == MODE_MODEL) {
+                    expected = &model_reference;
+                    r = run_model(opt, shard_of.data(), shards, model_reference);
+                } else if (mode == MODE_KERNEL) {
+                    r = run_kernel(opt, *dev, kernel, shard_of.data(), shards, reference);
+                } else
+#endif
+                r = run_threads(opt, shard_of.data(), shards, reference);
+                if (shards == 1) base_busiest = r.busiest;
+                int ok = r.mismatches == 0 && r.messages == expected->messages;
+                errors += !ok;
+                double stage = r.split > r.busiest ? r.split : r.busiest;
+                printf("%10d %10.2f %10.2f %10.2f %12.2f %11.2fx %7.2fx %14.0f %8s\n", shards, imbalance,
+                       r.wall * 1e3, r.split * 1e3, r.busiest * 1e3, r.busiest > 0 ? base_busiest / r.busiest : 0.0,
+                       shards / imbalance, stage > 0 ? r.messages / stage : 0.0, ok ? "ok" : "FAIL");
+                if (!ok) {
+                    printf("  %d symbols differ, %zu of %zu messages\n", r.mismatches, r.messages, expected->messages);
+                }
+                if (shards < max_shards && shards * 2 > max_shards) shards = max_shards / 2;
+            }
+        }
+    }
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
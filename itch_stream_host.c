@@ -0,0 +1,282 @@
+#ifdef CL_MOCK
+#include "cl_mock.h"
+#else
+#include <CL/opencl.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "itch.h"
+#include "itch_replay.h"
+
+/* Replays a BinaryFILE through parser_framed with several chunks in flight at once.
+ *
+ * itch_replay_host runs each chunk to completion before starting the next, so the card's DMA
+ * engines and compute unit take turns and each sits idle two thirds of the time. Here every
+ * buffer slot has its own input, output and count buffers and its own kernel object, and the
+ * commands of a chunk are chained with events on an out-of-order queue:
+ *
+ *   write input k  ->  parser_framed k  ->  migrate count k  ->  read outputs k
+ *
+ * While the kernel parses chunk k, the write of chunk k+1 and the read of chunk k-1 are in
+ * flight on the other two engines. A slot is reused only after its read has completed, so with
+ * N slots at most N chunks are on the card at once. The file is replayed twice, with one slot
+ * (the serial baseline) and with N, and both runs must return the same records.
+ *
+ * Build against the card:  gcc -O2 -o itch_stream_host itch_stream_host.c itch_replay.c -lOpenCL
+ * Build against the mock:  gcc -O2 -pthread -DCL_MOCK -o itch_stream_host itch_stream_host.c itch_replay.c \
+ *                              cl_mock.c libitch.a -lstdc++
+ * (the mock ignores the xclbin contents; see cl_mock.h for its timing model) */
+
+#define MAX_SLOTS 8
+
+typedef struct {
+    cl_kernel kernel;
+    cl_mem input;
+    cl_mem output;
+    cl_mem num_outputs;
+    ParserOutput* output_host;
+    int num_outputs_host;
+    cl_event write_done, task_done, count_done, read_done;
+    int busy;       /* a chunk has been enqueued and not yet retired */
+    int reading;    /* its output read has been enqueued */
+} Slot;
+
+typedef struct {
+    size_t bytes, messages, chunks;
+    uint64_t checksum;
+    double seconds;
+    double kernel_seconds;   /* sum of parser_framed run times, from event profiling */
+} RunStats;
+
+static cl_command_queue queue;
+
+/* Helper: aligned allocation for XRT-friendly host pointers */
+static void *aligned_alloc_xrt(size_t align, size_t size) {
+    void *p = NULL;
+    int r = posix_memalign(&p, align, size);
+    if (r != 0) return NULL;
+    memset(p, 0, size);
+    return p;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double event_seconds(cl_event e) {
+    cl_ulong start = 0, end = 0;
+    clGetEventProfilingInfo(e, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL);
+    clGetEventProfilingInfo(e, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL);
+    return (end - start) * 1e-9;
+}
+
+/* Order-sensitive hash of the fields every record carries */
+static uint64_t checksum_records(uint64_t h, const ParserOutput* out, int n) {
+    for (int i = 0; i < n; i++) {
+        h = (h ^ out[i].msg_type) * 0x100000001B3ULL;
+        h = (h ^ out[i].stock_locate) * 0x100000001B3ULL;
+        h = (h ^ out[i].timestamp) * 0x100000001B3ULL;
+        h = (h ^ out[i].order_ref_no) * 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/* Enqueues the read of a slot's records once the kernel has reported how many there are */
+static int enqueue_read(Slot* s) {
+    clWaitForEvents(1, &s->count_done);
+    s->reading = 1;
+    cl_int err = clEnqueueReadBuffer(queue, s->output, CL_FALSE, 0, s->num_outputs_host * sizeof(ParserOutput),
+                                     s->output_host, 1, &s->count_done, &s->read_done);
+    if (err != CL_SUCCESS) { printf("clEnqueueReadBuffer output failed: %d\n", err); return -1; }
+    clFlush(queue);
+    return 0;
+}
+
+/* Waits for a slot's chunk to come back, consumes its records and frees the slot */
+static int retire(Slot* s, RunStats* st) {
+    if (!s->reading && enqueue_read(s) != 0) return -1;
+    clWaitForEvents(1, &s->read_done);
+    st->messages += s->num_outputs_host;
+    st->checksum = checksum_records(st->checksum, s->output_host, s->num_outputs_host);
+    st->kernel_seconds += event_seconds(s->task_done);
+    clReleaseEvent(s->write_done);
+    clReleaseEvent(s->task_done);
+    clReleaseEvent(s->count_done);
+    clReleaseEvent(s->read_done);
+    s->busy = 0;
+    s->reading = 0;
+    return 0;
+}
+
+static int run(const char* path, size_t chunk_size, Slot* slots, int num_slots, RunStats* st) {
+    ItchReplay replay;
+    if (itch_replay_open(&replay, path, chunk_size) != 0) {
+        printf("Error: could not open %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+    memset(st, 0, sizeof(*st));
+    st->checksum = 0xCBF29CE484222325ULL;
+
+    const uint8_t *chunk;
+    size_t len;
+    Slot* prev = NULL;
+    double start = now_seconds();
+
+    while (itch_replay_next(&replay, &chunk, &len)) {
+        Slot* s = &slots[st->chunks % num_slots];
+        if (s->busy && retire(s, st) != 0) return -1;
+        int num_bytes = (int)len;
+
+        /* DMA straight from the file mapping */
+        cl_int err = clEnqueueWriteBuffer(queue, s->input, CL_FALSE, 0, len, chunk, 0, NULL, &s->write_done);
+        if (err != CL_SUCCESS) { printf("clEnqueueWriteBuffer failed: %d\n", err); return -1; }
+
+        err = clSetKernelArg(s->kernel, 1, sizeof(int), &num_bytes);
+        if (err != CL_SUCCESS) { printf("clSetKernelArg failed: %d\n", err); return -1; }
+
+        err = clEnqueueTask(queue, s->kernel, 1, &s->write_done, &s->task_done);
+        if (err != CL_SUCCESS) { printf("clEnqueueTask failed: %d\n", err); return -1; }
+
+        err = clEnqueueMigrateMemObjects(queue, 1, &s->num_outputs, CL_MIGRATE_MEM_OBJECT_HOST,
+                                         1, &s->task_done, &s->count_done);
+        if (err != CL_SUCCESS) { printf("clEnqueueMigrate back failed: %d\n", err); return -1; }
+        clFlush(queue);
+        s->busy = 1;
+
+        /* The previous chunk's read goes out while this chunk is being written */
+        if (prev && prev != s && enqueue_read(prev) != 0) return -1;
+        prev = s;
+
+        st->bytes += len;
+        st->chunks++;
+    }
+
+    /* Drain in submission order */
+    for (size_t i = 0; i < (size_t)num_slots; i++) {
+        Slot* s = &slots[(st->chunks + i) % num_slots];
+        if (s->busy && retire(s, st) != 0) return -1;
+    }
+    st->seconds = now_seconds() - start;
+
+    if (st->bytes != replay.size) printf("Warning: file ends with a truncated message\n");
+    itch_replay_close(&replay);
+    return 0;
+}
+
+static void print_run(const char* name, int num_slots, const RunStats* st) {
+    printf("%-10s %d slot%s: %zu chunks, %zu messages, %.3f s, %.2f GB/s, compute unit busy %.0f%%\n",
+           name, num_slots, num_slots == 1 ? " " : "s", st->chunks, st->messages, st->seconds,
+           st->bytes / st->seconds / 1e9, 100.0 * st->kernel_seconds / st->seconds);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        printf("Usage: %s <xclbin> <itch BinaryFILE> [chunk size in MB, default 16] [buffer slots, default 3]\n", argv[0]);
+        return 1;
+    }
+    const char* xclbinPath = argv[1];
+    size_t chunk_size = (argc > 3 ? strtoull(argv[3], NULL, 10) : 16) << 20;
+    int num_slots = argc > 4 ? atoi(argv[4]) : 3;
+    if (num_slots < 2 || num_slots > MAX_SLOTS) {
+        printf("Error: buffer slots must be between 2 and %d\n", MAX_SLOTS);
+        return 1;
+    }
+
+    /* Same sizing as itch_replay_host */
+    size_t max_outputs = (chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN) /
+                         (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    size_t input_capacity = chunk_size + ITCH_LENGTH_PREFIX + ITCH_SPEC_MAX_MSG_LEN + 64;
+
+    /* --- OpenCL / Xilinx flow --- */
+    cl_int err;
+    cl_platform_id platform;
+    err = clGetPlatformIDs(1, &platform, NULL);
+    if (err != CL_SUCCESS) { printf("clGetPlatformIDs failed: %d\n", err); return 1; }
+
+    cl_device_id device;
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ACCELERATOR, 1, &device, NULL);
+    if (err != CL_SUCCESS) { printf("clGetDeviceIDs failed: %d\n", err); return 1; }
+
+    cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (!context || err != CL_SUCCESS) { printf("clCreateContext failed: %d\n", err); return 1; }
+
+    /* Out of order: the event wait lists are the only ordering between commands */
+    queue = clCreateCommandQueue(context, device,
+                                 CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE, &err);
+    if (!queue || err != CL_SUCCESS) { printf("clCreateCommandQueue failed: %d\n", err); return 1; }
+
+    FILE* fp = fopen(xclbinPath, "rb");
+    if (!fp) { printf("Error: could not open %s (%s)\n", xclbinPath, strerror(errno)); return 1; }
+    fseek(fp, 0, SEEK_END);
+    size_t binary_size = ftell(fp);
+    rewind(fp);
+    void *binary = aligned_alloc_xrt(4096, binary_size);
+    if (!binary) { perror("aligned_alloc binary"); fclose(fp); return 1; }
+    if (fread(binary, 1, binary_size, fp) != binary_size) { perror("fread"); fclose(fp); return 1; }
+    fclose(fp);
+
+    cl_program program = clCreateProgramWithBinary(context, 1, &device, &binary_size,
+                                                   (const unsigned char**)&binary, NULL, &err);
+    if (err != CL_SUCCESS) { printf("clCreateProgramWithBinary failed: %d\n", err); return 1; }
+    err = clBuildProgram(program, 1, &device, NULL, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clBuildProgram failed: %d\n", err); return 1; }
+
+    /* Every slot owns its buffers and a kernel object bound to them */
+    Slot slots[MAX_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    for (int i = 0; i < num_slots; i++) {
+        Slot* s = &slots[i];
+        s->output_host = (ParserOutput*)aligned_alloc_xrt(4096, max_outputs * sizeof(ParserOutput));
+        if (!s->output_host) { perror("aligned_alloc output"); return 1; }
+
+        s->kernel = clCreateKernel(program, "parser_framed", &err);
+        if (err != CL_SUCCESS) { printf("clCreateKernel failed: %d\n", err); return 1; }
+
+        s->input = clCreateBuffer(context, CL_MEM_READ_ONLY, input_capacity, NULL, &err);
+        if (err != CL_SUCCESS) { printf("buffer_input create failed: %d\n", err); return 1; }
+
+        s->output = clCreateBuffer(context, CL_MEM_WRITE_ONLY, max_outputs * sizeof(ParserOutput), NULL, &err);
+        if (err != CL_SUCCESS) { printf("buffer_output create failed: %d\n", err); return 1; }
+
+        s->num_outputs = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                                        sizeof(int), &s->num_outputs_host, &err);
+        if (err != CL_SUCCESS) { printf("buffer_num_outputs create failed: %d\n", err); return 1; }
+
+        err  = clSetKernelArg(s->kernel, 0, sizeof(cl_mem), &s->input);
+        err |= clSetKernelArg(s->kernel, 2, sizeof(cl_mem), &s->output);
+        err |= clSetKernelArg(s->kernel, 3, sizeof(cl_mem), &s->num_outputs);
+        if (err != CL_SUCCESS) { printf("clSetKernelArg failed: %d\n", err); return 1; }
+    }
+
+    RunStats serial, pipelined;
+    if (run(argv[2], chunk_size, slots, 1, &serial) != 0) return 1;
+    print_run("serial", 1, &serial);
+    if (run(argv[2], chunk_size, slots, num_slots, &pipelined) != 0) return 1;
+    print_run("pipelined", num_slots, &pipelined);
+    printf("speedup %.2fx\n", serial.seconds / pipelined.seconds);
+
+    int ok = serial.messages == pipelined.messages && serial.checksum == pipelined.checksum &&
+             serial.bytes == pipelined.bytes;
+    if (!ok) printf("Error: pipelined run returned different records than the serial run\n");
+
+    for (int i = 0; i < num_slots; i++) {
+        clReleaseMemObject(slots[i].input);
+        clReleaseMemObject(slots[i].output);
+        clReleaseMemObject(slots[i].num_outputs);
+        clReleaseKernel(slots[i].kernel);
+        free(slots[i].output_host);
+    }
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    free(binary);
+
+    printf(ok ? "TEST PASSED\n" : "TEST FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#ifndef ITCH_TESTGEN_H
+#define ITCH_TESTGEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "itch.h"
+
+// Random ITCH message streams for testbenches and benchmarks
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static inline uint64_t next_rand() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static inline void put_be(std::vector<uint8_t>& buf, uint64_t value, int n) {
+    for (int i = n - 1; i >= 0; i--) buf.push_back((uint8_t)(value >> (8 * i)));
+}
+
+// Appends one random message; the mix is weighted towards adds and deletes like a real feed
+static inline void append_random_message(std::vector<uint8_t>& buf) {
+    int r = (int)(next_rand() % 100);
+    uint8_t msg_type = r < 40 ? ITCH_ADD_ORDER
+                     : r < 75 ? ITCH_ORDER_DELETE
+                     : r < 85 ? ITCH_ORDER_EXECUTED
+                     : r < 90 ? ITCH_ORDER_CANCEL
+                     : r < 98 ? ITCH_ORDER_REPLACE
+                     : ITCH_ADD_ORDER_MPID;
+
+    size_t start = buf.size();
+    buf.push_back(msg_type);
+    put_be(buf, next_rand() % 8000, 2);                  // stock_locate
+    put_be(buf, next_rand(), 2);                         // tracking_no
+    put_be(buf, next_rand() % 86400000000000ULL, 6);     // timestamp
+    put_be(buf, next_rand(), 8);                         // order_ref_no
+    while (buf.size() - start < (size_t)itch_msg_length(msg_type)) {
+        buf.push_back((uint8_t)next_rand());             // type-specific fields
+    }
+}
+
+// Appends one message of a uniformly random ITCH 5.0 type with random fields
+static inline void append_random_spec_message(std::vector<uint8_t>& buf) {
+    static const uint8_t types[] = {
+        ITCH_SYSTEM_EVENT, ITCH_STOCK_DIRECTORY, ITCH_STOCK_TRADING_ACTION, ITCH_REG_SHO,
+        ITCH_MARKET_PARTICIPANT, ITCH_MWCB_DECLINE_LEVEL, ITCH_MWCB_STATUS, ITCH_IPO_QUOTING_PERIOD,
+        ITCH_LULD_AUCTION_COLLAR, ITCH_OPERATIONAL_HALT, ITCH_ADD_ORDER, ITCH_ADD_ORDER_MPID,
+        ITCH_ORDER_EXECUTED, ITCH_ORDER_EXECUTED_PRICE, ITCH_ORDER_CANCEL, ITCH_ORDER_DELETE,
+        ITCH_ORDER_REPLACE, ITCH_TRADE, ITCH_CROSS_TRADE, ITCH_BROKEN_TRADE, ITCH_NOII, ITCH_RPII,
+        ITCH_DLCR_PRICE_DISCOVERY,
+    };
+    uint8_t msg_type = types[next_rand() % (sizeof(types) / sizeof(types[0]))];
+    int len = itch_spec_msg_length(msg_type);
+    buf.push_back(msg_type);
+    for (int i = 1; i < len; i++) buf.push_back((uint8_t)next_rand());
+}
+
+// State of a book-coherent stream: executions, cancels, deletes and replaces only reference
+// orders that are still resting, so every message applies cleanly to an order book
+struct LiveOrder {
+    uint64_t order_ref_no;
+    uint16_t stock_locate;
+    uint8_t  buy_sell;
+    uint32_t shares;
+    uint32_t price;
+};
+
+struct BookFeed {
+    std::vector<LiveOrder> live;
+    uint64_t next_ref_no;
+    uint64_t timestamp;
+    int num_stocks;
+    size_t target_live;    // resting orders the stream hovers around once warmed up
+};
+
+static inline void book_feed_init(BookFeed& feed, int num_stocks, size_t target_live) {
+    feed.live.clear();
+    feed.live.reserve(target_live + target_live / 4);
+    feed.next_ref_no = 1 + next_rand() % 1000000;
+    feed.timestamp = 34200000000000ULL;   // 9:30
+    feed.num_stocks = num_stocks;
+    feed.target_live = target_live;
+}
+
+// Price in 1/10000 dollars on the stock's side of a fixed mid, clustered near the inside
+static inline uint32_t book_feed_price(uint16_t stock_locate, uint8_t buy_sell) {
+    uint32_t mid = 100000 + 10000 * (stock_locate % 500);
+    uint64_t a = next_rand() % 64, b = next_rand() % 64;
+    uint32_t ticks = 1 + (uint32_t)(a < b ? a : b);
+    return buy_sell == 'B' ? mid - 100 * ticks : mid + 100 * ticks;
+}
+
+static inline void put_stock(std::vector<uint8_t>& buf, uint16_t stock_locate) {
+    char symbol[9];
+    snprintf(symbol, sizeof(symbol), "S%-7u", (unsigned)stock_locate);
+    buf.insert(buf.end(), symbol, symbol + 8);
+}
+
+static inline void put_header(std::vector<uint8_t>& buf, uint8_t msg_type, uint16_t stock_locate,
+                              BookFeed& feed) {
+    feed.timestamp += 1 + next_rand() % 2000;
+    buf.push_back(msg_type);
+    put_be(buf, stock_locate, 2);
+    put_be(buf, next_rand(), 2);
+    put_be(buf, feed.timestamp, 6);
+}
+
+// Appends one A/F/E/X/D/U message that is valid against the orders already generated
+static inline void append_book_message(BookFeed& feed, std::vector<uint8_t>& buf) {
+    int r = (int)(next_rand() % 100);
+    bool grow = feed.live.size() < feed.target_live;
+    if (feed.live.empty() || r < (grow ? 55 : 40)) {
+        LiveOrder o;
+        o.order_ref_no = feed.next_ref_no++;
+        o.stock_locate = (uint16_t)(1 + next_rand() % feed.num_stocks);
+        o.buy_sell = next_rand() & 1 ? 'B' : 'S';
+        o.shares = 100 * (uint32_t)(1 + next_rand() % 10);
+        o.price = book_feed_price(o.stock_locate, o.buy_sell);
+        bool mpid = next_rand() % 20 == 0;
+        put_header(buf, mpid ? ITCH_ADD_ORDER_MPID : ITCH_ADD_ORDER, o.stock_locate, feed);
+        put_be(buf, o.order_ref_no, 8);
+        buf.push_back(o.buy_sell);
+        put_be(buf, o.shares, 4);
+        put_stock(buf, o.stock_locate);
+        put_be(buf, o.price, 4);
+        if (mpid) buf.insert(buf.end(), {'M', 'P', 'I', 'D'});
+        feed.live.push_back(o);
+        return;
+    }
+
+    size_t i = next_rand() % feed.live.size();
+    LiveOrder& o = feed.live[i];
+    r = (int)(next_rand() % 100);
+    bool gone = false;
+    if (r < 55) {
+        put_header(buf, ITCH_ORDER_DELETE, o.stock_locate, feed);
+        put_be(buf, o.order_ref_no, 8);
+        gone = true;
+    } else if (r < 75) {
+        uint32_t shares = next_rand() & 1 ? o.shares : 1 + (uint32_t)(next_rand() % o.shares);
+        put_header(buf, ITCH_ORDER_EXECUTED, o.stock_locate, feed);
+        put_be(buf, o.order_ref_no, 8);
+        put_be(buf, shares, 4);
+        put_be(buf, next_rand(), 8);                     // match_no
+        o.shares -= shares;
+        gone = o.shares == 0;
+    } else if (r < 85 && o.shares > 1) {
+        uint32_t shares = 1 + (uint32_t)(next_rand() % (o.shares - 1));
+        put_header(buf, ITCH_ORDER_CANCEL, o.stock_locate, feed);
+        put_be(buf, o.order_ref_no, 8);
+        put_be(buf, shares, 4);
+        o.shares -= shares;
+    } else {
+        put_header(buf, ITCH_ORDER_REPLACE, o.stock_locate, feed);
+        put_be(buf, o.order_ref_no, 8);
+        o.order_ref_no = feed.next_ref_no++;
+        o.shares = 100 * (uint32_t)(1 + next_rand() % 10);
+        o.price = book_feed_price(o.stock_locate, o.buy_sell);
+        put_be(buf, o.order_ref_no, 8);
+        put_be(buf, o.shares, 4);
+        put_be(buf, o.price, 4);
+    }
+    if (gone) {
+        o = feed.live.back();
+        feed.live.pop_back();
+    }
+}
+
+// Wraps messages of any ITCH 5.0 type, back to back, in BinaryFILE framing
+static inline std::vector<uint8_t> to_framed_spec(const std::vector<uint8_t>& bytes) {
+    std::vector<uint8_t> framed;
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        int len = itch_spec_msg_length(bytes[pos]);
+        put_be(framed, len, 2);
+        framed.insert(framed.end(), bytes.begin() + pos, bytes.begin() + pos + len);
+        pos += len;
+    }
+    return framed;
+}
+
+// Expands back-to-back messages into the byte-serial parser's ByteData format
+static inline std::vector<ByteData> to_byte_data(const std::vector<uint8_t>& bytes) {
+    std::vector<ByteData> serial(bytes.size());
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        int len = itch_msg_length(bytes[pos]);
+        for (int i = 0; i < len; i++) {
+            serial[pos + i].data = bytes[pos + i];
+            serial[pos + i].valid = 1;
+            serial[pos + i].start_msg = i == 0;
+            serial[pos + i].end_msg = i == len - 1;
+        }
+        pos += len;
+    }
+    return serial;
+}
+
+// Wraps back-to-back messages in Nasdaq BinaryFILE framing (2-byte big-endian length prefix).
+// If `system_event_every` is non-zero, a System Event ('S') message, which the parser does not
+// support and must skip, is inserted before every that many messages.
+static inline std::vector<uint8_t> to_framed(const std::vector<uint8_t>& bytes, int system_event_every) {
+    std::vector<uint8_t> framed;
+    framed.reserve(bytes.size() + bytes.size() / 8);
+    size_t pos = 0;
+    for (int i = 0; pos < bytes.size(); i++) {
+        if (system_event_every > 0 && i % system_event_every == 0) {
+            put_be(framed, 12, 2);
+            framed.push_back('S');
+            for (int j = 1; j < 12; j++) framed.push_back((uint8_t)next_rand());
+        }
+        int len = itch_msg_length(bytes[pos]);
+        put_be(framed, len, 2);
+        framed.insert(framed.end(), bytes.begin() + pos, bytes.begin() + pos + len);
+        pos += len;
+    }
+    return framed;
+}
+
+static inline bool same_output(const ParserOutput& a, const ParserOutput& b) {
+    return a.valid_msg == b.valid_msg && a.msg_type == b.msg_type &&
+           a.stock_locate == b.stock_locate && a.tracking_no == b.tracking_no &&
+           a.timestamp == b.timestamp && a.order_ref_no == b.order_ref_no &&
+           a.shares == b.shares && a.buy_sell == b.buy_sell && a.stock == b.stock &&
+           a.price == b.price && a.match_no == b.match_no &&
+           a.new_order_ref_no == b.new_order_ref_no && a.attribution == b.attribution;
+}
+
+static inline int compare_outputs(const char* name, const ParserOutput* got, int num_got,
+                           const ParserOutput* expected, int num_expected) {
+    if (num_got != num_expected) {
+        printf("%s: produced %d messages, expected %d\n", name, num_got, num_expected);
+        return 1;
+    }
+    for (int i = 0; i < num_got; i++) {
+        if (!same_output(got[i], expected[i])) {
+            printf("%s: message %d differs (type 0x%02x)\n", name, i, (unsigned)expected[i].msg_type);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif
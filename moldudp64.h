@@ -0,0 +1,41 @@
+#ifndef MOLDUDP64_H
+#define MOLDUDP64_H
+
+#include <stdint.h>
+
+// MoldUDP64 downstream packets, as ITCH is delivered in production:
+//
+//   Session          10 bytes  ASCII session name
+//   Sequence Number   8 bytes  big-endian, sequence number of the first message in the packet
+//   Message Count     2 bytes  big-endian, 0 for a heartbeat, 0xFFFF for end of session
+//   Message blocks             Message Count times: 2-byte big-endian length + message body
+//
+// The message blocks use the same length prefix as Nasdaq BinaryFILE, so the parsers reuse their
+// framed-input path once the header has been consumed. Packets are self-delimiting, so a capture
+// is stored as UDP payloads back to back, with no extra framing.
+
+#define MOLD_SESSION_LEN      10
+#define MOLD_HEADER_LEN       20
+#define MOLD_END_OF_SESSION   0xFFFF
+
+// Sequence tracking carried from one buffer to the next. Zero-initialize before the first buffer.
+// Layout must match between host and kernel.
+typedef struct {
+    uint8_t  session[MOLD_SESSION_LEN];
+    uint8_t  have_session;     // session and next_seq hold a packet already seen
+    uint8_t  end_of_session;   // an end-of-session packet has been seen for this session
+    uint32_t reserved;
+    uint64_t next_seq;         // sequence number of the next message expected
+} MoldState;
+
+// A sequence gap, reported inline with the decoded messages. Messages from `expected_seq` up to
+// (not including) `received_seq` were lost; `output_index` is the number of records written
+// before the gap was detected, so the gap sits between record output_index - 1 and output_index.
+typedef struct {
+    uint64_t expected_seq;
+    uint64_t received_seq;
+    uint32_t output_index;
+    uint32_t reserved;
+} MoldGap;
+
+#endif
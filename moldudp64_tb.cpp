@@ -0,0 +1,305 @@
+// C-simulation testbench for the MoldUDP64 front-end.
+// 1. Generates a capture of MoldUDP64 packets (UDP payloads back to back) from a random ITCH
+//    stream, with dropped packets, duplicated and overlapping packets, heartbeats, unsupported
+//    System Event messages and an end of session followed by a new session. The generator knows
+//    which messages must come out and which gaps must be reported.
+// 2. Runs parse_wide_core<64, INPUT_MOLDUDP64> (the parser_moldudp64 kernel) over the whole
+//    capture and over two buffers split on a packet boundary, and the CPU decoder over
+//    arbitrary-sized chunks, and checks every output and gap against the generator.
+//
+// With -r, decodes an existing capture with both paths and checks they agree instead.
+// With -w, also saves the generated capture.
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -o moldudp64_tb moldudp64_tb.cpp itch_decoder.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "parser_wide.h"
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+
+struct Capture {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> packet_starts;
+    std::vector<ParserOutput> expected;
+    std::vector<MoldGap> expected_gaps;
+};
+
+// A message with its MoldUDP64 sequence number
+struct SeqMessage {
+    uint64_t seq;
+    std::vector<uint8_t> body;
+};
+
+static void append_packet(Capture& cap, const char* session, uint64_t seq, int count,
+                          const SeqMessage* msgs) {
+    cap.packet_starts.push_back(cap.bytes.size());
+    cap.bytes.insert(cap.bytes.end(), session, session + MOLD_SESSION_LEN);
+    put_be(cap.bytes, seq, 8);
+    put_be(cap.bytes, (uint64_t)count, 2);
+    for (int i = 0; count != MOLD_END_OF_SESSION && i < count; i++) {
+        put_be(cap.bytes, msgs[i].body.size(), 2);
+        cap.bytes.insert(cap.bytes.end(), msgs[i].body.begin(), msgs[i].body.end());
+    }
+}
+
+// Generator-side view of what the receiver has seen
+struct Receiver {
+    uint64_t next_seq;
+};
+
+// Delivers a packet and records what a correct receiver must output for it
+static void deliver(Capture& cap, Receiver& rx, const char* session, uint64_t seq,
+                    const std::vector<SeqMessage>& msgs) {
+    if (seq > rx.next_seq) {
+        MoldGap gap = {rx.next_seq, seq, (uint32_t)cap.expected.size(), 0};
+        cap.expected_gaps.push_back(gap);
+        rx.next_seq = seq;
+    }
+    for (size_t i = 0; i < msgs.size(); i++) {
+        if (msgs[i].seq < rx.next_seq) continue;
+        ParserOutput out;
+        const std::vector<uint8_t>& body = msgs[i].body;
+        if (itch_decode_message(body.data(), body.size(), &out)) cap.expected.push_back(out);
+        rx.next_seq = msgs[i].seq + 1;
+    }
+    append_packet(cap, session, seq, (int)msgs.size(), msgs.empty() ? NULL : msgs.data());
+}
+
+static std::vector<SeqMessage> make_messages(uint64_t first_seq, int count) {
+    std::vector<SeqMessage> msgs(count);
+    for (int i = 0; i < count; i++) {
+        msgs[i].seq = first_seq + i;
+        if (next_rand() % 32 == 0) {
+            msgs[i].body.push_back('S');   // System Event: sequenced, but not parsed
+            for (int j = 1; j < 12; j++) msgs[i].body.push_back((uint8_t)next_rand());
+        } else {
+            append_random_message(msgs[i].body);
+        }
+    }
+    return msgs;
+}
+
+static Capture generate_capture(int num_messages) {
+    Capture cap;
+    const char* sessions[2] = {"0000012345", "0000012346"};
+    int generated = 0;
+
+    for (int s = 0; s < 2; s++) {
+        Receiver rx = {1};
+        uint64_t seq = 1;
+        std::vector<SeqMessage> last;
+        uint64_t last_seq = 0;
+        int target = (s + 1) * num_messages / 2;
+
+        while (generated < target) {
+            int r = (int)(next_rand() % 100);
+            if (r < 5 && seq > 1) {
+                // Dropped packet: never delivered, the next packet reveals the gap
+                int n = 1 + (int)(next_rand() % 20);
+                seq += n;
+                generated += n;
+            } else if (r < 9 && !last.empty()) {
+                // Duplicate of the last packet, as from A/B feed arbitration
+                deliver(cap, rx, sessions[s], last_seq, last);
+            } else if (r < 12 && !last.empty() && last.back().seq + 1 == seq) {
+                // Retransmission overlapping the last packet's tail
+                std::vector<SeqMessage> msgs(last.end() - 1, last.end());
+                std::vector<SeqMessage> fresh = make_messages(seq, 1 + (int)(next_rand() % 5));
+                msgs.insert(msgs.end(), fresh.begin(), fresh.end());
+                deliver(cap, rx, sessions[s], msgs[0].seq, msgs);
+                seq += fresh.size();
+                generated += (int)fresh.size();
+                last = msgs;
+                last_seq = msgs[0].seq;
+            } else if (r < 16) {
+                // Heartbeat: carries the next sequence number and no messages
+                deliver(cap, rx, sessions[s], seq, std::vector<SeqMessage>());
+            } else {
+                // Up to roughly an Ethernet MTU of messages
+                int n = 1 + (int)(next_rand() % 36);
+                last = make_messages(seq, n);
+                last_seq = seq;
+                deliver(cap, rx, sessions[s], seq, last);
+                seq += n;
+                generated += n;
+            }
+        }
+
+        // End of session; the next session starts again from sequence number 1 without a gap
+        append_packet(cap, sessions[s], seq, MOLD_END_OF_SESSION, NULL);
+    }
+    return cap;
+}
+
+static std::vector<ap_uint<512> > to_beats(const uint8_t* bytes, size_t size) {
+    std::vector<ap_uint<512> > beats((size + 63) / 64 + 1);
+    for (size_t i = 0; i < size; i++) {
+        beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = bytes[i];
+    }
+    return beats;
+}
+
+struct Decoded {
+    std::vector<ParserOutput> outputs;
+    std::vector<MoldGap> gaps;
+    long cycles;
+};
+
+// Runs the kernel core over `bytes` split at the given offsets (which must be packet boundaries)
+static Decoded run_kernel(const std::vector<uint8_t>& bytes, const std::vector<size_t>& splits) {
+    Decoded d;
+    d.cycles = 0;
+    MoldState state;
+    memset(&state, 0, sizeof(state));
+
+    size_t max_records = bytes.size() / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1;
+    std::vector<ParserOutput> outputs(max_records);
+    std::vector<MoldGap> gaps(bytes.size() / MOLD_HEADER_LEN + 1);
+
+    for (size_t c = 0; c + 1 < splits.size(); c++) {
+        size_t size = splits[c + 1] - splits[c];
+        std::vector<ap_uint<512> > beats = to_beats(bytes.data() + splits[c], size);
+        int num_outputs = 0, num_gaps = 0;
+        d.cycles += parse_wide_core<64, INPUT_MOLDUDP64>(beats.data(), (int)size, outputs.data(), &num_outputs,
+                                                         &state, gaps.data(), &num_gaps);
+        for (int i = 0; i < num_gaps; i++) {
+            gaps[i].output_index += (uint32_t)d.outputs.size();
+            d.gaps.push_back(gaps[i]);
+        }
+        d.outputs.insert(d.outputs.end(), outputs.begin(), outputs.begin() + num_outputs);
+    }
+    return d;
+}
+
+// Runs the CPU decoder over chunks of `chunk` bytes, carrying unconsumed bytes over
+static Decoded run_cpu(const std::vector<uint8_t>& bytes, size_t chunk) {
+    Decoded d;
+    d.cycles = 0;
+    MoldState state;
+    memset(&state, 0, sizeof(state));
+
+    std::vector<ParserOutput> outputs;
+    std::vector<MoldGap> gaps;
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        outputs.resize(chunk / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1);
+        gaps.resize(chunk / MOLD_HEADER_LEN + 1);
+        size_t size = bytes.size() - pos < chunk ? bytes.size() - pos : chunk;
+        size_t num_gaps = 0, consumed = 0;
+        size_t n = itch_decode_moldudp64(bytes.data() + pos, size, &state, outputs.data(), outputs.size(),
+                                         gaps.data(), gaps.size(), &num_gaps, &consumed);
+        for (size_t i = 0; i < num_gaps; i++) {
+            gaps[i].output_index += (uint32_t)d.outputs.size();
+            d.gaps.push_back(gaps[i]);
+        }
+        d.outputs.insert(d.outputs.end(), outputs.begin(), outputs.begin() + n);
+        if (consumed == 0) {
+            if (size < chunk) break;   // truncated final packet
+            chunk *= 2;                // a packet larger than the chunk
+        }
+        pos += consumed;
+    }
+    return d;
+}
+
+static int compare_gaps(const char* name, const std::vector<MoldGap>& got, const std::vector<MoldGap>& expected) {
+    if (got.size() != expected.size()) {
+        printf("%s: reported %zu gaps, expected %zu\n", name, got.size(), expected.size());
+        return 1;
+    }
+    for (size_t i = 0; i < got.size(); i++) {
+        if (got[i].expected_seq != expected[i].expected_seq || got[i].received_seq != expected[i].received_seq ||
+            got[i].output_index != expected[i].output_index) {
+            printf("%s: gap %zu is %llu..%llu at record %u, expected %llu..%llu at record %u\n", name, i,
+                   (unsigned long long)got[i].expected_seq, (unsigned long long)got[i].received_seq,
+                   got[i].output_index, (unsigned long long)expected[i].expected_seq,
+                   (unsigned long long)expected[i].received_seq, expected[i].output_index);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int check(const char* name, const Decoded& d, const std::vector<ParserOutput>& expected,
+                 const std::vector<MoldGap>& expected_gaps, size_t num_bytes) {
+    int errors = compare_outputs(name, d.outputs.data(), (int)d.outputs.size(),
+                                 expected.data(), (int)expected.size());
+    errors += compare_gaps(name, d.gaps, expected_gaps);
+    if (d.cycles) {
+        printf("%-24s %8zu msgs %6zu gaps %10ld cycles  %6.2f bytes/cycle  %s\n", name, d.outputs.size(),
+               d.gaps.size(), d.cycles, (double)num_bytes / d.cycles, errors ? "FAIL" : "ok");
+    } else {
+        printf("%-24s %8zu msgs %6zu gaps %s\n", name, d.outputs.size(), d.gaps.size(), errors ? "FAIL" : "ok");
+    }
+    return errors;
+}
+
+static int read_file(const char* path, std::vector<uint8_t>& bytes) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    bytes.resize(ftell(fp));
+    rewind(fp);
+    size_t n = fread(bytes.data(), 1, bytes.size(), fp);
+    fclose(fp);
+    return n == bytes.size() ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    int num_messages = 200000;
+    const char* read_path = NULL;
+    const char* write_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) read_path = argv[++i];
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) write_path = argv[++i];
+        else num_messages = atoi(argv[i]);
+    }
+
+    int errors = 0;
+    if (read_path) {
+        // Existing capture: no ground truth, so the CPU decoder is the reference
+        std::vector<uint8_t> bytes;
+        if (read_file(read_path, bytes) != 0) {
+            printf("Error: could not read %s\n", read_path);
+            return 1;
+        }
+        Decoded cpu = run_cpu(bytes, bytes.size() + 1);
+        printf("%s: %zu bytes, %zu messages, %zu gaps\n", read_path, bytes.size(), cpu.outputs.size(), cpu.gaps.size());
+        std::vector<size_t> whole(1, 0);
+        whole.push_back(bytes.size());
+        errors += check("kernel", run_kernel(bytes, whole), cpu.outputs, cpu.gaps, bytes.size());
+        errors += check("cpu, 4 KB chunks", run_cpu(bytes, 4096), cpu.outputs, cpu.gaps, bytes.size());
+    } else {
+        Capture cap = generate_capture(num_messages);
+        printf("%zu packets, %zu bytes, %zu messages expected, %zu gaps expected\n", cap.packet_starts.size(),
+               cap.bytes.size(), cap.expected.size(), cap.expected_gaps.size());
+        if (write_path) {
+            FILE* fp = fopen(write_path, "wb");
+            if (!fp || fwrite(cap.bytes.data(), 1, cap.bytes.size(), fp) != cap.bytes.size()) {
+                printf("Error: could not write %s\n", write_path);
+                return 1;
+            }
+            fclose(fp);
+        }
+
+        std::vector<size_t> whole(1, 0), halves(1, 0);
+        whole.push_back(cap.bytes.size());
+        halves.push_back(cap.packet_starts[cap.packet_starts.size() / 2]);
+        halves.push_back(cap.bytes.size());
+
+        errors += check("kernel", run_kernel(cap.bytes, whole), cap.expected, cap.expected_gaps, cap.bytes.size());
+        errors += check("kernel, 2 buffers", run_kernel(cap.bytes, halves), cap.expected, cap.expected_gaps,
+                        cap.bytes.size());
+        errors += check("cpu", run_cpu(cap.bytes, cap.bytes.size()), cap.expected, cap.expected_gaps,
+                        cap.bytes.size());
+        errors += check("cpu, 1000-byte chunks", run_cpu(cap.bytes, 1000), cap.expected, cap.expected_gaps,
+                        cap.bytes.size());
+    }
+
+    printf(errors ? "\nTEST FAILED\n" : "\nTEST PASSED\n");
+    return errors ? 1 : 0;
+}
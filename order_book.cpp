@@ -0,0 +1,324 @@
+#include <algorithm>
+#include "order_book.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
+
+OrderBook::OrderBook(size_t expected_orders)
+    : num_orders_(0), ignored_(0), books_(65536) {
+    size_t capacity = 16;
+    shift_ = 60;
+    while (capacity < 2 * expected_orders) {
+        capacity <<= 1;
+        shift_--;
+    }
+    table_.assign(capacity, BookOrder());
+    mask_ = capacity - 1;
+    levels_.reserve(expected_orders);
+    free_levels_.reserve(expected_orders);
+}
+
+// Order table: linear probing from a Fibonacci hash of order_ref_no. Order reference numbers are
+// handed out almost sequentially, which the multiply spreads evenly over the table.
+
+BookOrder* OrderBook::lookup(uint64_t order_ref_no) {
+    for (size_t i = slot_of(order_ref_no);; i = (i + 1) & mask_) {
+        BookOrder& slot = table_[i];
+        if (slot.order_ref_no == order_ref_no) return &slot;
+        if (slot.order_ref_no == 0) return 0;
+    }
+}
+
+const BookOrder* OrderBook::find(uint64_t order_ref_no) const {
+    if (order_ref_no == 0) return 0;
+    return const_cast<OrderBook*>(this)->lookup(order_ref_no);
+}
+
+// Returns a fresh slot for order_ref_no, or 0 if the order is already in the table
+BookOrder* OrderBook::insert(uint64_t order_ref_no) {
+    if (2 * (num_orders_ + 1) > table_.size()) grow();
+    for (size_t i = slot_of(order_ref_no);; i = (i + 1) & mask_) {
+        BookOrder& slot = table_[i];
+        if (slot.order_ref_no == 0) {
+            slot.order_ref_no = order_ref_no;
+            num_orders_++;
+            return &slot;
+        }
+        if (slot.order_ref_no == order_ref_no) return 0;
+    }
+}
+
+// Backward-shift deletion: later entries of the same probe run move up into the hole, so lookups
+// never have to step over tombstones left by the constant stream of deletes
+void OrderBook::erase(BookOrder* order) {
+    size_t hole = (size_t)(order - table_.data());
+    for (size_t i = (hole + 1) & mask_; table_[i].order_ref_no != 0; i = (i + 1) & mask_) {
+        size_t home = slot_of(table_[i].order_ref_no);
+        // The entry may move into the hole only if its home slot is not between the hole and i
+        bool movable = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+        if (movable) {
+            table_[hole] = table_[i];
+            hole = i;
+        }
+    }
+    table_[hole].order_ref_no = 0;
+    num_orders_--;
+}
+
+void OrderBook::grow() {
+    std::vector<BookOrder> old;
+    old.swap(table_);
+    table_.assign(old.size() * 2, BookOrder());
+    mask_ = table_.size() - 1;
+    shift_--;
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].order_ref_no == 0) continue;
+        size_t j = slot_of(old[i].order_ref_no);
+        while (table_[j].order_ref_no != 0) j = (j + 1) & mask_;
+        table_[j] = old[i];
+    }
+}
+
+// Price levels
+
+// Position of `price` in a side's index, or of the first worse price if it has no level
+static size_t find_level(const std::vector<LevelRef>& side, uint8_t buy_sell, uint32_t price) {
+    std::vector<LevelRef>::const_iterator it;
+    if (buy_sell == BOOK_SELL) {
+        it = std::lower_bound(side.begin(), side.end(), price,
+                              [](const LevelRef& l, uint32_t p) { return l.price > p; });
+    } else {
+        it = std::lower_bound(side.begin(), side.end(), price,
+                              [](const LevelRef& l, uint32_t p) { return l.price < p; });
+    }
+    return (size_t)(it - side.begin());
+}
+
+// Returns the pool index of the level at `price`, creating it if this is its first order
+uint32_t OrderBook::level_for(uint16_t stock_locate, uint8_t buy_sell, uint32_t price) {
+    std::vector<LevelRef>& side = side_of(stock_locate, buy_sell);
+    size_t pos = find_level(side, buy_sell, price);
+    if (pos < side.size() && side[pos].price == price) return side[pos].level;
+
+    uint32_t index;
+    if (!free_levels_.empty()) {
+        index = free_levels_.back();
+        free_levels_.pop_back();
+    } else {
+        index = (uint32_t)levels_.size();
+        levels_.push_back(BookLevel());
+    }
+    BookLevel& level = levels_[index];
+    level.shares = 0;
+    level.price = price;
+    level.num_orders = 0;
+    level.stock_locate = stock_locate;
+    level.buy_sell = buy_sell;
+    LevelRef ref = {price, index};
+    side.insert(side.begin() + pos, ref);
+    return index;
+}
+
+void OrderBook::level_reduce(uint32_t index, uint32_t shares, int removed) {
+    BookLevel& level = levels_[index];
+    level.shares -= shares;
+    if (!removed || --level.num_orders != 0) return;
+
+    std::vector<LevelRef>& side = side_of(level.stock_locate, level.buy_sell);
+    side.erase(side.begin() + find_level(side, level.buy_sell, level.price));
+    free_levels_.push_back(index);
+}
+
+// Updates
+
+int OrderBook::add(uint16_t stock_locate, uint64_t order_ref_no, uint8_t buy_sell, uint32_t shares,
+                   uint32_t price) {
+    if (order_ref_no == 0 || (buy_sell != BOOK_BUY && buy_sell != BOOK_SELL)) return 0;
+    BookOrder* order = insert(order_ref_no);
+    if (!order) return 0;
+    uint32_t index = level_for(stock_locate, buy_sell, price);
+    order->shares = shares;
+    order->level = index;
+    levels_[index].num_orders++;
+    levels_[index].shares += shares;
+    return 1;
+}
+
+int OrderBook::execute(uint64_t order_ref_no, uint32_t shares) {
+    return cancel(order_ref_no, shares);
+}
+
+int OrderBook::cancel(uint64_t order_ref_no, uint32_t shares) {
+    BookOrder* order = order_ref_no ? lookup(order_ref_no) : 0;
+    if (!order) return 0;
+    if (shares >= order->shares) {
+        level_reduce(order->level, order->shares, 1);
+        erase(order);
+    } else {
+        level_reduce(order->level, shares, 0);
+        order->shares -= shares;
+    }
+    return 1;
+}
+
+int OrderBook::remove(uint64_t order_ref_no) {
+    BookOrder* order = order_ref_no ? lookup(order_ref_no) : 0;
+    if (!order) return 0;
+    level_reduce(order->level, order->shares, 1);
+    erase(order);
+    return 1;
+}
+
+// The replacement keeps the stock and side of the original and loses its time priority. If
+// new_order_ref_no is somehow already live, the original is still removed and 0 is returned.
+int OrderBook::replace(uint64_t order_ref_no, uint64_t new_order_ref_no, uint32_t shares, uint32_t price) {
+    BookOrder* order = order_ref_no ? lookup(order_ref_no) : 0;
+    if (!order) return 0;
+    const BookLevel& level = levels_[order->level];
+    uint16_t stock_locate = level.stock_locate;
+    uint8_t buy_sell = level.buy_sell;
+    level_reduce(order->level, order->shares, 1);
+    erase(order);
+    return add(stock_locate, new_order_ref_no, buy_sell, shares, price);
+}
+
+int OrderBook::apply(const ParserOutput& msg) {
+    int applied;
+    switch (msg.msg_type) {
+        case ITCH_ADD_ORDER:
+        case ITCH_ADD_ORDER_MPID:
+            applied = add(msg.stock_locate, msg.order_ref_no, msg.buy_sell, msg.shares, msg.price);
+            break;
+        case ITCH_ORDER_EXECUTED: applied = execute(msg.order_ref_no, msg.shares); break;
+        case ITCH_ORDER_CANCEL:   applied = cancel(msg.order_ref_no, msg.shares); break;
+        case ITCH_ORDER_DELETE:   applied = remove(msg.order_ref_no); break;
+        case ITCH_ORDER_REPLACE:
+            applied = replace(msg.order_ref_no, msg.new_order_ref_no, msg.shares, msg.price);
+            break;
+        default:                  applied = 0; break;
+    }
+    ignored_ += !applied;
+    return applied;
+}
+
+// Prefetching
+
+void OrderBook::prefetch(const ParserOutput& msg) const {
+    size_t slot = slot_of(msg.order_ref_no);
+    PREFETCH(&table_[slot]);
+    // Removing an order shifts the entries after it back, so the next line is written too
+    if (msg.msg_type != ITCH_ADD_ORDER && msg.msg_type != ITCH_ADD_ORDER_MPID) PREFETCH(&table_[(slot + 4) & mask_]);
+    if (msg.msg_type == ITCH_ORDER_REPLACE) PREFETCH(&table_[slot_of(msg.new_order_ref_no)]);
+    PREFETCH(&books_[msg.stock_locate]);
+}
+
+// Pulls in the lines of a price index that a search is likely to touch. Updates cluster near the
+// inside, at the back, and an emptied level is erased by moving every entry behind it, so the
+// last sixteen lines are fetched.
+static void prefetch_side(const std::vector<LevelRef>& side) {
+    if (side.empty()) return;
+    const char* begin = (const char*)side.data();
+    const char* end = (const char*)(side.data() + side.size());
+    for (const char* p = end - 1; p >= begin && p > end - 16 * 64; p -= 64) PREFETCH(p);
+}
+
+void OrderBook::prefetch_levels(const ParserOutput& msg) const {
+    const StockBook& book = books_[msg.stock_locate];
+    switch (msg.msg_type) {
+        case ITCH_ADD_ORDER:
+        case ITCH_ADD_ORDER_MPID: {
+            // Search the index here, so the level itself is on its way too
+            const std::vector<LevelRef>& side = msg.buy_sell == BOOK_SELL ? book.asks : book.bids;
+            size_t pos = find_level(side, msg.buy_sell, msg.price);
+            if (pos < side.size() && side[pos].price == msg.price) PREFETCH(&levels_[side[pos].level]);
+            break;
+        }
+        case ITCH_ORDER_EXECUTED:
+        case ITCH_ORDER_CANCEL:
+        case ITCH_ORDER_DELETE:
+        case ITCH_ORDER_REPLACE: {
+            const BookOrder* order = find(msg.order_ref_no);
+            if (!order) break;
+            PREFETCH(&levels_[order->level]);
+            // The side is not known without waiting for the level; fetch both in case the
+            // level empties and has to leave the index
+            if (msg.msg_type != ITCH_ORDER_CANCEL) {
+                prefetch_side(book.bids);
+                prefetch_side(book.asks);
+            }
+            // The new order's level is found the way an add finds it
+            if (msg.msg_type == ITCH_ORDER_REPLACE) {
+                for (int side = 0; side < 2; side++) {
+                    const std::vector<LevelRef>& refs = side ? book.asks : book.bids;
+                    size_t pos = find_level(refs, side ? BOOK_SELL : BOOK_BUY, msg.price);
+                    if (pos < refs.size() && refs[pos].price == msg.price) PREFETCH(&levels_[refs[pos].level]);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int OrderBook::best_bid(uint16_t stock_locate, BookLevel* level) const {
+    const std::vector<LevelRef>& side = books_[stock_locate].bids;
+    if (side.empty()) return 0;
+    *level = levels_[side.back().level];
+    return 1;
+}
+
+int OrderBook::best_ask(uint16_t stock_locate, BookLevel* level) const {
+    const std::vector<LevelRef>& side = books_[stock_locate].asks;
+    if (side.empty()) return 0;
+    *level = levels_[side.back().level];
+    return 1;
+}
+
+// Top of book
+
+static void quote(const OrderBook& book, uint16_t stock_locate, BboUpdate* q) {
+    BookLevel level;
+    int bid = book.best_bid(stock_locate, &level);
+    q->bid_price = bid ? level.price : 0;
+    q->bid_shares = bid ? bbo_shares(level.shares) : 0;
+    int ask = book.best_ask(stock_locate, &level);
+    q->ask_price = ask ? level.price : 0;
+    q->ask_shares = ask ? bbo_shares(level.shares) : 0;
+}
+
+int book_apply_bbo(OrderBook& book, const ParserOutput& msg, uint32_t msg_index, BboUpdate* update) {
+    // Updates name only the order; its stock comes from the book
+    uint16_t stock_locate = msg.stock_locate;
+    if (msg.msg_type != ITCH_ADD_ORDER && msg.msg_type != ITCH_ADD_ORDER_MPID) {
+        const BookOrder* order = book.find(msg.order_ref_no);
+        if (!order) {
+            book.apply(msg);   // counted as ignored
+            return 0;
+        }
+        stock_locate = book.level(order->level).stock_locate;
+    }
+
+    BboUpdate before;
+    quote(book, stock_locate, &before);
+    book.apply(msg);
+    quote(book, stock_locate, update);
+    update->changed = 0;
+    if (update->bid_price != before.bid_price || update->bid_shares != before.bid_shares) update->changed |= BBO_BID;
+    if (update->ask_price != before.ask_price || update->ask_shares != before.ask_shares) update->changed |= BBO_ASK;
+    if (!update->changed) return 0;
+    update->timestamp = msg.timestamp;
+    update->stock_locate = stock_locate;
+    update->reserved = 0;
+    update->msg_index = msg_index;
+    return 1;
+}
+
+size_t book_apply_bbo_batch(OrderBook& book, const ParserOutput* msgs, size_t num_msgs, BboUpdate* updates) {
+    size_t count = 0;
+    for (size_t i = 0; i < num_msgs; i++) count += book_apply_bbo(book, msgs[i], (uint32_t)i, &updates[count]);
+    return count;
+}
@@ -0,0 +1,126 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "itch.h"
+#include "bbo.h"
+
+// In-memory limit order book built from the parser output. Handles the six message types the
+// parsers decode: A/F adds, E executions, X partial cancels, D deletes and U replaces.
+//
+// Orders live in one open-addressing hash table keyed by order_ref_no. Each order points at its
+// aggregated price level, and levels live in a pool where they never move, so an E/X/D touches
+// exactly one table slot and one level and never searches a book. Each stock_locate keeps its
+// levels sorted by price per side; that index is only searched when an add needs its level, and
+// only changes when a level appears or empties.
+//
+// Build with the decoder library:
+//   g++ -O3 -c itch_decoder.cpp order_book.cpp && ar rcs libitch.a itch_decoder.o order_book.o
+
+#define BOOK_BUY   'B'
+#define BOOK_SELL  'S'
+
+// One aggregated price level, 32 bytes so that it never straddles a cache line
+struct alignas(32) BookLevel {
+    uint64_t shares;
+    uint32_t price;
+    uint32_t num_orders;
+    uint16_t stock_locate;
+    uint8_t  buy_sell;
+};
+
+// Entry of a side's price index: the level's price, and where it sits in the level pool
+struct LevelRef {
+    uint32_t price;
+    uint32_t level;
+};
+
+// Price index of one stock. Both sides are sorted so that the best price is at the back: bids by
+// ascending price, asks by descending price. Most levels appear and empty near the inside, so
+// inserting or erasing one only moves the few entries behind it.
+struct StockBook {
+    std::vector<LevelRef> bids;
+    std::vector<LevelRef> asks;
+};
+
+// A resting order, as stored in the order table: 16 bytes, four to a cache line
+struct BookOrder {
+    uint64_t order_ref_no;   // 0 marks an empty slot; ITCH never uses 0 as a reference number
+    uint32_t shares;
+    uint32_t level;          // index into the level pool
+};
+
+class OrderBook {
+public:
+    // The order table starts with room for `expected_orders` live orders at half load. It doubles
+    // when it gets fuller than that, which costs one slow update, so size it for the peak.
+    explicit OrderBook(size_t expected_orders = 1 << 20);
+
+    // Applies one parser output. Returns 1 if the book changed, 0 if the message was ignored: an
+    // unsupported type, an add for an order already in the book, or an update for an unknown one.
+    int apply(const ParserOutput& msg);
+
+    int add(uint16_t stock_locate, uint64_t order_ref_no, uint8_t buy_sell, uint32_t shares, uint32_t price);
+    int execute(uint64_t order_ref_no, uint32_t shares);   // E: removes the order once fully filled
+    int cancel(uint64_t order_ref_no, uint32_t shares);    // X: partial cancel
+    int remove(uint64_t order_ref_no);                     // D
+    int replace(uint64_t order_ref_no, uint64_t new_order_ref_no, uint32_t shares, uint32_t price);  // U
+
+    // Two-stage prefetch for a batch of messages. prefetch() pulls in the order table slots and
+    // the stock's price index header, which only need the message itself. prefetch_levels() finds
+    // the order, now in cache, and pulls in its level or the part of the price index an add will
+    // search. A replace also looks up the level its new order joins. Call prefetch() about 2k
+    // messages ahead of apply() and prefetch_levels() about k.
+    void prefetch(const ParserOutput& msg) const;
+    void prefetch_levels(const ParserOutput& msg) const;
+
+    const BookOrder* find(uint64_t order_ref_no) const;
+    const StockBook& book(uint16_t stock_locate) const { return books_[stock_locate]; }
+    const BookLevel& level(uint32_t index) const { return levels_[index]; }
+
+    // Best level on each side; returns 0 if that side is empty
+    int best_bid(uint16_t stock_locate, BookLevel* level) const;
+    int best_ask(uint16_t stock_locate, BookLevel* level) const;
+
+    size_t num_orders() const { return num_orders_; }
+    size_t num_levels() const { return levels_.size() - free_levels_.size(); }
+    size_t table_capacity() const { return table_.size(); }
+    size_t ignored() const { return ignored_; }   // messages apply() returned 0 for
+
+private:
+    size_t slot_of(uint64_t order_ref_no) const {
+        return (size_t)((order_ref_no * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+    BookOrder* lookup(uint64_t order_ref_no);
+    BookOrder* insert(uint64_t order_ref_no);
+    void erase(BookOrder* order);
+    void grow();
+
+    uint32_t level_for(uint16_t stock_locate, uint8_t buy_sell, uint32_t price);
+    void level_reduce(uint32_t index, uint32_t shares, int removed);
+    std::vector<LevelRef>& side_of(uint16_t stock_locate, uint8_t buy_sell) {
+        return buy_sell == BOOK_SELL ? books_[stock_locate].asks : books_[stock_locate].bids;
+    }
+
+    std::vector<BookOrder> table_;   // power-of-two size, linear probing, no tombstones
+    size_t mask_;
+    int shift_;
+    size_t num_orders_;
+    size_t ignored_;
+    std::vector<BookLevel> levels_;        // level pool; indices stay valid while a level is live
+    std::vector<uint32_t> free_levels_;
+    std::vector<StockBook> books_;         // indexed by stock_locate
+};
+
+// Top-of-book deltas, the CPU equivalent of the bbo_stage kernel (bbo.h). Applies msg like
+// OrderBook::apply() and returns 1, filling *update, if it moved the best price or the size at the
+// best price on either side of the order's stock; returns 0 otherwise.
+int book_apply_bbo(OrderBook& book, const ParserOutput& msg, uint32_t msg_index, BboUpdate* update);
+
+// Applies num_msgs messages and writes a BboUpdate for each one that changed a BBO, tagged with the
+// message's position in msgs. Returns the number of updates; `updates` needs room for num_msgs.
+size_t book_apply_bbo_batch(OrderBook& book, const ParserOutput* msgs, size_t num_msgs, BboUpdate* updates);
+
+#endif
@@ -0,0 +1,203 @@
+// Latency benchmark for the order book.
+// Generates a book-coherent ITCH feed, decodes it with the CPU decoder in batches like a real
+// consumer, and times every OrderBook::apply() with the time-stamp counter. Reports latency
+// percentiles per message type, with and without prefetching the order table and price levels
+// a few messages ahead, then checks the final book against the generator's view of the resting
+// orders.
+//
+// Build: g++ -O3 -c itch_decoder.cpp order_book.cpp && ar rcs libitch.a itch_decoder.o order_book.o
+//        g++ -O3 -o order_book_bench order_book_bench.cpp libitch.a
+// Usage: ./order_book_bench [million messages, default 10] [resting orders, default 1000000] [stocks, default 8000]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+#include "order_book.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t ticks() {
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+#else
+static inline uint64_t ticks() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// Messages generated, decoded and applied per batch
+#define BATCH_MESSAGES 4096
+
+// How many messages ahead of apply() the two prefetch stages run
+#define PREFETCH_AHEAD 4
+
+static double ticks_per_ns() {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = ticks();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(200)) {}
+    uint64_t c1 = ticks();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return (c1 - c0) / ns;
+}
+
+// Cost of the timing itself, subtracted from every sample
+static uint64_t timer_overhead() {
+    uint64_t best = ~0ULL;
+    for (int i = 0; i < 100000; i++) {
+        uint64_t t0 = ticks();
+        uint64_t t1 = ticks();
+        best = std::min(best, t1 - t0);
+    }
+    return best;
+}
+
+// Latency samples by message type
+struct Samples {
+    const char* name;
+    uint8_t types[2];
+    std::vector<uint32_t> ticks;
+};
+
+static void report(Samples& s, double tpn) {
+    if (s.ticks.empty()) return;
+    std::sort(s.ticks.begin(), s.ticks.end());
+    size_t n = s.ticks.size();
+    double sum = 0;
+    for (uint32_t t : s.ticks) sum += t;
+    printf("  %-10s %10zu %8.1f %8.1f %8.1f %8.1f %8.1f %10.1f\n", s.name, n, sum / n / tpn,
+           s.ticks[n / 2] / tpn, s.ticks[n * 90 / 100] / tpn, s.ticks[n * 99 / 100] / tpn,
+           s.ticks[n * 999 / 1000] / tpn, s.ticks[n - 1] / tpn);
+}
+
+// Decodes the next batch of the feed into outputs; returns the number of records
+static size_t next_batch(BookFeed& feed, std::vector<uint8_t>& bytes, ParserOutput* outputs) {
+    bytes.clear();
+    for (int i = 0; i < BATCH_MESSAGES; i++) append_book_message(feed, bytes);
+    std::vector<uint8_t> framed = to_framed(bytes, 0);
+    size_t consumed = 0;
+    return itch_decode_framed(framed.data(), framed.size(), outputs, BATCH_MESSAGES, &consumed);
+}
+
+// Replays the feed through a fresh book. Returns non-zero on a mismatch.
+static int run(const char* name, bool prefetch, size_t num_messages, size_t resting, int num_stocks,
+               double tpn, uint64_t overhead) {
+    rng_state = 0x9E3779B97F4A7C15ULL;   // same feed for every run
+    BookFeed feed;
+    book_feed_init(feed, num_stocks, resting);
+    OrderBook book(resting + resting / 4);
+    std::vector<uint8_t> bytes;
+    std::vector<ParserOutput> outputs(BATCH_MESSAGES);
+
+    // Warm up until the book holds the target number of orders; not timed
+    while (feed.live.size() < resting) {
+        size_t n = next_batch(feed, bytes, outputs.data());
+        for (size_t i = 0; i < n; i++) book.apply(outputs[i]);
+    }
+
+    Samples samples[] = {
+        {"add A/F",  {ITCH_ADD_ORDER, ITCH_ADD_ORDER_MPID}, {}},
+        {"execute E", {ITCH_ORDER_EXECUTED, ITCH_ORDER_EXECUTED}, {}},
+        {"cancel X", {ITCH_ORDER_CANCEL, ITCH_ORDER_CANCEL}, {}},
+        {"delete D", {ITCH_ORDER_DELETE, ITCH_ORDER_DELETE}, {}},
+        {"replace U", {ITCH_ORDER_REPLACE, ITCH_ORDER_REPLACE}, {}},
+    };
+    const int num_samples = sizeof(samples) / sizeof(samples[0]);
+    Samples* by_type[256] = {0};
+    for (int s = 0; s < num_samples; s++) {
+        samples[s].ticks.reserve(num_messages / 2);
+        by_type[samples[s].types[0]] = by_type[samples[s].types[1]] = &samples[s];
+    }
+
+    size_t done = 0;
+    uint64_t busy = 0;
+    while (done < num_messages) {
+        size_t n = next_batch(feed, bytes, outputs.data());
+        for (size_t i = 0; i < n; i++) {
+            if (prefetch) {
+                if (i + 2 * PREFETCH_AHEAD < n) book.prefetch(outputs[i + 2 * PREFETCH_AHEAD]);
+                if (i + PREFETCH_AHEAD < n) book.prefetch_levels(outputs[i + PREFETCH_AHEAD]);
+            }
+            uint64_t t0 = ticks();
+            book.apply(outputs[i]);
+            uint64_t t = ticks() - t0;
+            t = t > overhead ? t - overhead : 0;
+            busy += t;
+            by_type[outputs[i].msg_type]->ticks.push_back((uint32_t)std::min<uint64_t>(t, UINT32_MAX));
+        }
+        done += n;
+    }
+
+    printf("%s: %zu updates, %zu resting orders, %.1f M updates/s\n", name, done, book.num_orders(),
+           done / (busy / tpn) * 1e3);
+    printf("  %-10s %10s %8s %8s %8s %8s %8s %10s\n", "type", "count", "mean ns", "p50", "p90", "p99",
+           "p99.9", "max");
+    for (int s = 0; s < num_samples; s++) report(samples[s], tpn);
+
+    // The book must hold exactly the orders the generator still considers live
+    std::map<uint64_t, BookLevel> expected;
+    for (const LiveOrder& o : feed.live) {
+        uint64_t key = ((uint64_t)o.stock_locate << 40) | ((uint64_t)o.buy_sell << 32) | o.price;
+        BookLevel& level = expected[key];
+        level.price = o.price;
+        level.num_orders++;
+        level.shares += o.shares;
+    }
+    size_t num_levels = 0;
+    for (int locate = 0; locate < 65536; locate++) {
+        const StockBook& sb = book.book((uint16_t)locate);
+        for (int side = 0; side < 2; side++) {
+            const std::vector<LevelRef>& refs = side ? sb.asks : sb.bids;
+            for (size_t i = 0; i < refs.size(); i++) {
+                const BookLevel& level = book.level(refs[i].level);
+                uint64_t key = ((uint64_t)locate << 40) | ((uint64_t)(side ? BOOK_SELL : BOOK_BUY) << 32) |
+                               level.price;
+                std::map<uint64_t, BookLevel>::iterator it = expected.find(key);
+                if (it == expected.end() || it->second.shares != level.shares ||
+                    it->second.num_orders != level.num_orders || refs[i].price != level.price ||
+                    (i > 0 && (side ? refs[i].price >= refs[i - 1].price
+                                    : refs[i].price <= refs[i - 1].price))) {
+                    printf("%s: stock %d %s level %u differs from the feed\n", name, locate,
+                           side ? "ask" : "bid", (unsigned)level.price);
+                    return 1;
+                }
+                num_levels++;
+            }
+        }
+    }
+    if (num_levels != expected.size() || num_levels != book.num_levels() ||
+        book.num_orders() != feed.live.size() || book.ignored() != 0) {
+        printf("%s: %zu levels and %zu orders, expected %zu and %zu; %zu updates ignored\n", name,
+               num_levels, book.num_orders(), expected.size(), feed.live.size(), book.ignored());
+        return 1;
+    }
+    printf("  book matches the feed: %zu price levels\n\n", num_levels);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    size_t num_messages = (argc > 1 ? strtoull(argv[1], NULL, 10) : 10) * 1000000;
+    size_t resting = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    int num_stocks = argc > 3 ? atoi(argv[3]) : 8000;
+    if (num_stocks < 1 || num_stocks > 65535) num_stocks = 8000;
+
+    double tpn = ticks_per_ns();
+    uint64_t overhead = timer_overhead();
+    printf("%.2f ticks/ns, timer overhead %.1f ns subtracted\n\n", tpn, overhead / tpn);
+
+    int errors = 0;
+    errors += run("no prefetch", false, num_messages, resting, num_stocks, tpn, overhead);
+    errors += run("prefetch", true, num_messages, resting, num_stocks, tpn, overhead);
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
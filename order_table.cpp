@@ -0,0 +1,63 @@
+#include <stdint.h>
+#include "order_table.h"
+
+// Batch front end for the two-tier order table (order_table.h): runs a list of operations in
+// order and writes one result per operation. Tier 1 is a static, so it stays in on-chip memory
+// from one call to the next along with the cuckoo table in card memory; a call with reset set
+// clears it, and the host zeroes the buckets at the same time.
+
+extern "C" {
+void order_table(
+    // Input: operations, run in order
+    const OrderOp* ops,
+    int num_ops,
+
+    // Output: one result per operation
+    OrderResult* results,
+
+    // Tier 2, 1 << bucket_bits buckets of ORDER_BUCKET_SLOTS entries
+    OrderBucket* buckets,
+    int bucket_bits,
+
+    // Clear tier 1 before the first operation
+    int reset
+) {
+    #pragma HLS INTERFACE m_axi port=ops bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=results bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=buckets bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_ops
+    #pragma HLS INTERFACE s_axilite port=bucket_bits
+    #pragma HLS INTERFACE s_axilite port=reset
+    #pragma HLS INTERFACE s_axilite port=return
+
+    static OrderCache cache;
+    #pragma HLS ARRAY_PARTITION variable=cache.way complete dim=2
+    #pragma HLS ARRAY_PARTITION variable=cache.stash complete
+
+    if (reset) order_table_reset(cache);
+
+    // Not pipelined: an operation can read the cache set, stash or bucket that the one before it
+    // wrote, so operations run one at a time, and each bucket read waits out the card memory latency.
+    OPS: for (int i = 0; i < num_ops; i++) {
+        OrderOp op = ops[i];
+        OrderResult r = {};
+        switch (op.op) {
+            case ORDER_FIND:
+                r.ok = order_table_find(cache, buckets, bucket_bits, op.order_ref_no, &r.value, r.probe);
+                break;
+            case ORDER_INSERT:
+                r.ok = order_table_insert(cache, buckets, bucket_bits, op.order_ref_no, op.value, r.probe);
+                break;
+            case ORDER_UPDATE:
+                r.ok = order_table_update(cache, buckets, bucket_bits, op.order_ref_no, op.value, r.probe);
+                break;
+            case ORDER_ERASE:
+                r.ok = order_table_erase(cache, buckets, bucket_bits, op.order_ref_no, r.probe);
+                break;
+            default:
+                break;
+        }
+        results[i] = r;
+    }
+}
+}
@@ -0,0 +1,292 @@
+#ifndef ORDER_TABLE_H
+#define ORDER_TABLE_H
+
+#include <stdint.h>
+
+// Two-tier order reference table: maps the 64-bit order_ref_no to 64 bits of order state (for a
+// book, the shares and a level index, as in BookOrder) for tens of millions of live orders.
+//
+// Tier 1 is on chip: a 4-way set-associative cache of ORDER_CACHE_SETS sets and a stash of
+// ORDER_STASH entries. New orders are written to the cache. Most executions, cancels and deletes
+// in a feed hit orders added shortly before, so those never leave the chip. When a set is full,
+// the way named by the set's round-robin pointer is evicted to tier 2. That is not always the
+// oldest entry: an erase frees a way out of turn, and the next insert fills it.
+//
+// Tier 2 is off chip: a bucketized cuckoo hash table. Each key has two candidate buckets from two
+// hash functions, and a bucket is four 16-byte entries, one 64-byte (512-bit) beat. A lookup that
+// misses on chip therefore reads at most two beats, whatever the load. An insert into two full
+// buckets moves an entry to its other bucket, at most ORDER_MAX_KICKS times, and whatever entry is
+// still homeless then goes to the stash. Inserts only fail once the stash is full as well.
+//
+// An entry lives in exactly one place, so an update or erase writes once. The functions below
+// drive both the HLS kernel (order_table.cpp) and the CPU build, which calls them directly on host
+// memory; order_table_bench.cpp checks the kernel in C simulation and benchmarks the CPU build.
+// Layout must match between host and kernel.
+
+#define ORDER_BUCKET_SLOTS  4
+#define ORDER_CACHE_BITS    10
+#define ORDER_CACHE_SETS    (1 << ORDER_CACHE_BITS)
+#define ORDER_CACHE_WAYS    4
+#define ORDER_STASH         16
+#define ORDER_MAX_KICKS     128   // enough to keep the stash nearly empty up to 95% load
+
+// Where an operation found its key
+#define ORDER_TIER_NONE   0
+#define ORDER_TIER_CACHE  1
+#define ORDER_TIER_STASH  2
+#define ORDER_TIER_TABLE  3
+
+// order_ref_no 0 marks an empty slot; ITCH never uses 0 as a reference number
+typedef struct {
+    uint64_t order_ref_no;
+    uint64_t value;
+} OrderEntry;
+
+typedef struct {
+    OrderEntry slot[ORDER_BUCKET_SLOTS];
+} OrderBucket;
+
+// Tier 1: 64 KB of cache and the stash, in on-chip memory in the kernel
+typedef struct {
+    OrderEntry way[ORDER_CACHE_SETS][ORDER_CACHE_WAYS];
+    uint8_t    victim[ORDER_CACHE_SETS];   // next way to evict, round robin
+    OrderEntry stash[ORDER_STASH];
+    int        stash_count;
+} OrderCache;
+
+// Off-chip work of one operation, for the benchmark's cycle model and probe tails
+typedef struct {
+    uint8_t tier;     // ORDER_TIER_*
+    uint8_t reads;    // buckets read
+    uint8_t writes;   // buckets written
+    uint8_t kicks;    // entries moved to their other bucket
+} OrderProbe;
+
+// Kernel operations
+#define ORDER_FIND    0
+#define ORDER_INSERT  1
+#define ORDER_UPDATE  2
+#define ORDER_ERASE   3
+
+typedef struct {
+    uint64_t order_ref_no;
+    uint64_t value;         // ORDER_INSERT, ORDER_UPDATE
+    uint8_t  op;            // ORDER_*
+    uint8_t  reserved[7];
+} OrderOp;
+
+typedef struct {
+    uint64_t   value;       // ORDER_FIND: the entry's value
+    uint8_t    ok;          // found, or for ORDER_INSERT inserted
+    uint8_t    reserved[3];
+    OrderProbe probe;
+} OrderResult;
+
+static inline uint64_t order_bucket1(uint64_t order_ref_no, int bucket_bits) {
+    return (order_ref_no * 0x9E3779B97F4A7C15ULL) >> (64 - bucket_bits);
+}
+
+// A second, independent hash; never the same bucket as the first
+static inline uint64_t order_bucket2(uint64_t order_ref_no, int bucket_bits) {
+    uint64_t h = ((order_ref_no ^ (order_ref_no >> 31)) * 0xBF58476D1CE4E5B9ULL) >> (64 - bucket_bits);
+    uint64_t b1 = order_bucket1(order_ref_no, bucket_bits);
+    return h == b1 ? b1 ^ 1 : h;
+}
+
+static inline uint32_t order_cache_set(uint64_t order_ref_no) {
+    return (uint32_t)((order_ref_no * 0xD6E8FEB86659FD93ULL) >> (64 - ORDER_CACHE_BITS));
+}
+
+static inline void order_table_reset(OrderCache& cache) {
+    RESET: for (int s = 0; s < ORDER_CACHE_SETS; s++) {
+        #pragma HLS PIPELINE II=1
+        for (int w = 0; w < ORDER_CACHE_WAYS; w++) cache.way[s][w].order_ref_no = 0;
+        cache.victim[s] = 0;
+    }
+    cache.stash_count = 0;
+}
+
+// Where a key was found
+struct OrderPlace {
+    int tier;
+    int index;            // way in the cache set, stash entry, or slot in the bucket
+    uint64_t bucket;
+    OrderBucket data;     // the bucket as read, for ORDER_TIER_TABLE
+};
+
+static inline int bucket_find(const OrderBucket& b, uint64_t order_ref_no) {
+    #pragma HLS INLINE
+    int found = -1;
+    SLOTS: for (int i = ORDER_BUCKET_SLOTS - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (b.slot[i].order_ref_no == order_ref_no) found = i;
+    }
+    return found;
+}
+
+// Looks in the cache set, the stash and then the two buckets, stopping at the first hit
+static inline bool order_locate(const OrderCache& cache, const OrderBucket* buckets, int bucket_bits,
+                                uint64_t order_ref_no, OrderPlace& at, OrderProbe& probe) {
+    uint32_t set = order_cache_set(order_ref_no);
+    at.tier = ORDER_TIER_NONE;
+    at.bucket = 0;
+    CACHE: for (int w = ORDER_CACHE_WAYS - 1; w >= 0; w--) {
+        #pragma HLS UNROLL
+        if (cache.way[set][w].order_ref_no == order_ref_no) {
+            at.tier = ORDER_TIER_CACHE;
+            at.index = w;
+        }
+    }
+    STASH: for (int i = ORDER_STASH - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (i < cache.stash_count && cache.stash[i].order_ref_no == order_ref_no) {
+            at.tier = ORDER_TIER_STASH;
+            at.index = i;
+        }
+    }
+    if (at.tier == ORDER_TIER_NONE) {
+        uint64_t b[2] = {order_bucket1(order_ref_no, bucket_bits), order_bucket2(order_ref_no, bucket_bits)};
+        BUCKETS: for (int k = 0; k < 2; k++) {
+            at.bucket = b[k];
+            at.data = buckets[b[k]];
+            probe.reads++;
+            at.index = bucket_find(at.data, order_ref_no);
+            if (at.index >= 0) {
+                at.tier = ORDER_TIER_TABLE;
+                break;
+            }
+        }
+    }
+    probe.tier = (uint8_t)at.tier;
+    return at.tier != ORDER_TIER_NONE;
+}
+
+static inline int bucket_free(const OrderBucket& b) {
+    #pragma HLS INLINE
+    int free_slot = -1;
+    FREE: for (int i = ORDER_BUCKET_SLOTS - 1; i >= 0; i--) {
+        #pragma HLS UNROLL
+        if (b.slot[i].order_ref_no == 0) free_slot = i;
+    }
+    return free_slot;
+}
+
+// Puts an entry evicted from the cache into the cuckoo table, or into the stash if its chain of
+// moves runs out of kicks. The caller has checked that the stash has room.
+static inline void order_place(OrderCache& cache, OrderBucket* buckets, int bucket_bits, OrderEntry e,
+                               OrderProbe& probe) {
+    uint64_t b = order_bucket1(e.order_ref_no, bucket_bits);
+    OrderBucket data = buckets[b];
+    probe.reads++;
+    int free_slot = bucket_free(data);
+    if (free_slot < 0) {
+        b = order_bucket2(e.order_ref_no, bucket_bits);
+        data = buckets[b];
+        probe.reads++;
+        free_slot = bucket_free(data);
+    }
+    KICK: for (int k = 0; free_slot < 0 && k < ORDER_MAX_KICKS; k++) {
+        // Swap the homeless entry into a full bucket and carry on with the one it displaces
+        int victim = (int)((e.order_ref_no + k) % ORDER_BUCKET_SLOTS);
+        OrderEntry displaced = data.slot[victim];
+        data.slot[victim] = e;
+        buckets[b] = data;
+        probe.writes++;
+        probe.kicks++;
+        e = displaced;
+        uint64_t b1 = order_bucket1(e.order_ref_no, bucket_bits);
+        b = b1 == b ? order_bucket2(e.order_ref_no, bucket_bits) : b1;
+        data = buckets[b];
+        probe.reads++;
+        free_slot = bucket_free(data);
+    }
+    if (free_slot < 0) {
+        cache.stash[cache.stash_count++] = e;
+        return;
+    }
+    data.slot[free_slot] = e;
+    buckets[b] = data;
+    probe.writes++;
+}
+
+static inline bool order_table_find(const OrderCache& cache, const OrderBucket* buckets, int bucket_bits,
+                                    uint64_t order_ref_no, uint64_t* value, OrderProbe& probe) {
+    OrderPlace at;
+    if (order_ref_no == 0 || !order_locate(cache, buckets, bucket_bits, order_ref_no, at, probe)) return false;
+    uint32_t set = order_cache_set(order_ref_no);
+    *value = at.tier == ORDER_TIER_CACHE ? cache.way[set][at.index].value
+           : at.tier == ORDER_TIER_STASH ? cache.stash[at.index].value
+           : at.data.slot[at.index].value;
+    return true;
+}
+
+// Returns false if the order is already live, or if the table is full: the order's cache set
+// and the stash are both full
+static inline bool order_table_insert(OrderCache& cache, OrderBucket* buckets, int bucket_bits,
+                                      uint64_t order_ref_no, uint64_t value, OrderProbe& probe) {
+    OrderPlace at;
+    if (order_ref_no == 0 || order_locate(cache, buckets, bucket_bits, order_ref_no, at, probe)) return false;
+    uint32_t set = order_cache_set(order_ref_no);
+    int way = -1;
+    WAYS: for (int w = ORDER_CACHE_WAYS - 1; w >= 0; w--) {
+        #pragma HLS UNROLL
+        if (cache.way[set][w].order_ref_no == 0) way = w;
+    }
+    if (way < 0) {
+        if (cache.stash_count == ORDER_STASH) return false;
+        way = cache.victim[set];
+        cache.victim[set] = (uint8_t)((way + 1) % ORDER_CACHE_WAYS);
+        order_place(cache, buckets, bucket_bits, cache.way[set][way], probe);
+    }
+    cache.way[set][way].order_ref_no = order_ref_no;
+    cache.way[set][way].value = value;
+    return true;
+}
+
+static inline bool order_table_update(OrderCache& cache, OrderBucket* buckets, int bucket_bits,
+                                      uint64_t order_ref_no, uint64_t value, OrderProbe& probe) {
+    OrderPlace at;
+    if (order_ref_no == 0 || !order_locate(cache, buckets, bucket_bits, order_ref_no, at, probe)) return false;
+    if (at.tier == ORDER_TIER_CACHE) {
+        cache.way[order_cache_set(order_ref_no)][at.index].value = value;
+    } else if (at.tier == ORDER_TIER_STASH) {
+        cache.stash[at.index].value = value;
+    } else {
+        at.data.slot[at.index].value = value;
+        buckets[at.bucket] = at.data;
+        probe.writes++;
+    }
+    return true;
+}
+
+// An erase from the cuckoo table also moves in a stashed entry that belongs to the freed bucket
+static inline bool order_table_erase(OrderCache& cache, OrderBucket* buckets, int bucket_bits,
+                                     uint64_t order_ref_no, OrderProbe& probe) {
+    OrderPlace at;
+    if (order_ref_no == 0 || !order_locate(cache, buckets, bucket_bits, order_ref_no, at, probe)) return false;
+    if (at.tier == ORDER_TIER_CACHE) {
+        cache.way[order_cache_set(order_ref_no)][at.index].order_ref_no = 0;
+    } else if (at.tier == ORDER_TIER_STASH) {
+        cache.stash[at.index] = cache.stash[--cache.stash_count];
+    } else {
+        at.data.slot[at.index].order_ref_no = 0;
+        int moved = -1;
+        UNSTASH: for (int i = ORDER_STASH - 1; i >= 0; i--) {
+            #pragma HLS UNROLL
+            uint64_t ref = cache.stash[i].order_ref_no;
+            if (i < cache.stash_count &&
+                (order_bucket1(ref, bucket_bits) == at.bucket || order_bucket2(ref, bucket_bits) == at.bucket)) {
+                moved = i;
+            }
+        }
+        if (moved >= 0) {
+            at.data.slot[at.index] = cache.stash[moved];
+            cache.stash[moved] = cache.stash[--cache.stash_count];
+        }
+        buckets[at.bucket] = at.data;
+        probe.writes++;
+    }
+    return true;
+}
+
+#endif
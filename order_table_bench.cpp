@@ -0,0 +1,374 @@
+// Two-tier order reference table (order_table.h): a C-simulation check of the order_table kernel,
+// then lookup throughput and probe tails of the CPU build at realistic load factors.
+//
+// 1. Check: random finds, inserts (new and duplicate), updates and erases, some for orders that
+//    are not live, go through the kernel in calls of 10000 operations and are checked against
+//    std::unordered_map. The cuckoo table is small (64K slots) and held near 90% full, so the
+//    cache evicts all the time, inserts kick, and the stash fills and drains.
+// 2. Benchmark, per load factor of the cuckoo table (50, 75, 90, 95%): fill the table with
+//    near-sequential reference numbers, as ITCH hands them out. Then churn it with an add and a
+//    delete per step, at constant load, for a quarter of the live orders. Deletes, like most
+//    cancels in a real feed, go to one of the 1024 orders added last 70% of the time, and to any
+//    live order otherwise. Lookups are then timed twice: with that same mix ("recent"), and
+//    uniformly over the live orders ("uniform"), where the cache hardly ever hits.
+// Reported per run:
+//   - lookups per second of the CPU build, and the share served on chip (cache and stash)
+//   - buckets read per lookup, and its p99/p99.9/max
+//   - cycles per lookup of the kernel, which runs one operation at a time: one cycle on chip plus
+//     MEM_LATENCY cycles for each bucket read, since the second read waits for the first to miss
+//   - for comparison, the 64-byte lines a lookup touches in a linear-probing table of the same
+//     size and contents (OrderBook's layout): p50/p99/p99.9/max
+// and per load factor: kicks per insert (p99.9/max), the stash high-water mark, and failed inserts.
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -o order_table_bench order_table_bench.cpp order_table.cpp
+// Usage: ./order_table_bench [bucket bits, default 22: 16M slots, 256 MB] [million lookups, default 4]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "order_table.h"
+#include "itch_testgen.h"
+
+extern "C" void order_table(const OrderOp* ops, int num_ops, OrderResult* results, OrderBucket* buckets,
+                            int bucket_bits, int reset);
+
+#define CHECK_BUCKET_BITS 14
+#define CHECK_OPS         400000
+#define MEM_LATENCY       64   // cycles of card memory latency per bucket read, as in bbo_stage_tb
+#define CHECK_BATCH       10000
+
+// Deletes and "recent" lookups go to one of the orders added last
+#define RECENT_ORDERS     1024
+#define RECENT_PERCENT    70
+
+#define HIST_BINS 4096
+
+// Counts of small integers, with percentiles
+struct Hist {
+    uint64_t bin[HIST_BINS];
+    uint64_t n;
+    void add(unsigned v) { bin[v < HIST_BINS ? v : HIST_BINS - 1]++; n++; }
+    unsigned pct(double p) const {
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)(n - 1));
+        uint64_t seen = 0;
+        for (unsigned v = 0; v < HIST_BINS; v++) {
+            seen += bin[v];
+            if (seen > rank) return v;
+        }
+        return HIST_BINS - 1;
+    }
+    unsigned max() const {
+        for (unsigned v = HIST_BINS; v > 0; v--) if (bin[v - 1]) return v - 1;
+        return 0;
+    }
+};
+
+// Kernel in C simulation against std::unordered_map. Returns the number of mismatches.
+static int check_kernel() {
+    std::vector<OrderBucket> buckets((size_t)1 << CHECK_BUCKET_BITS);
+    memset(buckets.data(), 0, buckets.size() * sizeof(OrderBucket));
+    size_t target = (size_t)(0.9 * ORDER_BUCKET_SLOTS * buckets.size()) + ORDER_CACHE_SETS * ORDER_CACHE_WAYS;
+
+    std::unordered_map<uint64_t, uint64_t> model;
+    std::vector<uint64_t> live;
+    uint64_t next_ref = 1 + next_rand() % 1000000;
+    std::vector<OrderOp> ops(CHECK_BATCH);
+    std::vector<OrderResult> results(CHECK_BATCH);
+    int errors = 0, reset = 1;
+    Hist kicks = {};
+    unsigned stashed = 0;
+
+    for (int done = 0; done < CHECK_OPS; done += CHECK_BATCH) {
+        // Operations and the results the model expects for them
+        std::vector<OrderResult> expect(CHECK_BATCH);
+        for (int i = 0; i < CHECK_BATCH; i++) {
+            OrderOp& op = ops[i];
+            memset(&op, 0, sizeof(op));
+            int r = (int)(next_rand() % 100);
+            bool have = !live.empty();
+            size_t pick = have ? next_rand() % live.size() : 0;
+            OrderResult& e = expect[i];
+            memset(&e, 0, sizeof(e));
+            if (!have || (r < 35 && live.size() < target)) {
+                op.op = ORDER_INSERT;
+                op.order_ref_no = next_ref;
+                next_ref += 1 + next_rand() % 2;
+                op.value = next_rand();
+            } else if (r < 37) {
+                op.op = ORDER_INSERT;                       // already live
+                op.order_ref_no = live[pick];
+                op.value = next_rand();
+            } else if (r < 62) {
+                op.op = ORDER_FIND;
+                op.order_ref_no = live[pick];
+            } else if (r < 66) {
+                op.op = next_rand() & 1 ? ORDER_FIND : ORDER_UPDATE;   // not live
+                op.order_ref_no = next_ref + 1 + next_rand() % 1000;
+            } else if (r < 81) {
+                op.op = ORDER_UPDATE;
+                op.order_ref_no = live[pick];
+                op.value = next_rand();
+            } else {
+                op.op = ORDER_ERASE;
+                op.order_ref_no = r < 84 ? next_ref + 1 + next_rand() % 1000 : live[pick];
+            }
+
+            // Apply to the model
+            auto it = model.find(op.order_ref_no);
+            bool found = it != model.end();
+            switch (op.op) {
+                case ORDER_FIND:
+                    e.ok = found;
+                    e.value = found ? it->second : 0;
+                    break;
+                case ORDER_INSERT:
+                    e.ok = !found;
+                    if (!found) {
+                        model[op.order_ref_no] = op.value;
+                        live.push_back(op.order_ref_no);
+                    }
+                    break;
+                case ORDER_UPDATE:
+                    e.ok = found;
+                    if (found) it->second = op.value;
+                    break;
+                default:
+                    e.ok = found;
+                    if (found) {
+                        model.erase(it);
+                        live[pick] = live.back();
+                        live.pop_back();
+                    }
+                    break;
+            }
+        }
+
+        order_table(ops.data(), CHECK_BATCH, results.data(), buckets.data(), CHECK_BUCKET_BITS, reset);
+        reset = 0;
+        for (int i = 0; i < CHECK_BATCH; i++) {
+            const OrderResult& got = results[i];
+            if (ops[i].op == ORDER_INSERT && got.ok) kicks.add(got.probe.kicks);
+            bool bad = got.ok != expect[i].ok || (ops[i].op == ORDER_FIND && got.ok && got.value != expect[i].value);
+            if (!bad) continue;
+            if (errors < 10) {
+                printf("  op %d (type %d, ref %llu): got ok %d value %llu, expected ok %d value %llu\n", done + i,
+                       ops[i].op, (unsigned long long)ops[i].order_ref_no, got.ok,
+                       (unsigned long long)got.value, expect[i].ok, (unsigned long long)expect[i].value);
+            }
+            errors++;
+        }
+        // Tier 1 is not visible from the host: an insert that used every kick sent an order to the stash
+        for (int i = 0; i < CHECK_BATCH; i++) stashed += results[i].probe.kicks == ORDER_MAX_KICKS;
+    }
+
+    // Every live order must still be there with its value
+    std::vector<OrderOp> finds;
+    for (const auto& kv : model) {
+        OrderOp op = {};
+        op.op = ORDER_FIND;
+        op.order_ref_no = kv.first;
+        finds.push_back(op);
+    }
+    std::vector<OrderResult> found(finds.size());
+    order_table(finds.data(), (int)finds.size(), found.data(), buckets.data(), CHECK_BUCKET_BITS, 0);
+    int lost = 0;
+    for (size_t i = 0; i < finds.size(); i++) {
+        lost += !found[i].ok || found[i].value != model[finds[i].order_ref_no];
+    }
+    errors += lost;
+
+    printf("check: %d operations through order_table in C-sim, %zu live orders at the end (%.0f%% of the "
+           "cuckoo slots if none were on chip), kicks per insert p99.9 %u max %u, %u stashed, "
+           "%d lost: %s\n", CHECK_OPS, model.size(), 100.0 * model.size() / (ORDER_BUCKET_SLOTS * buckets.size()),
+           kicks.pct(99.9), kicks.max(), stashed, lost, errors ? "FAIL" : "ok");
+    return errors;
+}
+
+// Linear probing over the same number of 16-byte slots, with backward-shift deletion, as in
+// OrderBook. Only the keys are kept; lookups count the 64-byte lines they touch.
+struct LinearTable {
+    std::vector<uint64_t> keys;
+    uint64_t mask;
+    int shift;
+
+    explicit LinearTable(int slot_bits) : keys((size_t)1 << slot_bits, 0), mask(((uint64_t)1 << slot_bits) - 1),
+                                          shift(64 - slot_bits) {}
+    uint64_t home(uint64_t key) const { return (key * 0x9E3779B97F4A7C15ULL) >> shift; }
+    void insert(uint64_t key) {
+        uint64_t i = home(key);
+        while (keys[i]) i = (i + 1) & mask;
+        keys[i] = key;
+    }
+    void erase(uint64_t key) {
+        uint64_t hole = home(key);
+        while (keys[hole] != key) hole = (hole + 1) & mask;
+        for (uint64_t i = (hole + 1) & mask; keys[i]; i = (i + 1) & mask) {
+            uint64_t h = home(keys[i]);
+            bool movable = hole <= i ? (h <= hole || h > i) : (h <= hole && h > i);
+            if (movable) {
+                keys[hole] = keys[i];
+                hole = i;
+            }
+        }
+        keys[hole] = 0;
+    }
+    unsigned lines(uint64_t key) const {
+        uint64_t start = home(key), n = 0;
+        while (keys[(start + n) & mask] != key) n++;
+        return (unsigned)((start + n) / ORDER_BUCKET_SLOTS - start / ORDER_BUCKET_SLOTS + 1);
+    }
+};
+
+// Live orders by issue number, for picking delete and lookup targets
+struct Orders {
+    std::vector<uint64_t> refs;     // every order_ref_no issued, in order
+    std::vector<uint32_t> pos;      // issue number -> index in live, or UINT32_MAX once deleted
+    std::vector<uint32_t> live;     // issue numbers of live orders
+    uint64_t next_ref;
+
+    uint32_t add() {
+        uint32_t id = (uint32_t)refs.size();
+        refs.push_back(next_ref);
+        next_ref += 1 + next_rand() % 2;
+        pos.push_back((uint32_t)live.size());
+        live.push_back(id);
+        return id;
+    }
+    uint32_t pick(bool recent) const {
+        if (recent) {
+            for (int tries = 0; tries < 8; tries++) {
+                uint32_t id = (uint32_t)(refs.size() - 1 - next_rand() % RECENT_ORDERS);
+                if (pos[id] != UINT32_MAX) return id;
+            }
+        }
+        return live[next_rand() % live.size()];
+    }
+    void remove(uint32_t id) {
+        uint32_t at = pos[id];
+        live[at] = live.back();
+        pos[live[at]] = at;
+        live.pop_back();
+        pos[id] = UINT32_MAX;
+    }
+};
+
+static uint64_t value_of(uint32_t id) {
+    return ((uint64_t)id << 1) | 1;
+}
+
+// One load factor: fill, churn, then time both lookup patterns. Returns the number of wrong lookups.
+static int run_load(int bucket_bits, double load, size_t num_lookups) {
+    size_t slots = (size_t)ORDER_BUCKET_SLOTS << bucket_bits;
+    size_t target = (size_t)(load * slots);
+    std::vector<OrderBucket> buckets((size_t)1 << bucket_bits);
+    memset(buckets.data(), 0, buckets.size() * sizeof(OrderBucket));
+    std::unique_ptr<OrderCache> cache(new OrderCache);
+    order_table_reset(*cache);
+    LinearTable linear(bucket_bits + 2);
+
+    Orders orders;
+    orders.next_ref = 1 + next_rand() % 1000000;
+    orders.refs.reserve(target + target / 4 + 1);
+    orders.pos.reserve(target + target / 4 + 1);
+    orders.live.reserve(target + 1);
+
+    Hist kicks = {};
+    size_t failed = 0;
+    unsigned stash_max = 0;
+    auto add = [&] {
+        uint32_t id = orders.add();
+        OrderProbe probe = {};
+        if (!order_table_insert(*cache, buckets.data(), bucket_bits, orders.refs[id], value_of(id), probe)) {
+            failed++;
+            orders.remove(id);
+            return;
+        }
+        kicks.add(probe.kicks);
+        linear.insert(orders.refs[id]);
+        stash_max = cache->stash_count > (int)stash_max ? (unsigned)cache->stash_count : stash_max;
+    };
+
+    while (orders.live.size() < target && failed < 1000) add();
+    size_t churn = target / 4;
+    for (size_t i = 0; i < churn; i++) {
+        add();
+        uint32_t id = orders.pick(next_rand() % 100 < RECENT_PERCENT);
+        OrderProbe probe = {};
+        order_table_erase(*cache, buckets.data(), bucket_bits, orders.refs[id], probe);
+        linear.erase(orders.refs[id]);
+        orders.remove(id);
+    }
+
+    int errors = 0;
+    for (int uniform = 0; uniform < 2; uniform++) {
+        std::vector<uint32_t> ids(num_lookups);
+        uint64_t expect = 0;
+        for (size_t i = 0; i < num_lookups; i++) {
+            ids[i] = orders.pick(!uniform && next_rand() % 100 < RECENT_PERCENT);
+            expect += value_of(ids[i]);
+        }
+        std::vector<uint64_t> keys(num_lookups);
+        for (size_t i = 0; i < num_lookups; i++) keys[i] = orders.refs[ids[i]];
+
+        Hist reads = {};
+        uint64_t sum = 0, on_chip = 0, cycles = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_lookups; i++) {
+            OrderProbe probe = {};
+            uint64_t value = 0;
+            order_table_find(*cache, buckets.data(), bucket_bits, keys[i], &value, probe);
+            sum += value;
+            reads.bin[probe.reads]++;
+            on_chip += probe.tier == ORDER_TIER_CACHE || probe.tier == ORDER_TIER_STASH;
+            cycles += 1 + probe.reads * MEM_LATENCY;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        reads.n = num_lookups;
+        errors += sum != expect;
+
+        Hist lines = {};
+        for (size_t i = 0; i < num_lookups; i++) lines.add(linear.lines(keys[i]));
+
+        uint64_t total_reads = 0;
+        for (unsigned v = 0; v < HIST_BINS; v++) total_reads += v * reads.bin[v];
+        printf("%4.0f%% %-8s %10.1f %7.1f%% %8.2f %8.1f %4u %5u %4u   %4u %4u %5u %5u %s\n", load * 100,
+               uniform ? "uniform" : "recent", num_lookups / seconds / 1e6, 100.0 * on_chip / num_lookups,
+               (double)total_reads / num_lookups, (double)cycles / num_lookups, reads.pct(99), reads.pct(99.9),
+               reads.max(), lines.pct(50), lines.pct(99), lines.pct(99.9), lines.max(),
+               sum == expect ? "" : "WRONG VALUES");
+    }
+    printf("%4.0f%% inserts: %zu live orders, kicks p99.9 %u max %u, stash high-water mark %u of %d, "
+           "%zu failed\n", load * 100, orders.live.size(), kicks.pct(99.9), kicks.max(), stash_max, ORDER_STASH,
+           failed);
+    return errors + (failed != 0);
+}
+
+int main(int argc, char** argv) {
+    int bucket_bits = argc > 1 ? atoi(argv[1]) : 22;
+    double millions = argc > 2 ? atof(argv[2]) : 4;
+    if (bucket_bits < 8 || bucket_bits > 28 || millions <= 0) {
+        printf("Usage: %s [bucket bits, 8 to 28, default 22] [million lookups, default 4]\n", argv[0]);
+        return 1;
+    }
+
+    int errors = check_kernel();
+
+    size_t slots = (size_t)ORDER_BUCKET_SLOTS << bucket_bits;
+    printf("\n%zu cuckoo slots (%zu MB) behind %d cache entries and a %d-entry stash (%zu KB on chip), "
+           "%.0fM lookups per run\n", slots, slots * sizeof(OrderEntry) >> 20, ORDER_CACHE_SETS * ORDER_CACHE_WAYS,
+           ORDER_STASH, sizeof(OrderCache) >> 10, millions);
+    printf("%-13s %10s %8s %8s %8s %-16s   %-23s\n", "", "", "", "buckets", "cycles", "bucket reads",
+           "linear probing lines");
+    printf("%-4s %-8s %10s %8s %8s %8s %4s %5s %4s   %4s %4s %5s %5s\n", "load", "lookups", "M/s", "on chip",
+           "/lookup", "/lookup", "p99", "p99.9", "max", "p50", "p99", "p99.9", "max");
+    static const double kLoads[] = {0.5, 0.75, 0.9, 0.95};
+    for (double load : kLoads) errors += run_load(bucket_bits, load, (size_t)(millions * 1e6));
+
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
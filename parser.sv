@@ -35,13 +35,55 @@ module parser (
     // Add Order with MPID Attribution Message (F) only
     output logic[31:0] attribution  // Nasdaq Market participant identifier associated with the entered order
 
+`ifdef PARSER_INSTRUMENT
+    ,
+    // Latency stamps of a free-running cycle counter, valid while valid_msg is high
+    output logic [63:0] first_cycle,  // Cycle the message's first byte (start_msg) arrived
+    output logic [63:0] done_cycle    // Cycle valid_msg was raised
+`endif
+
+`ifdef PARSER_EARLY_NOTIFY
+    ,
+    // Cut-through notification: high for one cycle once msg_type, stock_locate, tracking_no,
+    // timestamp and order_ref_no hold the current message, i.e. on the clock after byte 18.
+    // Speculative: valid_msg follows only if the rest of the message arrives intact.
+    output logic early_valid
+`endif
 );
 
     logic [5:0] byte_idx;  // stores the index of the current byte
     logic count_en;  // determines whether byte_idx should be incremented on the current cycle
     logic message_invalid;  // keeps track of whether an invalid byte has been encountered yet
+    logic msg_done;  // valid_msg is raised on the next clock
+
+    // `define PARSER_BACK_TO_BACK decodes end_msg from the byte on the bus instead of the original
+    // register set one byte ahead. It has not been simulated yet (see verilator.mk), so the
+    // original stays the default.
+`ifdef PARSER_BACK_TO_BACK
+    logic [5:0] msg_len;  // length of the message being received, 0 for an unsupported type
+    logic end_msg; // Single bit that indicates the last byte of a valid message is on the bus
+
+    always_comb begin
+        case (msg_type)
+            8'h41:   msg_len = 6'd36;
+            8'h44:   msg_len = 6'd19;
+            8'h45:   msg_len = 6'd31;
+            8'h46:   msg_len = 6'd40;
+            8'h55:   msg_len = 6'd35;
+            8'h58:   msg_len = 6'd23;
+            default: msg_len = 6'd0;
+        endcase
+    end
+
+    // Decoded from the index of the byte on the bus, so the last byte is stored, valid_msg rises
+    // right after it, and a start_msg on the very next cycle begins the next message
+    assign end_msg = valid && !start_msg && !message_invalid && count_en && (byte_idx == msg_len - 6'd1);
+    assign msg_done = end_msg;
+`else
     logic end_msg; // Single bit that indicates the end of a message
-    
+    assign msg_done = valid && !message_invalid && end_msg;
+`endif
+
     always_ff @(posedge clk or posedge rst) begin
 
         if (rst) begin
@@ -61,9 +103,12 @@ module parser (
             new_order_ref_no <= 64'd0;
             attribution <= 32'd0;
             count_en <= 1'b0;
+`ifndef PARSER_BACK_TO_BACK
             end_msg <= 1'b0;
+`endif
         end else begin
 
+`ifndef PARSER_BACK_TO_BACK
             if (end_msg) begin
                 end_msg <= 1'b0;
             end else if (valid && !start_msg) begin
@@ -77,6 +122,7 @@ module parser (
                     default: end_msg <= 1'b0;
                 endcase
             end
+`endif
 
             if (start_msg && valid) begin
                 byte_idx <= 6'd1; // Stores 1 in the counter, which will be the index of the next byte
@@ -103,9 +149,11 @@ module parser (
                 new_order_ref_no <= 64'd0;
                 attribution <= 32'd0;
 
-            end else if (valid && !message_invalid && end_msg) begin
+`ifndef PARSER_BACK_TO_BACK
+            end else if (msg_done) begin
                 count_en <= 1'b0;
                 byte_idx <= 6'b111111; // Put index out of range so data is not overwritten by in-between message bytes
+`endif
             end else begin
                 if (count_en)  // Increment byte_idx if count is enabled
                     byte_idx <= byte_idx + 1;
@@ -287,16 +335,54 @@ module parser (
                         end
                     endcase
                 end
+`ifdef PARSER_BACK_TO_BACK
+                if (end_msg) begin
+                    count_en <= 1'b0;
+                    byte_idx <= 6'b111111; // Put index out of range so data is not overwritten by in-between message bytes
+                end
+`endif
             end
 
             // If the overall message is valid and this is the last byte, raise valid_msg for one cycle
-            if (valid && !message_invalid && end_msg) begin
-                valid_msg <= 1'b1;
-            end else begin
-                valid_msg <= 1'b0;  // else set to 0
-            end
+            valid_msg <= msg_done;
         end
 
     end
 
+`ifdef PARSER_EARLY_NOTIFY
+    // Byte 18 (order_ref_no[7:0]) is stored on the same clock edge; for a D message it is also
+    // the last byte, so early_valid and valid_msg rise together. Without PARSER_BACK_TO_BACK a
+    // D message's last byte is not stored, so its order_ref_no is wrong here as in valid_msg.
+    always_ff @(posedge clk or posedge rst) begin
+        if (rst)
+            early_valid <= 1'b0;
+        else
+            early_valid <= valid && !start_msg && !message_invalid && count_en && (byte_idx == 6'd18);
+    end
+`endif
+
+`ifdef PARSER_INSTRUMENT
+    logic [63:0] cycle_count;  // free-running, cleared only by rst
+    logic [63:0] start_cycle;  // cycle_count at the current message's start_msg
+
+    always_ff @(posedge clk or posedge rst) begin
+        if (rst) begin
+            cycle_count <= 64'd0;
+            start_cycle <= 64'd0;
+            first_cycle <= 64'd0;
+            done_cycle <= 64'd0;
+        end else begin
+            cycle_count <= cycle_count + 64'd1;
+            if (start_msg && valid)
+                start_cycle <= cycle_count;
+            // Same condition that raises valid_msg; start_cycle is read before a start_msg in
+            // this cycle can overwrite it
+            if (msg_done) begin
+                first_cycle <= start_cycle;
+                done_cycle <= cycle_count;
+            end
+        end
+    end
+`endif
+
 endmodule
@@ -0,0 +1,197 @@
+`timescale 1ns / 1ps
+
+
+// 64-bit AXI4-Stream variant of parser: eight bytes per clock instead of one, with the same
+// output registers.
+//
+// The stream carries length-prefixed message blocks, as in a Nasdaq BinaryFILE or the payload
+// of a MoldUDP64 packet: a 2-byte big-endian length, then the message. Byte lane 0
+// (s_axis_tdata[7:0]) comes first, and lanes whose tkeep bit is low are skipped wherever they
+// are in the beat. Blocks run on across beats with no alignment, so one message can finish and
+// the next start in the same beat. Messages of other types, or whose length does not match
+// their type, are skipped, and so are empty blocks. s_axis_tlast ends a packet; a block it cuts
+// short is dropped and the next beat starts a new block.
+//
+// valid_msg rises for one cycle on the clock after the beat holding a message's last byte, with
+// the message's fields in the output registers, which then hold until the next message
+// completes. A supported block is at least 21 bytes, so at most one completes per beat and the
+// parser never stalls: s_axis_tready is always high.
+module parser_axis (
+    input logic        clk,
+    input logic        rst,
+
+    input  logic [63:0] s_axis_tdata,   // Eight message bytes, lane 0 first
+    input  logic [7:0]  s_axis_tkeep,   // Lanes that hold a byte
+    input  logic        s_axis_tlast,   // Last beat of a packet
+    input  logic        s_axis_tvalid,  // The beat is valid
+    output logic        s_axis_tready,  // Always high
+
+    // All message types (A, E, X, D, U, F)
+    output logic valid_msg,  // Single bit which indicates whether the entire message is valid
+    output logic [7:0] msg_type,  // Stores which type of market action the current message encodes
+    output logic [15:0] stock_locate,  // Locate code identifying the security
+    output logic [15:0] tracking_no,  // Nasdaq internal tracking number
+    output logic [47:0] timestamp,  // Nanoseconds since midnight
+    output logic [63:0] order_ref_no, // The unique reference number assigned to the order at the time of receipt
+
+    // Add Order (A), Order Executed Message (E), Order Cancel Message (X), Order Replace Message (U), Add Order with MPID Attribution Message (F) only
+    output logic [31:0] shares,  // The total number of shares associated with the order
+
+    // Add Order (A) only, Order Replace Message (U) only, Add Order with MPID Attribution Message (F) only
+    output logic [31:0] price,  // The display price of the new order
+
+    // Add Order (A) and Add Order with MPID Attribution Message (F) only
+    output logic [7:0] buy_sell, // The type of order being added. “B” = Buy Order. “S” = SellOrder
+    output logic [63:0] stock,  // Stock symbol, right padded with spaces
+
+    // Order Executed Message (E) only
+    output logic [63:0] match_no,  // The Nasdaq generated day unique Match Number of this execution
+
+    // Order Replace Message (U) only
+    output logic[63:0] new_order_ref_no,  // The unique reference number assigned to the new order at the time of receipt
+
+    // Add Order with MPID Attribution Message (F) only
+    output logic[31:0] attribution  // Nasdaq Market participant identifier associated with the entered order
+);
+
+    localparam int MAX_LEN = 40;  // longest supported message (F)
+
+    logic [7:0]  msg_buf [MAX_LEN];  // message bytes of the block in progress
+    logic [16:0] blk_pos;  // index in the block of the next byte: 0 and 1 are the length prefix
+    logic [15:0] blk_len;  // message length from the prefix
+
+    // Length of a supported message type, 0 for any other
+    function automatic logic [15:0] msg_length(input logic [7:0] t);
+        case (t)
+            8'h41:   return 16'd36;
+            8'h44:   return 16'd19;
+            8'h45:   return 16'd31;
+            8'h46:   return 16'd40;
+            8'h55:   return 16'd35;
+            8'h58:   return 16'd23;
+            default: return 16'd0;
+        endcase
+    endfunction
+
+    // The beat is taken lane by lane. done_buf is the message buffer as it stands after the last
+    // byte of a message that completes in this beat, before the next block's bytes reuse it.
+    logic [7:0]  buf_n [MAX_LEN];
+    logic [7:0]  done_buf [MAX_LEN];
+    logic [16:0] pos_n;
+    logic [15:0] len_n;
+    logic        done;  // a supported message completes in this beat
+
+    always_comb begin
+        buf_n = msg_buf;
+        done_buf = msg_buf;
+        pos_n = blk_pos;
+        len_n = blk_len;
+        done = 1'b0;
+        if (s_axis_tvalid) begin
+            for (int j = 0; j < 8; j++) begin
+                if (s_axis_tkeep[j]) begin
+                    if (pos_n == 17'd0) begin
+                        len_n[15:8] = s_axis_tdata[8*j +: 8];
+                        pos_n = 17'd1;
+                    end else if (pos_n == 17'd1) begin
+                        len_n[7:0] = s_axis_tdata[8*j +: 8];
+                        pos_n = (len_n == 16'd0) ? 17'd0 : 17'd2;  // an empty block is skipped
+                    end else begin
+                        if (pos_n < 17'(MAX_LEN + 2))
+                            buf_n[6'(pos_n - 17'd2)] = s_axis_tdata[8*j +: 8];
+                        if (pos_n == {1'b0, len_n} + 17'd1) begin
+                            // Last byte of the block; emit it if the type and length are supported
+                            if (len_n == msg_length(buf_n[0])) begin
+                                done = 1'b1;
+                                done_buf = buf_n;
+                            end
+                            pos_n = 17'd0;
+                        end else begin
+                            pos_n = pos_n + 17'd1;
+                        end
+                    end
+                end
+            end
+            if (s_axis_tlast)
+                pos_n = 17'd0;  // Drop a block the packet cut short
+        end
+    end
+
+    assign s_axis_tready = 1'b1;
+
+    always_ff @(posedge clk or posedge rst) begin
+
+        if (rst) begin
+            for (int i = 0; i < MAX_LEN; i++)
+                msg_buf[i] <= 8'd0;
+            blk_pos <= 17'd0;
+            blk_len <= 16'd0;
+            valid_msg <= 1'd0;
+            msg_type <= 8'd0;
+            stock_locate <= 16'd0;
+            tracking_no <= 16'd0;
+            timestamp <= 48'd0;
+            order_ref_no <= 64'd0;
+            shares <= 32'd0;
+            buy_sell <= 8'd0;
+            stock <= 64'd0;
+            price <= 32'd0;
+            match_no <= 64'd0;
+            new_order_ref_no <= 64'd0;
+            attribution <= 32'd0;
+        end else begin
+            msg_buf <= buf_n;
+            blk_pos <= pos_n;
+            blk_len <= len_n;
+            valid_msg <= done;
+
+            if (done) begin
+                // Fields every type carries
+                msg_type <= done_buf[0];
+                stock_locate <= {done_buf[1], done_buf[2]};
+                tracking_no <= {done_buf[3], done_buf[4]};
+                timestamp <= {done_buf[5], done_buf[6], done_buf[7], done_buf[8], done_buf[9], done_buf[10]};
+                order_ref_no <= {done_buf[11], done_buf[12], done_buf[13], done_buf[14],
+                                 done_buf[15], done_buf[16], done_buf[17], done_buf[18]};
+
+                // Sentinel values for the fields the type does not carry
+                shares <= 32'd0;
+                buy_sell <= 8'd0;
+                stock <= 64'd0;
+                price <= 32'd0;
+                match_no <= 64'd0;
+                new_order_ref_no <= 64'd0;
+                attribution <= 32'd0;
+
+                case (done_buf[0])
+                    8'h41, 8'h46: begin
+                        buy_sell <= done_buf[19];
+                        shares <= {done_buf[20], done_buf[21], done_buf[22], done_buf[23]};
+                        stock <= {done_buf[24], done_buf[25], done_buf[26], done_buf[27],
+                                  done_buf[28], done_buf[29], done_buf[30], done_buf[31]};
+                        price <= {done_buf[32], done_buf[33], done_buf[34], done_buf[35]};
+                        if (done_buf[0] == 8'h46)
+                            attribution <= {done_buf[36], done_buf[37], done_buf[38], done_buf[39]};
+                    end
+                    8'h45: begin
+                        shares <= {done_buf[19], done_buf[20], done_buf[21], done_buf[22]};
+                        match_no <= {done_buf[23], done_buf[24], done_buf[25], done_buf[26],
+                                     done_buf[27], done_buf[28], done_buf[29], done_buf[30]};
+                    end
+                    8'h58: begin
+                        shares <= {done_buf[19], done_buf[20], done_buf[21], done_buf[22]};
+                    end
+                    8'h55: begin
+                        new_order_ref_no <= {done_buf[19], done_buf[20], done_buf[21], done_buf[22],
+                                             done_buf[23], done_buf[24], done_buf[25], done_buf[26]};
+                        shares <= {done_buf[27], done_buf[28], done_buf[29], done_buf[30]};
+                        price <= {done_buf[31], done_buf[32], done_buf[33], done_buf[34]};
+                    end
+                    default: ;
+                endcase
+            end
+        end
+
+    end
+
+endmodule
@@ -0,0 +1,334 @@
+// Cycle-accurate testbench for the 64-bit AXI-Stream parser (parser_axis.sv) against the
+// byte-serial parser (parser.sv), both built with Verilator.
+//
+// Random traffic (A/F/E/X/D/U mixed with other ITCH 5.0 types, which both modules skip) is cut
+// into packets of length-prefixed message blocks. The packets go through parser_axis eight
+// bytes per beat, and their messages go through parser one byte per clock, back to back. Each
+// module's valid_msg records must equal itch_decode_framed() on the same packets, in order, and
+// each other record by record.
+// There are three runs:
+//   line rate   one packet, every beat full, tvalid always high
+//   packets     packets of up to 1500 bytes ending in tlast with a partial last beat; one in
+//               eight ends with a message cut short, which both modules must drop
+//   throttled   the same packets with tvalid low on a quarter of the cycles and null lanes
+//               (tkeep low, garbage in tdata) in random places
+// Reported per run: messages, cycles and cycles per message for each module, input bytes per
+// cycle, message rate at the 156.25 MHz clock of a 64-bit 10GbE MAC interface, and the cycles
+// from the beat holding a message's last byte to its valid_msg, which must be 1. Each run must
+// also cover the cases parser_axis handles lane by lane: a message ending in each of the 8
+// lanes, a beat in which the next block's bytes follow a finished message (so its fields come
+// from the done_buf snapshot, not the reused buffer), and, with cut packets, tlast dropping a
+// block cut short.
+//
+// Build: make -f verilator.mk parser_axis_tb (binary in obj_verilator/parser_axis_tb/), which runs
+//        verilator --cc -O3 -Wno-fatal +define+PARSER_BACK_TO_BACK --prefix Vparser --Mdir <serial> parser.sv
+//        make -C <serial> -f Vparser.mk Vparser__ALL.a
+//        verilator --cc --exe --build -O3 -Wno-fatal -CFLAGS "-O2 -I<repo> -I<serial>"
+//            -LDFLAGS <serial>/Vparser__ALL.a parser_axis.sv parser_axis_tb.cpp itch_decoder.cpp
+// (parser.sv is built on its own, with its own prefix, so that both models link into one binary)
+// Usage: ./obj_verilator/parser_axis_tb/Vparser_axis [messages=100000]
+// Not yet built with Verilator (none was available where it was written); so far it has only
+// been compiled against hand-written C++ stand-ins for Vparser and Vparser_axis.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "verilated.h"
+#include "Vparser.h"
+#include "Vparser_axis.h"
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+
+// Clock of a 64-bit 10GbE MAC interface: 8 bytes x 156.25 MHz = 10 Gb/s
+#define MAC_MHZ 156.25
+
+#define MAX_PACKET 1500
+#define DRAIN_CYCLES 8
+
+// One packet: length-prefixed blocks, the last possibly cut short
+struct Packet {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> blocks;     // offset of each block's length prefix
+};
+
+struct Beat {
+    uint64_t tdata;
+    uint8_t tkeep;
+    bool tlast;
+    bool completes;                 // holds the last byte of a message that must be emitted
+    int done_lane;                  // lane of that byte, -1 if none
+    bool reuses;                    // the next block's message bytes follow it in the same beat
+    bool drops;                     // tlast cuts a block short
+};
+
+// Beats that exercise each lane-by-lane case
+struct Coverage {
+    size_t done_lanes[8];
+    size_t reuses;
+    size_t drops;
+};
+
+struct RunResult {
+    uint64_t cycles;
+    std::vector<ParserOutput> out;
+    int min_latency, max_latency;
+};
+
+template <typename Top>
+static void tick(VerilatedContext& ctx, Top& top) {
+    top.clk = 0;
+    top.eval();
+    ctx.timeInc(1);
+    top.clk = 1;
+    top.eval();
+    ctx.timeInc(1);
+}
+
+template <typename Top>
+static ParserOutput sample(const Top& top) {
+    ParserOutput o = {};
+    o.valid_msg = top.valid_msg;
+    o.msg_type = top.msg_type;
+    o.stock_locate = top.stock_locate;
+    o.tracking_no = top.tracking_no;
+    o.timestamp = top.timestamp;
+    o.order_ref_no = top.order_ref_no;
+    o.shares = top.shares;
+    o.buy_sell = top.buy_sell;
+    o.stock = top.stock;
+    o.price = top.price;
+    o.match_no = top.match_no;
+    o.new_order_ref_no = top.new_order_ref_no;
+    o.attribution = top.attribution;
+    return o;
+}
+
+static std::vector<Packet> make_packets(int num_messages, bool single, bool cut) {
+    std::vector<Packet> packets(1);
+    for (int i = 0; i < num_messages; i++) {
+        std::vector<uint8_t> msg;
+        if (next_rand() % 16 == 0) append_random_spec_message(msg);
+        else append_random_message(msg);
+        Packet* p = &packets.back();
+        if (!single && p->bytes.size() + ITCH_LENGTH_PREFIX + msg.size() > MAX_PACKET) {
+            packets.emplace_back();
+            p = &packets.back();
+        }
+        p->blocks.push_back(p->bytes.size());
+        put_be(p->bytes, msg.size(), ITCH_LENGTH_PREFIX);
+        p->bytes.insert(p->bytes.end(), msg.begin(), msg.end());
+    }
+    if (cut) {
+        for (Packet& p : packets) {
+            if (next_rand() % 8 != 0) continue;
+            size_t last = p.blocks.back();
+            p.bytes.resize(last + 1 + next_rand() % (p.bytes.size() - last - 1));
+        }
+    }
+    return packets;
+}
+
+// The block at `at` is whole and holds a message the modules emit
+static bool emitted(const Packet& p, size_t at) {
+    size_t len = ((size_t)p.bytes[at] << 8) | p.bytes[at + 1];
+    return at + ITCH_LENGTH_PREFIX + len <= p.bytes.size() && len > 0 &&
+           (size_t)itch_msg_length(p.bytes[at + ITCH_LENGTH_PREFIX]) == len;
+}
+
+static std::vector<Beat> make_beats(const std::vector<Packet>& packets, bool sparse) {
+    std::vector<Beat> beats;
+    for (const Packet& p : packets) {
+        // Byte offsets at which an emitted message ends, and those holding message bytes
+        std::vector<char> ends(p.bytes.size() + 1, 0);
+        std::vector<char> body(p.bytes.size(), 0);
+        for (size_t at : p.blocks) {
+            if (emitted(p, at)) ends[at + ITCH_LENGTH_PREFIX + itch_msg_length(p.bytes[at + ITCH_LENGTH_PREFIX]) - 1] = 1;
+            for (size_t i = at + ITCH_LENGTH_PREFIX; i < p.bytes.size() && i < at + ITCH_LENGTH_PREFIX + ITCH_MAX_MSG_LEN; i++) body[i] = 1;
+        }
+        size_t last = p.blocks.back();
+        bool cut = last + ITCH_LENGTH_PREFIX > p.bytes.size() ||
+                   last + ITCH_LENGTH_PREFIX + (((size_t)p.bytes[last] << 8) | p.bytes[last + 1]) > p.bytes.size();
+        size_t pos = 0;
+        while (pos < p.bytes.size()) {
+            Beat b = {0, 0, false, false, -1, false, false};
+            for (int lane = 0; lane < 8; lane++) {
+                if (pos < p.bytes.size() && !(sparse && next_rand() % 8 == 0)) {
+                    b.tdata |= (uint64_t)p.bytes[pos] << (8 * lane);
+                    b.tkeep |= 1 << lane;
+                    b.reuses |= b.completes && body[pos];
+                    if (ends[pos]) {
+                        b.completes = true;
+                        b.done_lane = lane;
+                    }
+                    pos++;
+                } else {
+                    b.tdata |= (uint64_t)(uint8_t)next_rand() << (8 * lane);
+                }
+            }
+            b.tlast = pos == p.bytes.size();
+            b.drops = b.tlast && cut;
+            beats.push_back(b);
+        }
+    }
+    return beats;
+}
+
+static Coverage coverage(const std::vector<Beat>& beats) {
+    Coverage c = {};
+    for (const Beat& b : beats) {
+        if (b.done_lane >= 0) c.done_lanes[b.done_lane]++;
+        c.reuses += b.reuses;
+        c.drops += b.drops;
+    }
+    return c;
+}
+
+static RunResult run_axis(VerilatedContext& ctx, Vparser_axis& top, const std::vector<Beat>& beats, bool throttle) {
+    RunResult r = {0, {}, 1 << 30, 0};
+    top.rst = 1;
+    top.s_axis_tvalid = 0;
+    tick(ctx, top);
+    tick(ctx, top);
+    top.rst = 0;
+
+    std::deque<uint64_t> pending;   // cycles of beats that complete a message
+    auto clock = [&] {
+        tick(ctx, top);
+        r.cycles++;
+        if (!top.valid_msg) return;
+        r.out.push_back(sample(top));
+        if (pending.empty()) return;
+        int latency = (int)(r.cycles - pending.front());
+        pending.pop_front();
+        r.min_latency = latency < r.min_latency ? latency : r.min_latency;
+        r.max_latency = latency > r.max_latency ? latency : r.max_latency;
+    };
+    for (const Beat& b : beats) {
+        while (throttle && next_rand() % 4 == 0) {
+            top.s_axis_tvalid = 0;
+            clock();
+        }
+        top.s_axis_tvalid = 1;
+        top.s_axis_tdata = b.tdata;
+        top.s_axis_tkeep = b.tkeep;
+        top.s_axis_tlast = b.tlast;
+        if (b.completes) pending.push_back(r.cycles);
+        clock();
+    }
+    top.s_axis_tvalid = 0;
+    for (int i = 0; i < DRAIN_CYCLES; i++) clock();
+    if (r.min_latency > r.max_latency) r.min_latency = r.max_latency = 0;
+    return r;
+}
+
+// Every message body, whole or cut short, back to back with start_msg on its first byte
+static RunResult run_serial(VerilatedContext& ctx, Vparser& top, const std::vector<Packet>& packets) {
+    RunResult r = {0, {}, 0, 0};
+    top.rst = 1;
+    top.valid = 0;
+    top.start_msg = 0;
+    tick(ctx, top);
+    tick(ctx, top);
+    top.rst = 0;
+
+    auto clock = [&] {
+        tick(ctx, top);
+        r.cycles++;
+        if (top.valid_msg) r.out.push_back(sample(top));
+    };
+    for (const Packet& p : packets) {
+        for (size_t i = 0; i < p.blocks.size(); i++) {
+            size_t body = p.blocks[i] + ITCH_LENGTH_PREFIX;
+            size_t end = i + 1 < p.blocks.size() ? p.blocks[i + 1] : p.bytes.size();
+            for (size_t j = body; j < end; j++) {
+                top.valid = 1;
+                top.start_msg = j == body;
+                top.message = p.bytes[j];
+                clock();
+            }
+        }
+    }
+    top.valid = 0;
+    top.start_msg = 0;
+    for (int i = 0; i < DRAIN_CYCLES; i++) clock();
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int num_messages = argc > 1 ? atoi(argv[1]) : 100000;
+    if (num_messages < 1) {
+        printf("Usage: %s [messages, default 100000]\n", argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<VerilatedContext> ctx(new VerilatedContext);
+    ctx->commandArgs(argc, argv);
+    std::unique_ptr<Vparser_axis> axis(new Vparser_axis(ctx.get()));
+    std::unique_ptr<Vparser> serial(new Vparser(ctx.get()));
+
+    struct Case {
+        const char* name;
+        bool single, cut, throttle;
+    };
+    static const Case kCases[] = {
+        {"line rate", true, false, false},
+        {"packets", false, true, false},
+        {"throttled", false, true, true},
+    };
+
+    printf("parser_axis vs parser: %d messages per run, 1 in 16 of a type both skip\n", num_messages);
+    printf("%-10s %9s %12s %10s %12s %10s %9s %10s %12s %8s %6s\n", "", "messages", "axis cycles", "axis c/msg",
+           "serial cyc", "serial c/m", "speedup", "bytes/cyc", "Mmsg/s@MAC", "latency", "check");
+
+    int errors = 0;
+    for (const Case& c : kCases) {
+        std::vector<Packet> packets = make_packets(num_messages, c.single, c.cut);
+        std::vector<Beat> beats = make_beats(packets, c.throttle);
+
+        std::vector<ParserOutput> expect;
+        size_t bytes = 0;
+        for (const Packet& p : packets) {
+            std::vector<ParserOutput> out(p.bytes.size() / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1);
+            size_t consumed = 0;
+            size_t n = itch_decode_framed(p.bytes.data(), p.bytes.size(), out.data(), out.size(), &consumed);
+            expect.insert(expect.end(), out.begin(), out.begin() + n);
+            bytes += p.bytes.size();
+        }
+
+        RunResult a = run_axis(*ctx, *axis, beats, c.throttle);
+        RunResult s = run_serial(*ctx, *serial, packets);
+        int bad = compare_outputs("  parser_axis", a.out.data(), (int)a.out.size(), expect.data(), (int)expect.size());
+        bad += compare_outputs("  parser", s.out.data(), (int)s.out.size(), expect.data(), (int)expect.size());
+        bad += compare_outputs("  parser_axis vs parser", a.out.data(), (int)a.out.size(), s.out.data(), (int)s.out.size());
+        if (!expect.empty() && (a.min_latency != 1 || a.max_latency != 1)) {
+            printf("  parser_axis: valid_msg %d-%d cycles after the last beat, expected 1\n", a.min_latency, a.max_latency);
+            bad++;
+        }
+        Coverage cov = coverage(beats);
+        int lanes = 0;
+        for (int lane = 0; lane < 8; lane++) lanes += cov.done_lanes[lane] > 0;
+        if (lanes < 8 || cov.reuses == 0 || (c.cut && cov.drops == 0)) {
+            printf("  not covered: messages end in %d of 8 lanes, %zu beats reuse the buffer, %zu blocks dropped by tlast\n",
+                   lanes, cov.reuses, cov.drops);
+            bad++;
+        }
+        errors += bad;
+
+        double n = (double)expect.size();
+        printf("%-10s %9zu %12llu %10.2f %12llu %10.2f %8.2fx %10.2f %12.2f %4d-%-3d %6s\n", c.name, expect.size(),
+               (unsigned long long)a.cycles, a.cycles / n, (unsigned long long)s.cycles, s.cycles / n,
+               (double)s.cycles / a.cycles, (double)bytes / a.cycles, n / a.cycles * MAC_MHZ, a.min_latency,
+               a.max_latency, bad ? "FAIL" : "ok");
+        printf("  messages ending in lanes 0-7:");
+        for (int lane = 0; lane < 8; lane++) printf(" %zu", cov.done_lanes[lane]);
+        printf("; done_buf beats %zu; tlast drops %zu\n", cov.reuses, cov.drops);
+    }
+
+    axis->final();
+    serial->final();
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+#include <stdint.h>
+#include <ap_int.h>
+#include <hls_stream.h>
+#include "parser_dataflow.h"
+
+// FIFO depths between stages. parser_dataflow_tb.cpp reports a peak occupancy of 1 for the
+// first two and 12 for the outputs when the writer stalls 256 cycles every 64 records.
+#define FRAMED_FIFO_DEPTH  2
+#define MSG_FIFO_DEPTH     2
+#define OUTPUT_FIFO_DEPTH  16
+
+// Stage 1: reads ByteData from gmem0 and forwards only bytes of messages worth parsing
+static void framer(const ByteData* input_stream, int num_bytes, hls::stream<FramedByte>& bytes_out) {
+    FramerState state = {false};
+    FRAME_BYTES: for (int i = 0; i < num_bytes; i++) {
+        #pragma HLS PIPELINE II=1
+        FramedByte fb;
+        if (frame_byte(state, input_stream[i], fb)) bytes_out.write(fb);
+    }
+    FramedByte eos = {0, false, false, true};
+    bytes_out.write(eos);
+}
+
+// Stage 2: collects each message's bytes into a fixed-width buffer
+static void assembler(hls::stream<FramedByte>& bytes_in, hls::stream<MsgToken>& msgs_out) {
+    AssemblerState state;
+    state.msg = 0;
+    state.idx = 0;
+    ASSEMBLE: while (true) {
+        #pragma HLS PIPELINE II=1
+        FramedByte fb = bytes_in.read();
+        if (fb.eos) break;
+        MsgToken token;
+        token.eos = false;
+        if (assemble_byte(state, fb, token.msg)) msgs_out.write(token);
+    }
+    MsgToken eos;
+    eos.msg = 0;
+    eos.eos = true;
+    msgs_out.write(eos);
+}
+
+// Stage 2 of parser_dataflow_early: as assembler(), and also writes an EarlyNotify to early_out on
+// the byte that completes each message's order_ref_no
+static void assembler_early(hls::stream<FramedByte>& bytes_in, hls::stream<MsgToken>& msgs_out,
+                            hls::stream<EarlyNotify>& early_out) {
+    AssemblerState state;
+    state.msg = 0;
+    state.idx = 0;
+    ASSEMBLE: while (true) {
+        #pragma HLS PIPELINE II=1
+        FramedByte fb = bytes_in.read();
+        if (fb.eos) break;
+        MsgToken token;
+        token.eos = false;
+        bool done = assemble_byte(state, fb, token.msg);
+        EarlyNotify early;
+        if (early_notify(state, early)) early_out.write(early);
+        if (done) msgs_out.write(token);
+    }
+    MsgToken eos;
+    eos.msg = 0;
+    eos.eos = true;
+    msgs_out.write(eos);
+}
+
+// Stage 3: extracts every field of a message in parallel
+static void field_extractor(hls::stream<MsgToken>& msgs_in, hls::stream<OutputToken>& outputs_out) {
+    EXTRACT: while (true) {
+        #pragma HLS PIPELINE II=1
+        MsgToken token = msgs_in.read();
+        OutputToken out;
+        out.eos = token.eos;
+        decode_message(token.msg, out.out);
+        outputs_out.write(out);
+        if (token.eos) break;
+    }
+}
+
+// Stage 4: writes records to gmem1 in order, so the accesses are inferred as bursts
+static void burst_writer(hls::stream<OutputToken>& outputs_in, ParserOutput* output_stream, int* num_outputs) {
+    int output_count = 0;
+    WRITE: while (true) {
+        #pragma HLS PIPELINE II=1
+        OutputToken token = outputs_in.read();
+        if (token.eos) break;
+        output_stream[output_count] = token.out;
+        output_count++;
+    }
+    *num_outputs = output_count;
+}
+
+extern "C" {
+void parser_dataflow(
+    // Input: stream of bytes to process
+    const ByteData* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages
+    ParserOutput* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+    #pragma HLS DATAFLOW
+
+    hls::stream<FramedByte> framed_bytes("framed_bytes");
+    hls::stream<MsgToken> messages("messages");
+    hls::stream<OutputToken> outputs("outputs");
+    #pragma HLS STREAM variable=framed_bytes depth=FRAMED_FIFO_DEPTH
+    #pragma HLS STREAM variable=messages depth=MSG_FIFO_DEPTH
+    #pragma HLS STREAM variable=outputs depth=OUTPUT_FIFO_DEPTH
+
+    framer(input_stream, num_bytes, framed_bytes);
+    assembler(framed_bytes, messages);
+    field_extractor(messages, outputs);
+    burst_writer(outputs, output_stream, num_outputs);
+}
+
+// parser_dataflow with a cut-through output: besides the records, early_out (an AXI-Stream port,
+// for a downstream kernel such as an order book) carries an EarlyNotify for every message as soon
+// as its order_ref_no is complete, up to 21 bytes before the record
+void parser_dataflow_early(
+    const ByteData* input_stream,
+    int num_bytes,
+    ParserOutput* output_stream,
+    int* num_outputs,
+    hls::stream<EarlyNotify>& early_out
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE axis port=early_out
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+    #pragma HLS DATAFLOW
+
+    hls::stream<FramedByte> framed_bytes("framed_bytes");
+    hls::stream<MsgToken> messages("messages");
+    hls::stream<OutputToken> outputs("outputs");
+    #pragma HLS STREAM variable=framed_bytes depth=FRAMED_FIFO_DEPTH
+    #pragma HLS STREAM variable=messages depth=MSG_FIFO_DEPTH
+    #pragma HLS STREAM variable=outputs depth=OUTPUT_FIFO_DEPTH
+
+    framer(input_stream, num_bytes, framed_bytes);
+    assembler_early(framed_bytes, messages, early_out);
+    field_extractor(messages, outputs);
+    burst_writer(outputs, output_stream, num_outputs);
+}
+}
@@ -0,0 +1,115 @@
+#ifndef PARSER_DATAFLOW_H
+#define PARSER_DATAFLOW_H
+
+#include <stdint.h>
+#include <ap_int.h>
+#include <hls_stream.h>
+#include "itch.h"
+#include "parser_wide.h"
+
+// Per-token logic of the DATAFLOW parser stages. Each function handles exactly one input
+// token, so the same code drives the kernel's stage loops and the cycle model in
+// parser_dataflow_tb.cpp.
+
+// Framer -> assembler: one byte that belongs to a message still worth parsing
+struct FramedByte {
+    uint8_t data;
+    bool start;   // first byte (message type)
+    bool end;     // last byte of a message that is still valid
+    bool eos;     // end of input, no data
+};
+
+// Assembler -> field extractor: one complete message, type byte in bits [7:0]
+struct MsgToken {
+    msg_buf_t msg;
+    bool eos;
+};
+
+// Field extractor -> burst writer
+struct OutputToken {
+    ParserOutput out;
+    bool eos;
+};
+
+// Framing and boundary detection. Drops bytes outside messages and every byte of a message
+// once it turns invalid (unsupported type or an invalid byte), so only messages that can still
+// produce an output reach the assembler.
+struct FramerState {
+    bool in_msg;
+};
+
+static bool frame_byte(FramerState& state, const ByteData& byte_in, FramedByte& out) {
+    #pragma HLS INLINE
+    out.data = byte_in.data;
+    out.start = false;
+    out.end = false;
+    out.eos = false;
+
+    if (byte_in.start_msg && byte_in.valid) {
+        state.in_msg = itch_msg_length(byte_in.data) != 0;
+        out.start = true;
+    } else if (!byte_in.valid) {
+        state.in_msg = false;
+    }
+
+    bool forward = state.in_msg;
+    if (forward && byte_in.end_msg) {
+        out.end = true;
+        state.in_msg = false;
+    }
+    return forward;
+}
+
+// Message assembly into a fixed-width buffer. A message can run past its type's length when
+// end_msg comes late. parser() stops its byte index on the type's last field byte then, so every
+// extra byte overwrites that one, except for D, whose index stops one past its last field. The
+// assembler stores extra bytes the same way, so both keep the same record.
+struct AssemblerState {
+    msg_buf_t msg;
+    int idx;      // bytes received, up to ITCH_MAX_MSG_LEN
+};
+
+static bool assemble_byte(AssemblerState& state, const FramedByte& byte_in, msg_buf_t& out) {
+    #pragma HLS INLINE
+    if (byte_in.start) {
+        state.msg = 0;
+        state.idx = 0;
+    }
+    uint8_t msg_type = byte_in.start ? byte_in.data : (uint8_t)state.msg.range(7, 0);
+    int len = itch_msg_length(msg_type);
+    int pos = state.idx;
+    if (pos >= len) pos = msg_type == ITCH_ORDER_DELETE ? ITCH_MAX_MSG_LEN : len - 1;
+    if (pos < ITCH_MAX_MSG_LEN) state.msg.range(8 * pos + 7, 8 * pos) = byte_in.data;
+    if (state.idx < ITCH_MAX_MSG_LEN) state.idx++;
+    out = state.msg;
+    return byte_in.end;
+}
+
+// Bytes up to and including order_ref_no, at the same offsets in every supported type
+#define EARLY_NOTIFY_BYTES 19
+
+// Assembler -> downstream, ahead of the record: the header and order_ref_no of a message as soon
+// as its first EARLY_NOTIFY_BYTES bytes are in, so an order book can start its lookup while the
+// rest arrives. Speculative: if the message turns invalid later it gets no record, and the next
+// notification supersedes this one.
+struct EarlyNotify {
+    uint8_t  msg_type;
+    uint16_t stock_locate;
+    uint16_t tracking_no;
+    uint64_t timestamp;
+    uint64_t order_ref_no;
+};
+
+// Called after assemble_byte(); true on the byte that completes order_ref_no. For a D message
+// that byte is also the last, so the notification and the record leave the assembler together.
+static bool early_notify(const AssemblerState& state, EarlyNotify& out) {
+    #pragma HLS INLINE
+    out.msg_type = (uint8_t)be_field<1>(state.msg, 0);
+    out.stock_locate = (uint16_t)be_field<2>(state.msg, 1);
+    out.tracking_no = (uint16_t)be_field<2>(state.msg, 3);
+    out.timestamp = be_field<6>(state.msg, 5);
+    out.order_ref_no = be_field<8>(state.msg, 11);
+    return state.idx == EARLY_NOTIFY_BYTES;
+}
+
+#endif
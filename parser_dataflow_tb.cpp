@@ -0,0 +1,245 @@
+// C-simulation testbench for the DATAFLOW parser.
+// 1. Runs parser_dataflow() and the byte-serial parser() from Archive/parser.cpp over the
+//    same ByteData stream (with invalid bytes, unsupported types and garbage between
+//    messages mixed in) and checks that the outputs match exactly.
+// 2. Replays the stream through a cycle model built from the same per-token stage functions,
+//    and reports throughput and the peak occupancy of each FIFO. This is the depth each
+//    stream needs so that no stage ever stalls on a full FIFO.
+// 3. Runs parser_dataflow_early() on the same stream: its records must match too, and every
+//    record must follow an EarlyNotify with its header and order_ref_no. The cycle model reports
+//    how many cycles each message type's notification leads its record.
+// 4. Runs both kernels over messages whose end_msg comes up to 16 bytes late, past the longest
+//    type as well, where the extra bytes overwrite the last field byte as parser() does.
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -o parser_dataflow_tb parser_dataflow_tb.cpp parser_dataflow.cpp Archive/parser.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "parser_dataflow.h"
+#include "itch_testgen.h"
+
+extern "C" void parser(const ByteData* input_stream, int num_bytes,
+                       ParserOutput* output_stream, int* num_outputs);
+extern "C" void parser_dataflow(const ByteData* input_stream, int num_bytes,
+                                ParserOutput* output_stream, int* num_outputs);
+extern "C" void parser_dataflow_early(const ByteData* input_stream, int num_bytes,
+                                      ParserOutput* output_stream, int* num_outputs,
+                                      hls::stream<EarlyNotify>& early_out);
+
+// Unbounded FIFO that remembers its peak occupancy
+template <typename T>
+struct ModelFifo {
+    std::deque<T> q;
+    size_t peak = 0;
+    void push(const T& v) { q.push_back(v); if (q.size() > peak) peak = q.size(); }
+    T pop() { T v = q.front(); q.pop_front(); return v; }
+};
+
+struct ModelResult {
+    long cycles;
+    int outputs;
+    size_t framed_peak, msg_peak, output_peak;
+    long early_lead[256];       // cycles from EarlyNotify to the record leaving the extractor,
+    int early_count[256];       // summed per message type
+};
+
+// Steps every stage once per cycle, downstream first, so a token moves at most one stage per cycle.
+// The writer needs `write_cycles` per record and pauses `stall_cycles` after every `stall_every`
+// records, standing in for write-response latency and memory refresh on gmem1.
+static ModelResult run_cycle_model(const std::vector<ByteData>& input, int write_cycles,
+                                   int stall_every, int stall_cycles) {
+    ModelFifo<FramedByte> framed;
+    ModelFifo<msg_buf_t> msgs;
+    ModelFifo<ParserOutput> outputs;
+    FramerState framer = {false};
+    AssemblerState assembler;
+    assembler.msg = 0;
+    assembler.idx = 0;
+
+    ModelResult r = {0, 0, 0, 0, 0, {0}, {0}};
+    size_t next_byte = 0;
+    int writer_busy = 0;
+    long early_cycle = -1;      // cycle of the latest EarlyNotify not yet matched by a record
+
+    while (next_byte < input.size() || !framed.q.empty() || !msgs.q.empty() ||
+           !outputs.q.empty() || writer_busy > 0) {
+        // Burst writer
+        if (writer_busy > 0) {
+            writer_busy--;
+        } else if (!outputs.q.empty()) {
+            outputs.pop();
+            r.outputs++;
+            writer_busy = write_cycles - 1;
+            if (stall_every > 0 && r.outputs % stall_every == 0) writer_busy += stall_cycles;
+        }
+        // Field extractor
+        if (!msgs.q.empty()) {
+            ParserOutput out;
+            decode_message(msgs.pop(), out);
+            outputs.push(out);
+            if (early_cycle >= 0) {
+                r.early_lead[out.msg_type] += r.cycles - early_cycle;
+                r.early_count[out.msg_type]++;
+                early_cycle = -1;
+            }
+        }
+        // Assembler
+        if (!framed.q.empty()) {
+            msg_buf_t msg;
+            bool done = assemble_byte(assembler, framed.pop(), msg);
+            EarlyNotify early;
+            if (early_notify(assembler, early)) early_cycle = r.cycles;
+            if (done) msgs.push(msg);
+        }
+        // Framer
+        if (next_byte < input.size()) {
+            FramedByte fb;
+            if (frame_byte(framer, input[next_byte], fb)) framed.push(fb);
+            next_byte++;
+        }
+        r.cycles++;
+    }
+
+    r.framed_peak = framed.peak;
+    r.msg_peak = msgs.peak;
+    r.output_peak = outputs.peak;
+    return r;
+}
+
+// Moves end_msg of every fourth message 1 to 16 bytes later, onto random extra bytes, and checks
+// that parser_dataflow() and parser_dataflow_early() still match parser()
+static int run_over_long(const std::vector<ByteData>& clean, int num_messages) {
+    std::vector<ByteData> input;
+    int num_long = 0;
+    for (size_t i = 0; i < clean.size(); i++) {
+        ByteData b = clean[i];
+        if (b.end_msg && next_rand() % 4 == 0) {
+            b.end_msg = 0;
+            input.push_back(b);
+            int extra = 1 + (int)(next_rand() % 16);
+            for (int k = 0; k < extra; k++) {
+                ByteData e = {(uint8_t)next_rand(), 1, 0, (uint8_t)(k == extra - 1)};
+                input.push_back(e);
+            }
+            num_long++;
+        } else {
+            input.push_back(b);
+        }
+    }
+
+    std::vector<ParserOutput> expected(num_messages + 1), got(num_messages + 1), early_got(num_messages + 1);
+    int num_expected = 0, num_got = 0, num_early_got = 0;
+    parser(input.data(), (int)input.size(), expected.data(), &num_expected);
+    parser_dataflow(input.data(), (int)input.size(), got.data(), &num_got);
+    hls::stream<EarlyNotify> early_out;
+    parser_dataflow_early(input.data(), (int)input.size(), early_got.data(), &num_early_got, early_out);
+    while (!early_out.empty()) early_out.read();
+
+    int errors = compare_outputs("over-long, parser_dataflow", got.data(), num_got, expected.data(), num_expected);
+    errors += compare_outputs("over-long, parser_dataflow_early", early_got.data(), num_early_got, expected.data(),
+                              num_expected);
+    printf("over-long messages: %d of %d, %s\n", num_long, num_expected, errors ? "FAIL" : "ok");
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    int num_messages = argc > 1 ? atoi(argv[1]) : 100000;
+
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < num_messages; i++) append_random_message(bytes);
+    std::vector<ByteData> clean = to_byte_data(bytes);
+
+    // Mix in the cases parser_tb.c exercises: garbage between messages, invalid bytes
+    // inside a message, and an unsupported message type
+    std::vector<ByteData> input;
+    for (size_t i = 0; i < clean.size(); i++) {
+        if (clean[i].start_msg && next_rand() % 50 == 0) {
+            ByteData garbage = {0xF8, 1, 0, 0};
+            input.push_back(garbage);
+        }
+        if (clean[i].start_msg && next_rand() % 100 == 0) {
+            ByteData unsupported[3] = {{0x5A, 1, 1, 0}, {0x04, 1, 0, 0}, {0x05, 1, 0, 1}};
+            input.insert(input.end(), unsupported, unsupported + 3);
+        }
+        ByteData b = clean[i];
+        if (!b.start_msg && next_rand() % 2000 == 0) b.valid = 0;
+        input.push_back(b);
+    }
+
+    std::vector<ParserOutput> expected(num_messages + 1), got(num_messages + 1);
+    int num_expected = 0, num_got = 0;
+    parser(input.data(), (int)input.size(), expected.data(), &num_expected);
+    parser_dataflow(input.data(), (int)input.size(), got.data(), &num_got);
+
+    printf("%zu input bytes, %d valid messages\n", input.size(), num_expected);
+    int errors = compare_outputs("parser_dataflow", got.data(), num_got, expected.data(), num_expected);
+
+    // A ParserOutput takes two 512-bit beats on gmem1
+    int write_cycles = (int)((sizeof(ParserOutput) + 63) / 64);
+    struct { const char* name; int stall_every; int stall_cycles; } scenarios[] = {
+        {"no write stalls", 0, 0},
+        {"64-cycle stall every 16 records", 16, 64},
+        {"256-cycle stall every 64 records", 64, 256},
+    };
+
+    // Every record must come after a notification with the same header; notifications for
+    // messages that turned invalid past byte 18 are skipped over
+    std::vector<ParserOutput> early_got(num_messages + 1);
+    int num_early_got = 0;
+    hls::stream<EarlyNotify> early_out;
+    parser_dataflow_early(input.data(), (int)input.size(), early_got.data(), &num_early_got, early_out);
+    errors += compare_outputs("parser_dataflow_early", early_got.data(), num_early_got, expected.data(), num_expected);
+    int notified = 0, abandoned = 0, unmatched = 0;
+    for (int i = 0; i < num_early_got; i++) {
+        const ParserOutput& o = early_got[i];
+        bool found = false;
+        while (!found && !early_out.empty()) {
+            EarlyNotify e = early_out.read();
+            notified++;
+            found = e.msg_type == o.msg_type && e.stock_locate == o.stock_locate && e.tracking_no == o.tracking_no &&
+                    e.timestamp == o.timestamp && e.order_ref_no == o.order_ref_no;
+            abandoned += !found;
+        }
+        unmatched += !found;
+    }
+    while (!early_out.empty()) {
+        early_out.read();
+        notified++;
+        abandoned++;
+    }
+    printf("parser_dataflow_early: %d notifications, %d for messages that then turned invalid, %d records without one\n",
+           notified, abandoned, unmatched);
+    errors += unmatched != 0;
+
+    printf("\n%-34s %10s %11s %11s   %s\n", "writer", "cycles", "bytes/cycle", "msgs/cycle",
+           "peak FIFO depth (framed_bytes / messages / outputs)");
+    ModelResult unstalled;
+    for (int s = 0; s < 3; s++) {
+        ModelResult r = run_cycle_model(input, write_cycles, scenarios[s].stall_every, scenarios[s].stall_cycles);
+        if (s == 0) unstalled = r;
+        if (r.outputs != num_expected) {
+            printf("cycle model produced %d messages, expected %d\n", r.outputs, num_expected);
+            errors++;
+        }
+        printf("%-34s %10ld %11.3f %11.4f   %zu / %zu / %zu\n", scenarios[s].name, r.cycles,
+               (double)input.size() / r.cycles, (double)r.outputs / r.cycles,
+               r.framed_peak, r.msg_peak, r.output_peak);
+    }
+
+    printf("\nEarlyNotify lead over the record, in cycles:");
+    for (const char* t = "AFEXDU"; *t; t++) {
+        uint8_t type = (uint8_t)*t;
+        if (unstalled.early_count[type]) {
+            printf(" %c %.1f", *t, (double)unstalled.early_lead[type] / unstalled.early_count[type]);
+        }
+    }
+    printf("\n\n");
+
+    errors += run_over_long(clean, num_messages);
+
+    printf(errors ? "\nTEST FAILED\n" : "\nTEST PASSED\n");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+#include <CL/opencl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "itch.h"
+
+/* Compares the two parser input formats on the same Nasdaq BinaryFILE:
+ *  - ByteData: the host strips the framing and expands every ITCH byte to 4 bytes
+ *    (data + valid/start_msg/end_msg flags) before running `parser`
+ *  - framed:   the host DMAs the file bytes exactly as stored and `parser_framed`
+ *    finds the message boundaries from the 2-byte length prefixes
+ * The xclbin must contain both kernels. */
+
+/* Helper: aligned allocation for XRT-friendly host pointers */
+static void *aligned_alloc_xrt(size_t align, size_t size) {
+    void *p = NULL;
+    int r = posix_memalign(&p, align, size);
+    if (r != 0) return NULL;
+    memset(p, 0, size);
+    return p;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+} ClState;
+
+typedef struct {
+    size_t bytes_to_device;
+    size_t bytes_from_device;
+    int num_outputs;
+    double seconds;
+} RunResult;
+
+/* Runs one parser kernel over `input` and reads back its outputs, timing the whole round trip */
+static int run_parser_kernel(ClState *cl, const char *kernel_name, void *input, size_t input_size,
+                             int num_elements, ParserOutput *output, int max_outputs, RunResult *result) {
+    cl_int err;
+    int num_outputs_host = 0;
+    double start = now_seconds();
+
+    cl_kernel kernel = clCreateKernel(cl->program, kernel_name, &err);
+    if (err != CL_SUCCESS) { printf("clCreateKernel(%s) failed: %d\n", kernel_name, err); return 1; }
+
+    cl_mem buffer_input = clCreateBuffer(cl->context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
+                                         input_size, input, &err);
+    if (err != CL_SUCCESS) { printf("buffer_input create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_output = clCreateBuffer(cl->context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR,
+                                          max_outputs * sizeof(ParserOutput), output, &err);
+    if (err != CL_SUCCESS) { printf("buffer_output create failed: %d\n", err); return 1; }
+
+    cl_mem buffer_num_outputs = clCreateBuffer(cl->context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                                               sizeof(int), &num_outputs_host, &err);
+    if (err != CL_SUCCESS) { printf("buffer_num_outputs create failed: %d\n", err); return 1; }
+
+    err  = clSetKernelArg(kernel, 0, sizeof(cl_mem), &buffer_input);
+    err |= clSetKernelArg(kernel, 1, sizeof(int), &num_elements);
+    err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &buffer_output);
+    err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &buffer_num_outputs);
+    if (err != CL_SUCCESS) { printf("clSetKernelArg failed: %d\n", err); return 1; }
+
+    err = clEnqueueMigrateMemObjects(cl->queue, 1, &buffer_input, 0, 0, NULL, NULL);
+    err |= clEnqueueMigrateMemObjects(cl->queue, 1, &buffer_num_outputs, 0, 0, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clEnqueueMigrate input failed: %d\n", err); return 1; }
+
+    err = clEnqueueTask(cl->queue, kernel, 0, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clEnqueueTask failed: %d\n", err); return 1; }
+
+    err = clEnqueueMigrateMemObjects(cl->queue, 1, &buffer_num_outputs, CL_MIGRATE_MEM_OBJECT_HOST, 0, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clEnqueueMigrate back failed: %d\n", err); return 1; }
+    clFinish(cl->queue);
+
+    /* Only read back the records the kernel actually wrote */
+    int num_outputs = num_outputs_host < max_outputs ? num_outputs_host : max_outputs;
+    if (num_outputs > 0) {
+        err = clEnqueueReadBuffer(cl->queue, buffer_output, CL_TRUE, 0, num_outputs * sizeof(ParserOutput),
+                                  output, 0, NULL, NULL);
+        if (err != CL_SUCCESS) { printf("clEnqueueReadBuffer output failed: %d\n", err); return 1; }
+    }
+
+    result->seconds = now_seconds() - start;
+    result->bytes_to_device = input_size;
+    result->bytes_from_device = num_outputs * sizeof(ParserOutput) + sizeof(int);
+    result->num_outputs = num_outputs;
+
+    clReleaseMemObject(buffer_input);
+    clReleaseMemObject(buffer_output);
+    clReleaseMemObject(buffer_num_outputs);
+    clReleaseKernel(kernel);
+    return 0;
+}
+
+static void print_result(const char *name, const RunResult *r, size_t file_size, double prep_seconds) {
+    double total = r->seconds + prep_seconds;
+    printf("%-9s to device %12zu B  from device %12zu B  host prep %8.3f ms  total %8.3f ms  %8.1f MB/s of file\n",
+           name, r->bytes_to_device, r->bytes_from_device, prep_seconds * 1e3, total * 1e3,
+           file_size / total / 1e6);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        printf("Usage: %s <xclbin> <itch BinaryFILE>\n", argv[0]);
+        return 1;
+    }
+    const char* xclbinPath = argv[1];
+    const char* itchPath = argv[2];
+
+    /* --- Load the ITCH file exactly as stored --- */
+    FILE* fp = fopen(itchPath, "rb");
+    if (!fp) { printf("Error: could not open %s (%s)\n", itchPath, strerror(errno)); return 1; }
+    fseek(fp, 0, SEEK_END);
+    size_t file_size = ftell(fp);
+    rewind(fp);
+    if (file_size > 0x7FFFFFFF) { printf("Error: %s is larger than one kernel call can take\n", itchPath); return 1; }
+    uint8_t *framed = (uint8_t*)aligned_alloc_xrt(4096, file_size + 64);
+    if (!framed) { perror("aligned_alloc framed"); fclose(fp); return 1; }
+    if (fread(framed, 1, file_size, fp) != file_size) { perror("fread"); fclose(fp); return 1; }
+    fclose(fp);
+
+    /* Count messages and ITCH payload bytes to size the buffers */
+    int num_messages = 0;
+    size_t payload_bytes = 0;
+    size_t pos = 0;
+    while (pos + ITCH_LENGTH_PREFIX <= file_size) {
+        size_t len = ((size_t)framed[pos] << 8) | framed[pos + 1];
+        if (len == 0 || len > ITCH_SPEC_MAX_MSG_LEN || pos + ITCH_LENGTH_PREFIX + len > file_size) break;
+        payload_bytes += len;
+        num_messages++;
+        pos += ITCH_LENGTH_PREFIX + len;
+    }
+    printf("%s: %zu bytes, %d messages\n", itchPath, file_size, num_messages);
+
+    ParserOutput *output = (ParserOutput*)aligned_alloc_xrt(4096, (num_messages + 1) * sizeof(ParserOutput));
+    if (!output) { perror("aligned_alloc output"); return 1; }
+
+    /* --- OpenCL / Xilinx flow --- */
+    ClState cl;
+    cl_int err;
+    cl_platform_id platform;
+    err = clGetPlatformIDs(1, &platform, NULL);
+    if (err != CL_SUCCESS) { printf("clGetPlatformIDs failed: %d\n", err); return 1; }
+
+    cl_device_id device;
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ACCELERATOR, 1, &device, NULL);
+    if (err != CL_SUCCESS) { printf("clGetDeviceIDs failed: %d\n", err); return 1; }
+
+    cl.context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (!cl.context || err != CL_SUCCESS) { printf("clCreateContext failed: %d\n", err); return 1; }
+
+    cl.queue = clCreateCommandQueue(cl.context, device, 0, &err);
+    if (!cl.queue || err != CL_SUCCESS) { printf("clCreateCommandQueue failed: %d\n", err); return 1; }
+
+    fp = fopen(xclbinPath, "rb");
+    if (!fp) { printf("Error: could not open %s (%s)\n", xclbinPath, strerror(errno)); return 1; }
+    fseek(fp, 0, SEEK_END);
+    size_t binary_size = ftell(fp);
+    rewind(fp);
+    void *binary = aligned_alloc_xrt(4096, binary_size);
+    if (!binary) { perror("aligned_alloc binary"); fclose(fp); return 1; }
+    if (fread(binary, 1, binary_size, fp) != binary_size) { perror("fread"); fclose(fp); return 1; }
+    fclose(fp);
+
+    cl.program = clCreateProgramWithBinary(cl.context, 1, &device, &binary_size,
+                                           (const unsigned char**)&binary, NULL, &err);
+    if (err != CL_SUCCESS) { printf("clCreateProgramWithBinary failed: %d\n", err); return 1; }
+    err = clBuildProgram(cl.program, 1, &device, NULL, NULL, NULL);
+    if (err != CL_SUCCESS) { printf("clBuildProgram failed: %d\n", err); return 1; }
+
+    /* --- ByteData format: host expands every ITCH byte to four --- */
+    double prep_start = now_seconds();
+    ByteData *serial = (ByteData*)aligned_alloc_xrt(4096, payload_bytes * sizeof(ByteData));
+    if (!serial) { perror("aligned_alloc serial"); return 1; }
+    size_t out_pos = 0;
+    pos = 0;
+    for (int m = 0; m < num_messages; m++) {
+        size_t len = ((size_t)framed[pos] << 8) | framed[pos + 1];
+        pos += ITCH_LENGTH_PREFIX;
+        for (size_t i = 0; i < len; i++) {
+            serial[out_pos].data = framed[pos + i];
+            serial[out_pos].valid = 1;
+            serial[out_pos].start_msg = i == 0;
+            serial[out_pos].end_msg = i == len - 1;
+            out_pos++;
+        }
+        pos += len;
+    }
+    double serial_prep = now_seconds() - prep_start;
+
+    RunResult serial_result, framed_result;
+    if (run_parser_kernel(&cl, "parser", serial, payload_bytes * sizeof(ByteData), (int)payload_bytes,
+                          output, num_messages + 1, &serial_result)) return 1;
+    int serial_outputs = serial_result.num_outputs;
+
+    /* --- Framed format: file bytes go to the card untouched --- */
+    if (run_parser_kernel(&cl, "parser_framed", framed, file_size, (int)file_size,
+                          output, num_messages + 1, &framed_result)) return 1;
+
+    printf("\n");
+    print_result("ByteData", &serial_result, file_size, serial_prep);
+    print_result("framed", &framed_result, file_size, 0.0);
+    printf("\nInput bytes moved: %.2fx less with framed input\n",
+           (double)serial_result.bytes_to_device / framed_result.bytes_to_device);
+    printf("End-to-end speedup: %.2fx\n", (serial_result.seconds + serial_prep) / framed_result.seconds);
+
+    /* Both formats decode the same supported messages */
+    int ok = serial_outputs == framed_result.num_outputs;
+    printf(ok ? "\nTEST PASSED: both formats produced %d messages\n"
+              : "\nTEST FAILED: ByteData produced %d messages, framed produced %d\n",
+           serial_outputs, framed_result.num_outputs);
+
+    clReleaseProgram(cl.program);
+    clReleaseCommandQueue(cl.queue);
+    clReleaseContext(cl.context);
+    free(serial);
+    free(framed);
+    free(output);
+    free(binary);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+// Cycle-accurate testbench for the byte-serial RTL parser (parser.sv), built with Verilator.
+//
+// Random A/F/E/X/D/U traffic is streamed through the `parser` module one byte per clock, with
+// start_msg on each message's first byte. Between messages the bus is held idle (valid low)
+// for a fixed number of cycles, swept from 0 (back to back) to max_gap. Every cycle in which
+// valid_msg is high is taken as the result of the last message whose final byte went in before
+// it, and its fields are compared with itch_decode_message() on that message, the reference all
+// the HLS kernels are checked against. Reported per idle gap: cycles per message, input
+// utilisation (byte cycles over all cycles), messages delivered, dropped and mismatched, and
+// the cycles from a message's last byte to its valid_msg. The first mismatches are printed
+// field by field.
+//
+// Built with PARSER_EARLY_NOTIFY, every early_valid pulse is also checked: it must come once per
+// message, with msg_type, stock_locate, tracking_no, timestamp and order_ref_no already right,
+// and equal to the same fields of the message's valid_msg record. The cycles by which it beats
+// valid_msg are reported per message type, back to back and in the stress run.
+//
+// The back-to-back traffic needs parser.sv's PARSER_BACK_TO_BACK rework. Without it, the
+// original registered end_msg is expected to fail: make -f verilator.mk check runs both.
+//
+// Build: make -f verilator.mk parser_sv_tb (binary in obj_verilator/parser_sv_tb/), or
+//        verilator --cc --exe --build -O3 -Wno-fatal +define+PARSER_BACK_TO_BACK -CFLAGS "-O2 -I.."
+//            parser.sv parser_sv_tb.cpp itch_decoder.cpp
+//        (for early notify: make -f verilator.mk parser_sv_tb_early, or add +define+PARSER_EARLY_NOTIFY
+//        and -DPARSER_EARLY_NOTIFY in -CFLAGS)
+// Usage: ./obj_dir/Vparser [messages=100000] [max_gap=3]
+// Written for Verilator 4.210 or later (VerilatedContext, --build), but not yet built with any
+// Verilator version: none was available where it was written. So far it has only been compiled
+// against a hand-written C++ stand-in for Vparser, which checks the harness, not the RTL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "verilated.h"
+#include "Vparser.h"
+#include "itch_decoder.h"
+#include "itch_testgen.h"
+
+// Idle cycles after the last message, so its valid_msg is seen
+#define DRAIN_CYCLES 8
+
+// Mismatches printed per run
+#define MAX_REPORTED 5
+
+static const char* const kFieldNames[] = {
+    "msg_type", "stock_locate", "tracking_no", "timestamp", "order_ref_no", "shares",
+    "buy_sell", "stock", "price", "match_no", "new_order_ref_no", "attribution",
+};
+#define NUM_FIELDS ((int)(sizeof(kFieldNames) / sizeof(kFieldNames[0])))
+
+#ifdef PARSER_EARLY_NOTIFY
+static uint64_t be_bytes(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+    return v;
+}
+#endif
+
+static uint64_t field_value(const ParserOutput& o, int field) {
+    switch (field) {
+        case 0:  return o.msg_type;
+        case 1:  return o.stock_locate;
+        case 2:  return o.tracking_no;
+        case 3:  return o.timestamp;
+        case 4:  return o.order_ref_no;
+        case 5:  return o.shares;
+        case 6:  return o.buy_sell;
+        case 7:  return o.stock;
+        case 8:  return o.price;
+        case 9:  return o.match_no;
+        case 10: return o.new_order_ref_no;
+        default: return o.attribution;
+    }
+}
+
+// The module's output registers as a ParserOutput
+static ParserOutput sample(const Vparser& top) {
+    ParserOutput o = {};
+    o.valid_msg = top.valid_msg;
+    o.msg_type = top.msg_type;
+    o.stock_locate = top.stock_locate;
+    o.tracking_no = top.tracking_no;
+    o.timestamp = top.timestamp;
+    o.order_ref_no = top.order_ref_no;
+    o.shares = top.shares;
+    o.buy_sell = top.buy_sell;
+    o.stock = top.stock;
+    o.price = top.price;
+    o.match_no = top.match_no;
+    o.new_order_ref_no = top.new_order_ref_no;
+    o.attribution = top.attribution;
+    return o;
+}
+
+// One clock: inputs are already set, outputs are read after the rising edge
+static void tick(VerilatedContext& ctx, Vparser& top) {
+    top.clk = 0;
+    top.eval();
+    ctx.timeInc(1);
+    top.clk = 1;
+    top.eval();
+    ctx.timeInc(1);
+}
+
+struct Emitted {
+    uint64_t cycle;         // first cycle valid_msg was high
+    ParserOutput out;
+};
+
+// Messages back to back in `bytes`, each after gaps[k] idle cycles
+struct Stream {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> starts;
+    std::vector<int> gaps;
+
+    size_t length(size_t k) const { return (k + 1 < starts.size() ? starts[k + 1] : bytes.size()) - starts[k]; }
+};
+
+struct RunResult {
+    uint64_t cycles;
+    uint64_t byte_cycles;
+    size_t emitted;
+    size_t matched;
+    size_t expected;        // messages the reference decodes
+    size_t dropped;         // of those, messages with no valid_msg
+    size_t mismatched;      // messages whose valid_msg fields differ from the reference
+    size_t extra;           // valid_msg pulses beyond one per decodable message
+    int min_latency, max_latency;
+    size_t field_errors[NUM_FIELDS];
+#ifdef PARSER_EARLY_NOTIFY
+    size_t early_errors;    // early_valid pulses that are stray, repeated or carry wrong fields
+    size_t early_differs;   // early_valid fields that differ from the message's valid_msg record
+    size_t early_missed;    // messages with a valid_msg but no early_valid
+    size_t early_abandoned; // early_valid for a message that was then cut short
+    uint64_t saved[256];    // cycles from early_valid to valid_msg, summed per message type
+    size_t saved_count[256];
+    int saved_min[256], saved_max[256];
+#endif
+};
+
+static RunResult run(VerilatedContext& ctx, Vparser& top, const Stream& s, bool verbose) {
+    RunResult r = {};
+    r.min_latency = 1 << 30;
+
+    top.rst = 1;
+    top.start_msg = 0;
+    top.valid = 0;
+    top.message = 0;
+    tick(ctx, top);
+    tick(ctx, top);
+    top.rst = 0;
+
+    // Drive the stream; last_byte[k] is the cycle message k's final byte is on the bus
+    size_t n = s.starts.size();
+    std::vector<uint64_t> last_byte(n);
+    std::vector<Emitted> emitted;
+    emitted.reserve(n);
+    uint64_t cycle = 0;
+#ifdef PARSER_EARLY_NOTIFY
+    std::vector<uint64_t> first_byte(n);
+    std::vector<Emitted> early;
+    early.reserve(n);
+#endif
+    auto clock = [&] {
+        tick(ctx, top);
+        cycle++;
+        if (top.valid_msg) emitted.push_back({cycle, sample(top)});
+#ifdef PARSER_EARLY_NOTIFY
+        if (top.early_valid) early.push_back({cycle, sample(top)});
+#endif
+    };
+    for (size_t k = 0; k < n; k++) {
+        for (int i = 0; i < s.gaps[k]; i++) {
+            top.valid = 0;
+            top.start_msg = 0;
+            clock();
+        }
+        for (size_t i = s.starts[k]; i < s.starts[k] + s.length(k); i++) {
+            top.valid = 1;
+            top.start_msg = i == s.starts[k];
+            top.message = s.bytes[i];
+#ifdef PARSER_EARLY_NOTIFY
+            if (i == s.starts[k]) first_byte[k] = cycle;
+#endif
+            last_byte[k] = cycle;
+            clock();
+            r.byte_cycles++;
+        }
+    }
+    top.valid = 0;
+    top.start_msg = 0;
+    for (int i = 0; i < DRAIN_CYCLES; i++) clock();
+    r.cycles = cycle;
+    r.emitted = emitted.size();
+
+    // Attribute each valid_msg to the last message that had finished before it. Messages the
+    // reference rejects (unsupported or cut short) must raise none.
+    std::vector<int> pulses(n, 0);
+    std::vector<ParserOutput> expect(n);
+    std::vector<char> decodable(n);
+    for (size_t k = 0; k < n; k++) {
+        decodable[k] = (char)itch_decode_message(&s.bytes[s.starts[k]], s.length(k), &expect[k]);
+        r.expected += decodable[k];
+    }
+    std::vector<uint64_t> done_cycle(n, 0);
+    std::vector<ParserOutput> done_out(n);
+    int reported = 0;
+    for (const Emitted& e : emitted) {
+        size_t k = std::upper_bound(last_byte.begin(), last_byte.end(), e.cycle - 1) - last_byte.begin();
+        if (k == 0 || !decodable[k - 1] || pulses[k - 1]++ > 0) {
+            r.extra++;
+            continue;
+        }
+        k--;
+        done_cycle[k] = e.cycle;
+        done_out[k] = e.out;
+        int latency = (int)(e.cycle - last_byte[k]);
+        r.min_latency = std::min(r.min_latency, latency);
+        r.max_latency = std::max(r.max_latency, latency);
+
+        if (same_output(e.out, expect[k])) {
+            r.matched++;
+            continue;
+        }
+        r.mismatched++;
+        for (int f = 0; f < NUM_FIELDS; f++) {
+            if (field_value(e.out, f) == field_value(expect[k], f)) continue;
+            r.field_errors[f]++;
+            if (verbose && reported < MAX_REPORTED) {
+                printf("    message %zu ('%c'): %s is 0x%llx, expected 0x%llx\n", k, expect[k].msg_type,
+                       kFieldNames[f], (unsigned long long)field_value(e.out, f),
+                       (unsigned long long)field_value(expect[k], f));
+            }
+        }
+        reported++;
+    }
+    for (size_t k = 0; k < n; k++) r.dropped += decodable[k] && pulses[k] == 0;
+
+#ifdef PARSER_EARLY_NOTIFY
+    // Attribute each early_valid to the last message that had started before it
+    std::vector<uint64_t> early_cycle(n, 0);
+    std::vector<ParserOutput> early_out(n);
+    for (const Emitted& e : early) {
+        size_t k = std::upper_bound(first_byte.begin(), first_byte.end(), e.cycle - 1) - first_byte.begin();
+        if (k == 0 || early_cycle[k - 1] != 0) {
+            r.early_errors++;
+            continue;
+        }
+        k--;
+        early_cycle[k] = e.cycle;
+        early_out[k] = e.out;
+        // A message cut short after byte 18 is notified too, and then abandoned
+        const uint8_t* m = &s.bytes[s.starts[k]];
+        if (s.length(k) < 19 || !itch_msg_length(m[0]) || e.out.msg_type != m[0] ||
+            e.out.stock_locate != (uint16_t)be_bytes(m + 1, 2) || e.out.tracking_no != (uint16_t)be_bytes(m + 3, 2) ||
+            e.out.timestamp != be_bytes(m + 5, 6) || e.out.order_ref_no != be_bytes(m + 11, 8)) {
+            r.early_errors++;
+        } else {
+            r.early_abandoned += !decodable[k];
+        }
+    }
+    for (int t = 0; t < 256; t++) r.saved_min[t] = 1 << 30;
+    for (size_t k = 0; k < n; k++) {
+        if (!done_cycle[k]) continue;
+        if (!early_cycle[k]) {
+            r.early_missed++;
+            continue;
+        }
+        const ParserOutput& e = early_out[k];
+        const ParserOutput& d = done_out[k];
+        if (e.msg_type != d.msg_type || e.stock_locate != d.stock_locate || e.tracking_no != d.tracking_no ||
+            e.timestamp != d.timestamp || e.order_ref_no != d.order_ref_no) {
+            r.early_differs++;
+        }
+        uint8_t t = expect[k].msg_type;
+        int saved = (int)(done_cycle[k] - early_cycle[k]);
+        r.saved[t] += saved;
+        r.saved_count[t]++;
+        r.saved_min[t] = std::min(r.saved_min[t], saved);
+        r.saved_max[t] = std::max(r.saved_max[t], saved);
+    }
+#endif
+    if (r.min_latency > r.max_latency) r.min_latency = r.max_latency = 0;
+    return r;
+}
+
+#ifdef PARSER_EARLY_NOTIFY
+// Mean (and range) of the cycles from early_valid to valid_msg, per message type
+static void report_lead(const char* name, const RunResult& r) {
+    printf("  early_valid ahead of valid_msg, %s:", name);
+    for (const char* t = "AFEXDU"; *t; t++) {
+        uint8_t type = (uint8_t)*t;
+        if (!r.saved_count[type]) continue;
+        printf(" %c %.1f", *t, (double)r.saved[type] / r.saved_count[type]);
+        if (r.saved_min[type] != r.saved_max[type]) printf(" (%d-%d)", r.saved_min[type], r.saved_max[type]);
+    }
+    printf(" cycles\n");
+}
+#endif
+
+// Prints one row of the results table; returns 1 if every decodable message came out right
+static int report(const char* name, const RunResult& r, size_t messages, bool* shown,
+                  VerilatedContext& ctx, Vparser& top, const Stream& s) {
+    printf("%-10s %10.2f %9.1f%% %10zu %10zu %10zu %10zu %10zu %5d-%-3d\n", name, (double)r.cycles / messages,
+           100.0 * r.byte_cycles / r.cycles, r.emitted, r.matched, r.dropped, r.mismatched, r.extra,
+           r.min_latency, r.max_latency);
+    if (r.mismatched) {
+        printf("  mismatched fields:");
+        for (int f = 0; f < NUM_FIELDS; f++) {
+            if (r.field_errors[f]) printf(" %s %zu", kFieldNames[f], r.field_errors[f]);
+        }
+        printf("\n");
+        if (!*shown) run(ctx, top, s, true);
+        *shown = true;
+    }
+    int ok = r.matched == r.expected && r.extra == 0;
+#ifdef PARSER_EARLY_NOTIFY
+    if (r.early_errors || r.early_missed || r.early_differs) {
+        printf("  early_valid: %zu stray or wrong, %zu messages without one, %zu differing from valid_msg\n",
+               r.early_errors, r.early_missed, r.early_differs);
+        ok = 0;
+    }
+    if (r.early_abandoned) printf("  early_valid: %zu for messages then cut short\n", r.early_abandoned);
+#endif
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int num_messages = argc > 1 ? atoi(argv[1]) : 100000;
+    int max_gap = argc > 2 ? atoi(argv[2]) : 3;
+    int stress_messages = argc > 3 ? atoi(argv[3]) : 1000000;
+    if (num_messages < 1 || max_gap < 0 || stress_messages < 0) {
+        printf("Usage: %s [messages, default 100000] [max idle gap, default 3] [stress messages, default 1000000]\n",
+               argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<VerilatedContext> ctx(new VerilatedContext);
+    ctx->commandArgs(argc, argv);
+    std::unique_ptr<Vparser> top(new Vparser(ctx.get()));
+
+    Stream sweep;
+    for (int i = 0; i < num_messages; i++) {
+        sweep.starts.push_back(sweep.bytes.size());
+        append_random_message(sweep.bytes);
+    }
+    printf("parser.sv: %d random A/F/E/X/D/U messages, %zu bytes\n", num_messages, sweep.bytes.size());
+    printf("%-10s %10s %10s %10s %10s %10s %10s %10s %9s\n", "idle gap", "cycles/msg", "input use", "emitted",
+           "matched", "dropped", "mismatch", "extra", "latency");
+
+    int errors = 0;
+    int min_clean_gap = -1;
+    bool shown = false;
+    for (int gap = 0; gap <= max_gap; gap++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%d", gap);
+        sweep.gaps.assign(num_messages, gap);
+        RunResult r = run(*ctx, *top, sweep, false);
+        int clean = report(name, r, num_messages, &shown, *ctx, *top, sweep);
+#ifdef PARSER_EARLY_NOTIFY
+        if (gap == 0) report_lead("back to back", r);
+#endif
+        if (clean && min_clean_gap < 0) min_clean_gap = gap;
+        errors += !clean;
+    }
+    if (min_clean_gap >= 0) {
+        printf("Every message is decoded correctly with %d or more idle cycles between messages\n", min_clean_gap);
+    } else {
+        printf("No idle gap up to %d decodes every message correctly\n", max_gap);
+    }
+
+    // Stress: continuous traffic, mostly back to back, with unsupported types and messages cut
+    // short by the next start_msg mixed in; every supported message must still come out
+    if (stress_messages > 0) {
+        Stream stress;
+        for (int i = 0; i < stress_messages; i++) {
+            stress.starts.push_back(stress.bytes.size());
+            int r = (int)(next_rand() % 32);
+            if (r == 0) {
+                stress.bytes.push_back('S');        // System Event, not supported by the module
+                for (int j = 1; j < 12; j++) stress.bytes.push_back((uint8_t)next_rand());
+            } else {
+                append_random_message(stress.bytes);
+                if (r == 1) stress.bytes.resize(stress.starts.back() + 1 + next_rand() % (stress.length(i) - 1));
+            }
+            stress.gaps.push_back(next_rand() % 8 ? 0 : 1 + (int)(next_rand() % 3));
+        }
+        RunResult r = run(*ctx, *top, stress, false);
+        printf("Stress: %d messages, %zu supported and whole\n", stress_messages, r.expected);
+        int clean = report("stress", r, stress_messages, &shown, *ctx, *top, stress);
+#ifdef PARSER_EARLY_NOTIFY
+        report_lead("stress", r);
+#endif
+        errors += !clean;
+    }
+
+    top->final();
+    printf(errors ? "TEST FAILED\n" : "TEST PASSED\n");
+    return errors ? 1 : 0;
+}
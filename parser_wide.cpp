@@ -0,0 +1,188 @@
+#include <stdint.h>
+#include <ap_int.h>
+#include "parser_wide.h"
+
+extern "C" {
+// 8 bytes per beat: at most one message completes per cycle
+void parser_wide64(
+    // Input: ITCH messages packed back to back, 8 bytes per beat
+    const ap_uint<64>* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages
+    ParserOutput* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<8>(input_stream, num_bytes, output_stream, num_outputs);
+}
+
+// 64 bytes per beat: up to four messages complete per cycle
+void parser_wide512(
+    // Input: ITCH messages packed back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages
+    ParserOutput* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64>(input_stream, num_bytes, output_stream, num_outputs);
+}
+
+// Native Nasdaq BinaryFILE input: the host DMAs the file bytes exactly as stored
+void parser_framed(
+    // Input: 2-byte big-endian length + message body, back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages
+    ParserOutput* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64, INPUT_FRAMED>(input_stream, num_bytes, output_stream, num_outputs);
+}
+
+// BinaryFILE input with a stock_locate subscription: only subscribed stocks reach gmem1
+void parser_filtered(
+    // Input: 2-byte big-endian length + message body, back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages for subscribed stocks
+    ParserOutput* output_stream,
+    int* num_outputs,
+
+    // Subscription bitmap over stock_locate (see stock_filter.h), read once per call
+    const ap_uint<512>* filter,
+
+    // Output: messages dropped because their stock is not subscribed
+    int* num_dropped
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE m_axi port=filter bundle=gmem3 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_dropped bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64, INPUT_FRAMED, ParserOutput, true>(input_stream, num_bytes, output_stream, num_outputs,
+                                                          0, 0, 0, filter, num_dropped);
+}
+
+// BinaryFILE input with compact, type-tagged output records (see itch_compact.h)
+void parser_compact(
+    // Input: 2-byte big-endian length + message body, back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: packed 32/48-byte records in 16-byte words
+    ap_uint<128>* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64, INPUT_FRAMED>(input_stream, num_bytes, output_stream, num_outputs);
+}
+
+// BinaryFILE input with columnar output: one column set per order book message type, laid out
+// in output_stream as itch_columns.h describes, every set with room for `capacity` records
+void parser_columns(
+    // Input: 2-byte big-endian length + message body, back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: the column buffer, itch_columns_size() bytes for `capacity`
+    ap_uint<512>* output_stream,
+    int capacity,
+    int* num_outputs       // records per set, ITCH_COLUMN_SETS entries
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=capacity
+    #pragma HLS INTERFACE s_axilite port=return
+
+    ColumnWriter writer;
+    #pragma HLS ARRAY_PARTITION variable=writer.staged complete dim=0
+    column_writer_init(writer, output_stream, capacity);
+    int total = 0;
+    parse_wide_core<64, INPUT_FRAMED>(input_stream, num_bytes, &writer, &total);
+    column_writer_flush(writer);
+    STORE_COUNTS: for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        num_outputs[s] = writer.count[s];
+    }
+}
+
+// BinaryFILE input decoded into type-specific records for every ITCH 5.0 message type
+void parser_itch(
+    // Input: 2-byte big-endian length + message body, back to back, 64 bytes per beat
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: one 64-byte ItchRecord per message (see itch_records.h)
+    ap_uint<512>* output_stream,
+    int* num_outputs
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64, INPUT_FRAMED>(input_stream, num_bytes, output_stream, num_outputs);
+}
+
+// MoldUDP64 packets as received off the wire, with sequence gaps reported in line
+void parser_moldudp64(
+    // Input: MoldUDP64 packets back to back, 64 bytes per beat, ending on a packet boundary
+    const ap_uint<512>* input_stream,
+    int num_bytes,
+
+    // Output: parsed messages
+    ParserOutput* output_stream,
+    int* num_outputs,
+
+    // Sequence tracking, read on entry and written back on return
+    MoldState* mold,
+
+    // Output: sequence gaps, each tagged with its position in output_stream
+    MoldGap* gaps,
+    int* num_gaps
+) {
+    #pragma HLS INTERFACE m_axi port=input_stream bundle=gmem0 offset=slave
+    #pragma HLS INTERFACE m_axi port=output_stream bundle=gmem1 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_outputs bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE m_axi port=mold bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE m_axi port=gaps bundle=gmem3 offset=slave
+    #pragma HLS INTERFACE m_axi port=num_gaps bundle=gmem2 offset=slave
+    #pragma HLS INTERFACE s_axilite port=num_bytes
+    #pragma HLS INTERFACE s_axilite port=return
+
+    parse_wide_core<64, INPUT_MOLDUDP64>(input_stream, num_bytes, output_stream, num_outputs,
+                                         mold, gaps, num_gaps);
+}
+}
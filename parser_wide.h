@@ -0,0 +1,573 @@
+#ifndef PARSER_WIDE_H
+#define PARSER_WIDE_H
+
+#include <stdint.h>
+#include <ap_int.h>
+#include "itch.h"
+#include "itch_columns.h"
+#include "itch_compact.h"
+#include "itch_records.h"
+#include "moldudp64.h"
+#include "stock_filter.h"
+#include "itch_layout.h"
+
+// A whole message, aligned so that its type byte sits in bits [7:0]
+typedef ap_uint<ITCH_MAX_MSG_LEN * 8> msg_buf_t;
+
+// Same for a message of any ITCH 5.0 type
+typedef ap_uint<ITCH_SPEC_MAX_MSG_LEN * 8> spec_msg_buf_t;
+
+// Width of the gmem1 write port, used by the cycle model below
+#define OUT_BUS_BYTES 64
+
+// Reads an N-byte big-endian field starting at byte `offset` of a little-endian packed buffer
+template <int N, int W>
+static uint64_t be_field(const ap_uint<W>& buf, int offset) {
+    #pragma HLS INLINE
+    uint64_t value = 0;
+    BE_BYTES: for (int i = 0; i < N; i++) {
+        #pragma HLS UNROLL
+        value = (value << 8) | (uint64_t)buf.range(8 * (offset + i) + 7, 8 * (offset + i));
+    }
+    return value;
+}
+
+// Field extractors generated from the ITCH_LAYOUT table in itch_layout.h. Every field of every
+// type is extracted in parallel at a constant offset; the message type only drives the muxes
+// that pick which fields reach the output.
+template <typename MsgT>
+struct OutputCtx {
+    const MsgT& msg;
+    ParserOutput& out;
+    uint8_t msg_type;
+};
+
+struct PutOutputField {
+    template <int ROW, typename Ctx>
+    static void field(Ctx& ctx) {
+        #pragma HLS INLINE
+        constexpr LayoutRow row = ITCH_LAYOUT[ROW];
+        set_output_field<row.field>(ctx.out, be_field<row.width>(ctx.msg, row.offset));
+    }
+};
+
+struct PutOutputType {
+    template <int MSG_TYPE, typename Ctx>
+    static void type(Ctx& ctx) {
+        #pragma HLS INLINE
+        if (layout_in_parser_output(MSG_TYPE) && ctx.msg_type == MSG_TYPE) {
+            LayoutFields<MSG_TYPE, PutOutputField>::visit(ctx);
+        }
+    }
+};
+
+// Decodes a complete, type-aligned message into a ParserOutput
+template <int W>
+static void decode_message(const ap_uint<W>& msg, ParserOutput& out) {
+    #pragma HLS INLINE
+    out.valid_msg = 1;
+    out.shares = 0;
+    out.buy_sell = 0;
+    out.stock = 0;
+    out.price = 0;
+    out.match_no = 0;
+    out.new_order_ref_no = 0;
+    out.attribution = 0;
+#ifdef ITCH_INSTRUMENT
+    out.first_cycle = 0;
+    out.done_cycle = 0;
+#endif
+
+    OutputCtx<ap_uint<W> > ctx = {msg, out, (uint8_t)be_field<1>(msg, 0)};
+    LayoutFields<ITCH_LAYOUT_HEADER, PutOutputField>::visit(ctx);
+    LayoutTypes<PutOutputType>::visit(ctx);
+}
+
+// One compact record word on gmem1
+typedef ap_uint<COMPACT_WORD_BYTES * 8> compact_word_t;
+
+// Writes a decoded message as a full ParserOutput and returns the number of output elements used
+static inline int write_record(ParserOutput* output_stream, int out_pos, const ParserOutput& msg) {
+    #pragma HLS INLINE
+    output_stream[out_pos] = msg;
+    return 1;
+}
+
+// Packs a decoded message into its compact record (see itch_compact.h) and writes it as
+// 2 or 3 words. Returns the number of words used.
+static inline int write_record(compact_word_t* output_stream, int out_pos, const ParserOutput& msg) {
+    #pragma HLS INLINE
+    ap_uint<COMPACT_LONG_LEN * 8> record = 0;
+    int len = compact_record_length(msg.msg_type);
+
+    record.range(7, 0) = msg.msg_type;
+    record.range(15, 8) = len;
+    record.range(31, 16) = msg.stock_locate;
+    record.range(47, 32) = msg.tracking_no;
+    record.range(63, 48) = msg.timestamp >> 32;
+    record.range(95, 64) = msg.timestamp & 0xFFFFFFFF;
+    record.range(127, 96) = msg.shares;
+    record.range(191, 128) = msg.order_ref_no;
+    if (len == COMPACT_SHORT_LEN) {
+        record.range(255, 192) = msg.match_no;
+    } else {
+        record.range(255, 192) = msg.msg_type == ITCH_ORDER_REPLACE ? msg.new_order_ref_no : msg.stock;
+        record.range(287, 256) = msg.price;
+        record.range(319, 288) = msg.attribution;
+        record.range(327, 320) = msg.buy_sell;
+    }
+
+    int words = len / COMPACT_WORD_BYTES;
+    WRITE_WORDS: for (int w = 0; w < COMPACT_LONG_LEN / COMPACT_WORD_BYTES; w++) {
+        #pragma HLS UNROLL
+        if (w < words) output_stream[out_pos + w] = record.range(128 * w + 127, 128 * w);
+    }
+    return words;
+}
+
+// Column-set output (see itch_columns.h). Every column has one 512-bit word staged on chip; a
+// record's fields go into their columns' staged words, and a word is written to gmem1 only when
+// it is full, so each write is a whole beat of a single column. column_writer_flush() writes the
+// partly filled words at the end.
+struct ColumnWriter {
+    ap_uint<512>* output;
+    int word_offset[ITCH_COLUMN_SETS][ITCH_COLUMNS];   // column starts in 64-byte words
+    ap_uint<512> staged[ITCH_COLUMN_SETS][ITCH_COLUMNS];
+    int count[ITCH_COLUMN_SETS];
+};
+
+// All sets get the same capacity, in records
+static inline void column_writer_init(ColumnWriter& w, ap_uint<512>* output, int capacity) {
+    size_t capacities[ITCH_COLUMN_SETS];
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) capacities[s] = capacity;
+    w.output = output;
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        w.count[s] = 0;
+        for (int c = 0; c < ITCH_COLUMNS; c++) {
+            w.word_offset[s][c] = (int)(itch_column_offset(capacities, s, c) / 64);
+            w.staged[s][c] = 0;
+        }
+    }
+}
+
+static inline uint64_t column_value(const ParserOutput& msg, int col) {
+    #pragma HLS INLINE
+    switch (col) {
+        case ITCH_COL_TIMESTAMP:        return msg.timestamp;
+        case ITCH_COL_ORDER_REF_NO:     return msg.order_ref_no;
+        case ITCH_COL_STOCK_LOCATE:     return msg.stock_locate;
+        case ITCH_COL_TRACKING_NO:      return msg.tracking_no;
+        case ITCH_COL_SHARES:           return msg.shares;
+        case ITCH_COL_PRICE:            return msg.price;
+        case ITCH_COL_BUY_SELL:         return msg.buy_sell;
+        case ITCH_COL_STOCK:            return msg.stock;
+        case ITCH_COL_MATCH_NO:         return msg.match_no;
+        case ITCH_COL_NEW_ORDER_REF_NO: return msg.new_order_ref_no;
+        default:                        return msg.attribution;
+    }
+}
+
+// Adds a decoded message to its column set. Returns the number of 64-byte words written. The
+// writer keeps its own position per column, so the core's output position is not used.
+static inline int write_record(ColumnWriter* output_stream, int /* out_pos */, const ParserOutput& msg) {
+    #pragma HLS INLINE
+    ColumnWriter& w = *output_stream;
+    int set = itch_column_set(msg.msg_type);
+    uint32_t cols = itch_set_columns(set);
+    int idx = w.count[set];
+    int words = 0;
+    WRITE_COLUMNS: for (int c = 0; c < ITCH_COLUMNS; c++) {
+        #pragma HLS UNROLL
+        if (cols & (1u << c)) {
+            int bits = 8 * itch_column_bytes(c);
+            int per_word = 512 / bits;
+            int slot = idx % per_word;
+            w.staged[set][c].range(bits * slot + bits - 1, bits * slot) = column_value(msg, c);
+            if (slot == per_word - 1) {
+                w.output[w.word_offset[set][c] + idx / per_word] = w.staged[set][c];
+                words++;
+            }
+        }
+    }
+    w.count[set] = idx + 1;
+    return words;
+}
+
+// Writes every column's partly filled word. Returns the number of 64-byte words written.
+static inline int column_writer_flush(ColumnWriter& w) {
+    int words = 0;
+    FLUSH_SETS: for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        uint32_t cols = itch_set_columns(s);
+        FLUSH_COLUMNS: for (int c = 0; c < ITCH_COLUMNS; c++) {
+            #pragma HLS PIPELINE II=1
+            int per_word = 64 / itch_column_bytes(c);
+            if ((cols & (1u << c)) && w.count[s] % per_word != 0) {
+                w.output[w.word_offset[s][c] + w.count[s] / per_word] = w.staged[s][c];
+                words++;
+            }
+        }
+    }
+    return words;
+}
+
+// One type-specific record (see itch_records.h), a single 512-bit beat on gmem1
+typedef ap_uint<ITCH_RECORD_LEN * 8> itch_record_word_t;
+
+// Stores an N-byte big-endian integer field of the message little-endian at byte `rec_offset` of the record
+template <int N>
+static void put_int(itch_record_word_t& rec, int rec_offset, const spec_msg_buf_t& msg, int msg_offset) {
+    #pragma HLS INLINE
+    rec.range(8 * (rec_offset + N) - 1, 8 * rec_offset) = be_field<N>(msg, msg_offset);
+}
+
+// Copies an N-byte alphanumeric field of the message to byte `rec_offset` of the record, in message order
+template <int N>
+static void put_alpha(itch_record_word_t& rec, int rec_offset, const spec_msg_buf_t& msg, int msg_offset) {
+    #pragma HLS INLINE
+    rec.range(8 * (rec_offset + N) - 1, 8 * rec_offset) = msg.range(8 * (msg_offset + N) - 1, 8 * msg_offset);
+}
+
+struct RecordCtx {
+    const spec_msg_buf_t& msg;
+    itch_record_word_t& rec;
+    uint8_t msg_type;
+};
+
+struct PutRecordField {
+    template <int ROW, typename Ctx>
+    static void field(Ctx& ctx) {
+        #pragma HLS INLINE
+        constexpr LayoutRow row = ITCH_LAYOUT[ROW];
+        if (row.kind == KIND_ALPHA) {
+            put_alpha<row.width>(ctx.rec, row.rec_offset, ctx.msg, row.offset);
+        } else {
+            put_int<row.width>(ctx.rec, row.rec_offset, ctx.msg, row.offset);
+        }
+    }
+};
+
+struct PutRecordType {
+    template <int MSG_TYPE, typename Ctx>
+    static void type(Ctx& ctx) {
+        #pragma HLS INLINE
+        if (ctx.msg_type == MSG_TYPE) {
+            LayoutFields<MSG_TYPE, PutRecordField>::visit(ctx);
+        }
+    }
+};
+
+// Decodes a complete, type-aligned message of any ITCH 5.0 type into its ItchRecord
+static itch_record_word_t decode_itch_record(const spec_msg_buf_t& msg) {
+    #pragma HLS INLINE
+    itch_record_word_t rec = 0;
+    RecordCtx ctx = {msg, rec, (uint8_t)be_field<1>(msg, 0)};
+    LayoutFields<ITCH_LAYOUT_HEADER, PutRecordField>::visit(ctx);
+    LayoutTypes<PutRecordType>::visit(ctx);
+    return rec;
+}
+
+// Decodes a message and writes it in the output format of output_stream. Returns the number of
+// output elements used. The cycle stamps reach only full ParserOutput records, and only with
+// ITCH_INSTRUMENT; compact and ItchRecord outputs have no room for them.
+template <typename OutT>
+static int emit_record(OutT* output_stream, int out_pos, const spec_msg_buf_t& msg,
+                       uint64_t first_cycle = 0, uint64_t done_cycle = 0) {
+    #pragma HLS INLINE
+    ParserOutput out;
+    decode_message(msg, out);
+#ifdef ITCH_INSTRUMENT
+    out.first_cycle = first_cycle;
+    out.done_cycle = done_cycle;
+#else
+    (void)first_cycle;
+    (void)done_cycle;
+#endif
+    return write_record(output_stream, out_pos, out);
+}
+
+static inline int emit_record(itch_record_word_t* output_stream, int out_pos, const spec_msg_buf_t& msg,
+                              uint64_t first_cycle = 0, uint64_t done_cycle = 0) {
+    #pragma HLS INLINE
+    (void)first_cycle;
+    (void)done_cycle;
+    output_stream[out_pos] = decode_itch_record(msg);
+    return 1;
+}
+
+// Smallest power of two >= n
+static constexpr int pow2_at_least(int n, int p = 1) {
+    return p >= n ? p : pow2_at_least(n, 2 * p);
+}
+
+// Message types each output format can hold. ParserOutput, compact records and column sets carry
+// only the order book messages; anything else is skipped (framed input) or stops parsing (packed
+// input). ELEMENT_BYTES is what one output element costs on gmem1, for the cycle model.
+template <typename OutT>
+struct RecordTraits {
+    static const int MIN_MSG_LEN = ITCH_MIN_MSG_LEN;
+    static const int MAX_MSG_LEN = ITCH_MAX_MSG_LEN;
+    static const int ELEMENT_BYTES = sizeof(OutT);
+    static int msg_length(uint8_t msg_type) { return itch_msg_length(msg_type); }
+};
+
+template <>
+struct RecordTraits<itch_record_word_t> {
+    static const int MIN_MSG_LEN = ITCH_SPEC_MIN_MSG_LEN;
+    static const int MAX_MSG_LEN = ITCH_SPEC_MAX_MSG_LEN;
+    static const int ELEMENT_BYTES = ITCH_RECORD_LEN;
+    static int msg_length(uint8_t msg_type) { return itch_spec_msg_length(msg_type); }
+};
+
+template <>
+struct RecordTraits<ColumnWriter> : RecordTraits<ParserOutput> {
+    static const int ELEMENT_BYTES = 64;
+};
+
+// Input formats accepted by parse_wide_core
+enum InputFormat {
+    INPUT_PACKED,      // messages back to back, boundaries implied by each type
+    INPUT_FRAMED,      // Nasdaq BinaryFILE: 2-byte big-endian length + message body
+    INPUT_MOLDUDP64    // MoldUDP64 packets back to back (see moldudp64.h)
+};
+
+// Wide-datapath parser core. Each iteration reads one BEAT_BYTES-wide beat into a byte
+// window and handles up to MSGS_PER_BEAT complete records from its head, so the loop keeps
+// up with the input even when a beat holds several of the shortest messages.
+//
+// Input formats:
+//  - INPUT_PACKED: each boundary is found from the length implied by the message type, so an
+//    unsupported type leaves no way to find the next boundary and parsing stops there.
+//  - INPUT_FRAMED: unsupported types and bodies whose length does not match their type are
+//    skipped; only a zero or over-long length stops parsing.
+//  - INPUT_MOLDUDP64: a packet header is just another record in the window, followed by
+//    Message Count message blocks handled as in INPUT_FRAMED. Sequence numbers are checked
+//    against *mold as each header goes by: a jump forward writes a MoldGap to `gaps` in line
+//    with the outputs, and messages already seen (retransmissions, A/B duplicates) are dropped.
+//    A new session name restarts tracking without a gap. The input must end on a packet
+//    boundary; *mold is updated on return so the next buffer carries on where this one stopped.
+//
+// With FILTERED, `filter` is a stock_locate subscription bitmap (see stock_filter.h), read into
+// on-chip memory before the first beat. Messages whose stock is not subscribed are dropped before
+// anything is written to gmem1 and counted in *num_dropped; they still count as seen for
+// MoldUDP64 sequence tracking. Each record slot of a beat has its own copy of the bitmap, so all
+// of them can look up their stock in the same cycle.
+//
+// Output formats, chosen by the output pointer type:
+//  - ParserOutput: one fixed-size ParserOutput per message
+//  - compact_word_t: packed compact records from itch_compact.h
+//  - itch_record_word_t: one ItchRecord per message, for every ITCH 5.0 type
+//  - ColumnWriter: one column set per message type (itch_columns.h); the caller initialises the
+//    writer and flushes it after the call
+// In every case, *num_outputs is the number of messages written.
+//
+// Returns a modelled cycle count for C-sim benchmarking: one cycle per iteration at
+// II=1, plus extra cycles when the emitted records need more than one gmem1 beat, plus one
+// cycle per filter word loaded.
+//
+// With ITCH_INSTRUMENT, each ParserOutput carries two stamps of that same counter, which
+// starts at 0 on every call: first_cycle, when the beat holding the message's first byte
+// (its length prefix, for framed input) was read, and done_cycle, when the message was
+// emitted. A ring of arrival stamps, one per beat the window can hold, maps a message's
+// stream offset back to its beat. Without ITCH_INSTRUMENT none of this is built.
+template <int BEAT_BYTES, InputFormat FORMAT = INPUT_PACKED, typename OutT = ParserOutput,
+          bool FILTERED = false>
+int parse_wide_core(
+    const ap_uint<BEAT_BYTES * 8>* input_stream,
+    int num_bytes,
+    OutT* output_stream,
+    int* num_outputs,
+    MoldState* mold = 0,
+    MoldGap* gaps = 0,
+    int* num_gaps = 0,
+    const ap_uint<512>* filter = 0,
+    int* num_dropped = 0
+) {
+    const bool MOLD = FORMAT == INPUT_MOLDUDP64;
+    const int PREFIX_BYTES = FORMAT == INPUT_PACKED ? 0 : ITCH_LENGTH_PREFIX;
+    const int MIN_MSG_LEN = RecordTraits<OutT>::MIN_MSG_LEN;
+    const int MAX_RECORD = PREFIX_BYTES + (FORMAT == INPUT_PACKED ? RecordTraits<OutT>::MAX_MSG_LEN
+                                                                  : ITCH_SPEC_MAX_MSG_LEN);
+    const int WIN_BYTES = BEAT_BYTES + MAX_RECORD;
+    const int MIN_RECORD = MOLD && MOLD_HEADER_LEN < PREFIX_BYTES + MIN_MSG_LEN
+                         ? MOLD_HEADER_LEN : PREFIX_BYTES + MIN_MSG_LEN;
+    const int MSGS_PER_BEAT = BEAT_BYTES / MIN_RECORD + 1;
+    typedef ap_uint<WIN_BYTES * 8> window_t;
+    typedef ap_uint<MAX_RECORD * 8> record_t;
+#ifdef ITCH_INSTRUMENT
+    const int STAMP_BEATS = pow2_at_least(WIN_BYTES / BEAT_BYTES + 2);
+    uint64_t beat_cycle[STAMP_BEATS];   // cycle each beat still in the window was read
+    #pragma HLS ARRAY_PARTITION variable=beat_cycle complete
+#endif
+
+    window_t window = 0;
+    int fill = 0;           // number of valid bytes held in the window
+    int bytes_read = 0;
+    int beat_idx = 0;
+    int output_count = 0;
+    int out_pos = 0;        // next free element of output_stream
+    int cycles = 0;
+    bool stopped = false;
+
+    // MoldUDP64 sequence tracking
+    ap_uint<MOLD_SESSION_LEN * 8> session = 0;
+    bool have_session = false;
+    bool end_of_session = false;
+    uint64_t next_seq = 0;
+    uint64_t pkt_seq = 0;   // sequence number of the next message block in the current packet
+    int msgs_left = 0;      // message blocks left in the current packet
+    int gap_count = 0;
+    if (MOLD) {
+        LOAD_SESSION: for (int i = 0; i < MOLD_SESSION_LEN; i++) {
+            #pragma HLS UNROLL
+            session.range(8 * i + 7, 8 * i) = mold->session[i];
+        }
+        have_session = mold->have_session;
+        end_of_session = mold->end_of_session;
+        next_seq = mold->next_seq;
+    }
+
+    // Subscription bitmap, one copy per record slot
+    ap_uint<512> subscribed[MSGS_PER_BEAT][STOCK_FILTER_BEATS];
+    #pragma HLS ARRAY_PARTITION variable=subscribed dim=1 complete
+    int drop_count = 0;
+    if (FILTERED) {
+        LOAD_FILTER: for (int i = 0; i < STOCK_FILTER_BEATS; i++) {
+            #pragma HLS PIPELINE II=1
+            ap_uint<512> word = filter[i];
+            for (int k = 0; k < MSGS_PER_BEAT; k++) {
+                #pragma HLS UNROLL
+                subscribed[k][i] = word;
+            }
+            cycles++;
+        }
+    }
+
+    PROCESS_BEATS: while (!stopped) {
+        #pragma HLS PIPELINE II=1
+        #pragma HLS LOOP_TRIPCOUNT min=1 max=65536
+
+        // Handle every complete record at the head of the window (up to MSGS_PER_BEAT)
+        int consumed = 0;
+        int emitted_bytes = 0;
+        bool active = true;
+        EXTRACT: for (int k = 0; k < MSGS_PER_BEAT; k++) {
+            #pragma HLS UNROLL
+            record_t record = window >> (8 * consumed);
+
+            if (MOLD && msgs_left == 0) {
+                // Packet header
+                if (active && consumed + MOLD_HEADER_LEN <= fill) {
+                    ap_uint<MOLD_SESSION_LEN * 8> pkt_session = record.range(MOLD_SESSION_LEN * 8 - 1, 0);
+                    uint64_t seq = be_field<8>(record, MOLD_SESSION_LEN);
+                    int count = (int)be_field<2>(record, MOLD_SESSION_LEN + 8);
+
+                    if (!have_session || pkt_session != session) {
+                        session = pkt_session;
+                        have_session = true;
+                        end_of_session = false;
+                        next_seq = seq;
+                    } else if (seq > next_seq) {
+                        MoldGap gap;
+                        gap.expected_seq = next_seq;
+                        gap.received_seq = seq;
+                        gap.output_index = output_count;
+                        gap.reserved = 0;
+                        gaps[gap_count] = gap;
+                        gap_count++;
+                        next_seq = seq;
+                    }
+                    if (count == MOLD_END_OF_SESSION) {
+                        end_of_session = true;
+                        count = 0;
+                    }
+                    pkt_seq = seq;
+                    msgs_left = count;
+                    consumed += MOLD_HEADER_LEN;
+                } else {
+                    active = false;
+                }
+                continue;
+            }
+
+            spec_msg_buf_t msg = record >> (8 * PREFIX_BYTES);
+            uint8_t msg_type = (uint8_t)be_field<1>(msg, 0);
+            int type_len = RecordTraits<OutT>::msg_length(msg_type);
+            int body_len = FORMAT == INPUT_PACKED ? type_len : (int)be_field<2>(record, 0);
+            bool have_len = consumed + PREFIX_BYTES < fill;
+            bool bad_len = body_len == 0 || body_len > MAX_RECORD - PREFIX_BYTES;
+
+            if (active && have_len && bad_len) {
+                stopped = true;
+            }
+            if (active && !bad_len && consumed + PREFIX_BYTES + body_len <= fill) {
+                bool fresh = !MOLD || pkt_seq >= next_seq;
+                uint16_t stock_locate = (uint16_t)be_field<2>(msg, 1);
+                bool wanted = !FILTERED || subscribed[k][stock_locate >> 9][stock_locate & 511];
+                if (type_len == body_len && fresh && wanted) {
+                    uint64_t first_cycle = 0;
+#ifdef ITCH_INSTRUMENT
+                    first_cycle = beat_cycle[((bytes_read - fill + consumed) / BEAT_BYTES) % STAMP_BEATS];
+#endif
+                    int used = emit_record(output_stream, out_pos, msg, first_cycle, (uint64_t)cycles);
+                    out_pos += used;
+                    output_count++;
+                    emitted_bytes += used * RecordTraits<OutT>::ELEMENT_BYTES;
+                } else if (type_len == body_len && fresh) {
+                    drop_count++;
+                }
+                if (MOLD) {
+                    if (fresh) next_seq = pkt_seq + 1;
+                    pkt_seq++;
+                    msgs_left--;
+                }
+                consumed += PREFIX_BYTES + body_len;
+            } else {
+                active = false;
+            }
+        }
+        window >>= 8 * consumed;
+        fill -= consumed;
+
+        // Bytes past `fill` are zero here (only the final beat may carry padding), so the
+        // next beat can be OR'd in place
+        bool can_read = bytes_read < num_bytes && fill + BEAT_BYTES <= WIN_BYTES;
+        if (can_read && !stopped) {
+            window_t beat = input_stream[beat_idx];
+#ifdef ITCH_INSTRUMENT
+            beat_cycle[beat_idx % STAMP_BEATS] = cycles;
+#endif
+            beat_idx++;
+            int n = num_bytes - bytes_read < BEAT_BYTES ? num_bytes - bytes_read : BEAT_BYTES;
+            window |= beat << (8 * fill);
+            fill += n;
+            bytes_read += n;
+        }
+
+        int out_beats = (emitted_bytes + OUT_BUS_BYTES - 1) / OUT_BUS_BYTES;
+        cycles += out_beats > 1 ? out_beats : 1;
+
+        if (consumed == 0 && !can_read) {
+            stopped = true;
+        }
+    }
+
+    if (MOLD) {
+        STORE_SESSION: for (int i = 0; i < MOLD_SESSION_LEN; i++) {
+            #pragma HLS UNROLL
+            mold->session[i] = session.range(8 * i + 7, 8 * i);
+        }
+        mold->have_session = have_session;
+        mold->end_of_session = end_of_session;
+        mold->next_seq = next_seq;
+        *num_gaps = gap_count;
+    }
+
+    if (FILTERED) {
+        *num_dropped = drop_count;
+    }
+
+    *num_outputs = output_count;
+    return cycles;
+}
+
+#endif
@@ -0,0 +1,320 @@
+// C-simulation benchmark for the wide-datapath parser.
+// Builds one random message stream, runs it through the byte-serial parser() from
+// Archive/parser.cpp, through parse_wide_core<8> and <64>, and (length-prefixed, with
+// unsupported messages mixed in) through the framed mode with every output format and the
+// CPU decoder, checks that they all agree, and reports input bytes consumed per (modelled)
+// clock cycle and output bytes written per message. The type-specific record output is also
+// run on a stream of every ITCH 5.0 type and checked against the CPU decoder, and the
+// stock_locate filter is run at several subscription sizes against the CPU filter, and the
+// columnar output is checked, column by column, against the expected records and the CPU decoder.
+// Finally a length prefix over the longest ITCH 5.0 message is planted mid-stream, where the
+// framed kernel and the CPU decoder must both stop.
+//
+// Build: g++ -O2 -I$XILINX_HLS/include -o parser_wide_tb parser_wide_tb.cpp Archive/parser.cpp itch_decoder.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "parser_wide.h"
+#include "itch_testgen.h"
+#include "itch_decoder.h"
+
+static_assert(sizeof(CompactShortRecord) == COMPACT_SHORT_LEN, "short record layout");
+static_assert(sizeof(CompactLongRecord) == COMPACT_LONG_LEN, "long record layout");
+static_assert(sizeof(ItchRecord) == ITCH_RECORD_LEN, "type-specific record layout");
+
+extern "C" void parser(const ByteData* input_stream, int num_bytes,
+                       ParserOutput* output_stream, int* num_outputs);
+
+// Brings kernel output back to ParserOutputs for comparison
+static int to_parser_outputs(const std::vector<ParserOutput>& output, int num_outputs,
+                             std::vector<ParserOutput>& decoded) {
+    decoded.assign(output.begin(), output.begin() + num_outputs);
+    return num_outputs;
+}
+
+static int to_parser_outputs(const std::vector<compact_word_t>& output, int num_outputs,
+                             std::vector<ParserOutput>& decoded) {
+    std::vector<uint8_t> bytes(output.size() * COMPACT_WORD_BYTES);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = (uint8_t)output[i / COMPACT_WORD_BYTES].range(8 * (i % COMPACT_WORD_BYTES) + 7,
+                                                                 8 * (i % COMPACT_WORD_BYTES));
+    }
+    decoded.resize(num_outputs);
+    return compact_decode(bytes.data(), num_outputs, decoded.data());
+}
+
+template <int BEAT_BYTES, InputFormat FORMAT, typename OutT>
+static int run_wide(const char* name, const std::vector<uint8_t>& bytes,
+                    const ParserOutput* expected, int num_expected) {
+    int num_beats = (int)((bytes.size() + BEAT_BYTES - 1) / BEAT_BYTES);
+    std::vector<ap_uint<BEAT_BYTES * 8> > beats(num_beats);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        beats[i / BEAT_BYTES].range(8 * (i % BEAT_BYTES) + 7, 8 * (i % BEAT_BYTES)) = bytes[i];
+    }
+
+    // Sized for the largest record per message in either format
+    std::vector<OutT> output((num_expected + 1) * (sizeof(ParserOutput) + sizeof(OutT) - 1) / sizeof(OutT));
+    int num_outputs = 0;
+    int cycles = parse_wide_core<BEAT_BYTES, FORMAT>(beats.data(), (int)bytes.size(), output.data(), &num_outputs);
+
+    std::vector<ParserOutput> decoded;
+    int num_decoded = to_parser_outputs(output, num_outputs, decoded);
+    int errors = compare_outputs(name, decoded.data(), num_decoded, expected, num_expected);
+
+    size_t output_bytes = 0;
+    for (int i = 0; i < num_decoded; i++) {
+        output_bytes += sizeof(OutT) == sizeof(ParserOutput) ? sizeof(ParserOutput)
+                                                             : compact_record_length(decoded[i].msg_type);
+    }
+    printf("%-15s %10d cycles  %6.2f bytes/cycle  %6.3f msgs/cycle  %5.1f out bytes/msg  %s\n", name, cycles,
+           (double)bytes.size() / cycles, (double)num_outputs / cycles,
+           num_decoded ? (double)output_bytes / num_decoded : 0.0, errors ? "FAIL" : "ok");
+    return errors;
+}
+
+// Runs BinaryFILE input through the type-specific record output and checks every record,
+// padding included, against the CPU decoder
+static int run_records(const char* name, const std::vector<uint8_t>& framed) {
+    int num_beats = (int)((framed.size() + 63) / 64);
+    std::vector<ap_uint<512> > beats(num_beats);
+    for (size_t i = 0; i < framed.size(); i++) {
+        beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = framed[i];
+    }
+
+    size_t max_records = framed.size() / (ITCH_LENGTH_PREFIX + ITCH_SPEC_MIN_MSG_LEN) + 1;
+    std::vector<itch_record_word_t> output(max_records);
+    int num_outputs = 0;
+    int cycles = parse_wide_core<64, INPUT_FRAMED>(beats.data(), (int)framed.size(), output.data(), &num_outputs);
+
+    std::vector<ItchRecord> expected(max_records);
+    size_t consumed = 0;
+    int num_expected = (int)itch_decode_framed_records(framed.data(), framed.size(), expected.data(),
+                                                       expected.size(), &consumed);
+
+    int errors = 0;
+    if (num_outputs != num_expected) {
+        printf("%s: produced %d records, expected %d\n", name, num_outputs, num_expected);
+        errors++;
+    }
+    for (int i = 0; i < num_outputs && i < num_expected && !errors; i++) {
+        uint8_t record[ITCH_RECORD_LEN];
+        for (int b = 0; b < ITCH_RECORD_LEN; b++) record[b] = (uint8_t)output[i].range(8 * b + 7, 8 * b);
+        if (memcmp(record, &expected[i], ITCH_RECORD_LEN) != 0) {
+            printf("%s: record %d differs (type 0x%02x)\n", name, i, (unsigned)expected[i].msg_type);
+            errors++;
+        }
+    }
+    printf("%-15s %10d cycles  %6.2f bytes/cycle  %6.3f msgs/cycle  %5.1f out bytes/msg  %s\n", name, cycles,
+           (double)framed.size() / cycles, (double)num_outputs / cycles, (double)ITCH_RECORD_LEN,
+           errors ? "FAIL" : "ok");
+    return errors;
+}
+
+// Runs BinaryFILE input through parser_filtered's core with a random subscription covering
+// `percent` of the stocks, checks it against the expected outputs filtered on the CPU and the CPU
+// filtered decoder, and reports the gmem1 bytes written per input message
+static int run_filtered(const char* name, const std::vector<uint8_t>& framed, int percent,
+                        const ParserOutput* expected, int num_expected) {
+    std::vector<uint64_t> filter(STOCK_FILTER_WORDS);
+    stock_filter_clear(filter.data());
+    for (int locate = 0; locate < STOCK_FILTER_BITS; locate++) {
+        if ((int)(next_rand() % 100) < percent) stock_filter_add(filter.data(), (uint16_t)locate);
+    }
+    std::vector<ap_uint<512> > filter_beats(STOCK_FILTER_BEATS);
+    for (int i = 0; i < STOCK_FILTER_WORDS; i++) {
+        filter_beats[i / 8].range(64 * (i % 8) + 63, 64 * (i % 8)) = filter[i];
+    }
+
+    int num_beats = (int)((framed.size() + 63) / 64);
+    std::vector<ap_uint<512> > beats(num_beats);
+    for (size_t i = 0; i < framed.size(); i++) {
+        beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = framed[i];
+    }
+    std::vector<ParserOutput> output(num_expected + 1);
+    int num_outputs = 0, num_dropped = 0;
+    int cycles = parse_wide_core<64, INPUT_FRAMED, ParserOutput, true>(
+        beats.data(), (int)framed.size(), output.data(), &num_outputs, 0, 0, 0, filter_beats.data(), &num_dropped);
+
+    std::vector<ParserOutput> kept;
+    for (int i = 0; i < num_expected; i++) {
+        if (stock_filter_test(filter.data(), expected[i].stock_locate)) kept.push_back(expected[i]);
+    }
+    int errors = compare_outputs(name, output.data(), num_outputs, kept.data(), (int)kept.size());
+    if (!errors && num_dropped != num_expected - (int)kept.size()) {
+        printf("%s: dropped %d messages, expected %d\n", name, num_dropped, num_expected - (int)kept.size());
+        errors++;
+    }
+
+    std::vector<ParserOutput> cpu(num_expected + 1);
+    size_t cpu_dropped = 0, consumed = 0;
+    int num_cpu = (int)itch_decode_framed_filtered(framed.data(), framed.size(), filter.data(), cpu.data(),
+                                                   cpu.size(), &cpu_dropped, &consumed);
+    if (!errors) errors += compare_outputs("cpu filter", cpu.data(), num_cpu, kept.data(), (int)kept.size());
+    if (!errors && cpu_dropped != (size_t)num_dropped) {
+        printf("cpu filter: dropped %zu messages, kernel dropped %d\n", cpu_dropped, num_dropped);
+        errors++;
+    }
+
+    printf("%-15s %10d cycles  %6.2f bytes/cycle  %6.3f msgs/cycle  %5.1f out bytes/msg  %s\n", name, cycles,
+           (double)framed.size() / cycles, (double)num_outputs / cycles,
+           (double)num_outputs * sizeof(ParserOutput) / num_expected, errors ? "FAIL" : "ok");
+    return errors;
+}
+
+// Checks that every expected record sits at its place in its column set; returns the first
+// mismatching record's index, or -1
+static int check_columns(const ItchColumns& cols, const ParserOutput* expected, int num_expected) {
+    size_t next[ITCH_COLUMN_SETS] = {0};
+    for (int i = 0; i < num_expected; i++) {
+        const ParserOutput& e = expected[i];
+        const ItchColumnSet& set = cols.set[itch_column_set(e.msg_type)];
+        size_t k = next[itch_column_set(e.msg_type)]++;
+        bool ok = k < set.count && set.timestamp[k] == e.timestamp && set.order_ref_no[k] == e.order_ref_no &&
+                  set.stock_locate[k] == e.stock_locate && set.tracking_no[k] == e.tracking_no &&
+                  (!set.shares || set.shares[k] == e.shares) && (!set.price || set.price[k] == e.price) &&
+                  (!set.buy_sell || set.buy_sell[k] == e.buy_sell) && (!set.stock || set.stock[k] == e.stock) &&
+                  (!set.match_no || set.match_no[k] == e.match_no) &&
+                  (!set.new_order_ref_no || set.new_order_ref_no[k] == e.new_order_ref_no) &&
+                  (!set.attribution || set.attribution[k] == e.attribution);
+        if (!ok) return i;
+    }
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        if (next[s] != cols.set[s].count) return num_expected;
+    }
+    return -1;
+}
+
+// Runs BinaryFILE input through parser_columns' core and the CPU column decoder, and reports the
+// gmem1 bytes written per message
+static int run_columns(const char* name, const std::vector<uint8_t>& framed, const ParserOutput* expected,
+                       int num_expected) {
+    int num_beats = (int)((framed.size() + 63) / 64);
+    std::vector<ap_uint<512> > beats(num_beats);
+    for (size_t i = 0; i < framed.size(); i++) {
+        beats[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64)) = framed[i];
+    }
+    size_t capacity[ITCH_COLUMN_SETS];
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) capacity[s] = num_expected;
+    size_t size = itch_columns_size(capacity);
+    std::vector<ap_uint<512> > output(size / 64);
+    ColumnWriter writer;
+    column_writer_init(writer, output.data(), num_expected);
+    int num_outputs = 0;
+    int cycles = parse_wide_core<64, INPUT_FRAMED>(beats.data(), (int)framed.size(), &writer, &num_outputs);
+    int words = column_writer_flush(writer);
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) {
+        for (int c = 0; c < ITCH_COLUMNS; c++) {
+            int per_word = 64 / itch_column_bytes(c);
+            if (itch_set_columns(s) & (1u << c)) words += writer.count[s] / per_word;
+        }
+    }
+
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++) bytes[i] = (uint8_t)output[i / 64].range(8 * (i % 64) + 7, 8 * (i % 64));
+    ItchColumns cols;
+    itch_columns_bind(&cols, bytes.data(), capacity);
+    for (int s = 0; s < ITCH_COLUMN_SETS; s++) cols.set[s].count = writer.count[s];
+    int errors = 0;
+    int bad = check_columns(cols, expected, num_expected);
+    if (num_outputs != num_expected || bad >= 0) {
+        printf("%s: %d records, expected %d; first mismatch at record %d\n", name, num_outputs, num_expected, bad);
+        errors++;
+    }
+
+    std::vector<uint8_t> cpu_bytes(size);
+    ItchColumns cpu;
+    itch_columns_bind(&cpu, cpu_bytes.data(), capacity);
+    size_t consumed = 0;
+    size_t num_cpu = itch_decode_framed_columns(framed.data(), framed.size(), &cpu, &consumed);
+    bad = check_columns(cpu, expected, num_expected);
+    if (num_cpu != (size_t)num_expected || bad >= 0) {
+        printf("cpu columns: %zu records, expected %d; first mismatch at record %d\n", num_cpu, num_expected, bad);
+        errors++;
+    }
+
+    printf("%-15s %10d cycles  %6.2f bytes/cycle  %6.3f msgs/cycle  %5.1f out bytes/msg  %s\n", name, cycles,
+           (double)framed.size() / cycles, (double)num_outputs / cycles, 64.0 * words / num_expected,
+           errors ? "FAIL" : "ok");
+    return errors;
+}
+
+// Plants a block with length `len` over ITCH_SPEC_MAX_MSG_LEN about a third of the way into
+// `framed`. The kernel cannot buffer it, so it must stop there, and so must the CPU decoder.
+static int run_over_long(const std::vector<uint8_t>& framed, int len) {
+    size_t cut = 0;
+    while (cut < framed.size() / 3) cut += ITCH_LENGTH_PREFIX + (((size_t)framed[cut] << 8) | framed[cut + 1]);
+    std::vector<uint8_t> bad(framed.begin(), framed.begin() + cut);
+    bad.push_back((uint8_t)(len >> 8));
+    bad.push_back((uint8_t)len);
+    bad.push_back(ITCH_ADD_ORDER);
+    bad.insert(bad.end(), len - 1, 0);
+    bad.insert(bad.end(), framed.begin() + cut, framed.end());
+
+    std::vector<ParserOutput> cpu(framed.size() / (ITCH_LENGTH_PREFIX + ITCH_MIN_MSG_LEN) + 1);
+    size_t consumed = 0;
+    int num_cpu = (int)itch_decode_framed(bad.data(), bad.size(), cpu.data(), cpu.size(), &consumed);
+    char name[32];
+    snprintf(name, sizeof(name), "length %d", len);
+    int errors = run_wide<64, INPUT_FRAMED, ParserOutput>(name, bad, cpu.data(), num_cpu);
+    if (consumed != cut) {
+        printf("%s: cpu decoder consumed %zu bytes, expected to stop at %zu\n", name, consumed, cut);
+        errors++;
+    }
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    int num_messages = argc > 1 ? atoi(argv[1]) : 100000;
+
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < num_messages; i++) append_random_message(bytes);
+
+    // Byte-serial reference: one ByteData per ITCH byte, flags marking each boundary
+    std::vector<ByteData> serial = to_byte_data(bytes);
+
+    std::vector<ParserOutput> expected(num_messages);
+    int num_expected = 0;
+    parser(serial.data(), (int)serial.size(), expected.data(), &num_expected);
+
+    printf("%d messages, %zu ITCH bytes\n", num_messages, bytes.size());
+    printf("%-15s %10zu cycles  %6.2f bytes/cycle  %6.3f msgs/cycle  %5.1f out bytes/msg  %s\n", "byte-serial",
+           serial.size(), 1.0, (double)num_expected / serial.size(), (double)sizeof(ParserOutput),
+           num_expected == num_messages ? "ok" : "FAIL");
+
+    int errors = num_expected == num_messages ? 0 : 1;
+    errors += run_wide<8, INPUT_PACKED, ParserOutput>("wide 64-bit", bytes, expected.data(), num_expected);
+    errors += run_wide<64, INPUT_PACKED, ParserOutput>("wide 512-bit", bytes, expected.data(), num_expected);
+
+    // BinaryFILE framing, with a System Event ('S') the parser must skip every 16 messages
+    std::vector<uint8_t> framed = to_framed(bytes, 16);
+    errors += run_wide<64, INPUT_FRAMED, ParserOutput>("framed 512-bit", framed, expected.data(), num_expected);
+    errors += run_wide<64, INPUT_FRAMED, compact_word_t>("compact 512-bit", framed, expected.data(), num_expected);
+    errors += run_records("records 512-bit", framed);
+    errors += run_columns("columns 512-bit", framed, expected.data(), num_expected);
+    errors += run_filtered("filtered 100%", framed, 100, expected.data(), num_expected);
+    errors += run_filtered("filtered 25%", framed, 25, expected.data(), num_expected);
+    errors += run_filtered("filtered 5%", framed, 5, expected.data(), num_expected);
+
+    // Every ITCH 5.0 type, in equal proportion
+    std::vector<uint8_t> spec_bytes;
+    for (int i = 0; i < num_messages; i++) append_random_spec_message(spec_bytes);
+    errors += run_records("records, all", to_framed_spec(spec_bytes));
+
+    // CPU reference decoder on the same framed stream
+    std::vector<ParserOutput> cpu(num_expected + 1);
+    size_t consumed = 0;
+    int num_cpu = (int)itch_decode_framed(framed.data(), framed.size(), cpu.data(), cpu.size(), &consumed);
+    int cpu_errors = compare_outputs("cpu decoder", cpu.data(), num_cpu, expected.data(), num_expected);
+    printf("%-15s %10s %s\n", "cpu decoder", "", cpu_errors ? "FAIL" : "ok");
+    errors += cpu_errors;
+
+    // A length prefix over the longest ITCH 5.0 message stops the kernel and the CPU decoder alike
+    errors += run_over_long(framed, ITCH_SPEC_MAX_MSG_LEN + 1);
+    errors += run_over_long(framed, 1000);
+
+    printf(errors ? "\nTEST FAILED\n" : "\nTEST PASSED\n");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+#ifndef STOCK_FILTER_H
+#define STOCK_FILTER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Subscription filter over the 16-bit stock_locate space: one bit per locate code, set for the
+// stocks to keep. Locate L is bit (L % 64) of word L / 64, so the same 8 KB of memory reads as
+// 128 little-endian 512-bit words on the card, where word L / 512 holds bit L % 512.
+//
+// Every ITCH message carries stock_locate in bytes 1-2. Market-wide messages (system events,
+// MWCB) use locate 0, so set bit 0 to keep them in the type-specific record output.
+// Layout must match between host and kernel.
+
+#define STOCK_FILTER_BITS   65536
+#define STOCK_FILTER_WORDS  (STOCK_FILTER_BITS / 64)
+#define STOCK_FILTER_BYTES  (STOCK_FILTER_BITS / 8)
+
+// Number of 512-bit words the kernel reads the filter in
+#define STOCK_FILTER_BEATS  (STOCK_FILTER_BITS / 512)
+
+static inline void stock_filter_clear(uint64_t* filter) {
+    memset(filter, 0, STOCK_FILTER_BYTES);
+}
+
+static inline void stock_filter_all(uint64_t* filter) {
+    memset(filter, 0xFF, STOCK_FILTER_BYTES);
+}
+
+static inline void stock_filter_add(uint64_t* filter, uint16_t stock_locate) {
+    filter[stock_locate >> 6] |= (uint64_t)1 << (stock_locate & 63);
+}
+
+static inline void stock_filter_remove(uint64_t* filter, uint16_t stock_locate) {
+    filter[stock_locate >> 6] &= ~((uint64_t)1 << (stock_locate & 63));
+}
+
+static inline int stock_filter_test(const uint64_t* filter, uint16_t stock_locate) {
+    return (int)((filter[stock_locate >> 6] >> (stock_locate & 63)) & 1);
+}
+
+#endif
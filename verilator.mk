@@ -0,0 +1,66 @@
+# Verilator builds of the RTL testbenches. The C++ and HLS programs are built with the commands in
+# the README; this file only covers the SystemVerilog modules.
+#
+# Usage: make -f verilator.mk [target] [VERILATOR=verilator]
+#   parser_sv_tb             parser.sv with PARSER_BACK_TO_BACK and parser_sv_tb.cpp: random
+#                            sweep and back-to-back stress run
+#   parser_sv_tb_early       the same with PARSER_EARLY_NOTIFY: checks every early_valid against the
+#                            message's valid_msg record and reports the lead per message type
+#   parser_sv_tb_registered  the same testbench on parser.sv without PARSER_BACK_TO_BACK, where
+#                            end_msg is the original register set a byte ahead
+#   parser_axis_tb           parser_axis.sv co-simulated with parser.sv (PARSER_BACK_TO_BACK) by
+#                            parser_axis_tb.cpp; parser.sv is verilated on its own, with its own
+#                            prefix, so that both models link into one binary
+#   check                    builds and runs every testbench. Each must print TEST PASSED, except
+#                            parser_sv_tb_registered, which must fail the stress run
+#   clean
+# Written for Verilator 4.210 or later (--build), but not yet run with any Verilator version:
+# none was available where it was written.
+
+VERILATOR ?= verilator
+VFLAGS = --cc -O3 -Wno-fatal
+OBJ = obj_verilator
+TB_CFLAGS = -O2 -I$(CURDIR)
+TB_DEPS = itch_decoder.cpp itch_decoder.h itch_layout.h itch_testgen.h itch.h
+
+.PHONY: all parser_sv_tb parser_sv_tb_early parser_sv_tb_registered parser_axis_tb check clean
+
+all: $(OBJ)/parser_sv_tb/Vparser $(OBJ)/parser_sv_tb_early/Vparser $(OBJ)/parser_sv_tb_registered/Vparser $(OBJ)/parser_axis_tb/Vparser_axis
+
+parser_sv_tb: $(OBJ)/parser_sv_tb/Vparser
+parser_sv_tb_early: $(OBJ)/parser_sv_tb_early/Vparser
+parser_sv_tb_registered: $(OBJ)/parser_sv_tb_registered/Vparser
+parser_axis_tb: $(OBJ)/parser_axis_tb/Vparser_axis
+
+$(OBJ)/parser_sv_tb/Vparser: parser.sv parser_sv_tb.cpp $(TB_DEPS)
+	$(VERILATOR) $(VFLAGS) --exe --build +define+PARSER_BACK_TO_BACK -CFLAGS "$(TB_CFLAGS)" --Mdir $(@D) \
+	    $(CURDIR)/parser.sv $(CURDIR)/parser_sv_tb.cpp $(CURDIR)/itch_decoder.cpp
+
+$(OBJ)/parser_sv_tb_early/Vparser: parser.sv parser_sv_tb.cpp $(TB_DEPS)
+	$(VERILATOR) $(VFLAGS) --exe --build +define+PARSER_BACK_TO_BACK +define+PARSER_EARLY_NOTIFY \
+	    -CFLAGS "$(TB_CFLAGS) -DPARSER_EARLY_NOTIFY" --Mdir $(@D) \
+	    $(CURDIR)/parser.sv $(CURDIR)/parser_sv_tb.cpp $(CURDIR)/itch_decoder.cpp
+
+$(OBJ)/parser_sv_tb_registered/Vparser: parser.sv parser_sv_tb.cpp $(TB_DEPS)
+	$(VERILATOR) $(VFLAGS) --exe --build -CFLAGS "$(TB_CFLAGS)" --Mdir $(@D) \
+	    $(CURDIR)/parser.sv $(CURDIR)/parser_sv_tb.cpp $(CURDIR)/itch_decoder.cpp
+
+AXIS_SERIAL = $(abspath $(OBJ))/parser_axis_tb/serial
+
+$(AXIS_SERIAL)/Vparser__ALL.a: parser.sv
+	$(VERILATOR) $(VFLAGS) +define+PARSER_BACK_TO_BACK --prefix Vparser --Mdir $(@D) $(CURDIR)/parser.sv
+	$(MAKE) -C $(@D) -f Vparser.mk Vparser__ALL.a
+
+$(OBJ)/parser_axis_tb/Vparser_axis: parser_axis.sv parser_axis_tb.cpp $(AXIS_SERIAL)/Vparser__ALL.a $(TB_DEPS)
+	$(VERILATOR) $(VFLAGS) --exe --build -CFLAGS "$(TB_CFLAGS) -I$(AXIS_SERIAL)" \
+	    -LDFLAGS $(AXIS_SERIAL)/Vparser__ALL.a --Mdir $(@D) \
+	    $(CURDIR)/parser_axis.sv $(CURDIR)/parser_axis_tb.cpp $(CURDIR)/itch_decoder.cpp
+
+check: all
+	$(OBJ)/parser_sv_tb/Vparser
+	$(OBJ)/parser_sv_tb_early/Vparser
+	! $(OBJ)/parser_sv_tb_registered/Vparser
+	$(OBJ)/parser_axis_tb/Vparser_axis
+
+clean:
+	rm -rf $(OBJ)